@@ -31,7 +31,10 @@ extern "C" {
 /* reference kernels included by default */
 #include "esp_nn_ansi_headers.h"
 
-#if defined(CONFIG_NN_OPTIMIZED)
+#if defined(CONFIG_NN_SIMD) && !defined(__XTENSA__)
+// host builds with vector instructions
+#include "esp_nn_simd.h"
+#elif defined(CONFIG_NN_OPTIMIZED)
 #if defined(ARCH_ESP32_S3)
 #include "esp_nn_esp32s3.h"
 #else // for other platforms use generic optimisations
@@ -45,6 +45,31 @@ void esp_nn_add_elementwise_s8_ansi(const int8_t *input1_data,
                                     const int32_t activation_min,
                                     const int32_t activation_max,
                                     const int32_t size);
+
+/**
+ * @brief       elementwise addition, int16 activations
+ *
+ * @note        inputs type: int16_t, output: int16_t
+ *              same parameters as esp_nn_add_elementwise_s8_ansi, with
+ *              left_shift of 15 in tflite
+ */
+void esp_nn_add_elementwise_s16_ansi(const int16_t *input1_data,
+                                     const int16_t *input2_data,
+                                     const int32_t input1_offset,
+                                     const int32_t input2_offset,
+                                     const int32_t input1_mult,
+                                     const int32_t input2_mult,
+                                     const int32_t input1_shift,
+                                     const int32_t input2_shift,
+                                     const int32_t left_shift,
+                                     int16_t *output,
+                                     const int32_t out_offset,
+                                     const int32_t out_mult,
+                                     const int32_t out_shift,
+                                     const int32_t activation_min,
+                                     const int32_t activation_max,
+                                     const int32_t size);
+
 /**
  * @brief       elementwise multiplication
  *
@@ -108,6 +133,37 @@ void esp_nn_conv_s8_ansi(const data_dims_t *input_dims,
                          const conv_params_t *conv_params,
                          const quant_data_t *quant_data);
 
+/**
+ * @brief       16x8 variants of the convolutions: int16 activations, int8
+ *              weights, int64 bias
+ *
+ * @note        operation: result += input * filter, accumulated in 64 bits
+ *
+ *              zero points of int16 tensors are 0 in tflite, the in_offset
+ *              and out_offset of the params are not used. Requantization
+ *              rounds the multiplier to 16 bits, as tflite does for them.
+ *              No scratch or prepared buffer is needed.
+ */
+void esp_nn_conv_s16_ansi(const data_dims_t *input_dims,
+                          const int16_t *input_data,
+                          const data_dims_t *filter_dims,
+                          const int8_t *filter_data,
+                          const int64_t *bias,
+                          const data_dims_t *output_dims,
+                          int16_t *out_data,
+                          const conv_params_t *conv_params,
+                          const quant_data_t *quant_data);
+
+void esp_nn_depthwise_conv_s16_ansi(const data_dims_t *input_dims,
+                                    const int16_t *input_data,
+                                    const data_dims_t *filter_dims,
+                                    const int8_t *filter_data,
+                                    const int64_t *bias,
+                                    const data_dims_t *output_dims,
+                                    int16_t *out_data,
+                                    const dw_conv_params_t *conv_params,
+                                    const quant_data_t *quant_data);
+
 int esp_nn_get_conv_scratch_size_ansi(const data_dims_t *input_dims,
                                       const data_dims_t *filter_dims,
                                       const data_dims_t *output_dims,
@@ -120,6 +176,58 @@ int esp_nn_get_depthwise_conv_scratch_size_ansi(const data_dims_t *input_dims,
                                                 const dw_conv_params_t *conv_params);
 void esp_nn_set_depthwise_conv_scratch_buf_ansi(const void *buf);
 
+/**
+ * @brief       one time transform of the weights of a convolution
+ *
+ * @note        The prepared buffer depends on the filter, the bias and the
+ *              input offset only, so it is computed once, when the model is
+ *              loaded, into memory that lives as long as the model.
+ *              get_*_prepared_size returns its size in bytes, 0 if the kernel
+ *              has no use for it. The buffer must be 4 byte aligned, and set
+ *              with set_*_prepared_buf before every call, as the scratch buffer.
+ */
+int esp_nn_get_conv_prepared_size_ansi(const data_dims_t *input_dims,
+                                       const data_dims_t *filter_dims,
+                                       const data_dims_t *output_dims,
+                                       const conv_params_t *conv_params);
+void esp_nn_prepare_conv_s8_ansi(const data_dims_t *input_dims,
+                                 const data_dims_t *filter_dims,
+                                 const int8_t *filter_data,
+                                 const int32_t *bias,
+                                 const data_dims_t *output_dims,
+                                 const conv_params_t *conv_params,
+                                 void *prepared);
+void esp_nn_set_conv_prepared_buf_ansi(const void *buf);
+
+int esp_nn_get_depthwise_conv_prepared_size_ansi(const data_dims_t *input_dims,
+                                                 const data_dims_t *filter_dims,
+                                                 const data_dims_t *output_dims,
+                                                 const dw_conv_params_t *conv_params);
+void esp_nn_prepare_depthwise_conv_s8_ansi(const data_dims_t *input_dims,
+                                           const data_dims_t *filter_dims,
+                                           const int8_t *filter_data,
+                                           const int32_t *bias,
+                                           const data_dims_t *output_dims,
+                                           const dw_conv_params_t *conv_params,
+                                           void *prepared);
+void esp_nn_set_depthwise_conv_prepared_buf_ansi(const void *buf);
+
+/**
+ * @brief       1x1 convolution with sparse weights
+ *
+ * @note        `sparse` is the filter encoded by esp_nn_encode_sparse_s8_ansi(),
+ *              one row per output channel. No padding, any stride. Same outputs
+ *              as esp_nn_conv_s8_ansi.
+ */
+void esp_nn_conv_1x1_sparse_s8_ansi(const data_dims_t *input_dims,
+                                    const int8_t *input_data,
+                                    const sparse_s8_t *sparse,
+                                    const int32_t *bias,
+                                    const data_dims_t *output_dims,
+                                    int8_t *out_data,
+                                    const conv_params_t *conv_params,
+                                    const quant_data_t *quant_data);
+
 /************************** Activation functions *****************************/
 
 /**
@@ -176,6 +284,27 @@ void esp_nn_avg_pool_s8_ansi(const int8_t *input,
                              const int32_t activation_max,
                              const uint16_t channels);
 
+/**
+ * @brief       avg_pool, int16 activations
+ *
+ * @note        inputs type: int16_t, output: int16_t
+ */
+void esp_nn_avg_pool_s16_ansi(const int16_t *input,
+                              const uint16_t input_wd,
+                              const uint16_t input_ht,
+                              int16_t *output,
+                              const uint16_t output_wd,
+                              const uint16_t output_ht,
+                              const uint16_t stride_wd,
+                              const uint16_t stride_ht,
+                              const uint16_t filter_wd,
+                              const uint16_t filter_ht,
+                              const uint16_t pad_wd,
+                              const uint16_t pad_ht,
+                              const int32_t activation_min,
+                              const int32_t activation_max,
+                              const uint16_t channels);
+
 
 /************************** Fully connected functions ***********************/
 
@@ -199,6 +328,63 @@ void esp_nn_fully_connected_s8_ansi(const int8_t *input_data,
                                     const int32_t activation_min,
                                     const int32_t activation_max);
 
+/**
+ * @brief       fully connected, int16 activations, int8 weights, int64 bias
+ *
+ * @note        per tensor quantization, as the int8 version. Zero points of
+ *              int16 tensors and int8 weights are 0 in tflite, so there are
+ *              no offsets.
+ */
+void esp_nn_fully_connected_s16_ansi(const int16_t *input_data,
+                                     const uint16_t row_len,
+                                     const int8_t *filter_data,
+                                     const int64_t *bias,
+                                     int16_t *out_data,
+                                     const uint16_t out_channels,
+                                     const int32_t out_shift,
+                                     const int32_t out_mult,
+                                     const int32_t activation_min,
+                                     const int32_t activation_max);
+
+/**
+ * @brief       sparse weights of a fully connected or 1x1 conv
+ *
+ * @note        the filter is one row of `row_len` values per output channel,
+ *              see sparse_s8_t. It is meant to be encoded offline, once:
+ *              get_sparse_s8_size returns the bytes of `row_start`, `cols` and
+ *              `values`, or 0 when fewer than ESP_NN_SPARSE_MIN_ZERO_WEIGHTS
+ *              percent of the weights are zeros or the encoding is not smaller
+ *              than the filter, and encode_sparse_s8 writes them, `cols` with
+ *              1 byte per value for rows up to 256 long and 2 bytes otherwise.
+ */
+int32_t esp_nn_get_sparse_s8_size_ansi(const int8_t *filter_data,
+                                       const int32_t rows,
+                                       const int32_t row_len);
+void esp_nn_encode_sparse_s8_ansi(const int8_t *filter_data,
+                                  const int32_t rows,
+                                  const int32_t row_len,
+                                  int32_t *row_start,
+                                  void *cols,
+                                  int8_t *values);
+
+/**
+ * @brief       fully connected with sparse weights
+ *
+ * @note        `sparse` is the filter encoded by esp_nn_encode_sparse_s8_ansi(),
+ *              with a filter offset of 0. Same outputs as
+ *              esp_nn_fully_connected_s8_ansi.
+ */
+void esp_nn_fully_connected_sparse_s8_ansi(const int8_t *input_data,
+                                           const int32_t input_offset,
+                                           const sparse_s8_t *sparse,
+                                           const int32_t *bias,
+                                           int8_t *out_data,
+                                           const int32_t out_offset,
+                                           const int32_t out_shift,
+                                           const int32_t out_mult,
+                                           const int32_t activation_min,
+                                           const int32_t activation_max);
+
 /**
  * @brief   Get scratch buffer size needed by softmax function
  *
@@ -234,6 +420,36 @@ void esp_nn_softmax_s8_ansi(const int8_t *input_data,
                             const int32_t diff_min,
                             int8_t *output_data);
 
+/* entries of the table of esp_nn_prepare_softmax_lut_s8_ansi() */
+#define ESP_NN_SOFTMAX_LUT_SIZE 256
+
+/**
+ * @brief       Table of exps for esp_nn_softmax_s8_lut functions
+ *
+ * @param       lut     ESP_NN_SOFTMAX_LUT_SIZE entries, entry `i` is the exp
+ *                      of an input `i` below the max of its row, 0 for the
+ *                      inputs below `diff_min` which are skipped
+ *
+ * @note        mult, shift and diff_min are those of esp_nn_softmax_s8_ansi,
+ *              fixed for a model, so the table is built once per op.
+ */
+void esp_nn_prepare_softmax_lut_s8_ansi(const int32_t mult,
+                                        const int32_t shift,
+                                        const int32_t diff_min,
+                                        int32_t *lut);
+
+/**
+ * @brief       reference softmax function, with the exps from a table
+ *
+ * @note        same outputs as esp_nn_softmax_s8_ansi, no scratch buffer.
+ *              The table is only read, so calls can share it.
+ */
+void esp_nn_softmax_s8_lut_ansi(const int8_t *input_data,
+                                const int32_t height,
+                                const int32_t width,
+                                const int32_t *lut,
+                                int8_t *output_data);
+
 
 //////////////////////////// Generic optimisations /////////////////////////////
 
@@ -279,6 +495,34 @@ void esp_nn_depthwise_conv_s8_opt(const data_dims_t *input_dims,
                                   const dw_conv_params_t *conv_params,
                                   const quant_data_t *quant_data);
 
+/**
+ * @brief       16x8 convolutions optimized versions
+ *
+ * @note        same outputs as the _ansi versions. The products are summed
+ *              in 32 bits over chunks short enough not to overflow.
+ *              Depthwise with a channel multiplier other than 1, or filters
+ *              of more than 256 taps, run the _ansi version.
+ */
+void esp_nn_conv_s16_opt(const data_dims_t *input_dims,
+                         const int16_t *input_data,
+                         const data_dims_t *filter_dims,
+                         const int8_t *filter_data,
+                         const int64_t *bias,
+                         const data_dims_t *output_dims,
+                         int16_t *out_data,
+                         const conv_params_t *conv_params,
+                         const quant_data_t *quant_data);
+
+void esp_nn_depthwise_conv_s16_opt(const data_dims_t *input_dims,
+                                   const int16_t *input_data,
+                                   const data_dims_t *filter_dims,
+                                   const int8_t *filter_data,
+                                   const int64_t *bias,
+                                   const data_dims_t *output_dims,
+                                   int16_t *out_data,
+                                   const dw_conv_params_t *conv_params,
+                                   const quant_data_t *quant_data);
+
 int esp_nn_get_conv_scratch_size_opt(const data_dims_t *input_dims,
                                      const data_dims_t *filter_dims,
                                      const data_dims_t *output_dims,
@@ -291,14 +535,135 @@ int esp_nn_get_depthwise_conv_scratch_size_opt(const data_dims_t *input_dims,
                                                const dw_conv_params_t *conv_params);
 void esp_nn_set_depthwise_conv_scratch_buf_opt(const void *buf);
 
+/**
+ * @note        the prepared buffer holds `bias + input_offset * sum(filter)`
+ *              of every output channel, which takes the input offset out of
+ *              the inner loops.
+ */
+int esp_nn_get_conv_prepared_size_opt(const data_dims_t *input_dims,
+                                      const data_dims_t *filter_dims,
+                                      const data_dims_t *output_dims,
+                                      const conv_params_t *conv_params);
+void esp_nn_prepare_conv_s8_opt(const data_dims_t *input_dims,
+                                const data_dims_t *filter_dims,
+                                const int8_t *filter_data,
+                                const int32_t *bias,
+                                const data_dims_t *output_dims,
+                                const conv_params_t *conv_params,
+                                void *prepared);
+void esp_nn_set_conv_prepared_buf_opt(const void *buf);
+
+int esp_nn_get_depthwise_conv_prepared_size_opt(const data_dims_t *input_dims,
+                                                const data_dims_t *filter_dims,
+                                                const data_dims_t *output_dims,
+                                                const dw_conv_params_t *conv_params);
+void esp_nn_prepare_depthwise_conv_s8_opt(const data_dims_t *input_dims,
+                                          const data_dims_t *filter_dims,
+                                          const int8_t *filter_data,
+                                          const int32_t *bias,
+                                          const data_dims_t *output_dims,
+                                          const dw_conv_params_t *conv_params,
+                                          void *prepared);
+void esp_nn_set_depthwise_conv_prepared_buf_opt(const void *buf);
+
+/************************** Pooling functions *****************************/
+
+/**
+ * @brief       max_pool optimized version
+ *
+ * @note        inputs type: int8_t, output: int8_t
+ */
+void esp_nn_max_pool_s8_opt(const int8_t *input,
+                            const uint16_t input_wd,
+                            const uint16_t input_ht,
+                            int8_t *output,
+                            const uint16_t output_wd,
+                            const uint16_t output_ht,
+                            const uint16_t stride_wd,
+                            const uint16_t stride_ht,
+                            const uint16_t filter_wd,
+                            const uint16_t filter_ht,
+                            const uint16_t pad_wd,
+                            const uint16_t pad_ht,
+                            const int32_t activation_min,
+                            const int32_t activation_max,
+                            const uint16_t channels);
+
+/**
+ * @brief       avg_pool optimized version
+ *
+ * @note        inputs type: int8_t, output: int8_t
+ *              the window sums slide along a row of outputs, and the average
+ *              is a multiply by the reciprocal of the window size.
+ */
+void esp_nn_avg_pool_s8_opt(const int8_t *input,
+                            const uint16_t input_wd,
+                            const uint16_t input_ht,
+                            int8_t *output,
+                            const uint16_t output_wd,
+                            const uint16_t output_ht,
+                            const uint16_t stride_wd,
+                            const uint16_t stride_ht,
+                            const uint16_t filter_wd,
+                            const uint16_t filter_ht,
+                            const uint16_t pad_wd,
+                            const uint16_t pad_ht,
+                            const int32_t activation_min,
+                            const int32_t activation_max,
+                            const uint16_t channels);
+
+/**
+ * @brief       avg_pool optimized version, int16 activations
+ *
+ * @note        as esp_nn_avg_pool_s8_opt, windows of 65536 values and more
+ *              run the _ansi version.
+ */
+void esp_nn_avg_pool_s16_opt(const int16_t *input,
+                             const uint16_t input_wd,
+                             const uint16_t input_ht,
+                             int16_t *output,
+                             const uint16_t output_wd,
+                             const uint16_t output_ht,
+                             const uint16_t stride_wd,
+                             const uint16_t stride_ht,
+                             const uint16_t filter_wd,
+                             const uint16_t filter_ht,
+                             const uint16_t pad_wd,
+                             const uint16_t pad_ht,
+                             const int32_t activation_min,
+                             const int32_t activation_max,
+                             const uint16_t channels);
+
+/************************** Fully connected functions ***********************/
+
+/**
+ * @brief       fully connected optimized version, int16 activations
+ *
+ * @note        4 output channels at a time, products summed in 32 bits
+ *              over chunks short enough not to overflow.
+ */
+void esp_nn_fully_connected_s16_opt(const int16_t *input_data,
+                                    const uint16_t row_len,
+                                    const int8_t *filter_data,
+                                    const int64_t *bias,
+                                    int16_t *out_data,
+                                    const uint16_t out_channels,
+                                    const int32_t out_shift,
+                                    const int32_t out_mult,
+                                    const int32_t activation_min,
+                                    const int32_t activation_max);
+
+/************************** Softmax functions *****************************/
+
 /* ANSI C function to be hooked up when optimised version needed */
 void esp_nn_set_softmax_scratch_buf_opt(void *buffer);
 
 /**
  * @brief       optimised version of softmax function
  *
- * @note        the function uses extra buffer (4 * width bytes)
- *              hence, scratch buffers must be set before calling this.
+ * @note        the function uses extra buffer (4 * width bytes) to keep
+ *              the exps, set with esp_nn_set_softmax_scratch_buf. Without
+ *              it, the exps are computed twice as the reference function.
  */
 void esp_nn_softmax_s8_opt(const int8_t *input_data,
                            const int32_t height,
@@ -307,3 +672,14 @@ void esp_nn_softmax_s8_opt(const int8_t *input_data,
                            const int32_t shift,
                            const int32_t diff_min,
                            int8_t *output_data);
+
+/**
+ * @brief       optimised version of softmax function, with the exps from a table
+ *
+ * @note        no scratch buffer needed
+ */
+void esp_nn_softmax_s8_lut_opt(const int8_t *input_data,
+                               const int32_t height,
+                               const int32_t width,
+                               const int32_t *lut,
+                               int8_t *output_data);
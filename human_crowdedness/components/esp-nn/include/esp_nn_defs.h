@@ -81,3 +81,19 @@ typedef struct dw_conv_params {
     data_2d_t dilation;
     act_params_t activation;
 } dw_conv_params_t;
+
+/**
+ * @brief sparse int8 weights of a fully connected or 1x1 convolution
+ *
+ * @note the filter has one row of `row_len` values per output channel. Only its
+ *       values other than 0 are kept, row after row, each with its column
+ *       (CSR). `cols` is uint8_t when `col_size` is 1 and uint16_t when it is 2.
+ */
+typedef struct sparse_s8 {
+    int32_t rows;
+    int32_t row_len;
+    const int32_t *row_start; // rows + 1 entries, first value of every row
+    const void *cols;
+    int32_t col_size;
+    const int8_t *values;
+} sparse_s8_t;
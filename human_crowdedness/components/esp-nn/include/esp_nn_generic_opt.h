@@ -23,11 +23,14 @@
 #include "esp_nn_ansi_headers.h"
 
 #define esp_nn_add_elementwise_s8 esp_nn_add_elementwise_s8_ansi
+#define esp_nn_add_elementwise_s16 esp_nn_add_elementwise_s16_ansi
 #define esp_nn_mul_elementwise_s8 esp_nn_mul_elementwise_s8_ansi
 
 #define esp_nn_depthwise_conv_s8 esp_nn_depthwise_conv_s8_opt
+#define esp_nn_depthwise_conv_s16 esp_nn_depthwise_conv_s16_opt
 
 #define esp_nn_conv_s8 esp_nn_conv_s8_opt
+#define esp_nn_conv_s16 esp_nn_conv_s16_opt
 
 #define esp_nn_get_conv_scratch_size esp_nn_get_conv_scratch_size_opt
 #define esp_nn_set_conv_scratch_buf esp_nn_set_conv_scratch_buf_opt
@@ -35,13 +38,30 @@
 #define esp_nn_get_depthwise_conv_scratch_size esp_nn_get_depthwise_conv_scratch_size_opt
 #define esp_nn_set_depthwise_conv_scratch_buf esp_nn_set_depthwise_conv_scratch_buf_opt
 
+#define esp_nn_get_conv_prepared_size esp_nn_get_conv_prepared_size_opt
+#define esp_nn_prepare_conv_s8 esp_nn_prepare_conv_s8_opt
+#define esp_nn_set_conv_prepared_buf esp_nn_set_conv_prepared_buf_opt
+
+#define esp_nn_get_depthwise_conv_prepared_size esp_nn_get_depthwise_conv_prepared_size_opt
+#define esp_nn_prepare_depthwise_conv_s8 esp_nn_prepare_depthwise_conv_s8_opt
+#define esp_nn_set_depthwise_conv_prepared_buf esp_nn_set_depthwise_conv_prepared_buf_opt
+
 #define esp_nn_relu6_s8 esp_nn_relu6_s8_ansi
 
-#define esp_nn_avg_pool_s8 esp_nn_avg_pool_s8_ansi
-#define esp_nn_max_pool_s8 esp_nn_max_pool_s8_ansi
+#define esp_nn_avg_pool_s8 esp_nn_avg_pool_s8_opt
+#define esp_nn_avg_pool_s16 esp_nn_avg_pool_s16_opt
+#define esp_nn_max_pool_s8 esp_nn_max_pool_s8_opt
 
 #define esp_nn_fully_connected_s8 esp_nn_fully_connected_s8_ansi
+#define esp_nn_fully_connected_s16 esp_nn_fully_connected_s16_opt
+
+#define esp_nn_get_sparse_s8_size esp_nn_get_sparse_s8_size_ansi
+#define esp_nn_encode_sparse_s8 esp_nn_encode_sparse_s8_ansi
+#define esp_nn_fully_connected_sparse_s8 esp_nn_fully_connected_sparse_s8_ansi
+#define esp_nn_conv_1x1_sparse_s8 esp_nn_conv_1x1_sparse_s8_ansi
 
 #define esp_nn_get_softmax_scratch_size esp_nn_get_softmax_scratch_size_opt
 #define esp_nn_set_softmax_scratch_buf esp_nn_set_softmax_scratch_buf_opt
 #define esp_nn_softmax_s8 esp_nn_softmax_s8_opt
+#define esp_nn_prepare_softmax_lut_s8 esp_nn_prepare_softmax_lut_s8_ansi
+#define esp_nn_softmax_s8_lut esp_nn_softmax_s8_lut_opt
@@ -0,0 +1,35 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <esp_nn_simd_common.h>
+
+ESP_NN_SIMD_DISPATCH
+void esp_nn_relu6_s8_simd(int8_t *data, uint16_t size)
+{
+    const v16i8_t zero = {};
+    const v16i8_t six = zero + 6;
+
+    int32_t i = 0;
+    for (; i <= size - 16; i += 16) {
+        v16i8_t val = simd_load_v16i8(data + i);
+        val = simd_min_s8(simd_max_s8(val, zero), six);
+        memcpy(data + i, &val, sizeof(val));
+    }
+    for (; i < size; i++) {
+        int32_t ip = data[i];
+
+        ip = max(ip, 0);
+        data[i] = min(ip, 6);
+    }
+}
@@ -24,6 +24,12 @@
  */
 #define __NN_FORCE_INLINE__ __attribute((always_inline)) static inline
 
+/**
+ * The buffers set with esp_nn_set_*_buf() are per thread, so that the layers
+ * split between threads each run with their own ones.
+ */
+#define __NN_THREAD_LOCAL__ __thread
+
 /* min/max macros */
 #ifndef max
 #define max(a, b) ({            \
@@ -133,7 +139,8 @@ __NN_FORCE_INLINE__ int32_t esp_nn_div_by_power_of_two(int32_t val, int32_t expo
 {
     int32_t result;
 
-    const int32_t mask = (1 << exponent) - 1;
+    /* unsigned, for exponents of 31 */
+    const int32_t mask = (int32_t) ((1u << exponent) - 1);
     const int32_t remainder = val & mask;
 
     result = val >> exponent;
@@ -170,6 +177,81 @@ __NN_FORCE_INLINE__ int32_t esp_nn_multiply_by_quantized_mult_fast(int32_t x, in
     return result;
 }
 
+/**
+ * 64 bit accumulators of the int16 activation kernels, as tflite does for them:
+ * the multiplier is rounded to 16 bits and applied with a single rounding.
+ * `x` is expected in [-(1 << 47), (1 << 47)).
+ */
+__NN_FORCE_INLINE__ int32_t esp_nn_multiply_by_quantized_mult_s64(int64_t x, int32_t mult, int32_t shift)
+{
+    const int32_t reduced_mult = mult < 0x7fff0000 ? (mult + (1 << 15)) >> 16 : 0x7fff;
+    const int32_t total_shift = 15 - shift;
+    const int64_t result = x * reduced_mult + ((int64_t) 1 << (total_shift - 1));
+    return (int32_t) (result >> total_shift);
+}
+
+/**
+ * int16 x int8 products are within 2^22, so the sum of 256 of them fits an
+ * int32. The dot products below add that many in 32 bits before they go to
+ * the 64 bit accumulators.
+ */
+#define ESP_NN_S16_DOT_CHUNK    256
+
+/**
+ * @brief       acc += dot(input, filter), `len` values
+ */
+__NN_FORCE_INLINE__ int64_t esp_nn_dot_s16_s8(const int16_t *input, const int8_t *filter,
+                                              int32_t len, int64_t acc)
+{
+    while (len > 0) {
+        const int32_t cnt = min(len, ESP_NN_S16_DOT_CHUNK);
+        int32_t sum = 0;
+        for (int32_t i = 0; i < cnt; i++) {
+            sum += input[i] * filter[i];
+        }
+        acc += sum;
+        input += cnt;
+        filter += cnt;
+        len -= cnt;
+    }
+    return acc;
+}
+
+/**
+ * @brief       acc[n] += dot(input, filter + n * filter_stride), `len` values,
+ *              for 4 filter rows, each input value loaded once
+ */
+__NN_FORCE_INLINE__ void esp_nn_dot_s16_s8_x4(const int16_t *input, const int8_t *filter,
+                                              const int32_t filter_stride, int32_t len,
+                                              int64_t acc[4])
+{
+    const int8_t *f0 = filter;
+    const int8_t *f1 = f0 + filter_stride;
+    const int8_t *f2 = f1 + filter_stride;
+    const int8_t *f3 = f2 + filter_stride;
+    while (len > 0) {
+        const int32_t cnt = min(len, ESP_NN_S16_DOT_CHUNK);
+        int32_t sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+        for (int32_t i = 0; i < cnt; i++) {
+            const int32_t in = input[i];
+            sum0 += in * f0[i];
+            sum1 += in * f1[i];
+            sum2 += in * f2[i];
+            sum3 += in * f3[i];
+        }
+        acc[0] += sum0;
+        acc[1] += sum1;
+        acc[2] += sum2;
+        acc[3] += sum3;
+        input += cnt;
+        f0 += cnt;
+        f1 += cnt;
+        f2 += cnt;
+        f3 += cnt;
+        len -= cnt;
+    }
+}
+
 static void esp_nn_aligned_s8_pad_with_value(const int8_t *src, int8_t *dst,
                                              const uint16_t input_wd,
                                              const uint16_t input_ht,
@@ -0,0 +1,209 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file        Common helpers of the SIMD kernels, for hosts other than the ESP chips.
+ *
+ *              The kernels are written with GCC vector extensions, which the
+ *              compiler lowers to SSE, AVX2 or NEON instructions. On x86-64,
+ *              every public kernel is built once per instruction set and the
+ *              best one for the CPU is picked when the program is loaded. On
+ *              aarch64, NEON is always there and there is a single build.
+ *
+ *              The helpers below are the vector versions of the ones in
+ *              common_functions.h, and give exactly the same results.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <common_functions.h>
+
+#if defined(__XTENSA__)
+#error "esp-nn SIMD kernels are meant for hosts, use the generic or esp32s3 ones on the chips"
+#endif
+
+#if defined(__x86_64__) && defined(__linux__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define ESP_NN_SIMD_DISPATCH __attribute__((target_clones("avx2", "sse4.1", "default")))
+#endif
+#endif
+
+#ifndef ESP_NN_SIMD_DISPATCH
+#define ESP_NN_SIMD_DISPATCH
+#endif
+
+/* lanes of the vectors, 8 x int32 is one AVX2 register or two SSE/NEON ones */
+#define SIMD_LANES 8
+
+typedef int8_t  v8i8_t  __attribute__((vector_size(SIMD_LANES)));
+typedef int16_t v8i16_t __attribute__((vector_size(SIMD_LANES * 2)));
+typedef int32_t v8i32_t __attribute__((vector_size(SIMD_LANES * 4)));
+typedef uint32_t v8u32_t __attribute__((vector_size(SIMD_LANES * 4)));
+typedef int64_t v8i64_t __attribute__((vector_size(SIMD_LANES * 8)));
+typedef int8_t  v16i8_t __attribute__((vector_size(16)));
+
+__NN_FORCE_INLINE__ v8i8_t simd_load_v8i8(const int8_t *src)
+{
+    v8i8_t val;
+    memcpy(&val, src, sizeof(val));
+    return val;
+}
+
+__NN_FORCE_INLINE__ v16i8_t simd_load_v16i8(const int8_t *src)
+{
+    v16i8_t val;
+    memcpy(&val, src, sizeof(val));
+    return val;
+}
+
+__NN_FORCE_INLINE__ v8i32_t simd_load_v8i32(const int32_t *src)
+{
+    v8i32_t val;
+    memcpy(&val, src, sizeof(val));
+    return val;
+}
+
+__NN_FORCE_INLINE__ v8i16_t simd_widen_s16(v8i8_t val)
+{
+    return __builtin_convertvector(val, v8i16_t);
+}
+
+__NN_FORCE_INLINE__ v8i32_t simd_widen_s32(v8i8_t val)
+{
+    return __builtin_convertvector(val, v8i32_t);
+}
+
+/**
+ * @brief   int8 x int8 products of 8 values, widened to int32.
+ *
+ * @note    the products fit in int16, so they are done at that width.
+ */
+__NN_FORCE_INLINE__ v8i32_t simd_mul_s8(v8i8_t a, v8i8_t b)
+{
+    return __builtin_convertvector(simd_widen_s16(a) * simd_widen_s16(b), v8i32_t);
+}
+
+__NN_FORCE_INLINE__ int32_t simd_hsum(v8i32_t val)
+{
+    int32_t sum = 0;
+    for (int i = 0; i < SIMD_LANES; i++) {
+        sum += val[i];
+    }
+    return sum;
+}
+
+/* lane wise `mask ? a : b`, with mask lanes all ones or all zeros */
+__NN_FORCE_INLINE__ v8i32_t simd_select(v8i32_t mask, v8i32_t a, v8i32_t b)
+{
+    return (mask & a) | (~mask & b);
+}
+
+__NN_FORCE_INLINE__ v8i32_t simd_min(v8i32_t a, v8i32_t b)
+{
+    return simd_select(a < b, a, b);
+}
+
+__NN_FORCE_INLINE__ v8i32_t simd_max(v8i32_t a, v8i32_t b)
+{
+    return simd_select(a > b, a, b);
+}
+
+__NN_FORCE_INLINE__ v16i8_t simd_max_s8(v16i8_t a, v16i8_t b)
+{
+    v16i8_t mask = a > b;
+    return (mask & a) | (~mask & b);
+}
+
+__NN_FORCE_INLINE__ v16i8_t simd_min_s8(v16i8_t a, v16i8_t b)
+{
+    v16i8_t mask = a < b;
+    return (mask & a) | (~mask & b);
+}
+
+/**
+ * @brief   Store 8 int32 values, already in int8 range, as int8.
+ */
+__NN_FORCE_INLINE__ void simd_store_s8(int8_t *dst, v8i32_t val)
+{
+    v8i8_t narrow = __builtin_convertvector(val, v8i8_t);
+    memcpy(dst, &narrow, sizeof(narrow));
+}
+
+/**
+ * @brief   Lane wise esp_nn_sat_round_doubling_high_mul()
+ */
+__NN_FORCE_INLINE__ v8i32_t simd_sat_round_doubling_high_mul(v8i32_t in0, v8i32_t in1)
+{
+    const v8i64_t in0_64 = __builtin_convertvector(in0, v8i64_t);
+    const v8i64_t in1_64 = __builtin_convertvector(in1, v8i64_t);
+
+    /* Nudge value, 1 - (1 << 30) where the signs differ */
+    const v8i64_t signs_differ = (in0_64 ^ in1_64) < 0;
+    const v8i64_t nudge_val = (signs_differ & (1 - (1ll << 30))) | (~signs_differ & (1ll << 30));
+
+    /* Multiply, add nudge, round and pickup 32 bits */
+    const v8i64_t mult = in0_64 * in1_64 + nudge_val;
+    const v8i64_t to_add = (mult >> 63) & ((1ll << 31) - 1);
+    const v8i32_t result = __builtin_convertvector((mult + to_add) >> 31, v8i32_t);
+
+    const v8i32_t overflow = (in0 == in1) & (in0 == INT32_MIN);
+    return simd_select(overflow, (v8i32_t) {} + INT32_MAX, result);
+}
+
+/**
+ * @brief   Lane wise esp_nn_div_by_power_of_two(), with an exponent per lane
+ */
+__NN_FORCE_INLINE__ v8i32_t simd_div_by_power_of_two(v8i32_t val, v8i32_t exponent)
+{
+    /* unsigned, for exponents of 31 */
+    const v8i32_t mask = (v8i32_t) ((((v8u32_t) {} + 1) << (v8u32_t) exponent) - 1);
+    const v8i32_t remainder = val & mask;
+
+    v8i32_t result = val >> exponent;
+    /* the comparisons give -1 where true */
+    const v8i32_t threshold = (mask >> 1) - (result < 0);
+
+    return result - (remainder > threshold);
+}
+
+/**
+ * @brief   Lane wise esp_nn_multiply_by_quantized_mult(), with a multiplier
+ *          and a shift per lane
+ */
+__NN_FORCE_INLINE__ v8i32_t simd_multiply_by_quantized_mult(v8i32_t x, v8i32_t mult, v8i32_t shift)
+{
+    const v8i32_t positive = shift > 0;
+    const v8i32_t left_shift = positive & shift;
+    const v8i32_t right_shift = ~positive & -shift;
+    const v8i32_t result = simd_sat_round_doubling_high_mul(x << left_shift, mult);
+    return simd_div_by_power_of_two(result, right_shift);
+}
+
+/**
+ * @brief   Requantize 8 accumulators: rescale, add the output offset and clamp.
+ */
+__NN_FORCE_INLINE__ v8i32_t simd_requantize(v8i32_t acc,
+                                            v8i32_t mult,
+                                            v8i32_t shift,
+                                            const int32_t out_offset,
+                                            const int32_t activation_min,
+                                            const int32_t activation_max)
+{
+    acc = simd_multiply_by_quantized_mult(acc, mult, shift) + out_offset;
+    acc = simd_max(acc, (v8i32_t) {} + activation_min);
+    return simd_min(acc, (v8i32_t) {} + activation_max);
+}
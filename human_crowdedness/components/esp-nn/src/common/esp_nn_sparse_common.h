@@ -0,0 +1,57 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * Sparse weights of the fully connected and 1x1 convolution kernels, see
+ * sparse_s8_t in esp_nn_defs.h.
+ *
+ * The filter, one row of `row_len` values per output channel, keeps only its
+ * values other than 0 (CSR), in three arrays that are encoded once, offline,
+ * and read where they are, in flash:
+ *
+ *      int32_t             row_start[rows + 1] first value of every row
+ *      uint8_t/uint16_t    cols[values]        column of every value, 1 byte
+ *                                              for rows up to 256 long
+ *      int8_t              values[values]
+ *
+ * The kernels multiply the inputs as they are and add `input_offset` times the
+ * sum of the values of a row at its end, the sum taken along the way, so that
+ * nothing of the filter has to be in RAM.
+ */
+
+#include <stdint.h>
+
+#include <common_functions.h>
+#include <esp_nn_defs.h>
+
+/**
+ * Filters with fewer zero weights than this percentage are left dense. A kept
+ * weight takes 2 bytes with its 1 byte column, so half of zeros is where the
+ * sparse filter starts to be smaller than the dense one. At 60%, it is 0.8 of
+ * its size and 0.4 of its multiplications.
+ */
+#define ESP_NN_SPARSE_MIN_ZERO_WEIGHTS 50
+
+__NN_FORCE_INLINE__ int32_t esp_nn_sparse_s8_col_size(int32_t row_len)
+{
+    return row_len <= UINT8_MAX + 1 ? 1 : 2;
+}
+
+__NN_FORCE_INLINE__ int32_t esp_nn_sparse_s8_size(int32_t rows, int32_t row_len, int32_t nonzeros)
+{
+    return (rows + 1) * sizeof(int32_t) +
+           nonzeros * (esp_nn_sparse_s8_col_size(row_len) + sizeof(int8_t));
+}
@@ -29,6 +29,30 @@ void esp_nn_set_conv_scratch_buf_ansi(const void *buf)
 
 }
 
+int esp_nn_get_conv_prepared_size_ansi(const data_dims_t *input_dims,
+                                       const data_dims_t *filter_dims,
+                                       const data_dims_t *output_dims,
+                                       const conv_params_t *conv_params)
+{
+    return 0;
+}
+
+void esp_nn_prepare_conv_s8_ansi(const data_dims_t *input_dims,
+                                 const data_dims_t *filter_dims,
+                                 const int8_t *filter_data,
+                                 const int32_t *bias,
+                                 const data_dims_t *output_dims,
+                                 const conv_params_t *conv_params,
+                                 void *prepared)
+{
+
+}
+
+void esp_nn_set_conv_prepared_buf_ansi(const void *buf)
+{
+
+}
+
 /**
  * Assumption 1: i/p channels == o/p channels
  * Assumption 2: Pointers are valid
@@ -177,3 +201,76 @@ void esp_nn_conv_s8_ansi(const data_dims_t *input_dims,
         }
     }
 }
+
+/**
+ * int16 activations, int8 weights.
+ * Zero points of int16 tensors are 0, the offsets of conv_params are unused.
+ */
+void esp_nn_conv_s16_ansi(const data_dims_t *input_dims,
+                          const int16_t *input_data,
+                          const data_dims_t *filter_dims,
+                          const int8_t *filter_data,
+                          const int64_t *bias,
+                          const data_dims_t *output_dims,
+                          int16_t *out_data,
+                          const conv_params_t *conv_params,
+                          const quant_data_t *quant_data)
+{
+    const uint16_t input_wd = input_dims->width;
+    const uint16_t input_ht = input_dims->height;
+    const uint16_t in_channels = input_dims->channels;
+    const uint16_t pad_wd = conv_params->padding.width;
+    const uint16_t pad_ht = conv_params->padding.height;
+    const uint16_t stride_wd = conv_params->stride.width;
+    const uint16_t stride_ht = conv_params->stride.height;
+    const uint16_t filter_wd = filter_dims->width;
+    const uint16_t filter_ht = filter_dims->height;
+    const uint16_t out_wd = output_dims->width;
+    const uint16_t out_ht = output_dims->height;
+    const uint16_t out_channels = output_dims->channels;
+    const int32_t *out_shift = quant_data->shift;
+    const int32_t *out_mult = quant_data->mult;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+
+    int32_t out_ch_idx, out_y, out_x, in_ch_idx, filter_y_idx, filter_x_idx;
+
+    for (out_y = 0; out_y < out_ht; out_y++) {
+        for (out_x = 0; out_x < out_wd; out_x++) {
+            for (out_ch_idx = 0; out_ch_idx < out_channels; out_ch_idx++) {
+                int64_t conv_out = 0;
+
+                const int32_t base_y = stride_ht * out_y - pad_ht;
+                const int32_t base_x = stride_wd * out_x - pad_wd;
+
+                const int32_t filter_y_start = max(0, -base_y);
+                const int32_t filter_x_start = max(0, -base_x);
+
+                const int32_t filter_y_end = min(filter_ht, input_ht - base_y);
+                const int32_t filter_x_end = min(filter_wd, input_wd - base_x);
+
+                for (filter_y_idx = filter_y_start; filter_y_idx < filter_y_end; filter_y_idx++) {
+                    for (filter_x_idx = filter_x_start; filter_x_idx < filter_x_end; filter_x_idx++) {
+                        const int32_t in_row = base_y + filter_y_idx;
+                        const int32_t in_col = base_x + filter_x_idx;
+                        int32_t input_base_offset = (in_row * input_wd + in_col) * in_channels;
+                        int32_t filter_base_offset = out_ch_idx * in_channels * filter_ht * filter_wd +
+                                                       (filter_y_idx * filter_wd + filter_x_idx) * in_channels;
+                        for (in_ch_idx = 0; in_ch_idx < in_channels; in_ch_idx++) {
+                            conv_out += (int64_t) input_data[input_base_offset + in_ch_idx] *
+                                        filter_data[filter_base_offset + in_ch_idx];
+                        }
+                    }
+                }
+                if (bias) {
+                    conv_out += bias[out_ch_idx];
+                }
+                int32_t result = esp_nn_multiply_by_quantized_mult_s64(conv_out, out_mult[out_ch_idx],
+                                                                       out_shift[out_ch_idx]);
+                result = max(result, activation_min);
+                result = min(result, activation_max);
+                *out_data++ = (int16_t) result;
+            }
+        }
+    }
+}
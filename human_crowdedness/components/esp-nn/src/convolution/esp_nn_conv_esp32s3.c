@@ -51,7 +51,7 @@
 
 #include <common_functions.h>
 
-static int16_t *scratch_buffer = NULL;
+static __NN_THREAD_LOCAL__ int16_t *scratch_buffer = NULL;
 
 extern void esp_nn_conv_s8_mult8_1x1_esp32s3(
                 const int8_t *input_data,
@@ -12,21 +12,294 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+/**
+ * Optimizations strategies used:
+ *
+ * The convolution is run as a matrix multiplication of the filter, one row of
+ * `filter_wd * filter_ht * in_ch` values per output channel, by the input
+ * patches, one row of the same length per output pixel:
+ *
+ * 1. For filter wdxht = 1x1, the patch of a pixel is already a contiguous row
+ *      of the input, so it is used as it is.
+ * 2. For all other filters, the patches of 4 output pixels at a time are
+ *      copied into contiguous rows of the scratch buffer (im2col). Padding is
+ *      filled with -input_offset, which cancels out below.
+ *
+ * The multiplication is done in blocks of 4 output channels x 4 pixels, so that
+ * every input and filter value loaded is used 4 times.
+ *
+ *      About the input offset:
+ *          > The conv operation before requantization is as follows:
+ *              for i in filter_size:
+ *                  conv_out += (input + input_offset) * filter;
+ *              conv_out += bias
+ *          > which is the same as:
+ *              for i in filter_size:
+ *                  conv_out += input * filter;
+ *              conv_out += input_offset * sum(filter) + bias
+ *          > the second term depends on the weights only, so it is computed
+ *              once per output channel by esp_nn_prepare_conv_s8_opt(), when
+ *              the model is loaded, and kept in the prepared buffer.
+ *
+ * The filter is kept in its OHWI layout, which already is one contiguous row
+ * per output channel. A repacked copy would have to live in RAM next to the
+ * weights in flash, which costs more than the model's arena.
+ *
+ * Without a prepared buffer, or without a scratch buffer for the im2col rows,
+ * the direct loops below are used.
+ *
+ * int16 activations (esp_nn_conv_s16_opt) have no offset and need no buffer:
+ * 4 output channels at a time are dotted with the part of every filter row
+ * that is inside the input, which is contiguous in both. The products are
+ * summed in 32 bits, ESP_NN_S16_DOT_CHUNK at a time, instead of 64.
+ */
+
+#include <string.h>
+
 #include <esp_nn_defs.h>
 
 #include <common_functions.h>
 
+/* output pixels and channels of a block of the multiplication */
+#define CONV_BLOCK_PIXELS   4
+#define CONV_BLOCK_CHANNELS 4
+
+static __NN_THREAD_LOCAL__ void *scratch_buffer = NULL;
+static __NN_THREAD_LOCAL__ const int32_t *prepared_buffer = NULL;
+
 int esp_nn_get_conv_scratch_size_opt(const data_dims_t *input_dims,
                                      const data_dims_t *filter_dims,
                                      const data_dims_t *output_dims,
                                      const conv_params_t *conv_params)
 {
-    return 0;
+    const int32_t filter_wd = filter_dims->width;
+    const int32_t filter_ht = filter_dims->height;
+    const int32_t in_channels = input_dims->channels;
+
+    if (filter_wd == 1 && filter_ht == 1) {
+        return 0;
+    }
+
+    /* im2col rows of a block of pixels */
+    return CONV_BLOCK_PIXELS * filter_wd * filter_ht * in_channels;
 }
 
 void esp_nn_set_conv_scratch_buf_opt(const void *buf)
 {
+    scratch_buffer = (void *) buf;
+}
+
+int esp_nn_get_conv_prepared_size_opt(const data_dims_t *input_dims,
+                                      const data_dims_t *filter_dims,
+                                      const data_dims_t *output_dims,
+                                      const conv_params_t *conv_params)
+{
+    /* per channel `input_offset * sum(filter) + bias` */
+    return output_dims->channels * sizeof(int32_t);
+}
+
+void esp_nn_prepare_conv_s8_opt(const data_dims_t *input_dims,
+                                const data_dims_t *filter_dims,
+                                const int8_t *filter_data,
+                                const int32_t *bias,
+                                const data_dims_t *output_dims,
+                                const conv_params_t *conv_params,
+                                void *prepared)
+{
+    const int32_t row_len = filter_dims->width * filter_dims->height * input_dims->channels;
+    int32_t *corr = (int32_t *) prepared;
+
+    for (int32_t out_ch_idx = 0; out_ch_idx < output_dims->channels; out_ch_idx++) {
+        int32_t sum = 0;
+        for (int32_t i = 0; i < row_len; i++) {
+            sum += *filter_data++;
+        }
+        corr[out_ch_idx] = sum * conv_params->in_offset + (bias ? bias[out_ch_idx] : 0);
+    }
+}
+
+void esp_nn_set_conv_prepared_buf_opt(const void *buf)
+{
+    prepared_buffer = (const int32_t *) buf;
+}
 
+__NN_FORCE_INLINE__ int8_t esp_nn_conv_s8_requant(int32_t conv_out,
+                                                  const int32_t mult,
+                                                  const int32_t shift,
+                                                  const int32_t out_offset,
+                                                  const int32_t activation_min,
+                                                  const int32_t activation_max)
+{
+    conv_out = esp_nn_multiply_by_quantized_mult_fast(conv_out, mult, shift);
+    conv_out += out_offset;
+    conv_out = max(conv_out, activation_min);
+    conv_out = min(conv_out, activation_max);
+    return (int8_t) conv_out;
+}
+
+/**
+ * @brief Multiply the filter by the rows of up to 4 output pixels.
+ *
+ * @param rows      input row of every pixel, each `row_len` long
+ * @param pixels    number of pixels, 1 to 4
+ * @param out_data  output of the first pixel, the rest follow it
+ */
+__attribute__ ((noinline))
+static void esp_nn_conv_s8_gemm(const int8_t *rows[CONV_BLOCK_PIXELS],
+                                const int32_t pixels,
+                                const int8_t *filter_data,
+                                const int32_t row_len,
+                                const int32_t *corr,
+                                int8_t *out_data,
+                                const int32_t out_channels,
+                                const int32_t out_offset,
+                                const quant_data_t *quant_data,
+                                const int32_t activation_min,
+                                const int32_t activation_max)
+{
+    const int32_t *out_mult = quant_data->mult;
+    const int32_t *out_shift = quant_data->shift;
+    int32_t out_ch_idx = 0;
+
+    if (pixels == CONV_BLOCK_PIXELS) {
+        const int8_t *in0 = rows[0];
+        const int8_t *in1 = rows[1];
+        const int8_t *in2 = rows[2];
+        const int8_t *in3 = rows[3];
+
+        for (; out_ch_idx < out_channels - (CONV_BLOCK_CHANNELS - 1); out_ch_idx += CONV_BLOCK_CHANNELS) {
+            const int8_t *f0 = filter_data + out_ch_idx * row_len;
+            const int8_t *f1 = f0 + row_len;
+            const int8_t *f2 = f1 + row_len;
+            const int8_t *f3 = f2 + row_len;
+
+            int32_t acc00 = 0, acc01 = 0, acc02 = 0, acc03 = 0;
+            int32_t acc10 = 0, acc11 = 0, acc12 = 0, acc13 = 0;
+            int32_t acc20 = 0, acc21 = 0, acc22 = 0, acc23 = 0;
+            int32_t acc30 = 0, acc31 = 0, acc32 = 0, acc33 = 0;
+
+            for (int32_t i = 0; i < row_len; i++) {
+                const int32_t i0 = in0[i], i1 = in1[i], i2 = in2[i], i3 = in3[i];
+                int32_t w = f0[i];
+                acc00 += i0 * w; acc01 += i1 * w; acc02 += i2 * w; acc03 += i3 * w;
+                w = f1[i];
+                acc10 += i0 * w; acc11 += i1 * w; acc12 += i2 * w; acc13 += i3 * w;
+                w = f2[i];
+                acc20 += i0 * w; acc21 += i1 * w; acc22 += i2 * w; acc23 += i3 * w;
+                w = f3[i];
+                acc30 += i0 * w; acc31 += i1 * w; acc32 += i2 * w; acc33 += i3 * w;
+            }
+
+            const int32_t acc[CONV_BLOCK_CHANNELS][CONV_BLOCK_PIXELS] = {
+                {acc00, acc01, acc02, acc03},
+                {acc10, acc11, acc12, acc13},
+                {acc20, acc21, acc22, acc23},
+                {acc30, acc31, acc32, acc33},
+            };
+            for (int32_t ch = 0; ch < CONV_BLOCK_CHANNELS; ch++) {
+                const int32_t out_ch = out_ch_idx + ch;
+                for (int32_t pix = 0; pix < CONV_BLOCK_PIXELS; pix++) {
+                    out_data[pix * out_channels + out_ch] =
+                        esp_nn_conv_s8_requant(acc[ch][pix] + corr[out_ch], out_mult[out_ch], out_shift[out_ch],
+                                               out_offset, activation_min, activation_max);
+                }
+            }
+        }
+    }
+
+    /* leftover channels, or a block with fewer pixels */
+    for (; out_ch_idx < out_channels; out_ch_idx++) {
+        const int8_t *filter_ptr = filter_data + out_ch_idx * row_len;
+        for (int32_t pix = 0; pix < pixels; pix++) {
+            const int8_t *input_ptr = rows[pix];
+            int32_t conv_out = 0;
+            for (int32_t i = 0; i < row_len; i++) {
+                conv_out += input_ptr[i] * filter_ptr[i];
+            }
+            out_data[pix * out_channels + out_ch_idx] =
+                esp_nn_conv_s8_requant(conv_out + corr[out_ch_idx], out_mult[out_ch_idx], out_shift[out_ch_idx],
+                                       out_offset, activation_min, activation_max);
+        }
+    }
+}
+
+/**
+ * @brief Convolution as a blocked matrix multiplication, see the top of the file.
+ *
+ * @param corr      the prepared buffer
+ * @param col_buf   at least esp_nn_get_conv_scratch_size_opt() bytes, unused for 1x1
+ */
+static void esp_nn_conv_s8_blocked(const data_dims_t *input_dims,
+                                   const int8_t *input_data,
+                                   const data_dims_t *filter_dims,
+                                   const int8_t *filter_data,
+                                   const int32_t *corr,
+                                   const data_dims_t *output_dims,
+                                   int8_t *out_data,
+                                   const conv_params_t *conv_params,
+                                   const quant_data_t *quant_data,
+                                   int8_t *col_buf)
+{
+    const int32_t input_wd = input_dims->width;
+    const int32_t input_ht = input_dims->height;
+    const int32_t in_channels = input_dims->channels;
+    const int32_t input_offset = conv_params->in_offset;
+    const int32_t out_offset = conv_params->out_offset;
+    const int32_t pad_wd = conv_params->padding.width;
+    const int32_t pad_ht = conv_params->padding.height;
+    const int32_t stride_wd = conv_params->stride.width;
+    const int32_t stride_ht = conv_params->stride.height;
+    const int32_t filter_wd = filter_dims->width;
+    const int32_t filter_ht = filter_dims->height;
+    const int32_t out_wd = output_dims->width;
+    const int32_t out_ht = output_dims->height;
+    const int32_t out_channels = output_dims->channels;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+
+    const int32_t row_len = filter_wd * filter_ht * in_channels;
+    const int32_t out_pixels = out_wd * out_ht;
+    const int32_t is_1x1 = filter_wd == 1 && filter_ht == 1;
+
+    /* input value whose (input + input_offset) is 0, always in int8 range */
+    const int8_t pad_value = (int8_t) -input_offset;
+
+    const int8_t *rows[CONV_BLOCK_PIXELS];
+    for (int32_t pix_idx = 0; pix_idx < out_pixels; pix_idx += CONV_BLOCK_PIXELS) {
+        const int32_t pixels = min(CONV_BLOCK_PIXELS, out_pixels - pix_idx);
+
+        for (int32_t pix = 0; pix < pixels; pix++) {
+            const int32_t out_y = (pix_idx + pix) / out_wd;
+            const int32_t out_x = (pix_idx + pix) % out_wd;
+            const int32_t base_y = stride_ht * out_y - pad_ht;
+            const int32_t base_x = stride_wd * out_x - pad_wd;
+
+            if (is_1x1) {
+                rows[pix] = input_data + (base_y * input_wd + base_x) * in_channels;
+                continue;
+            }
+
+            /* im2col: the patch of this pixel in (y, x, ch) order, as the filter */
+            int8_t *col_ptr = col_buf + pix * row_len;
+            for (int32_t filter_y_idx = 0; filter_y_idx < filter_ht; filter_y_idx++) {
+                const int32_t in_row = base_y + filter_y_idx;
+                for (int32_t filter_x_idx = 0; filter_x_idx < filter_wd; filter_x_idx++) {
+                    const int32_t in_col = base_x + filter_x_idx;
+                    if (in_row < 0 || in_row >= input_ht || in_col < 0 || in_col >= input_wd) {
+                        memset(col_ptr, pad_value, in_channels);
+                    } else {
+                        memcpy(col_ptr, input_data + (in_row * input_wd + in_col) * in_channels, in_channels);
+                    }
+                    col_ptr += in_channels;
+                }
+            }
+            rows[pix] = col_buf + pix * row_len;
+        }
+
+        esp_nn_conv_s8_gemm(rows, pixels, filter_data, row_len, corr,
+                            out_data + pix_idx * out_channels, out_channels, out_offset,
+                            quant_data, activation_min, activation_max);
+    }
 }
 
 __attribute__ ((noinline))
@@ -104,7 +377,15 @@ void esp_nn_conv_s8_opt(const data_dims_t *input_dims,
     const uint16_t filter_wd = filter_dims->width;
     const uint16_t filter_ht = filter_dims->height;
 
-    if (filter_wd == 1 && filter_ht == 1) {
+    const int32_t is_1x1 = filter_wd == 1 && filter_ht == 1;
+
+    if (prepared_buffer && (is_1x1 || scratch_buffer)) {
+        esp_nn_conv_s8_blocked(input_dims, input_data, filter_dims, filter_data, prepared_buffer,
+                               output_dims, out_data, conv_params, quant_data, (int8_t *) scratch_buffer);
+        return;
+    }
+
+    if (is_1x1) {
         esp_nn_conv_s8_1x1(input_dims, input_data, filter_data, bias,
                            output_dims, out_data, conv_params, quant_data);
         return;
@@ -177,3 +458,95 @@ void esp_nn_conv_s8_opt(const data_dims_t *input_dims,
         }
     }
 }
+
+__NN_FORCE_INLINE__ int16_t esp_nn_conv_s16_requant(int64_t conv_out,
+                                                    const int32_t mult,
+                                                    const int32_t shift,
+                                                    const int32_t activation_min,
+                                                    const int32_t activation_max)
+{
+    int32_t result = esp_nn_multiply_by_quantized_mult_s64(conv_out, mult, shift);
+    result = max(result, activation_min);
+    result = min(result, activation_max);
+    return (int16_t) result;
+}
+
+void esp_nn_conv_s16_opt(const data_dims_t *input_dims,
+                         const int16_t *input_data,
+                         const data_dims_t *filter_dims,
+                         const int8_t *filter_data,
+                         const int64_t *bias,
+                         const data_dims_t *output_dims,
+                         int16_t *out_data,
+                         const conv_params_t *conv_params,
+                         const quant_data_t *quant_data)
+{
+    const int32_t input_wd = input_dims->width;
+    const int32_t input_ht = input_dims->height;
+    const int32_t in_channels = input_dims->channels;
+    const int32_t pad_wd = conv_params->padding.width;
+    const int32_t pad_ht = conv_params->padding.height;
+    const int32_t stride_wd = conv_params->stride.width;
+    const int32_t stride_ht = conv_params->stride.height;
+    const int32_t filter_wd = filter_dims->width;
+    const int32_t filter_ht = filter_dims->height;
+    const int32_t out_wd = output_dims->width;
+    const int32_t out_ht = output_dims->height;
+    const int32_t out_channels = output_dims->channels;
+    const int32_t *out_shift = quant_data->shift;
+    const int32_t *out_mult = quant_data->mult;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+
+    const int32_t row_len = filter_wd * filter_ht * in_channels;
+
+    for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+        const int32_t base_y = stride_ht * out_y - pad_ht;
+        const int32_t filter_y_start = max(0, -base_y);
+        const int32_t filter_y_end = min(filter_ht, input_ht - base_y);
+
+        for (int32_t out_x = 0; out_x < out_wd; out_x++) {
+            const int32_t base_x = stride_wd * out_x - pad_wd;
+            const int32_t filter_x_start = max(0, -base_x);
+            const int32_t filter_x_end = min(filter_wd, input_wd - base_x);
+            /* the columns of a filter row inside the input, contiguous */
+            const int32_t seg_len = (filter_x_end - filter_x_start) * in_channels;
+            const int16_t *input_base = input_data +
+                            ((base_y + filter_y_start) * input_wd + base_x + filter_x_start) * in_channels;
+            const int32_t filter_base = (filter_y_start * filter_wd + filter_x_start) * in_channels;
+
+            int32_t out_ch_idx = 0;
+            for (; out_ch_idx < out_channels - 3; out_ch_idx += 4) {
+                int64_t acc[4] = {0, 0, 0, 0};
+                const int16_t *input_ptr = input_base;
+                const int8_t *filter_ptr = filter_data + out_ch_idx * row_len + filter_base;
+                for (int32_t filter_y_idx = filter_y_start; filter_y_idx < filter_y_end; filter_y_idx++) {
+                    esp_nn_dot_s16_s8_x4(input_ptr, filter_ptr, row_len, seg_len, acc);
+                    input_ptr += input_wd * in_channels;
+                    filter_ptr += filter_wd * in_channels;
+                }
+                for (int32_t ch = 0; ch < 4; ch++) {
+                    const int32_t out_ch = out_ch_idx + ch;
+                    if (bias) {
+                        acc[ch] += bias[out_ch];
+                    }
+                    out_data[out_ch] = esp_nn_conv_s16_requant(acc[ch], out_mult[out_ch], out_shift[out_ch],
+                                                               activation_min, activation_max);
+                }
+            }
+            for (; out_ch_idx < out_channels; out_ch_idx++) {
+                int64_t acc = bias ? bias[out_ch_idx] : 0;
+                const int16_t *input_ptr = input_base;
+                const int8_t *filter_ptr = filter_data + out_ch_idx * row_len + filter_base;
+                for (int32_t filter_y_idx = filter_y_start; filter_y_idx < filter_y_end; filter_y_idx++) {
+                    acc = esp_nn_dot_s16_s8(input_ptr, filter_ptr, seg_len, acc);
+                    input_ptr += input_wd * in_channels;
+                    filter_ptr += filter_wd * in_channels;
+                }
+                out_data[out_ch_idx] = esp_nn_conv_s16_requant(acc, out_mult[out_ch_idx], out_shift[out_ch_idx],
+                                                               activation_min, activation_max);
+            }
+            out_data += out_channels;
+        }
+    }
+}
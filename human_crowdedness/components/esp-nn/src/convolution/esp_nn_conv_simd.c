@@ -0,0 +1,262 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Optimizations strategies used:
+ *
+ * The same matrix multiplication as esp_nn_conv_opt.c, with the same scratch
+ * (im2col rows of 4 pixels) and prepared buffer (per channel
+ * `input_offset * sum(filter) + bias`), so that the sizes and the prepare
+ * function of the generic kernel are used as they are.
+ *
+ * 1. The rows of 2 pixels are multiplied by the rows of 4 output channels at a
+ *      time, 8 values of each per step, into 8 vector accumulators.
+ * 2. The sums of a run of output channels are requantized 8 at a time.
+ *
+ * Without the buffers, the generic kernel is used.
+ */
+
+#include <esp_nn_defs.h>
+#include <esp_nn_ansi_headers.h>
+
+#include <esp_nn_simd_common.h>
+
+/* output pixels of an im2col block, as esp_nn_get_conv_scratch_size_opt() */
+#define CONV_BLOCK_PIXELS   4
+/* output channels requantized together */
+#define CONV_CHANNEL_RUN    32
+
+static __NN_THREAD_LOCAL__ void *scratch_buffer = NULL;
+static __NN_THREAD_LOCAL__ const int32_t *prepared_buffer = NULL;
+
+void esp_nn_set_conv_scratch_buf_simd(const void *buf)
+{
+    scratch_buffer = (void *) buf;
+    esp_nn_set_conv_scratch_buf_opt(buf);
+}
+
+void esp_nn_set_conv_prepared_buf_simd(const void *buf)
+{
+    prepared_buffer = (const int32_t *) buf;
+    esp_nn_set_conv_prepared_buf_opt(buf);
+}
+
+__NN_FORCE_INLINE__ int32_t esp_nn_conv_s8_dot_simd(const int8_t *in, const int8_t *filter, const int32_t len)
+{
+    v8i32_t acc = {};
+    int32_t i = 0;
+    for (; i <= len - SIMD_LANES; i += SIMD_LANES) {
+        acc += simd_mul_s8(simd_load_v8i8(in + i), simd_load_v8i8(filter + i));
+    }
+    int32_t sum = simd_hsum(acc);
+    for (; i < len; i++) {
+        sum += in[i] * filter[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief Requantize the sums of `count` output channels of a pixel.
+ */
+__NN_FORCE_INLINE__ void esp_nn_conv_s8_requant_run_simd(const int32_t *sums,
+                                                         const int32_t *corr,
+                                                         const int32_t *out_mult,
+                                                         const int32_t *out_shift,
+                                                         const int32_t count,
+                                                         int8_t *out_data,
+                                                         const int32_t out_offset,
+                                                         const int32_t activation_min,
+                                                         const int32_t activation_max)
+{
+    int32_t i = 0;
+    for (; i <= count - SIMD_LANES; i += SIMD_LANES) {
+        v8i32_t acc = simd_load_v8i32(sums + i) + simd_load_v8i32(corr + i);
+        acc = simd_requantize(acc, simd_load_v8i32(out_mult + i), simd_load_v8i32(out_shift + i),
+                              out_offset, activation_min, activation_max);
+        simd_store_s8(out_data + i, acc);
+    }
+    for (; i < count; i++) {
+        int32_t result = esp_nn_multiply_by_quantized_mult(sums[i] + corr[i], out_mult[i], out_shift[i]);
+        result += out_offset;
+        result = max(result, activation_min);
+        result = min(result, activation_max);
+        out_data[i] = (int8_t) result;
+    }
+}
+
+/**
+ * @brief Multiply the filter by the rows of up to 4 output pixels.
+ */
+__NN_FORCE_INLINE__ void esp_nn_conv_s8_gemm_simd(const int8_t *rows[CONV_BLOCK_PIXELS],
+                                                  const int32_t pixels,
+                                                  const int8_t *filter_data,
+                                                  const int32_t row_len,
+                                                  const int32_t *corr,
+                                                  int8_t *out_data,
+                                                  const int32_t out_channels,
+                                                  const int32_t out_offset,
+                                                  const quant_data_t *quant_data,
+                                                  const int32_t activation_min,
+                                                  const int32_t activation_max)
+{
+    int32_t sums[2][CONV_CHANNEL_RUN];
+    int32_t pix = 0;
+
+    for (; pix < pixels; pix += 2) {
+        const int32_t pair = pix + 1 < pixels;
+        const int8_t *in0 = rows[pix];
+        const int8_t *in1 = pair ? rows[pix + 1] : rows[pix];
+        int8_t *out0 = out_data + pix * out_channels;
+        int8_t *out1 = out0 + out_channels;
+
+        for (int32_t run = 0; run < out_channels; run += CONV_CHANNEL_RUN) {
+            const int32_t run_len = min(CONV_CHANNEL_RUN, out_channels - run);
+            int32_t ch = 0;
+
+            for (; ch <= run_len - 4; ch += 4) {
+                const int8_t *f0 = filter_data + (run + ch) * row_len;
+                const int8_t *f1 = f0 + row_len;
+                const int8_t *f2 = f1 + row_len;
+                const int8_t *f3 = f2 + row_len;
+
+                v8i32_t acc00 = {}, acc01 = {}, acc10 = {}, acc11 = {};
+                v8i32_t acc20 = {}, acc21 = {}, acc30 = {}, acc31 = {};
+                int32_t i = 0;
+                for (; i <= row_len - SIMD_LANES; i += SIMD_LANES) {
+                    const v8i16_t i0 = simd_widen_s16(simd_load_v8i8(in0 + i));
+                    const v8i16_t i1 = simd_widen_s16(simd_load_v8i8(in1 + i));
+                    v8i16_t w = simd_widen_s16(simd_load_v8i8(f0 + i));
+                    acc00 += __builtin_convertvector(i0 * w, v8i32_t);
+                    acc01 += __builtin_convertvector(i1 * w, v8i32_t);
+                    w = simd_widen_s16(simd_load_v8i8(f1 + i));
+                    acc10 += __builtin_convertvector(i0 * w, v8i32_t);
+                    acc11 += __builtin_convertvector(i1 * w, v8i32_t);
+                    w = simd_widen_s16(simd_load_v8i8(f2 + i));
+                    acc20 += __builtin_convertvector(i0 * w, v8i32_t);
+                    acc21 += __builtin_convertvector(i1 * w, v8i32_t);
+                    w = simd_widen_s16(simd_load_v8i8(f3 + i));
+                    acc30 += __builtin_convertvector(i0 * w, v8i32_t);
+                    acc31 += __builtin_convertvector(i1 * w, v8i32_t);
+                }
+                int32_t s00 = simd_hsum(acc00), s01 = simd_hsum(acc01);
+                int32_t s10 = simd_hsum(acc10), s11 = simd_hsum(acc11);
+                int32_t s20 = simd_hsum(acc20), s21 = simd_hsum(acc21);
+                int32_t s30 = simd_hsum(acc30), s31 = simd_hsum(acc31);
+                for (; i < row_len; i++) {
+                    const int32_t i0 = in0[i], i1 = in1[i];
+                    s00 += i0 * f0[i]; s01 += i1 * f0[i];
+                    s10 += i0 * f1[i]; s11 += i1 * f1[i];
+                    s20 += i0 * f2[i]; s21 += i1 * f2[i];
+                    s30 += i0 * f3[i]; s31 += i1 * f3[i];
+                }
+                sums[0][ch + 0] = s00; sums[1][ch + 0] = s01;
+                sums[0][ch + 1] = s10; sums[1][ch + 1] = s11;
+                sums[0][ch + 2] = s20; sums[1][ch + 2] = s21;
+                sums[0][ch + 3] = s30; sums[1][ch + 3] = s31;
+            }
+            for (; ch < run_len; ch++) {
+                const int8_t *filter_ptr = filter_data + (run + ch) * row_len;
+                sums[0][ch] = esp_nn_conv_s8_dot_simd(in0, filter_ptr, row_len);
+                sums[1][ch] = esp_nn_conv_s8_dot_simd(in1, filter_ptr, row_len);
+            }
+
+            esp_nn_conv_s8_requant_run_simd(sums[0], corr + run, quant_data->mult + run,
+                                            quant_data->shift + run, run_len, out0 + run,
+                                            out_offset, activation_min, activation_max);
+            if (pair) {
+                esp_nn_conv_s8_requant_run_simd(sums[1], corr + run, quant_data->mult + run,
+                                                quant_data->shift + run, run_len, out1 + run,
+                                                out_offset, activation_min, activation_max);
+            }
+        }
+    }
+}
+
+ESP_NN_SIMD_DISPATCH
+void esp_nn_conv_s8_simd(const data_dims_t *input_dims,
+                         const int8_t *input_data,
+                         const data_dims_t *filter_dims,
+                         const int8_t *filter_data,
+                         const int32_t *bias,
+                         const data_dims_t *output_dims,
+                         int8_t *out_data,
+                         const conv_params_t *conv_params,
+                         const quant_data_t *quant_data)
+{
+    const int32_t filter_wd = filter_dims->width;
+    const int32_t filter_ht = filter_dims->height;
+    const int32_t is_1x1 = filter_wd == 1 && filter_ht == 1;
+
+    if (!prepared_buffer || (!is_1x1 && !scratch_buffer)) {
+        esp_nn_conv_s8_opt(input_dims, input_data, filter_dims, filter_data, bias,
+                           output_dims, out_data, conv_params, quant_data);
+        return;
+    }
+
+    const int32_t input_wd = input_dims->width;
+    const int32_t input_ht = input_dims->height;
+    const int32_t in_channels = input_dims->channels;
+    const int32_t input_offset = conv_params->in_offset;
+    const int32_t pad_wd = conv_params->padding.width;
+    const int32_t pad_ht = conv_params->padding.height;
+    const int32_t stride_wd = conv_params->stride.width;
+    const int32_t stride_ht = conv_params->stride.height;
+    const int32_t out_wd = output_dims->width;
+    const int32_t out_ht = output_dims->height;
+    const int32_t out_channels = output_dims->channels;
+
+    const int32_t row_len = filter_wd * filter_ht * in_channels;
+    const int32_t out_pixels = out_wd * out_ht;
+    int8_t *col_buf = (int8_t *) scratch_buffer;
+
+    /* input value whose (input + input_offset) is 0, always in int8 range */
+    const int8_t pad_value = (int8_t) -input_offset;
+
+    const int8_t *rows[CONV_BLOCK_PIXELS];
+    for (int32_t pix_idx = 0; pix_idx < out_pixels; pix_idx += CONV_BLOCK_PIXELS) {
+        const int32_t pixels = min(CONV_BLOCK_PIXELS, out_pixels - pix_idx);
+
+        for (int32_t pix = 0; pix < pixels; pix++) {
+            const int32_t out_y = (pix_idx + pix) / out_wd;
+            const int32_t out_x = (pix_idx + pix) % out_wd;
+            const int32_t base_y = stride_ht * out_y - pad_ht;
+            const int32_t base_x = stride_wd * out_x - pad_wd;
+
+            if (is_1x1) {
+                rows[pix] = input_data + (base_y * input_wd + base_x) * in_channels;
+                continue;
+            }
+
+            /* im2col: the patch of this pixel in (y, x, ch) order, as the filter */
+            int8_t *col_ptr = col_buf + pix * row_len;
+            for (int32_t filter_y_idx = 0; filter_y_idx < filter_ht; filter_y_idx++) {
+                const int32_t in_row = base_y + filter_y_idx;
+                for (int32_t filter_x_idx = 0; filter_x_idx < filter_wd; filter_x_idx++) {
+                    const int32_t in_col = base_x + filter_x_idx;
+                    if (in_row < 0 || in_row >= input_ht || in_col < 0 || in_col >= input_wd) {
+                        memset(col_ptr, pad_value, in_channels);
+                    } else {
+                        memcpy(col_ptr, input_data + (in_row * input_wd + in_col) * in_channels, in_channels);
+                    }
+                    col_ptr += in_channels;
+                }
+            }
+            rows[pix] = col_buf + pix * row_len;
+        }
+
+        esp_nn_conv_s8_gemm_simd(rows, pixels, filter_data, row_len, prepared_buffer,
+                                 out_data + pix_idx * out_channels, out_channels, conv_params->out_offset,
+                                 quant_data, conv_params->activation.min, conv_params->activation.max);
+    }
+}
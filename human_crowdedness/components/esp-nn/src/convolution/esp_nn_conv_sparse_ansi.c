@@ -0,0 +1,106 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * 1x1 convolution on sparse weights, encoded by esp_nn_encode_sparse_s8_ansi()
+ * with one row per output channel.
+ *
+ * The input channels of a pixel are a row of the input, so the convolution is
+ * the fully connected kernel run for every output pixel. Pixels are taken 4 at
+ * a time, so that every kept weight and its column are loaded, and added to
+ * the sum of the row for the input offset, once for 4 of them.
+ */
+
+#include <esp_nn_defs.h>
+
+#include <common_functions.h>
+#include <esp_nn_sparse_common.h>
+
+#define CONV_SPARSE_PIXELS 4
+
+void esp_nn_conv_1x1_sparse_s8_ansi(const data_dims_t *input_dims,
+                                    const int8_t *input_data,
+                                    const sparse_s8_t *sparse,
+                                    const int32_t *bias,
+                                    const data_dims_t *output_dims,
+                                    int8_t *out_data,
+                                    const conv_params_t *conv_params,
+                                    const quant_data_t *quant_data)
+{
+    const int32_t in_channels = input_dims->channels;
+    const int32_t out_channels = sparse->rows;
+    const int32_t in_row_size = input_dims->width * in_channels;
+    const int32_t out_wd = output_dims->width;
+    const int32_t pixels = out_wd * output_dims->height;
+    const int32_t in_offset = conv_params->in_offset;
+    const int32_t out_offset = conv_params->out_offset;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+    const int8_t *values = sparse->values;
+    const uint8_t *cols8 = (const uint8_t *) sparse->cols;
+    const uint16_t *cols16 = (const uint16_t *) sparse->cols;
+
+    for (int32_t pixel = 0; pixel < pixels; pixel += CONV_SPARSE_PIXELS) {
+        const int32_t count = min(pixels - pixel, CONV_SPARSE_PIXELS);
+
+        /* the last pixel is repeated in a block of less than 4 */
+        const int8_t *in[CONV_SPARSE_PIXELS];
+        for (int32_t i = 0; i < CONV_SPARSE_PIXELS; i++) {
+            const int32_t p = pixel + min(i, count - 1);
+            const int32_t out_y = p / out_wd;
+            const int32_t out_x = p % out_wd;
+            in[i] = input_data + out_y * conv_params->stride.height * in_row_size +
+                    out_x * conv_params->stride.width * in_channels;
+        }
+        const int8_t *in0 = in[0], *in1 = in[1], *in2 = in[2], *in3 = in[3];
+
+        for (int32_t out_ch = 0; out_ch < out_channels; out_ch++) {
+            int32_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0, sum = 0;
+            const int32_t end = sparse->row_start[out_ch + 1];
+            if (sparse->col_size == 1) {
+                for (int32_t k = sparse->row_start[out_ch]; k < end; k++) {
+                    const int32_t col = cols8[k];
+                    const int32_t w = values[k];
+                    acc0 += in0[col] * w;
+                    acc1 += in1[col] * w;
+                    acc2 += in2[col] * w;
+                    acc3 += in3[col] * w;
+                    sum += w;
+                }
+            } else {
+                for (int32_t k = sparse->row_start[out_ch]; k < end; k++) {
+                    const int32_t col = cols16[k];
+                    const int32_t w = values[k];
+                    acc0 += in0[col] * w;
+                    acc1 += in1[col] * w;
+                    acc2 += in2[col] * w;
+                    acc3 += in3[col] * w;
+                    sum += w;
+                }
+            }
+
+            const int32_t corr = sum * in_offset + (bias ? bias[out_ch] : 0);
+            const int32_t acc[CONV_SPARSE_PIXELS] = {acc0, acc1, acc2, acc3};
+            for (int32_t i = 0; i < count; i++) {
+                int32_t result = acc[i] + corr;
+                result = esp_nn_multiply_by_quantized_mult(result, quant_data->mult[out_ch],
+                                                           quant_data->shift[out_ch]);
+                result += out_offset;
+                result = max(result, activation_min);
+                result = min(result, activation_max);
+                out_data[(pixel + i) * out_channels + out_ch] = (int8_t) result;
+            }
+        }
+    }
+}
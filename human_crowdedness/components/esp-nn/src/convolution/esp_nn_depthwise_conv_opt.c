@@ -12,9 +12,36 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+/**
+ * Optimizations strategies used:
+ *
+ *      About the input offset:
+ *          > For an output pixel whose filter lies fully inside the input,
+ *              sum((input + input_offset) * filter) + bias
+ *          > is the same as
+ *              sum(input * filter) + (input_offset * sum(filter) + bias)
+ *          > where the second term depends on the weights only. It is
+ *              computed once per output channel by
+ *              esp_nn_prepare_depthwise_conv_s8_opt() and kept in the prepared
+ *              buffer, so those pixels skip the offset add of every MAC.
+ *          > Pixels on the padded border use a part of the filter only, and
+ *              keep adding the offset to every input.
+ *
+ * The filter is kept in its HWC layout, where the channels of a tap are
+ * already contiguous, as the channel loops below read them.
+ *
+ * int16 activations (esp_nn_depthwise_conv_s16_opt) have no offset. With a
+ * channel multiplier of 1, the channels are the inner loop there as well, and
+ * the sums of a chunk of channels are kept in 32 bits: a window has at most
+ * ESP_NN_S16_DOT_CHUNK taps. Other shapes take the reference path.
+ */
+
 #include <esp_nn_defs.h>
+#include <esp_nn_ansi_headers.h>
 #include <common_functions.h>
 
+static __NN_THREAD_LOCAL__ const int32_t *prepared_buffer = NULL;
+
 int esp_nn_get_depthwise_conv_scratch_size_opt(const data_dims_t *input_dims,
                                                const data_dims_t *filter_dims,
                                                const data_dims_t *output_dims,
@@ -28,133 +55,275 @@ void esp_nn_set_depthwise_conv_scratch_buf_opt(const void *buf)
 
 }
 
-/* common channel multiplier == 1 case */
-__attribute__ ((noinline))
-static void esp_nn_depthwise_conv_s8_ch_mult_1(const data_dims_t *input_dims,
-                                               const int8_t *input_data,
-                                               const data_dims_t *filter_dims,
-                                               const int8_t *filter_data,
-                                               const int32_t *bias,
-                                               const data_dims_t *output_dims,
-                                               int8_t *out_data,
-                                               const dw_conv_params_t *conv_params,
-                                               const quant_data_t *quant_data)
+int esp_nn_get_depthwise_conv_prepared_size_opt(const data_dims_t *input_dims,
+                                                const data_dims_t *filter_dims,
+                                                const data_dims_t *output_dims,
+                                                const dw_conv_params_t *conv_params)
 {
-    const uint16_t input_wd = input_dims->width;
-    const uint16_t input_ht = input_dims->height;
-    const uint16_t channels = input_dims->channels;
-    const int32_t input_offset = conv_params->in_offset;
-    const int32_t out_offset = conv_params->out_offset;
-    const uint16_t pad_wd = conv_params->padding.width;
-    const uint16_t pad_ht = conv_params->padding.height;
-    const uint16_t stride_wd = conv_params->stride.width;
-    const uint16_t stride_ht = conv_params->stride.height;
-    const uint16_t filter_wd = filter_dims->width;
-    const uint16_t filter_ht = filter_dims->height;
-    const uint16_t out_wd = output_dims->width;
-    const uint16_t out_ht = output_dims->height;
-    const int32_t activation_min = conv_params->activation.min;
-    const int32_t activation_max = conv_params->activation.max;
+    /* per channel `input_offset * sum(filter) + bias` */
+    return output_dims->channels * sizeof(int32_t);
+}
 
-    int out_idx = 0;
-    for (int out_y = 0; out_y < out_ht; out_y++) { //height loop
-        const int16_t base_y = (out_y * stride_ht) - pad_ht;
-        for (int out_x = 0; out_x < out_wd; out_x++) { //width_loop
-            const int16_t base_x = (out_x * stride_wd) - pad_wd;
+void esp_nn_prepare_depthwise_conv_s8_opt(const data_dims_t *input_dims,
+                                          const data_dims_t *filter_dims,
+                                          const int8_t *filter_data,
+                                          const int32_t *bias,
+                                          const data_dims_t *output_dims,
+                                          const dw_conv_params_t *conv_params,
+                                          void *prepared)
+{
+    const int32_t out_channels = output_dims->channels;
+    const int32_t filter_size = filter_dims->width * filter_dims->height;
+    int32_t *corr = (int32_t *) prepared;
+
+    for (int32_t out_ch_idx = 0; out_ch_idx < out_channels; out_ch_idx++) {
+        int32_t sum = 0;
+        for (int32_t i = 0; i < filter_size; i++) {
+            sum += filter_data[i * out_channels + out_ch_idx];
+        }
+        corr[out_ch_idx] = sum * conv_params->in_offset + (bias ? bias[out_ch_idx] : 0);
+    }
+}
 
-            const int32_t *out_shift = quant_data->shift;
-            const int32_t *out_mult = quant_data->mult;
+void esp_nn_set_depthwise_conv_prepared_buf_opt(const void *buf)
+{
+    prepared_buffer = (const int32_t *) buf;
+}
 
-            /* Select filter so as the point doesn't lie outside block */
-            int filter_y_start = max(0, -base_y);
-            int filter_x_start = max(0, -base_x);
-            int filter_y_end = min(filter_ht, input_ht - base_y);
-            int filter_x_end = min(filter_wd, input_wd - base_x);
-
-            int ch_idx = 0;
-            for (; ch_idx < channels - 3; ch_idx += 4) {//channel_loop
-                int32_t result0 = 0;
-                int32_t result1 = 0;
-                int32_t result2 = 0;
-                int32_t result3 = 0;
-
-                for (int filter_y_idx = filter_y_start; filter_y_idx < filter_y_end; filter_y_idx++) {
-                    const int32_t idx_y = base_y + filter_y_idx;
-                    for (int filter_x_idx = filter_x_start; filter_x_idx < filter_x_end; filter_x_idx++) {
-                        const int32_t idx_x = base_x + filter_x_idx;
-                        int32_t input_index = (idx_y * input_wd + idx_x) * channels + ch_idx;
-                        int32_t filter_index = (filter_y_idx * filter_wd + filter_x_idx) * (channels) + ch_idx;
-                        int32_t input_val0 = input_data[input_index + 0] + input_offset;
-                        int32_t input_val1 = input_data[input_index + 1] + input_offset;
-                        int32_t input_val2 = input_data[input_index + 2] + input_offset;
-                        int32_t input_val3 = input_data[input_index + 3] + input_offset;
-                        int32_t filter_val0 = filter_data[filter_index + 0];
-                        int32_t filter_val1 = filter_data[filter_index + 1];
-                        int32_t filter_val2 = filter_data[filter_index + 2];
-                        int32_t filter_val3 = filter_data[filter_index + 3];
-                        result0 += input_val0 * filter_val0;
-                        result1 += input_val1 * filter_val1;
-                        result2 += input_val2 * filter_val2;
-                        result3 += input_val3 * filter_val3;
-                    }
-                }
-                if (bias) {
-                    result0 += bias[ch_idx + 0];
-                    result1 += bias[ch_idx + 1];
-                    result2 += bias[ch_idx + 2];
-                    result3 += bias[ch_idx + 3];
-                }
-                result0 = esp_nn_multiply_by_quantized_mult_fast(result0, *out_mult++, *out_shift++);
-                result1 = esp_nn_multiply_by_quantized_mult_fast(result1, *out_mult++, *out_shift++);
-                result2 = esp_nn_multiply_by_quantized_mult_fast(result2, *out_mult++, *out_shift++);
-                result3 = esp_nn_multiply_by_quantized_mult_fast(result3, *out_mult++, *out_shift++);
-
-                result0 += out_offset;
-                result1 += out_offset;
-                result2 += out_offset;
-                result3 += out_offset;
-
-                result0 = max(result0, activation_min);
-                result1 = max(result1, activation_min);
-                result2 = max(result2, activation_min);
-                result3 = max(result3, activation_min);
-
-                result0 = min(result0, activation_max);
-                result1 = min(result1, activation_max);
-                result2 = min(result2, activation_max);
-                result3 = min(result3, activation_max);
-
-                out_data[out_idx++] = result0;
-                out_data[out_idx++] = result1;
-                out_data[out_idx++] = result2;
-                out_data[out_idx++] = result3;
+/**
+ * @brief Window of the filter that lies inside the input, for one output pixel.
+ */
+typedef struct {
+    int32_t base_y;
+    int32_t base_x;
+    int32_t y_start;
+    int32_t y_end;
+    int32_t x_start;
+    int32_t x_end;
+} dw_window_t;
+
+/**
+ * @brief All the channels of one output pixel, channel multiplier 1.
+ *
+ * @param input_offset  added to every input, 0 with a prepared `addend`
+ * @param addend        added to every result, the bias or the prepared buffer
+ *
+ * Always inlined, so the calls with an input_offset of 0 drop the add.
+ */
+__NN_FORCE_INLINE__ int8_t *esp_nn_depthwise_conv_s8_ch_mult_1_pixel(const int8_t *input_data,
+                                                                     const int8_t *filter_data,
+                                                                     const int32_t *addend,
+                                                                     int8_t *out_data,
+                                                                     const dw_window_t *win,
+                                                                     const int32_t input_wd,
+                                                                     const int32_t channels,
+                                                                     const int32_t filter_wd,
+                                                                     const int32_t input_offset,
+                                                                     const int32_t out_offset,
+                                                                     const quant_data_t *quant_data,
+                                                                     const int32_t activation_min,
+                                                                     const int32_t activation_max)
+{
+    const int32_t *out_shift = quant_data->shift;
+    const int32_t *out_mult = quant_data->mult;
+    const int32_t base_y = win->base_y, base_x = win->base_x;
+    const int32_t y_start = win->y_start, y_end = win->y_end;
+    const int32_t x_start = win->x_start, x_end = win->x_end;
+
+    int ch_idx = 0;
+    for (; ch_idx < channels - 3; ch_idx += 4) {//channel_loop
+        int32_t result0 = 0;
+        int32_t result1 = 0;
+        int32_t result2 = 0;
+        int32_t result3 = 0;
+
+        for (int filter_y_idx = y_start; filter_y_idx < y_end; filter_y_idx++) {
+            const int32_t idx_y = base_y + filter_y_idx;
+            for (int filter_x_idx = x_start; filter_x_idx < x_end; filter_x_idx++) {
+                const int32_t idx_x = base_x + filter_x_idx;
+                int32_t input_index = (idx_y * input_wd + idx_x) * channels + ch_idx;
+                int32_t filter_index = (filter_y_idx * filter_wd + filter_x_idx) * (channels) + ch_idx;
+                int32_t input_val0 = input_data[input_index + 0] + input_offset;
+                int32_t input_val1 = input_data[input_index + 1] + input_offset;
+                int32_t input_val2 = input_data[input_index + 2] + input_offset;
+                int32_t input_val3 = input_data[input_index + 3] + input_offset;
+                int32_t filter_val0 = filter_data[filter_index + 0];
+                int32_t filter_val1 = filter_data[filter_index + 1];
+                int32_t filter_val2 = filter_data[filter_index + 2];
+                int32_t filter_val3 = filter_data[filter_index + 3];
+                result0 += input_val0 * filter_val0;
+                result1 += input_val1 * filter_val1;
+                result2 += input_val2 * filter_val2;
+                result3 += input_val3 * filter_val3;
             }
-            for (; ch_idx < channels; ch_idx++) {//channel_loop
-                int32_t result = 0;
+        }
+        if (addend) {
+            result0 += addend[ch_idx + 0];
+            result1 += addend[ch_idx + 1];
+            result2 += addend[ch_idx + 2];
+            result3 += addend[ch_idx + 3];
+        }
+        result0 = esp_nn_multiply_by_quantized_mult_fast(result0, *out_mult++, *out_shift++);
+        result1 = esp_nn_multiply_by_quantized_mult_fast(result1, *out_mult++, *out_shift++);
+        result2 = esp_nn_multiply_by_quantized_mult_fast(result2, *out_mult++, *out_shift++);
+        result3 = esp_nn_multiply_by_quantized_mult_fast(result3, *out_mult++, *out_shift++);
 
-                for (int filter_y_idx = filter_y_start; filter_y_idx < filter_y_end; filter_y_idx++) {
-                    const int32_t idx_y = base_y + filter_y_idx;
-                    for (int filter_x_idx = filter_x_start; filter_x_idx < filter_x_end; filter_x_idx++) {
-                        const int32_t idx_x = base_x + filter_x_idx;
-                        int32_t input_index = (idx_y * input_wd + idx_x) * channels + ch_idx;
-                        int32_t filter_index = (filter_y_idx * filter_wd + filter_x_idx) * (channels) + ch_idx;
-                        int32_t input_val = input_data[input_index] + input_offset;
-                        int32_t filter_val = filter_data[filter_index];
-                        result += input_val * filter_val;
-                    }
-                }
-                if (bias) {
-                    result += bias[ch_idx];
+        result0 += out_offset;
+        result1 += out_offset;
+        result2 += out_offset;
+        result3 += out_offset;
+
+        result0 = max(result0, activation_min);
+        result1 = max(result1, activation_min);
+        result2 = max(result2, activation_min);
+        result3 = max(result3, activation_min);
+
+        result0 = min(result0, activation_max);
+        result1 = min(result1, activation_max);
+        result2 = min(result2, activation_max);
+        result3 = min(result3, activation_max);
+
+        *out_data++ = result0;
+        *out_data++ = result1;
+        *out_data++ = result2;
+        *out_data++ = result3;
+    }
+    for (; ch_idx < channels; ch_idx++) {//channel_loop
+        int32_t result = 0;
+
+        for (int filter_y_idx = y_start; filter_y_idx < y_end; filter_y_idx++) {
+            const int32_t idx_y = base_y + filter_y_idx;
+            for (int filter_x_idx = x_start; filter_x_idx < x_end; filter_x_idx++) {
+                const int32_t idx_x = base_x + filter_x_idx;
+                int32_t input_index = (idx_y * input_wd + idx_x) * channels + ch_idx;
+                int32_t filter_index = (filter_y_idx * filter_wd + filter_x_idx) * (channels) + ch_idx;
+                int32_t input_val = input_data[input_index] + input_offset;
+                int32_t filter_val = filter_data[filter_index];
+                result += input_val * filter_val;
+            }
+        }
+        if (addend) {
+            result += addend[ch_idx];
+        }
+        result = esp_nn_multiply_by_quantized_mult_fast(result, *out_mult++, *out_shift++);
+        result += out_offset;
+        result = max(result, activation_min);
+        result = min(result, activation_max);
+
+        *out_data++ = result;
+    }
+    return out_data;
+}
+
+/**
+ * @brief All the channels of one output pixel, any channel multiplier.
+ *
+ * Same parameters as esp_nn_depthwise_conv_s8_ch_mult_1_pixel().
+ */
+__NN_FORCE_INLINE__ int8_t *esp_nn_depthwise_conv_s8_pixel(const int8_t *input_data,
+                                                           const int8_t *filter_data,
+                                                           const int32_t *addend,
+                                                           int8_t *out_data,
+                                                           const dw_window_t *win,
+                                                           const int32_t input_wd,
+                                                           const int32_t channels,
+                                                           const int32_t ch_mult,
+                                                           const int32_t filter_wd,
+                                                           const int32_t input_offset,
+                                                           const int32_t out_offset,
+                                                           const quant_data_t *quant_data,
+                                                           const int32_t activation_min,
+                                                           const int32_t activation_max)
+{
+    const int32_t *out_shift = quant_data->shift;
+    const int32_t *out_mult = quant_data->mult;
+    const int32_t base_y = win->base_y, base_x = win->base_x;
+    const int32_t y_start = win->y_start, y_end = win->y_end;
+    const int32_t x_start = win->x_start, x_end = win->x_end;
+
+    for (int ch_idx = 0; ch_idx < channels; ch_idx++) {//channel_loop
+        int ch_mult_idx = 0;
+        for (; ch_mult_idx < ch_mult - 3; ch_mult_idx += 4) {
+            int32_t result0 = 0;
+            int32_t result1 = 0;
+            int32_t result2 = 0;
+            int32_t result3 = 0;
+            const int out_ch_idx =  ch_idx * ch_mult + ch_mult_idx;
+
+            for (int filter_y_idx = y_start; filter_y_idx < y_end; filter_y_idx++) {
+                const int32_t idx_y = base_y + filter_y_idx;
+                for (int filter_x_idx = x_start; filter_x_idx < x_end; filter_x_idx++) {
+                    const int32_t idx_x = base_x + filter_x_idx;
+                    int32_t input_index = (idx_y * input_wd + idx_x) * channels + ch_idx;
+                    int32_t filter_index = (filter_y_idx * filter_wd + filter_x_idx) * (channels * ch_mult) + out_ch_idx;
+                    int32_t input_val = input_data[input_index] + input_offset;
+                    int32_t filter_val0 = filter_data[filter_index + 0];
+                    int32_t filter_val1 = filter_data[filter_index + 1];
+                    int32_t filter_val2 = filter_data[filter_index + 2];
+                    int32_t filter_val3 = filter_data[filter_index + 3];
+                    result0 += input_val * filter_val0;
+                    result1 += input_val * filter_val1;
+                    result2 += input_val * filter_val2;
+                    result3 += input_val * filter_val3;
                 }
-                result = esp_nn_multiply_by_quantized_mult_fast(result, *out_mult++, *out_shift++);
-                result += out_offset;
-                result = max(result, activation_min);
-                result = min(result, activation_max);
+            }
+            if (addend) {
+                result0 += addend[out_ch_idx + 0];
+                result1 += addend[out_ch_idx + 1];
+                result2 += addend[out_ch_idx + 2];
+                result3 += addend[out_ch_idx + 3];
+            }
+            result0 = esp_nn_multiply_by_quantized_mult_fast(result0, *out_mult++, *out_shift++);
+            result1 = esp_nn_multiply_by_quantized_mult_fast(result1, *out_mult++, *out_shift++);
+            result2 = esp_nn_multiply_by_quantized_mult_fast(result2, *out_mult++, *out_shift++);
+            result3 = esp_nn_multiply_by_quantized_mult_fast(result3, *out_mult++, *out_shift++);
+
+            result0 += out_offset;
+            result1 += out_offset;
+            result2 += out_offset;
+            result3 += out_offset;
+
+            result0 = max(result0, activation_min);
+            result1 = max(result1, activation_min);
+            result2 = max(result2, activation_min);
+            result3 = max(result3, activation_min);
+            result0 = min(result0, activation_max);
+            result1 = min(result1, activation_max);
+            result2 = min(result2, activation_max);
+            result3 = min(result3, activation_max);
+
+            *out_data++ = result0;
+            *out_data++ = result1;
+            *out_data++ = result2;
+            *out_data++ = result3;
+        }
+        for (; ch_mult_idx < ch_mult; ch_mult_idx++) {
+            int32_t result = 0;
+            const int out_ch_idx =  ch_idx * ch_mult + ch_mult_idx;
 
-                out_data[out_idx++] = result;
+            for (int filter_y_idx = y_start; filter_y_idx < y_end; filter_y_idx++) {
+                const int32_t idx_y = base_y + filter_y_idx;
+                for (int filter_x_idx = x_start; filter_x_idx < x_end; filter_x_idx++) {
+                    const int32_t idx_x = base_x + filter_x_idx;
+                    int32_t input_index = (idx_y * input_wd + idx_x) * channels + ch_idx;
+                    int32_t filter_index = (filter_y_idx * filter_wd + filter_x_idx) * (channels * ch_mult) + out_ch_idx;
+                    int32_t input_val = input_data[input_index] + input_offset;
+                    int32_t filter_val = filter_data[filter_index];
+                    result += input_val * filter_val;
+                }
             }
+            if (addend) {
+                result += addend[out_ch_idx];
+            }
+            result = esp_nn_multiply_by_quantized_mult_fast(result, *out_mult++, *out_shift++);
+            result += out_offset;
+            result = max(result, activation_min);
+            result = min(result, activation_max);
+
+            *out_data++ = result;
         }
     }
+    return out_data;
 }
 
 void esp_nn_depthwise_conv_s8_opt(const data_dims_t *input_dims,
@@ -168,11 +337,6 @@ void esp_nn_depthwise_conv_s8_opt(const data_dims_t *input_dims,
                                   const quant_data_t *quant_data)
 {
     const uint16_t ch_mult = conv_params->ch_mult;
-    if (ch_mult == 1) {
-        esp_nn_depthwise_conv_s8_ch_mult_1(input_dims, input_data, filter_dims, filter_data,
-                                           bias, output_dims, out_data, conv_params, quant_data);
-        return;
-    }
     const uint16_t input_wd = input_dims->width;
     const uint16_t input_ht = input_dims->height;
     const uint16_t channels = input_dims->channels;
@@ -188,104 +352,129 @@ void esp_nn_depthwise_conv_s8_opt(const data_dims_t *input_dims,
     const uint16_t out_ht = output_dims->height;
     const int32_t activation_min = conv_params->activation.min;
     const int32_t activation_max = conv_params->activation.max;
+    const int32_t *corr = prepared_buffer;
 
-    int out_idx = 0;
     for (int out_y = 0; out_y < out_ht; out_y++) { //height loop
-        const int16_t base_y = (out_y * stride_ht) - pad_ht;
         for (int out_x = 0; out_x < out_wd; out_x++) { //width_loop
-            const int16_t base_x = (out_x * stride_wd) - pad_wd;
-
-            const int32_t *out_shift = quant_data->shift;
-            const int32_t *out_mult = quant_data->mult;
+            dw_window_t win;
+            win.base_y = (out_y * stride_ht) - pad_ht;
+            win.base_x = (out_x * stride_wd) - pad_wd;
 
             /* Select filter so as the point doesn't lie outside block */
-            int filter_y_start = max(0, -base_y);
-            int filter_x_start = max(0, -base_x);
-            int filter_y_end = min(filter_ht, input_ht - base_y);
-            int filter_x_end = min(filter_wd, input_wd - base_x);
-
-            for (int ch_idx = 0; ch_idx < channels; ch_idx++) {//channel_loop
-                int ch_mult_idx = 0;
-                for (; ch_mult_idx < ch_mult - 3; ch_mult_idx += 4) {
-                    int32_t result0 = 0;
-                    int32_t result1 = 0;
-                    int32_t result2 = 0;
-                    int32_t result3 = 0;
-                    const int out_ch_idx =  ch_idx * ch_mult + ch_mult_idx;
-
-                    for (int filter_y_idx = filter_y_start; filter_y_idx < filter_y_end; filter_y_idx++) {
-                        const int32_t idx_y = base_y + filter_y_idx;
-                        for (int filter_x_idx = filter_x_start; filter_x_idx < filter_x_end; filter_x_idx++) {
-                            const int32_t idx_x = base_x + filter_x_idx;
-                            int32_t input_index = (idx_y * input_wd + idx_x) * channels + ch_idx;
-                            int32_t filter_index = (filter_y_idx * filter_wd + filter_x_idx) * (channels * ch_mult) + out_ch_idx;
-                            int32_t input_val = input_data[input_index] + input_offset;
-                            int32_t filter_val0 = filter_data[filter_index + 0];
-                            int32_t filter_val1 = filter_data[filter_index + 1];
-                            int32_t filter_val2 = filter_data[filter_index + 2];
-                            int32_t filter_val3 = filter_data[filter_index + 3];
-                            result0 += input_val * filter_val0;
-                            result1 += input_val * filter_val1;
-                            result2 += input_val * filter_val2;
-                            result3 += input_val * filter_val3;
-                        }
-                    }
-                    if (bias) {
-                        result0 += bias[out_ch_idx + 0];
-                        result1 += bias[out_ch_idx + 1];
-                        result2 += bias[out_ch_idx + 2];
-                        result3 += bias[out_ch_idx + 3];
-                    }
-                    result0 = esp_nn_multiply_by_quantized_mult_fast(result0, *out_mult++, *out_shift++);
-                    result1 = esp_nn_multiply_by_quantized_mult_fast(result1, *out_mult++, *out_shift++);
-                    result2 = esp_nn_multiply_by_quantized_mult_fast(result2, *out_mult++, *out_shift++);
-                    result3 = esp_nn_multiply_by_quantized_mult_fast(result3, *out_mult++, *out_shift++);
-
-                    result0 += out_offset;
-                    result1 += out_offset;
-                    result2 += out_offset;
-                    result3 += out_offset;
-
-                    result0 = max(result0, activation_min);
-                    result1 = max(result1, activation_min);
-                    result2 = max(result2, activation_min);
-                    result3 = max(result3, activation_min);
-                    result0 = min(result0, activation_max);
-                    result1 = min(result1, activation_max);
-                    result2 = min(result2, activation_max);
-                    result3 = min(result3, activation_max);
-
-                    out_data[out_idx++] = result0;
-                    out_data[out_idx++] = result1;
-                    out_data[out_idx++] = result2;
-                    out_data[out_idx++] = result3;
+            win.y_start = max(0, -win.base_y);
+            win.x_start = max(0, -win.base_x);
+            win.y_end = min(filter_ht, input_ht - win.base_y);
+            win.x_end = min(filter_wd, input_wd - win.base_x);
+
+            const int32_t inside = corr && win.y_start == 0 && win.x_start == 0 &&
+                                   win.y_end == filter_ht && win.x_end == filter_wd;
+
+            if (ch_mult == 1) {
+                if (inside) {
+                    out_data = esp_nn_depthwise_conv_s8_ch_mult_1_pixel(input_data, filter_data, corr, out_data,
+                                    &win, input_wd, channels, filter_wd, 0, out_offset,
+                                    quant_data, activation_min, activation_max);
+                } else {
+                    out_data = esp_nn_depthwise_conv_s8_ch_mult_1_pixel(input_data, filter_data, bias, out_data,
+                                    &win, input_wd, channels, filter_wd, input_offset, out_offset,
+                                    quant_data, activation_min, activation_max);
                 }
-                for (; ch_mult_idx < ch_mult; ch_mult_idx++) {
-                    int32_t result = 0;
-                    const int out_ch_idx =  ch_idx * ch_mult + ch_mult_idx;
-
-                    for (int filter_y_idx = filter_y_start; filter_y_idx < filter_y_end; filter_y_idx++) {
-                        const int32_t idx_y = base_y + filter_y_idx;
-                        for (int filter_x_idx = filter_x_start; filter_x_idx < filter_x_end; filter_x_idx++) {
-                            const int32_t idx_x = base_x + filter_x_idx;
-                            int32_t input_index = (idx_y * input_wd + idx_x) * channels + ch_idx;
-                            int32_t filter_index = (filter_y_idx * filter_wd + filter_x_idx) * (channels * ch_mult) + out_ch_idx;
-                            int32_t input_val = input_data[input_index] + input_offset;
-                            int32_t filter_val = filter_data[filter_index];
-                            result += input_val * filter_val;
+            } else {
+                if (inside) {
+                    out_data = esp_nn_depthwise_conv_s8_pixel(input_data, filter_data, corr, out_data,
+                                    &win, input_wd, channels, ch_mult, filter_wd, 0, out_offset,
+                                    quant_data, activation_min, activation_max);
+                } else {
+                    out_data = esp_nn_depthwise_conv_s8_pixel(input_data, filter_data, bias, out_data,
+                                    &win, input_wd, channels, ch_mult, filter_wd, input_offset, out_offset,
+                                    quant_data, activation_min, activation_max);
+                }
+            }
+        }
+    }
+}
+
+/* channels whose int16 sums are kept at a time */
+#define DW_S16_CH_CHUNK     64
+
+void esp_nn_depthwise_conv_s16_opt(const data_dims_t *input_dims,
+                                   const int16_t *input_data,
+                                   const data_dims_t *filter_dims,
+                                   const int8_t *filter_data,
+                                   const int64_t *bias,
+                                   const data_dims_t *output_dims,
+                                   int16_t *out_data,
+                                   const dw_conv_params_t *conv_params,
+                                   const quant_data_t *quant_data)
+{
+    const int32_t filter_wd = filter_dims->width;
+    const int32_t filter_ht = filter_dims->height;
+
+    if (conv_params->ch_mult != 1 || filter_wd * filter_ht > ESP_NN_S16_DOT_CHUNK) {
+        esp_nn_depthwise_conv_s16_ansi(input_dims, input_data, filter_dims, filter_data, bias,
+                                       output_dims, out_data, conv_params, quant_data);
+        return;
+    }
+
+    const int32_t input_wd = input_dims->width;
+    const int32_t input_ht = input_dims->height;
+    const int32_t channels = input_dims->channels;
+    const int32_t pad_wd = conv_params->padding.width;
+    const int32_t pad_ht = conv_params->padding.height;
+    const int32_t stride_wd = conv_params->stride.width;
+    const int32_t stride_ht = conv_params->stride.height;
+    const int32_t out_wd = output_dims->width;
+    const int32_t out_ht = output_dims->height;
+    const int32_t *out_shift = quant_data->shift;
+    const int32_t *out_mult = quant_data->mult;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+
+    int32_t sums[DW_S16_CH_CHUNK];
+
+    for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+        const int32_t base_y = out_y * stride_ht - pad_ht;
+        const int32_t filter_y_start = max(0, -base_y);
+        const int32_t filter_y_end = min(filter_ht, input_ht - base_y);
+
+        for (int32_t out_x = 0; out_x < out_wd; out_x++) {
+            const int32_t base_x = out_x * stride_wd - pad_wd;
+            const int32_t filter_x_start = max(0, -base_x);
+            const int32_t filter_x_end = min(filter_wd, input_wd - base_x);
+
+            for (int32_t ch_start = 0; ch_start < channels; ch_start += DW_S16_CH_CHUNK) {
+                const int32_t ch_cnt = min(DW_S16_CH_CHUNK, channels - ch_start);
+                for (int32_t ch = 0; ch < ch_cnt; ch++) {
+                    sums[ch] = 0;
+                }
+
+                for (int32_t filter_y_idx = filter_y_start; filter_y_idx < filter_y_end; filter_y_idx++) {
+                    const int32_t idx_y = base_y + filter_y_idx;
+                    for (int32_t filter_x_idx = filter_x_start; filter_x_idx < filter_x_end; filter_x_idx++) {
+                        const int32_t idx_x = base_x + filter_x_idx;
+                        const int16_t *input_ptr = input_data + (idx_y * input_wd + idx_x) * channels + ch_start;
+                        const int8_t *filter_ptr = filter_data +
+                                        (filter_y_idx * filter_wd + filter_x_idx) * channels + ch_start;
+                        for (int32_t ch = 0; ch < ch_cnt; ch++) {
+                            sums[ch] += input_ptr[ch] * filter_ptr[ch];
                         }
                     }
+                }
+
+                for (int32_t ch = 0; ch < ch_cnt; ch++) {
+                    const int32_t out_ch = ch_start + ch;
+                    int64_t acc = sums[ch];
                     if (bias) {
-                        result += bias[out_ch_idx];
+                        acc += bias[out_ch];
                     }
-                    result = esp_nn_multiply_by_quantized_mult_fast(result, *out_mult++, *out_shift++);
-                    result += out_offset;
+                    int32_t result = esp_nn_multiply_by_quantized_mult_s64(acc, out_mult[out_ch],
+                                                                           out_shift[out_ch]);
                     result = max(result, activation_min);
                     result = min(result, activation_max);
-
-                    out_data[out_idx++] = result;
+                    out_data[out_ch] = (int16_t) result;
                 }
             }
+            out_data += channels;
         }
     }
 }
@@ -0,0 +1,175 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Optimizations strategies used:
+ *
+ * For channel multiplier 1, 8 channels of an output pixel are computed at a
+ * time: input and filter are both HWC, so the channels of a tap are 8
+ * contiguous values of each. The 8 results are requantized together.
+ *
+ * The prepared buffer is the one of esp_nn_depthwise_conv_opt.c. Pixels whose
+ * filter lies fully inside the input add it once instead of adding the input
+ * offset to every input.
+ *
+ * Other channel multipliers use the generic kernel.
+ */
+
+#include <esp_nn_defs.h>
+#include <esp_nn_ansi_headers.h>
+
+#include <esp_nn_simd_common.h>
+
+static __NN_THREAD_LOCAL__ const int32_t *prepared_buffer = NULL;
+
+void esp_nn_set_depthwise_conv_prepared_buf_simd(const void *buf)
+{
+    prepared_buffer = (const int32_t *) buf;
+    esp_nn_set_depthwise_conv_prepared_buf_opt(buf);
+}
+
+/**
+ * @brief All the channels of one output pixel, channel multiplier 1.
+ *
+ * @param input_offset  added to every input, 0 with a prepared `addend`
+ * @param addend        added to every result, the bias or the prepared buffer
+ */
+__NN_FORCE_INLINE__ void esp_nn_depthwise_conv_s8_pixel_simd(const int8_t *input_data,
+                                                             const int8_t *filter_data,
+                                                             const int32_t *addend,
+                                                             int8_t *out_data,
+                                                             const int32_t base_y,
+                                                             const int32_t base_x,
+                                                             const int32_t y_start,
+                                                             const int32_t y_end,
+                                                             const int32_t x_start,
+                                                             const int32_t x_end,
+                                                             const int32_t input_wd,
+                                                             const int32_t channels,
+                                                             const int32_t filter_wd,
+                                                             const int32_t input_offset,
+                                                             const int32_t out_offset,
+                                                             const quant_data_t *quant_data,
+                                                             const int32_t activation_min,
+                                                             const int32_t activation_max)
+{
+    int32_t ch_idx = 0;
+    for (; ch_idx <= channels - SIMD_LANES; ch_idx += SIMD_LANES) {
+        v8i32_t acc = {};
+        for (int32_t filter_y_idx = y_start; filter_y_idx < y_end; filter_y_idx++) {
+            const int32_t idx_y = base_y + filter_y_idx;
+            for (int32_t filter_x_idx = x_start; filter_x_idx < x_end; filter_x_idx++) {
+                const int32_t idx_x = base_x + filter_x_idx;
+                const int8_t *input_ptr = input_data + (idx_y * input_wd + idx_x) * channels + ch_idx;
+                const int8_t *filter_ptr = filter_data + (filter_y_idx * filter_wd + filter_x_idx) * channels + ch_idx;
+                if (input_offset == 0) {
+                    acc += simd_mul_s8(simd_load_v8i8(input_ptr), simd_load_v8i8(filter_ptr));
+                } else {
+                    /* (input + offset) needs 9 bits, so the products need int32 */
+                    acc += (simd_widen_s32(simd_load_v8i8(input_ptr)) + input_offset) *
+                           simd_widen_s32(simd_load_v8i8(filter_ptr));
+                }
+            }
+        }
+        if (addend) {
+            acc += simd_load_v8i32(addend + ch_idx);
+        }
+        acc = simd_requantize(acc, simd_load_v8i32(quant_data->mult + ch_idx),
+                              simd_load_v8i32(quant_data->shift + ch_idx),
+                              out_offset, activation_min, activation_max);
+        simd_store_s8(out_data + ch_idx, acc);
+    }
+    for (; ch_idx < channels; ch_idx++) {
+        int32_t result = 0;
+        for (int32_t filter_y_idx = y_start; filter_y_idx < y_end; filter_y_idx++) {
+            const int32_t idx_y = base_y + filter_y_idx;
+            for (int32_t filter_x_idx = x_start; filter_x_idx < x_end; filter_x_idx++) {
+                const int32_t idx_x = base_x + filter_x_idx;
+                int32_t input_index = (idx_y * input_wd + idx_x) * channels + ch_idx;
+                int32_t filter_index = (filter_y_idx * filter_wd + filter_x_idx) * channels + ch_idx;
+                result += (input_data[input_index] + input_offset) * filter_data[filter_index];
+            }
+        }
+        if (addend) {
+            result += addend[ch_idx];
+        }
+        result = esp_nn_multiply_by_quantized_mult(result, quant_data->mult[ch_idx], quant_data->shift[ch_idx]);
+        result += out_offset;
+        result = max(result, activation_min);
+        result = min(result, activation_max);
+        out_data[ch_idx] = (int8_t) result;
+    }
+}
+
+ESP_NN_SIMD_DISPATCH
+void esp_nn_depthwise_conv_s8_simd(const data_dims_t *input_dims,
+                                   const int8_t *input_data,
+                                   const data_dims_t *filter_dims,
+                                   const int8_t *filter_data,
+                                   const int32_t *bias,
+                                   const data_dims_t *output_dims,
+                                   int8_t *out_data,
+                                   const dw_conv_params_t *conv_params,
+                                   const quant_data_t *quant_data)
+{
+    if (conv_params->ch_mult != 1) {
+        esp_nn_depthwise_conv_s8_opt(input_dims, input_data, filter_dims, filter_data, bias,
+                                     output_dims, out_data, conv_params, quant_data);
+        return;
+    }
+
+    const int32_t input_wd = input_dims->width;
+    const int32_t input_ht = input_dims->height;
+    const int32_t channels = input_dims->channels;
+    const int32_t input_offset = conv_params->in_offset;
+    const int32_t out_offset = conv_params->out_offset;
+    const int32_t pad_wd = conv_params->padding.width;
+    const int32_t pad_ht = conv_params->padding.height;
+    const int32_t stride_wd = conv_params->stride.width;
+    const int32_t stride_ht = conv_params->stride.height;
+    const int32_t filter_wd = filter_dims->width;
+    const int32_t filter_ht = filter_dims->height;
+    const int32_t out_wd = output_dims->width;
+    const int32_t out_ht = output_dims->height;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+    const int32_t *corr = prepared_buffer;
+
+    for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+        const int32_t base_y = (out_y * stride_ht) - pad_ht;
+        const int32_t y_start = max(0, -base_y);
+        const int32_t y_end = min(filter_ht, input_ht - base_y);
+
+        for (int32_t out_x = 0; out_x < out_wd; out_x++) {
+            const int32_t base_x = (out_x * stride_wd) - pad_wd;
+            const int32_t x_start = max(0, -base_x);
+            const int32_t x_end = min(filter_wd, input_wd - base_x);
+
+            const int32_t inside = corr && y_start == 0 && x_start == 0 &&
+                                   y_end == filter_ht && x_end == filter_wd;
+            if (inside) {
+                esp_nn_depthwise_conv_s8_pixel_simd(input_data, filter_data, corr, out_data,
+                                                    base_y, base_x, y_start, y_end, x_start, x_end,
+                                                    input_wd, channels, filter_wd, 0, out_offset,
+                                                    quant_data, activation_min, activation_max);
+            } else {
+                esp_nn_depthwise_conv_s8_pixel_simd(input_data, filter_data, bias, out_data,
+                                                    base_y, base_x, y_start, y_end, x_start, x_end,
+                                                    input_wd, channels, filter_wd, input_offset, out_offset,
+                                                    quant_data, activation_min, activation_max);
+            }
+            out_data += channels;
+        }
+    }
+}
@@ -48,3 +48,30 @@ void esp_nn_fully_connected_s8_ansi(const int8_t *input_data,
         out_data[out_c] = (int8_t) result;
     }
 }
+
+void esp_nn_fully_connected_s16_ansi(const int16_t *input_data,
+                                     const uint16_t row_len,
+                                     const int8_t *filter_data,
+                                     const int64_t *bias,
+                                     int16_t *out_data,
+                                     const uint16_t out_channels,
+                                     const int32_t out_shift,
+                                     const int32_t out_mult,
+                                     const int32_t activation_min,
+                                     const int32_t activation_max)
+{
+    for (int32_t out_c = 0; out_c < out_channels; ++out_c) {
+        int64_t acc = 0;
+        for (int32_t data_idx = 0; data_idx < row_len; data_idx++) {
+            int32_t filter_index = row_len * out_c + data_idx;
+            acc += input_data[data_idx] * filter_data[filter_index];
+        }
+        if (bias) {
+            acc += bias[out_c];
+        }
+        int32_t result = esp_nn_multiply_by_quantized_mult_s64(acc, out_mult, out_shift);
+        result = max(result, activation_min);
+        result = min(result, activation_max);
+        out_data[out_c] = (int16_t) result;
+    }
+}
@@ -0,0 +1,70 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Optimizations strategies used:
+ *
+ * 1. 4 output channels at a time, every input value loaded is used 4 times.
+ * 2. The products are summed in 32 bits, ESP_NN_S16_DOT_CHUNK at a time,
+ *      and only those sums go to the 64 bit accumulators.
+ *
+ * The int8 version has nothing to gain from this, it sums in 32 bits anyway.
+ */
+
+#include <stdint.h>
+
+#include <common_functions.h>
+
+__NN_FORCE_INLINE__ int16_t esp_nn_fully_connected_s16_requant(int64_t acc,
+                                                               const int32_t out_mult,
+                                                               const int32_t out_shift,
+                                                               const int32_t activation_min,
+                                                               const int32_t activation_max)
+{
+    int32_t result = esp_nn_multiply_by_quantized_mult_s64(acc, out_mult, out_shift);
+    result = max(result, activation_min);
+    result = min(result, activation_max);
+    return (int16_t) result;
+}
+
+void esp_nn_fully_connected_s16_opt(const int16_t *input_data,
+                                    const uint16_t row_len,
+                                    const int8_t *filter_data,
+                                    const int64_t *bias,
+                                    int16_t *out_data,
+                                    const uint16_t out_channels,
+                                    const int32_t out_shift,
+                                    const int32_t out_mult,
+                                    const int32_t activation_min,
+                                    const int32_t activation_max)
+{
+    int32_t out_c = 0;
+    for (; out_c < out_channels - 3; out_c += 4) {
+        int64_t acc[4] = {0, 0, 0, 0};
+        esp_nn_dot_s16_s8_x4(input_data, filter_data + out_c * row_len, row_len, row_len, acc);
+        for (int32_t ch = 0; ch < 4; ch++) {
+            if (bias) {
+                acc[ch] += bias[out_c + ch];
+            }
+            out_data[out_c + ch] = esp_nn_fully_connected_s16_requant(acc[ch], out_mult, out_shift,
+                                                                      activation_min, activation_max);
+        }
+    }
+    for (; out_c < out_channels; out_c++) {
+        int64_t acc = esp_nn_dot_s16_s8(input_data, filter_data + out_c * row_len, row_len,
+                                        bias ? bias[out_c] : 0);
+        out_data[out_c] = esp_nn_fully_connected_s16_requant(acc, out_mult, out_shift,
+                                                             activation_min, activation_max);
+    }
+}
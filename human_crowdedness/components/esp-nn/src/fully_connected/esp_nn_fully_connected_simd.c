@@ -0,0 +1,69 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <esp_nn_simd_common.h>
+
+/**
+ * @brief Row of an output channel by the input, 8 values per step.
+ *
+ * @note  (value + offset) needs 9 bits, so the products need int32.
+ */
+__NN_FORCE_INLINE__ int32_t esp_nn_fc_dot_simd(const int8_t *input_data,
+                                               const int32_t input_offset,
+                                               const int8_t *filter_data,
+                                               const int32_t filter_offset,
+                                               const int32_t row_len)
+{
+    v8i32_t acc = {};
+    int32_t i = 0;
+    for (; i <= row_len - SIMD_LANES; i += SIMD_LANES) {
+        const v8i32_t in = simd_widen_s32(simd_load_v8i8(input_data + i)) + input_offset;
+        const v8i32_t filter = simd_widen_s32(simd_load_v8i8(filter_data + i)) + filter_offset;
+        acc += in * filter;
+    }
+    int32_t result = simd_hsum(acc);
+    for (; i < row_len; i++) {
+        result += (filter_data[i] + filter_offset) * (input_data[i] + input_offset);
+    }
+    return result;
+}
+
+ESP_NN_SIMD_DISPATCH
+void esp_nn_fully_connected_s8_simd(const int8_t *input_data,
+                                    const int32_t input_offset,
+                                    const uint16_t row_len,
+                                    const int8_t *filter_data,
+                                    const int32_t filter_offset,
+                                    const int32_t *bias,
+                                    int8_t *out_data,
+                                    const uint16_t out_channels,
+                                    const int32_t out_offset,
+                                    const int32_t out_shift,
+                                    const int32_t out_mult,
+                                    const int32_t activation_min,
+                                    const int32_t activation_max)
+{
+    for (int32_t out_c = 0; out_c < out_channels; ++out_c) {
+        int32_t result = esp_nn_fc_dot_simd(input_data, input_offset,
+                                            filter_data + out_c * row_len, filter_offset, row_len);
+        if (bias) {
+            result += bias[out_c];
+        }
+        result = esp_nn_multiply_by_quantized_mult(result, out_mult, out_shift);
+        result += out_offset;
+        result = max(result, activation_min);
+        result = min(result, activation_max);
+        out_data[out_c] = (int8_t) result;
+    }
+}
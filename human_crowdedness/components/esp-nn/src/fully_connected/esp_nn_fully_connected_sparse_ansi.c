@@ -0,0 +1,118 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Sparse weights, see esp_nn_sparse_common.h for the format, and the fully
+ * connected kernel that runs on them. The 1x1 convolution is in
+ * esp_nn_conv_sparse_ansi.c.
+ */
+
+#include <stdint.h>
+
+#include <common_functions.h>
+#include <esp_nn_sparse_common.h>
+
+static int32_t esp_nn_sparse_s8_nonzeros(const int8_t *filter_data,
+                                         const int32_t rows,
+                                         const int32_t row_len)
+{
+    int32_t nonzeros = 0;
+    for (int32_t i = 0; i < rows * row_len; i++) {
+        nonzeros += filter_data[i] != 0;
+    }
+    return nonzeros;
+}
+
+int32_t esp_nn_get_sparse_s8_size_ansi(const int8_t *filter_data,
+                                       const int32_t rows,
+                                       const int32_t row_len)
+{
+    const int32_t total = rows * row_len;
+    if (total == 0 || row_len > UINT16_MAX + 1) {
+        return 0;
+    }
+    const int32_t nonzeros = esp_nn_sparse_s8_nonzeros(filter_data, rows, row_len);
+    if ((int64_t) (total - nonzeros) * 100 < (int64_t) total * ESP_NN_SPARSE_MIN_ZERO_WEIGHTS) {
+        return 0;
+    }
+    const int32_t size = esp_nn_sparse_s8_size(rows, row_len, nonzeros);
+    return size < total ? size : 0;
+}
+
+void esp_nn_encode_sparse_s8_ansi(const int8_t *filter_data,
+                                  const int32_t rows,
+                                  const int32_t row_len,
+                                  int32_t *row_start,
+                                  void *cols,
+                                  int8_t *values)
+{
+    uint8_t *cols8 = (uint8_t *) cols;
+    uint16_t *cols16 = (uint16_t *) cols;
+    const int32_t col_size = esp_nn_sparse_s8_col_size(row_len);
+    int32_t idx = 0;
+    for (int32_t row = 0; row < rows; row++) {
+        const int8_t *filter_row = filter_data + row * row_len;
+        row_start[row] = idx;
+        for (int32_t col = 0; col < row_len; col++) {
+            if (filter_row[col] == 0) {
+                continue;
+            }
+            if (col_size == 1) {
+                cols8[idx] = (uint8_t) col;
+            } else {
+                cols16[idx] = (uint16_t) col;
+            }
+            values[idx++] = filter_row[col];
+        }
+    }
+    row_start[rows] = idx;
+}
+
+void esp_nn_fully_connected_sparse_s8_ansi(const int8_t *input_data,
+                                           const int32_t input_offset,
+                                           const sparse_s8_t *sparse,
+                                           const int32_t *bias,
+                                           int8_t *out_data,
+                                           const int32_t out_offset,
+                                           const int32_t out_shift,
+                                           const int32_t out_mult,
+                                           const int32_t activation_min,
+                                           const int32_t activation_max)
+{
+    const int8_t *values = sparse->values;
+    const uint8_t *cols8 = (const uint8_t *) sparse->cols;
+    const uint16_t *cols16 = (const uint16_t *) sparse->cols;
+
+    for (int32_t out_c = 0; out_c < sparse->rows; ++out_c) {
+        int32_t result = 0, sum = 0;
+        const int32_t end = sparse->row_start[out_c + 1];
+        if (sparse->col_size == 1) {
+            for (int32_t i = sparse->row_start[out_c]; i < end; i++) {
+                result += input_data[cols8[i]] * values[i];
+                sum += values[i];
+            }
+        } else {
+            for (int32_t i = sparse->row_start[out_c]; i < end; i++) {
+                result += input_data[cols16[i]] * values[i];
+                sum += values[i];
+            }
+        }
+        result += sum * input_offset + (bias ? bias[out_c] : 0);
+        result = esp_nn_multiply_by_quantized_mult(result, out_mult, out_shift);
+        result += out_offset;
+        result = max(result, activation_min);
+        result = min(result, activation_max);
+        out_data[out_c] = (int8_t) result;
+    }
+}
@@ -0,0 +1,265 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Optimizations strategies used:
+ *
+ * 1. Channels are the innermost loop, over contiguous memory. They are taken
+ *      in chunks whose sums stay on the stack.
+ * 2. Along a row of outputs, the window sums slide: the input columns that
+ *      leave the window are subtracted and the ones that enter it are added,
+ *      instead of adding the whole window again.
+ * 3. The rounded division by the window size is a multiply by its reciprocal.
+ *      The reciprocal only changes with the window size, i.e. on the edges.
+ *
+ * The int16 version is the same, windows of 65536 values and more, for which
+ * the reciprocal is not exact anymore, take the reference path.
+ */
+
+#include <stdint.h>
+
+#include <esp_nn_ansi_headers.h>
+
+#include <common_functions.h>
+
+/* channels whose sums are kept at a time */
+#define AVG_POOL_CH_CHUNK       64
+/**
+ * (n * recip) >> 47 == n / cnt for n < 2^47 / cnt. n is at most 129 * cnt,
+ * so this holds for windows of up to a million values.
+ */
+#define AVG_POOL_RECIP_SHIFT    47
+/* n is at most 32769 * cnt for int16 inputs, so cnt must stay below 65536 */
+#define AVG_POOL_S16_MAX_CNT    65535
+
+__NN_FORCE_INLINE__ void esp_nn_avg_pool_add_col(int32_t *sums,
+                                                 const int8_t *col_ptr,
+                                                 const int32_t rows,
+                                                 const int32_t row_stride,
+                                                 const int32_t ch_cnt)
+{
+    for (int32_t y = 0; y < rows; y++, col_ptr += row_stride) {
+        for (int32_t ch = 0; ch < ch_cnt; ch++) {
+            sums[ch] += col_ptr[ch];
+        }
+    }
+}
+
+__NN_FORCE_INLINE__ void esp_nn_avg_pool_sub_col(int32_t *sums,
+                                                 const int8_t *col_ptr,
+                                                 const int32_t rows,
+                                                 const int32_t row_stride,
+                                                 const int32_t ch_cnt)
+{
+    for (int32_t y = 0; y < rows; y++, col_ptr += row_stride) {
+        for (int32_t ch = 0; ch < ch_cnt; ch++) {
+            sums[ch] -= col_ptr[ch];
+        }
+    }
+}
+
+void esp_nn_avg_pool_s8_opt(const int8_t *input,
+                            const uint16_t input_wd,
+                            const uint16_t input_ht,
+                            int8_t *output,
+                            const uint16_t output_wd,
+                            const uint16_t output_ht,
+                            const uint16_t stride_wd,
+                            const uint16_t stride_ht,
+                            const uint16_t filter_wd,
+                            const uint16_t filter_ht,
+                            const uint16_t pad_wd,
+                            const uint16_t pad_ht,
+                            const int32_t activation_min,
+                            const int32_t activation_max,
+                            const uint16_t channels)
+{
+    const int32_t row_stride = input_wd * channels;
+    int32_t sums[AVG_POOL_CH_CHUNK];
+
+    int32_t base_y = -pad_ht;
+    for (int32_t out_y = 0; out_y < output_ht; out_y++, base_y += stride_ht) {
+        /* Make sure filter does not cross the input box */
+        const int32_t in_y_start = max(0, base_y);
+        const int32_t in_y_end = min(input_ht, base_y + filter_ht);
+        const int32_t rows = in_y_end - in_y_start;
+        const int8_t *in_row = input + in_y_start * row_stride;
+
+        for (int32_t ch_start = 0; ch_start < channels; ch_start += AVG_POOL_CH_CHUNK) {
+            const int32_t ch_cnt = min(AVG_POOL_CH_CHUNK, channels - ch_start);
+            const int8_t *in_ptr = in_row + ch_start;
+            int8_t *out_ptr = output + out_y * output_wd * channels + ch_start;
+
+            /* input columns in the sums, [col_start, col_end) */
+            int32_t col_start = 0, col_end = 0;
+            int32_t filter_cnt = 0;
+            uint64_t recip = 0;
+
+            int32_t base_x = -pad_wd;
+            for (int32_t out_x = 0; out_x < output_wd; out_x++, base_x += stride_wd) {
+                const int32_t in_x_start = max(0, base_x);
+                const int32_t in_x_end = min(input_wd, base_x + filter_wd);
+
+                if (out_x == 0 || in_x_start >= col_end) {
+                    /* no overlap with the previous window */
+                    for (int32_t ch = 0; ch < ch_cnt; ch++) {
+                        sums[ch] = 0;
+                    }
+                    col_start = col_end = in_x_start;
+                }
+                for (; col_start < in_x_start; col_start++) {
+                    esp_nn_avg_pool_sub_col(sums, in_ptr + col_start * channels, rows, row_stride, ch_cnt);
+                }
+                for (; col_end < in_x_end; col_end++) {
+                    esp_nn_avg_pool_add_col(sums, in_ptr + col_end * channels, rows, row_stride, ch_cnt);
+                }
+
+                const int32_t cnt = rows * (in_x_end - in_x_start);
+                if (cnt != filter_cnt) {
+                    filter_cnt = cnt;
+                    recip = ((1ull << AVG_POOL_RECIP_SHIFT) / cnt) + 1;
+                }
+                const uint32_t half = filter_cnt / 2;
+
+                for (int32_t ch = 0; ch < ch_cnt; ch++) {
+                    /* Rounded average, away from zero */
+                    const int32_t sum = sums[ch];
+                    const uint32_t abs_sum = sum > 0 ? sum : -sum;
+                    int32_t result = (int32_t) (((abs_sum + half) * recip) >> AVG_POOL_RECIP_SHIFT);
+                    result = sum > 0 ? result : -result;
+
+                    /* Activation function */
+                    result = max(result, activation_min);
+                    result = min(result, activation_max);
+                    out_ptr[ch] = (int8_t) result;
+                }
+                out_ptr += channels;
+            }
+        }
+    }
+}
+
+__NN_FORCE_INLINE__ void esp_nn_avg_pool_add_col_s16(int32_t *sums,
+                                                     const int16_t *col_ptr,
+                                                     const int32_t rows,
+                                                     const int32_t row_stride,
+                                                     const int32_t ch_cnt)
+{
+    for (int32_t y = 0; y < rows; y++, col_ptr += row_stride) {
+        for (int32_t ch = 0; ch < ch_cnt; ch++) {
+            sums[ch] += col_ptr[ch];
+        }
+    }
+}
+
+__NN_FORCE_INLINE__ void esp_nn_avg_pool_sub_col_s16(int32_t *sums,
+                                                     const int16_t *col_ptr,
+                                                     const int32_t rows,
+                                                     const int32_t row_stride,
+                                                     const int32_t ch_cnt)
+{
+    for (int32_t y = 0; y < rows; y++, col_ptr += row_stride) {
+        for (int32_t ch = 0; ch < ch_cnt; ch++) {
+            sums[ch] -= col_ptr[ch];
+        }
+    }
+}
+
+void esp_nn_avg_pool_s16_opt(const int16_t *input,
+                             const uint16_t input_wd,
+                             const uint16_t input_ht,
+                             int16_t *output,
+                             const uint16_t output_wd,
+                             const uint16_t output_ht,
+                             const uint16_t stride_wd,
+                             const uint16_t stride_ht,
+                             const uint16_t filter_wd,
+                             const uint16_t filter_ht,
+                             const uint16_t pad_wd,
+                             const uint16_t pad_ht,
+                             const int32_t activation_min,
+                             const int32_t activation_max,
+                             const uint16_t channels)
+{
+    if (filter_wd * filter_ht > AVG_POOL_S16_MAX_CNT) {
+        esp_nn_avg_pool_s16_ansi(input, input_wd, input_ht, output, output_wd, output_ht,
+                                 stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
+                                 activation_min, activation_max, channels);
+        return;
+    }
+
+    const int32_t row_stride = input_wd * channels;
+    int32_t sums[AVG_POOL_CH_CHUNK];
+
+    int32_t base_y = -pad_ht;
+    for (int32_t out_y = 0; out_y < output_ht; out_y++, base_y += stride_ht) {
+        /* Make sure filter does not cross the input box */
+        const int32_t in_y_start = max(0, base_y);
+        const int32_t in_y_end = min(input_ht, base_y + filter_ht);
+        const int32_t rows = in_y_end - in_y_start;
+        const int16_t *in_row = input + in_y_start * row_stride;
+
+        for (int32_t ch_start = 0; ch_start < channels; ch_start += AVG_POOL_CH_CHUNK) {
+            const int32_t ch_cnt = min(AVG_POOL_CH_CHUNK, channels - ch_start);
+            const int16_t *in_ptr = in_row + ch_start;
+            int16_t *out_ptr = output + out_y * output_wd * channels + ch_start;
+
+            /* input columns in the sums, [col_start, col_end) */
+            int32_t col_start = 0, col_end = 0;
+            int32_t filter_cnt = 0;
+            uint64_t recip = 0;
+
+            int32_t base_x = -pad_wd;
+            for (int32_t out_x = 0; out_x < output_wd; out_x++, base_x += stride_wd) {
+                const int32_t in_x_start = max(0, base_x);
+                const int32_t in_x_end = min(input_wd, base_x + filter_wd);
+
+                if (out_x == 0 || in_x_start >= col_end) {
+                    /* no overlap with the previous window */
+                    for (int32_t ch = 0; ch < ch_cnt; ch++) {
+                        sums[ch] = 0;
+                    }
+                    col_start = col_end = in_x_start;
+                }
+                for (; col_start < in_x_start; col_start++) {
+                    esp_nn_avg_pool_sub_col_s16(sums, in_ptr + col_start * channels, rows, row_stride, ch_cnt);
+                }
+                for (; col_end < in_x_end; col_end++) {
+                    esp_nn_avg_pool_add_col_s16(sums, in_ptr + col_end * channels, rows, row_stride, ch_cnt);
+                }
+
+                const int32_t cnt = rows * (in_x_end - in_x_start);
+                if (cnt != filter_cnt) {
+                    filter_cnt = cnt;
+                    recip = ((1ull << AVG_POOL_RECIP_SHIFT) / cnt) + 1;
+                }
+                const uint32_t half = filter_cnt / 2;
+
+                for (int32_t ch = 0; ch < ch_cnt; ch++) {
+                    /* Rounded average, away from zero */
+                    const int32_t sum = sums[ch];
+                    const uint32_t abs_sum = sum > 0 ? sum : -sum;
+                    int32_t result = (int32_t) (((abs_sum + half) * recip) >> AVG_POOL_RECIP_SHIFT);
+                    result = sum > 0 ? result : -result;
+
+                    /* Activation function */
+                    result = max(result, activation_min);
+                    result = min(result, activation_max);
+                    out_ptr[ch] = (int16_t) result;
+                }
+                out_ptr += channels;
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Optimizations strategies used:
+ *
+ * Channels are the innermost loop, over contiguous memory: the output pixel
+ * takes the max with every input pixel of the window in turn, and the
+ * activation is applied in the end.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <common_functions.h>
+
+void esp_nn_max_pool_s8_opt(const int8_t *input,
+                            const uint16_t input_wd,
+                            const uint16_t input_ht,
+                            int8_t *output,
+                            const uint16_t output_wd,
+                            const uint16_t output_ht,
+                            const uint16_t stride_wd,
+                            const uint16_t stride_ht,
+                            const uint16_t filter_wd,
+                            const uint16_t filter_ht,
+                            const uint16_t pad_wd,
+                            const uint16_t pad_ht,
+                            const int32_t activation_min,
+                            const int32_t activation_max,
+                            const uint16_t channels)
+{
+    /* the activation range of an int8 output is in int8 range */
+    const int8_t act_min = (int8_t) max(activation_min, INT8_MIN);
+    const int8_t act_max = (int8_t) min(activation_max, INT8_MAX);
+    int8_t *out_ptr = output;
+
+    int32_t base_y = -pad_ht;
+    for (int32_t out_y = 0; out_y < output_ht; out_y++, base_y += stride_ht) {
+        /* Make sure filter does not cross the input box */
+        const int32_t in_y_start = max(0, base_y);
+        const int32_t in_y_end = min(input_ht, base_y + filter_ht);
+
+        int32_t base_x = -pad_wd;
+        for (int32_t out_x = 0; out_x < output_wd; out_x++, base_x += stride_wd) {
+            const int32_t in_x_start = max(0, base_x);
+            const int32_t in_x_end = min(input_wd, base_x + filter_wd);
+
+            memset(out_ptr, INT8_MIN, channels);
+            for (int32_t in_y = in_y_start; in_y < in_y_end; in_y++) {
+                for (int32_t in_x = in_x_start; in_x < in_x_end; in_x++) {
+                    const int8_t *in_ptr = input + (in_y * input_wd + in_x) * channels;
+                    for (int32_t ch = 0; ch < channels; ch++) {
+                        out_ptr[ch] = max(out_ptr[ch], in_ptr[ch]);
+                    }
+                }
+            }
+
+            for (int32_t ch = 0; ch < channels; ch++) {
+                int8_t result = max(out_ptr[ch], act_min);
+                out_ptr[ch] = min(result, act_max);
+            }
+            out_ptr += channels;
+        }
+    }
+}
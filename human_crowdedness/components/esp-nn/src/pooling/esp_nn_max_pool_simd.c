@@ -0,0 +1,78 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <esp_nn_simd_common.h>
+
+ESP_NN_SIMD_DISPATCH
+void esp_nn_max_pool_s8_simd(const int8_t *input,
+                             const uint16_t input_wd,
+                             const uint16_t input_ht,
+                             int8_t *output,
+                             const uint16_t output_wd,
+                             const uint16_t output_ht,
+                             const uint16_t stride_wd,
+                             const uint16_t stride_ht,
+                             const uint16_t filter_wd,
+                             const uint16_t filter_ht,
+                             const uint16_t pad_wd,
+                             const uint16_t pad_ht,
+                             const int32_t activation_min,
+                             const int32_t activation_max,
+                             const uint16_t channels)
+{
+    /* the activation range of an int8 output is in int8 range */
+    const int8_t act_min = (int8_t) max(activation_min, INT8_MIN);
+    const int8_t act_max = (int8_t) min(activation_max, INT8_MAX);
+    const v16i8_t act_min_vec = (v16i8_t) {} + act_min;
+    const v16i8_t act_max_vec = (v16i8_t) {} + act_max;
+
+    int32_t base_y = -pad_ht;
+    for (int32_t out_y = 0; out_y < output_ht; out_y++, base_y += stride_ht) {
+        int32_t base_x = -pad_wd;
+        for (int32_t out_x = 0; out_x < output_wd; out_x++, base_x += stride_wd) {
+            /* Make sure filter does not cross the input box */
+            const int32_t filter_y_start = max(0, -base_y);
+            const int32_t filter_x_start = max(0, -base_x);
+            const int32_t filter_y_end = min(filter_ht, input_ht - base_y);
+            const int32_t filter_x_end = min(filter_wd, input_wd - base_x);
+            int8_t *out_ptr = output + (out_y * output_wd + out_x) * channels;
+
+            /* 16 channels at a time */
+            int32_t ch_idx = 0;
+            for (; ch_idx <= channels - 16; ch_idx += 16) {
+                v16i8_t result = (v16i8_t) {} + INT8_MIN;
+                for (int32_t filter_y = filter_y_start; filter_y < filter_y_end; filter_y++) {
+                    for (int32_t filter_x = filter_x_start; filter_x < filter_x_end; filter_x++) {
+                        const int32_t input_index = ((base_y + filter_y) * input_wd + base_x + filter_x) * channels;
+                        result = simd_max_s8(result, simd_load_v16i8(input + input_index + ch_idx));
+                    }
+                }
+                result = simd_min_s8(simd_max_s8(result, act_min_vec), act_max_vec);
+                memcpy(out_ptr + ch_idx, &result, sizeof(result));
+            }
+            for (; ch_idx < channels; ch_idx++) {
+                int8_t result = INT8_MIN;
+                for (int32_t filter_y = filter_y_start; filter_y < filter_y_end; filter_y++) {
+                    for (int32_t filter_x = filter_x_start; filter_x < filter_x_end; filter_x++) {
+                        const int32_t input_index = ((base_y + filter_y) * input_wd + base_x + filter_x) * channels;
+                        result = max(input[input_index + ch_idx], result);
+                    }
+                }
+                result = max(result, act_min);
+                result = min(result, act_max);
+                out_ptr[ch_idx] = result;
+            }
+        }
+    }
+}
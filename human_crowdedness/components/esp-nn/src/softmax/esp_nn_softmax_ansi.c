@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <esp_nn_ansi_headers.h>
+
 #include "softmax_common.h"
 
 int32_t esp_nn_get_softmax_scratch_size_ansi(const int32_t width, const int32_t height)
@@ -66,9 +68,8 @@ void esp_nn_softmax_s8_ansi(const int8_t *input_data,
             }
         }
 
-        const int32_t headroom_plus1 = esp_nn_clz32((uint32_t) sum_of_exps);
-        const int32_t shifted_scale = ONE_OVER_ONE_X((sum_of_exps << headroom_plus1) - (1 << 31));
-        const int32_t bits_over_unit = ACCUM_BITS - headroom_plus1 + 31 - sizeof(int8_t) * 8;
+        int32_t shifted_scale, bits_over_unit;
+        esp_nn_softmax_row_scale(sum_of_exps, &shifted_scale, &bits_over_unit);
 
         for (col = 0; col < width; col++) {
             input_diff = in_ptr[col] - max_in_row;
@@ -86,3 +87,52 @@ void esp_nn_softmax_s8_ansi(const int8_t *input_data,
         out_ptr += width;
     }
 }
+
+void esp_nn_prepare_softmax_lut_s8_ansi(const int32_t mult,
+                                        const int32_t shift,
+                                        const int32_t diff_min,
+                                        int32_t *lut)
+{
+    const int32_t mask = (1 << shift);
+    for (int32_t i = 0; i < ESP_NN_SOFTMAX_LUT_SIZE; i++) {
+        const int32_t input_diff = -i;
+        if (input_diff >= diff_min) {
+            const int32_t input_diff_rescaled = SAT_HIGH_MUL(input_diff * mask, mult);
+            lut[i] = esp_nn_exp_on_negative_values(input_diff_rescaled);
+        } else {
+            lut[i] = 0;
+        }
+    }
+}
+
+void esp_nn_softmax_s8_lut_ansi(const int8_t *input_data,
+                                const int32_t height,
+                                const int32_t width,
+                                const int32_t *lut,
+                                int8_t *output_data)
+{
+    const int8_t *in_ptr = input_data;
+    int8_t *out_ptr = output_data;
+
+    for (int row_idx = 0; row_idx < height; row_idx++) {
+        int8_t max_in_row = in_ptr[0];
+        for (int32_t col = 1; col < width; col++) {
+            max_in_row = max(max_in_row, in_ptr[col]);
+        }
+
+        int32_t sum_of_exps = 0;
+        for (int32_t col = 0; col < width; col++) {
+            sum_of_exps += DIV_POW2(lut[max_in_row - in_ptr[col]], SOFTMAX_ACCUM_BITS);
+        }
+
+        int32_t shifted_scale, bits_over_unit;
+        esp_nn_softmax_row_scale(sum_of_exps, &shifted_scale, &bits_over_unit);
+
+        for (int32_t col = 0; col < width; col++) {
+            out_ptr[col] = esp_nn_softmax_output_s8(lut[max_in_row - in_ptr[col]],
+                                                    shifted_scale, bits_over_unit);
+        }
+        in_ptr  += width;
+        out_ptr += width;
+    }
+}
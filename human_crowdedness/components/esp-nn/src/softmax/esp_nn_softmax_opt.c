@@ -12,8 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <esp_nn_ansi_headers.h>
+
 #include "softmax_common.h"
-#include <stdio.h>
 
 static int32_t *scratch_buf = NULL;
 
@@ -52,7 +53,8 @@ void esp_nn_softmax_s8_opt(const int8_t *input_data,
                            int8_t *output_data)
 {
     if (scratch_buf == NULL) {
-        printf("%s error! scratch buffer not set\n", __FUNCTION__);
+        /* the reference function computes the exps twice instead */
+        esp_nn_softmax_s8_ansi(input_data, height, width, mult, shift, diff_min, output_data);
         return;
     }
     // The representation chosen for the input to the exp() function is Q5.26.
@@ -87,9 +89,8 @@ void esp_nn_softmax_s8_opt(const int8_t *input_data,
             }
         }
 
-        const int32_t headroom_plus1 = esp_nn_clz32((uint32_t) sum_of_exps);
-        const int32_t shifted_scale = ONE_OVER_ONE_X((sum_of_exps << headroom_plus1) - (1 << 31));
-        const int32_t bits_over_unit = ACCUM_BITS - headroom_plus1 + 31 - sizeof(int8_t) * 8;
+        int32_t shifted_scale, bits_over_unit;
+        esp_nn_softmax_row_scale(sum_of_exps, &shifted_scale, &bits_over_unit);
 
         for (col = 0; col < width; col++) {
             input_diff = in_ptr[col] - max_in_row;
@@ -106,3 +107,58 @@ void esp_nn_softmax_s8_opt(const int8_t *input_data,
         out_ptr += width;
     }
 }
+
+/**
+ * Optimizations strategies used for the table version:
+ *
+ * 1. The max of a row is kept in 4 independent values, so that the compares
+ *      of 4 inputs do not wait on each other.
+ * 2. The exps come from the table, so they are looked up again for the
+ *      outputs instead of being kept in a scratch buffer.
+ */
+void esp_nn_softmax_s8_lut_opt(const int8_t *input_data,
+                               const int32_t height,
+                               const int32_t width,
+                               const int32_t *lut,
+                               int8_t *output_data)
+{
+    const int8_t *in_ptr = input_data;
+    int8_t *out_ptr = output_data;
+
+    for (int row_idx = 0; row_idx < height; row_idx++) {
+        int32_t max0 = in_ptr[0], max1 = in_ptr[0], max2 = in_ptr[0], max3 = in_ptr[0];
+        int32_t col = 0;
+        for (; col <= width - 4; col += 4) {
+            max0 = max(max0, in_ptr[col + 0]);
+            max1 = max(max1, in_ptr[col + 1]);
+            max2 = max(max2, in_ptr[col + 2]);
+            max3 = max(max3, in_ptr[col + 3]);
+        }
+        for (; col < width; col++) {
+            max0 = max(max0, in_ptr[col]);
+        }
+        const int32_t max_in_row = max(max(max0, max1), max(max2, max3));
+
+        /* entry `max - input` of the table */
+        const int32_t *row_lut = lut + max_in_row;
+
+        int32_t sum0 = 0, sum1 = 0;
+        for (col = 0; col <= width - 2; col += 2) {
+            sum0 += DIV_POW2(row_lut[-in_ptr[col + 0]], SOFTMAX_ACCUM_BITS);
+            sum1 += DIV_POW2(row_lut[-in_ptr[col + 1]], SOFTMAX_ACCUM_BITS);
+        }
+        for (; col < width; col++) {
+            sum0 += DIV_POW2(row_lut[-in_ptr[col]], SOFTMAX_ACCUM_BITS);
+        }
+
+        int32_t shifted_scale, bits_over_unit;
+        esp_nn_softmax_row_scale(sum0 + sum1, &shifted_scale, &bits_over_unit);
+
+        for (col = 0; col < width; col++) {
+            out_ptr[col] = esp_nn_softmax_output_s8(row_lut[-in_ptr[col]],
+                                                    shifted_scale, bits_over_unit);
+        }
+        in_ptr  += width;
+        out_ptr += width;
+    }
+}
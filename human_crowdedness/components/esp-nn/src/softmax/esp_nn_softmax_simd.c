@@ -0,0 +1,99 @@
+// Copyright 2020-2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Optimizations strategies used:
+ *
+ * 1. The max of a row is taken 16 inputs at a time.
+ * 2. The exps are looked up 8 at a time, then summed and turned into
+ *      outputs as vectors.
+ */
+
+#include <esp_nn_defs.h>
+#include <esp_nn_ansi_headers.h>
+
+#include <esp_nn_simd_common.h>
+
+#include "softmax_common.h"
+
+/* exps of 8 inputs, entry `max - input` of the table */
+__NN_FORCE_INLINE__ v8i32_t esp_nn_softmax_lookup_simd(const int32_t *row_lut, const int8_t *in_ptr)
+{
+    v8i32_t exps = {0};
+    for (int i = 0; i < SIMD_LANES; i++) {
+        exps[i] = row_lut[-in_ptr[i]];
+    }
+    return exps;
+}
+
+ESP_NN_SIMD_DISPATCH
+void esp_nn_softmax_s8_lut_simd(const int8_t *input_data,
+                                const int32_t height,
+                                const int32_t width,
+                                const int32_t *lut,
+                                int8_t *output_data)
+{
+    const int8_t *in_ptr = input_data;
+    int8_t *out_ptr = output_data;
+
+    for (int row_idx = 0; row_idx < height; row_idx++) {
+        int32_t col = 0;
+        int32_t max_in_row = in_ptr[0];
+        if (width >= 16) {
+            v16i8_t max_vec = simd_load_v16i8(in_ptr);
+            for (col = 16; col <= width - 16; col += 16) {
+                max_vec = simd_max_s8(max_vec, simd_load_v16i8(in_ptr + col));
+            }
+            for (int i = 0; i < 16; i++) {
+                max_in_row = max(max_in_row, max_vec[i]);
+            }
+        }
+        for (; col < width; col++) {
+            max_in_row = max(max_in_row, in_ptr[col]);
+        }
+
+        const int32_t *row_lut = lut + max_in_row;
+        const v8i32_t accum_bits = (v8i32_t) {} + SOFTMAX_ACCUM_BITS;
+
+        v8i32_t sum_vec = {};
+        for (col = 0; col <= width - SIMD_LANES; col += SIMD_LANES) {
+            sum_vec += simd_div_by_power_of_two(esp_nn_softmax_lookup_simd(row_lut, in_ptr + col),
+                                                accum_bits);
+        }
+        int32_t sum_of_exps = simd_hsum(sum_vec);
+        for (; col < width; col++) {
+            sum_of_exps += DIV_POW2(row_lut[-in_ptr[col]], SOFTMAX_ACCUM_BITS);
+        }
+
+        int32_t shifted_scale, bits_over_unit;
+        esp_nn_softmax_row_scale(sum_of_exps, &shifted_scale, &bits_over_unit);
+
+        const v8i32_t scale_vec = (v8i32_t) {} + shifted_scale;
+        const v8i32_t bits_vec = (v8i32_t) {} + bits_over_unit;
+        for (col = 0; col <= width - SIMD_LANES; col += SIMD_LANES) {
+            const v8i32_t exps = esp_nn_softmax_lookup_simd(row_lut, in_ptr + col);
+            v8i32_t result = simd_div_by_power_of_two(simd_sat_round_doubling_high_mul(scale_vec, exps),
+                                                      bits_vec) - 128;
+            result = simd_max(result, (v8i32_t) {} - 128);
+            result = simd_min(result, (v8i32_t) {} + 127);
+            simd_store_s8(out_ptr + col, result);
+        }
+        for (; col < width; col++) {
+            out_ptr[col] = esp_nn_softmax_output_s8(row_lut[-in_ptr[col]],
+                                                    shifted_scale, bits_over_unit);
+        }
+        in_ptr  += width;
+        out_ptr += width;
+    }
+}
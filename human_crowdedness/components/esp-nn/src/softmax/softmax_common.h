@@ -101,4 +101,41 @@ __NN_FORCE_INLINE__ int32_t esp_nn_exp_on_negative_values(int32_t val)
 
     mask = MASK_IF_ZERO(val);
     return SELECT_USING_MASK(mask, INT32_MAX, result);
-}
\ No newline at end of file
+}
+
+/* exps of a row are summed in Q12, see esp_nn_softmax_s8_ansi() */
+#define SOFTMAX_ACCUM_BITS  12
+
+/**
+ * @brief   Scale and shift that turn the exps of a row into outputs, from
+ *          their sum.
+ */
+__NN_FORCE_INLINE__ void esp_nn_softmax_row_scale(const int32_t sum_of_exps,
+                                                  int32_t *shifted_scale,
+                                                  int32_t *bits_over_unit)
+{
+    const int32_t headroom_plus1 = esp_nn_clz32((uint32_t) sum_of_exps);
+    *shifted_scale = ONE_OVER_ONE_X((sum_of_exps << headroom_plus1) - (1 << 31));
+    *bits_over_unit = SOFTMAX_ACCUM_BITS - headroom_plus1 + 31 - sizeof(int8_t) * 8;
+
+    /* Sums of 512 or more: every output is below half a step, -128 */
+    if (*bits_over_unit > 31) {
+        *shifted_scale = 0;
+        *bits_over_unit = 0;
+    }
+}
+
+/**
+ * @brief   Output of one exp of a row.
+ *
+ * @note    an exp of 0, the table entry of a skipped input, gives -128 as
+ *          the skipped inputs of esp_nn_softmax_s8_ansi()
+ */
+__NN_FORCE_INLINE__ int8_t esp_nn_softmax_output_s8(const int32_t exp_raw,
+                                                    const int32_t shifted_scale,
+                                                    const int32_t bits_over_unit)
+{
+    const int32_t shifted_output = SAT_HIGH_MUL(shifted_scale, exp_raw);
+    const int32_t result = DIV_POW2(shifted_output, bits_over_unit) - 128;
+    return (int8_t) esp_nn_saturate8(result);
+}
@@ -54,6 +54,7 @@ void app_main()
     printf("mul, c %u opt %u\n", total_c, total_opt);
     esp_nn_depthwise_conv_s8_test();
     esp_nn_conv_s8_test();
+    esp_nn_conv_1x1_sparse_s8_test();
 
     esp_nn_relu6_s8_test();
     printf("relu, c %u opt %u\n", total_c, total_opt);
@@ -62,10 +63,22 @@ void app_main()
     esp_nn_max_pool_s8_test();
     printf("max_pool, c %u opt %u\n", total_c, total_opt);
     esp_nn_fully_connected_s8_test();
+    esp_nn_fully_connected_sparse_s8_test();
     esp_nn_softmax_s8_test();
     printf("softmax, c %u opt %u\n", total_c, total_opt);
+    esp_nn_softmax_s8_lut_test();
+    printf("softmax lut, c %u opt %u\n", total_c, total_opt);
     ESP_LOGI(TAG, "s8 tests done!\n");
 
+    /* 16x8 tests */
+    ESP_LOGI(TAG, "Running 16x8 tests...");
+    esp_nn_depthwise_conv_s16_test();
+    esp_nn_conv_s16_test();
+    esp_nn_avg_pool_s16_test();
+    printf("avg_pool s16, c %u opt %u\n", total_c, total_opt);
+    esp_nn_fully_connected_s16_test();
+    ESP_LOGI(TAG, "16x8 tests done!\n");
+
     /* u8 tests */
     //ESP_LOGI(TAG, "Running u8 tests...");
     //esp_nn_add_elementwise_u8_test();
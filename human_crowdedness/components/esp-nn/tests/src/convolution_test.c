@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <malloc.h>
+#include <string.h>
 
 #include <esp_nn.h>
 #include "test_utils.h"
@@ -34,6 +35,7 @@ void esp_nn_depthwise_conv_s8_test()
     int32_t activation_min = -125;
     int32_t activation_max = 120;
     void *scratch_buf = NULL;
+    void *prepared_buf = NULL;
 
     /* independent variables */
     int input_wd, input_ht, channels;
@@ -270,7 +272,24 @@ void esp_nn_depthwise_conv_s8_test()
                 goto dc_s8_cleanup;
             }
             esp_nn_set_depthwise_conv_scratch_buf(scratch_buf + align_sz);
+        } else {
+            esp_nn_set_depthwise_conv_scratch_buf(NULL);
+        }
+
+        /* one time transform of the weights, as done when the model is loaded */
+        int prepared_buf_size = esp_nn_get_depthwise_conv_prepared_size(&input_dims, &filter_dims,
+                                                                        &output_dims, &conv_params);
+        if (prepared_buf_size > 0) {
+            prepared_buf = memalign(16, prepared_buf_size);
+            if (prepared_buf == NULL) {
+                printf(ANSI_COLOR_RED"[%d] prepared_buf alloc failed size %d\n"ANSI_COLOR_RESET,
+                       itr, prepared_buf_size);
+                goto dc_s8_cleanup;
+            }
+            esp_nn_prepare_depthwise_conv_s8(&input_dims, &filter_dims, filter_data + 4, bias + 1,
+                                             &output_dims, &conv_params, prepared_buf);
         }
+        esp_nn_set_depthwise_conv_prepared_buf(prepared_buf);
 
         /* enable profiler */
         profile_c_start();
@@ -333,6 +352,11 @@ void esp_nn_depthwise_conv_s8_test()
         }
         if (scratch_buf) {
             free(scratch_buf);
+            scratch_buf = NULL;
+        }
+        if (prepared_buf) {
+            free(prepared_buf);
+            prepared_buf = NULL;
         }
     }
 }
@@ -346,6 +370,7 @@ void esp_nn_conv_s8_test()
     const int32_t out_offset = 3;
 
     void *scratch_buf = NULL;
+    void *prepared_buf = NULL;
     int8_t *input_orig;
     int8_t *out_c_orig;
     int8_t *out_opt_orig;
@@ -566,10 +591,10 @@ void esp_nn_conv_s8_test()
                                                             &output_dims, &conv_params);
         if (scratch_buf_size > 0) {
 #if IDF_HEAP_CAPS
-            void *scratch_buf = heap_caps_malloc(scratch_buf_size + 32, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            scratch_buf = heap_caps_malloc(scratch_buf_size + 32, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
             int align_sz = 16 - (((int32_t) scratch_buf) & 0xf);
 #else
-            void *scratch_buf = memalign(16, scratch_buf_size);
+            scratch_buf = memalign(16, scratch_buf_size);
             int align_sz = 0;
 #endif
             if (scratch_buf == NULL) {
@@ -577,8 +602,24 @@ void esp_nn_conv_s8_test()
                 goto conv_s8_cleanup;
             }
             esp_nn_set_conv_scratch_buf(scratch_buf + align_sz);
+        } else {
+            esp_nn_set_conv_scratch_buf(NULL);
         }
 
+        /* one time transform of the weights, as done when the model is loaded */
+        int prepared_buf_size = esp_nn_get_conv_prepared_size(&input_dims, &filter_dims,
+                                                              &output_dims, &conv_params);
+        if (prepared_buf_size > 0) {
+            prepared_buf = memalign(16, prepared_buf_size);
+            if (prepared_buf == NULL) {
+                printf(ANSI_COLOR_RED"prepared_buf alloc failed size %d\n"ANSI_COLOR_RESET, prepared_buf_size);
+                goto conv_s8_cleanup;
+            }
+            esp_nn_prepare_conv_s8(&input_dims, &filter_dims, filter_data + 2, bias,
+                                   &output_dims, &conv_params, prepared_buf);
+        }
+        esp_nn_set_conv_prepared_buf(prepared_buf);
+
         /* enable profiler */
         profile_c_start();
 
@@ -646,6 +687,377 @@ void esp_nn_conv_s8_test()
         }
         if (scratch_buf) {
             free(scratch_buf);
+            scratch_buf = NULL;
+        }
+        if (prepared_buf) {
+            free(prepared_buf);
+            prepared_buf = NULL;
+        }
+    }
+}
+
+#define CONV_S16_TEST_ITERATIONS    6
+
+/* shapes of the 16x8 tests, pad is SAME when set, VALID otherwise */
+static void conv_s16_test_params(int itr, uint16_t *in_wd, uint16_t *in_ht, uint16_t *channels,
+                                 uint16_t *filter_wd, uint16_t *filter_ht, uint16_t *pad_wd, uint16_t *pad_ht,
+                                 uint16_t *stride_wd, uint16_t *stride_ht)
+{
+    switch (itr) {
+    case 0: // filter (1,1)
+        *in_wd = 10; *in_ht = 10; *channels = 32;
+        *filter_wd = 1; *filter_ht = 1; *pad_wd = 0; *pad_ht = 0;
+        *stride_wd = 1; *stride_ht = 1;
+        break;
+    case 1: // filter (3,3), pad (1,1)
+        *in_wd = 12; *in_ht = 12; *channels = 16;
+        *filter_wd = 3; *filter_ht = 3; *pad_wd = 1; *pad_ht = 1;
+        *stride_wd = 1; *stride_ht = 1;
+        break;
+    case 2: // stride (2,2), odd channels
+        *in_wd = 13; *in_ht = 11; *channels = 7;
+        *filter_wd = 3; *filter_ht = 3; *pad_wd = 1; *pad_ht = 1;
+        *stride_wd = 2; *stride_ht = 2;
+        break;
+    case 3: // filter rows longer than a chunk of 32 bit sums, more channels than a chunk
+        *in_wd = 8; *in_ht = 8; *channels = 130;
+        *filter_wd = 3; *filter_ht = 3; *pad_wd = 0; *pad_ht = 0;
+        *stride_wd = 1; *stride_ht = 1;
+        break;
+    case 4: // filter (5,5), pad (2,2)
+        *in_wd = 9; *in_ht = 9; *channels = 12;
+        *filter_wd = 5; *filter_ht = 5; *pad_wd = 2; *pad_ht = 2;
+        *stride_wd = 1; *stride_ht = 1;
+        break;
+    default: // filter (3,1) not square, first layer like
+        *in_wd = 16; *in_ht = 16; *channels = 3;
+        *filter_wd = 3; *filter_ht = 1; *pad_wd = 1; *pad_ht = 0;
+        *stride_wd = 1; *stride_ht = 1;
+        break;
+    }
+}
+
+static uint16_t conv_s16_out_size(uint16_t input, uint16_t filter, uint16_t pad, uint16_t stride)
+{
+    return pad ? (input + stride - 1) / stride : (input + stride - filter) / stride;
+}
+
+void esp_nn_depthwise_conv_s16_test()
+{
+    uint32_t total_c = 0, total_opt = 0;
+    int16_t *input = NULL, *out_data_c = NULL, *out_data_opt = NULL;
+    int8_t *filter_data = NULL;
+    int64_t *bias = NULL;
+    int32_t *out_shift = NULL, *out_mult = NULL;
+    uint16_t input_wd, input_ht, channels, filter_wd, filter_ht;
+    uint16_t pad_wd, pad_ht, stride_wd, stride_ht;
+
+    printf("\n######## Running %s ##########\n", __FUNCTION__);
+    for (int itr = 0; itr < CONV_S16_TEST_ITERATIONS * 2; itr++) {
+        /* the second round with a channel multiplier of 2 */
+        const uint16_t ch_mult = itr < CONV_S16_TEST_ITERATIONS ? 1 : 2;
+        conv_s16_test_params(itr % CONV_S16_TEST_ITERATIONS, &input_wd, &input_ht, &channels,
+                             &filter_wd, &filter_ht, &pad_wd, &pad_ht, &stride_wd, &stride_ht);
+        const uint16_t out_wd = conv_s16_out_size(input_wd, filter_wd, pad_wd, stride_wd);
+        const uint16_t out_ht = conv_s16_out_size(input_ht, filter_ht, pad_ht, stride_ht);
+        const int out_channels = channels * ch_mult;
+        const int in_size = input_wd * input_ht * channels;
+        const int out_size = out_wd * out_ht * out_channels;
+        const int filter_size = filter_wd * filter_ht * out_channels;
+
+        input = memalign(16, in_size * sizeof(int16_t));
+        out_data_c = memalign(16, out_size * sizeof(int16_t));
+        out_data_opt = memalign(16, out_size * sizeof(int16_t));
+        filter_data = memalign(16, filter_size);
+        bias = memalign(16, out_channels * sizeof(int64_t));
+        out_shift = memalign(16, out_channels * sizeof(int32_t));
+        out_mult = memalign(16, out_channels * sizeof(int32_t));
+        if (input == NULL || out_data_c == NULL || out_data_opt == NULL || filter_data == NULL ||
+                bias == NULL || out_shift == NULL || out_mult == NULL) {
+            printf(ANSI_COLOR_RED"[%3d] allocations failed\n"ANSI_COLOR_RESET, itr);
+            goto dc_s16_cleanup;
+        }
+
+        for (int i = 0; i < in_size; ++i) {
+            input[i] = rand() % 65536 - 32768;
+        }
+        for (int i = 0; i < filter_size; ++i) {
+            filter_data[i] = rand() % 256 - 128;
+        }
+        for (int i = 0; i < out_channels; ++i) {
+            bias[i] = (int64_t) (rand() % 65536 - 32768) << 8;
+            out_shift[i] = -12 + rand() % 3;
+            out_mult[i] = 0x7eb0e200 + rand() % 50;
         }
+
+        data_dims_t input_dims = {.width = input_wd, .height = input_ht, .channels = channels, 1};
+        data_dims_t output_dims = {.width = out_wd, .height = out_ht, .channels = out_channels, 1};
+        data_dims_t filter_dims = {.width = filter_wd, .height = filter_ht, 0, 0};
+        dw_conv_params_t conv_params = {.in_offset = 0, .out_offset = 0, .ch_mult = ch_mult,
+                                        .stride = {stride_wd, stride_ht}, .padding = {pad_wd, pad_ht},
+                                        .dilation = {0, 0}, .activation = {-30000, 30000}};
+        quant_data_t quant_data = {.shift = out_shift, .mult = out_mult};
+
+        /* enable profiler */
+        profile_c_start();
+
+        /* C function */
+        esp_nn_depthwise_conv_s16_ansi(&input_dims, input, &filter_dims, filter_data, bias,
+                                       &output_dims, out_data_c, &conv_params, &quant_data);
+
+        total_c = profile_c_end();
+        profile_opt_start();
+
+        /* Optimized function */
+        esp_nn_depthwise_conv_s16(&input_dims, input, &filter_dims, filter_data, bias,
+                                  &output_dims, out_data_opt, &conv_params, &quant_data);
+
+        /* disable profiler */
+        total_opt = profile_opt_end();
+
+        bool ret = CHECK_EQUAL(out_data_c, out_data_opt, out_size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed [ pad: (%d, %d), stride: (%d, %d)"
+                   " out: (%3d,%3d), filter: (%d, %d,%3d), ch_mult %d]\n"ANSI_COLOR_RESET,
+                   itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd, out_ht,
+                   filter_wd, filter_ht, channels, ch_mult);
+            goto dc_s16_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [ pad: (%d, %d), stride: (%d, %d)"
+               " out: (%3d,%3d), filter: (%d, %d,%3d), ch_mult %d]"ANSI_COLOR_RESET,
+               itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd,
+               out_ht, filter_wd, filter_ht, channels, ch_mult);
+        printf("\tcycles: c %8u, opt %8u\n", total_c, total_opt);
+
+    dc_s16_cleanup:
+        free(input);
+        free(out_data_c);
+        free(out_data_opt);
+        free(filter_data);
+        free(bias);
+        free(out_shift);
+        free(out_mult);
+        input = out_data_c = out_data_opt = NULL;
+        filter_data = NULL;
+        bias = NULL;
+        out_shift = out_mult = NULL;
+    }
+}
+
+void esp_nn_conv_s16_test()
+{
+    uint32_t total_c = 0, total_opt = 0;
+    int16_t *input = NULL, *out_data_c = NULL, *out_data_opt = NULL;
+    int8_t *filter_data = NULL;
+    int64_t *bias = NULL;
+    int32_t *out_shift = NULL, *out_mult = NULL;
+    uint16_t in_wd, in_ht, in_channels, filter_wd, filter_ht;
+    uint16_t pad_wd, pad_ht, stride_wd, stride_ht;
+
+    printf("\n######## Running %s ##########\n", __FUNCTION__);
+    for (int itr = 0; itr < CONV_S16_TEST_ITERATIONS; itr++) {
+        conv_s16_test_params(itr, &in_wd, &in_ht, &in_channels,
+                             &filter_wd, &filter_ht, &pad_wd, &pad_ht, &stride_wd, &stride_ht);
+        const uint16_t out_wd = conv_s16_out_size(in_wd, filter_wd, pad_wd, stride_wd);
+        const uint16_t out_ht = conv_s16_out_size(in_ht, filter_ht, pad_ht, stride_ht);
+        const int out_channels = 4 * (itr + 1) + itr % 3; /* blocks of 4 and left-over */
+        const int in_size = in_wd * in_ht * in_channels;
+        const int out_size = out_wd * out_ht * out_channels;
+        const int filter_size = filter_wd * filter_ht * in_channels * out_channels;
+
+        input = memalign(16, in_size * sizeof(int16_t));
+        out_data_c = memalign(16, out_size * sizeof(int16_t));
+        out_data_opt = memalign(16, out_size * sizeof(int16_t));
+        filter_data = memalign(16, filter_size);
+        bias = memalign(16, out_channels * sizeof(int64_t));
+        out_shift = memalign(16, out_channels * sizeof(int32_t));
+        out_mult = memalign(16, out_channels * sizeof(int32_t));
+        if (input == NULL || out_data_c == NULL || out_data_opt == NULL || filter_data == NULL ||
+                bias == NULL || out_shift == NULL || out_mult == NULL) {
+            printf(ANSI_COLOR_RED"[%3d] allocations failed\n"ANSI_COLOR_RESET, itr);
+            goto conv_s16_cleanup;
+        }
+
+        /* the largest products in the third iteration, over more than a chunk */
+        for (int i = 0; i < in_size; ++i) {
+            input[i] = itr == 3 ? INT16_MIN : rand() % 65536 - 32768;
+        }
+        for (int i = 0; i < filter_size; ++i) {
+            filter_data[i] = itr == 3 ? INT8_MIN : rand() % 256 - 128;
+        }
+        for (int i = 0; i < out_channels; ++i) {
+            bias[i] = (int64_t) (rand() % 65536 - 32768) << 12;
+            out_shift[i] = -18 + rand() % 4;
+            out_mult[i] = 0x7f67f4f8 + rand() % 50;
+        }
+
+        data_dims_t input_dims = {.width = in_wd, .height = in_ht, .channels = in_channels, 1};
+        data_dims_t output_dims = {.width = out_wd, .height = out_ht, .channels = out_channels, 1};
+        data_dims_t filter_dims = {.width = filter_wd, .height = filter_ht, 0, 0};
+        conv_params_t conv_params = {.in_offset = 0, .out_offset = 0,
+                                     .stride = {stride_wd, stride_ht}, .padding = {pad_wd, pad_ht},
+                                     .dilation = {0, 0}, .activation = {INT16_MIN, INT16_MAX}};
+        quant_data_t quant_data = {.shift = out_shift, .mult = out_mult};
+
+        /* enable profiler */
+        profile_c_start();
+
+        /* C function */
+        esp_nn_conv_s16_ansi(&input_dims, input, &filter_dims, filter_data, bias,
+                             &output_dims, out_data_c, &conv_params, &quant_data);
+
+        total_c = profile_c_end();
+        profile_opt_start();
+
+        /* Optimized function */
+        esp_nn_conv_s16(&input_dims, input, &filter_dims, filter_data, bias,
+                        &output_dims, out_data_opt, &conv_params, &quant_data);
+
+        /* disable profiler */
+        total_opt = profile_opt_end();
+
+        bool ret = CHECK_EQUAL(out_data_c, out_data_opt, out_size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed [ pad: (%d, %d), stride: (%d, %d)"
+                   " out: (%3d,%3d,%3d), filter: (%d, %d,%3d)]\n"ANSI_COLOR_RESET,
+                   itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd, out_ht,
+                   out_channels, filter_wd, filter_ht, in_channels);
+            goto conv_s16_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [ pad: (%d, %d), stride: (%d, %d)"
+               " out: (%3d,%3d,%3d), filter: (%d, %d,%3d)]"ANSI_COLOR_RESET,
+               itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd, out_ht,
+               out_channels, filter_wd, filter_ht, in_channels);
+        printf("\tcycles: c %8u, opt %8u\n", total_c, total_opt);
+
+    conv_s16_cleanup:
+        free(input);
+        free(out_data_c);
+        free(out_data_opt);
+        free(filter_data);
+        free(bias);
+        free(out_shift);
+        free(out_mult);
+        input = out_data_c = out_data_opt = NULL;
+        filter_data = NULL;
+        bias = NULL;
+        out_shift = out_mult = NULL;
+    }
+}
+
+void esp_nn_conv_1x1_sparse_s8_test()
+{
+    uint32_t total_c = 0, total_opt = 0;
+    int8_t *input = NULL, *out_data_c = NULL, *out_data_opt = NULL, *filter_data = NULL;
+    int32_t *bias = NULL, *out_shift = NULL, *out_mult = NULL;
+    int32_t *row_start = NULL;
+    uint8_t *cols = NULL;
+    int8_t *values = NULL;
+    const int32_t activation_min = -125;
+    const int32_t activation_max = 122;
+    const int32_t out_offset = 3;
+
+    printf("\n######## Running %s ##########\n", __FUNCTION__);
+    for (int itr = 0; itr < 4; itr++) {
+        /* pixels in blocks of 4 and left-over */
+        const int in_wd = 7 + itr, in_ht = 5 + itr;
+        const int in_channels = itr == 3 ? 64 : 32 + 2 * itr + 1;
+        const int out_channels = 8 + 3 * itr;
+        const int stride = itr % 2 + 1;
+        const int out_wd = (in_wd + stride - 1) / stride;
+        const int out_ht = (in_ht + stride - 1) / stride;
+        const int32_t input_offset = rand() % 256 - 128;
+        const int in_size = in_wd * in_ht * in_channels;
+        const int out_size = out_wd * out_ht * out_channels;
+        const int filter_size = in_channels * out_channels;
+
+        input = memalign(16, in_size);
+        out_data_c = memalign(16, out_size);
+        out_data_opt = memalign(16, out_size);
+        filter_data = memalign(16, filter_size);
+        bias = memalign(16, out_channels * sizeof(int32_t));
+        out_shift = memalign(16, out_channels * sizeof(int32_t));
+        out_mult = memalign(16, out_channels * sizeof(int32_t));
+        if (input == NULL || out_data_c == NULL || out_data_opt == NULL || filter_data == NULL ||
+                bias == NULL || out_shift == NULL || out_mult == NULL) {
+            printf(ANSI_COLOR_RED"[%3d] allocations failed\n"ANSI_COLOR_RESET, itr);
+            goto conv_sparse_cleanup;
+        }
+
+        for (int i = 0; i < in_size; ++i) {
+            input[i] = rand() % 256 - 128;
+        }
+        /* unstructured pruning of 65% of the weights and up */
+        for (int i = 0; i < filter_size; ++i) {
+            filter_data[i] = rand() % 100 < 65 + 5 * itr ? 0 : rand() % 256 - 128;
+        }
+        for (int i = 0; i < out_channels; ++i) {
+            bias[i] = (int32_t)rand() % UINT16_MAX + UINT8_MAX;
+            out_shift[i] = -10 + rand() % 2;
+            out_mult[i] = 0x7f67f4f8 + rand() % 50;
+        }
+
+        data_dims_t input_dims = {.width = in_wd, .height = in_ht, .channels = in_channels, 1};
+        data_dims_t output_dims = {.width = out_wd, .height = out_ht, .channels = out_channels, 1};
+        data_dims_t filter_dims = {.width = 1, .height = 1, 0, 0};
+        conv_params_t conv_params = {.in_offset = input_offset, .out_offset = out_offset,
+                                     .stride = {stride, stride}, .padding = {0, 0},
+                                     .dilation = {0, 0}, .activation = {activation_min, activation_max}};
+        quant_data_t quant_data = {.shift = out_shift, .mult = out_mult};
+
+        /* weights encoded offline */
+        int32_t sparse_size = esp_nn_get_sparse_s8_size(filter_data, out_channels, in_channels);
+        row_start = memalign(16, (out_channels + 1) * sizeof(int32_t));
+        cols = memalign(16, filter_size);
+        values = memalign(16, filter_size);
+        if (sparse_size <= 0 || row_start == NULL || cols == NULL || values == NULL) {
+            printf(ANSI_COLOR_RED"[%3d] failed, sparse size %d\n"ANSI_COLOR_RESET, itr, (int) sparse_size);
+            goto conv_sparse_cleanup;
+        }
+        esp_nn_encode_sparse_s8(filter_data, out_channels, in_channels, row_start, cols, values);
+        sparse_s8_t sparse = {.rows = out_channels, .row_len = in_channels, .row_start = row_start,
+                              .cols = cols, .col_size = 1, .values = values};
+
+        /* enable profiler */
+        profile_c_start();
+
+        /* C function */
+        esp_nn_conv_s8_ansi(&input_dims, input, &filter_dims, filter_data,
+                            bias, &output_dims, out_data_c, &conv_params, &quant_data);
+
+        total_c = profile_c_end();
+        profile_opt_start();
+
+        /* Sparse function */
+        esp_nn_conv_1x1_sparse_s8(&input_dims, input, &sparse, bias, &output_dims, out_data_opt,
+                                  &conv_params, &quant_data);
+
+        /* disable profiler */
+        total_opt = profile_opt_end();
+
+        bool ret = CHECK_EQUAL(out_data_c, out_data_opt, out_size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed [ stride: (%d, %d) out: (%3d,%3d,%3d), in_ch: %3d]\n"
+                   ANSI_COLOR_RESET, itr, stride, stride, out_wd, out_ht, out_channels, in_channels);
+            goto conv_sparse_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [ stride: (%d, %d) out: (%3d,%3d,%3d), in_ch: %3d]"
+               ANSI_COLOR_RESET, itr, stride, stride, out_wd, out_ht, out_channels, in_channels);
+        printf("\tcycles: c %8u, opt %8u\n", total_c, total_opt);
+
+    conv_sparse_cleanup:
+        free(input);
+        free(out_data_c);
+        free(out_data_opt);
+        free(filter_data);
+        free(bias);
+        free(out_shift);
+        free(out_mult);
+        free(row_start);
+        free(cols);
+        free(values);
+        input = out_data_c = out_data_opt = filter_data = values = NULL;
+        bias = out_shift = out_mult = row_start = NULL;
+        cols = NULL;
     }
 }
@@ -8,6 +8,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <esp_nn.h>
 #include "test_utils.h"
@@ -101,3 +102,166 @@ void esp_nn_fully_connected_s8_test()
         printf("\tcycles: c %8u, opt %8u\n", total_c, total_opt);
     }
 }
+
+void esp_nn_fully_connected_s16_test()
+{
+    uint32_t total_c = 0, total_opt = 0;
+    /* prepare data */
+    static uint16_t row_len = 512 + 8 + 7; /* more than 2 chunks of 32 bit sums */
+    static uint16_t out_channels = 7; /* a block of 4 and left-over */
+    int16_t input[row_len];
+    int8_t filter_data[row_len * out_channels];
+    int64_t bias[out_channels];
+    int16_t output_c[out_channels], output_opt[out_channels];
+    static int32_t activation_min = INT16_MIN;
+    static int32_t activation_max = INT16_MAX;
+    int32_t out_shift = -10;
+    int32_t out_mult = 0x59e492c4;
+    printf("\n######## Running %s ##########\n", __FUNCTION__);
+    for (int itr = 0; itr < 5; itr++) {
+        out_mult = 0x40000000 + rand() % 0x3fffffff;
+        switch (itr) {
+        case 0:
+            out_shift = -15;
+            break;
+        case 1:
+            out_shift = -31;
+            break;
+        case 2:
+            out_shift = 0;
+            break;
+        default:
+            out_shift = -20 + rand() % 10;
+            break;
+        }
+        /* Generate input and filter data, the largest products on the last */
+        for (int i = 0; i < row_len; ++i) {
+            input[i] = itr == 4 ? INT16_MIN : rand() % 65536 - 32768;
+        }
+        for (int i = 0; i < row_len * out_channels; ++i) {
+            filter_data[i] = itr == 4 ? INT8_MIN : rand() % 256 - 128;
+        }
+        for (int i = 0; i < out_channels; ++i) {
+            bias[i] = (int64_t) (rand() % 65536 - 32768) << 12;
+        }
+
+        /* enable profiler */
+        profile_c_start();
+
+        /* C function */
+        esp_nn_fully_connected_s16_ansi(input, row_len, filter_data, bias, output_c, out_channels,
+                                        out_shift, out_mult, activation_min, activation_max);
+
+        total_c = profile_c_end();
+        profile_opt_start();
+
+        /* Optimized function */
+        esp_nn_fully_connected_s16(input, row_len, filter_data, bias, output_opt, out_channels,
+                                   out_shift, out_mult, activation_min, activation_max);
+
+        /* disable profiler */
+        total_opt = profile_opt_end();
+
+        bool ret = CHECK_EQUAL(output_c, output_opt, out_channels);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed\n"ANSI_COLOR_RESET, itr);
+            return;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [row_len %d, out_ch %d]"ANSI_COLOR_RESET,
+               itr, row_len, out_channels);
+        printf("\tcycles: c %8u, opt %8u\n", total_c, total_opt);
+    }
+}
+
+void esp_nn_fully_connected_sparse_s8_test()
+{
+    uint32_t total_c = 0, total_opt = 0;
+    /* prepare data */
+    static uint16_t max_row_len = 256 + 8 + 3; /* columns of 2 bytes */
+    static uint16_t out_channels = 9;
+    int8_t input[max_row_len];
+    int8_t filter_data[max_row_len * out_channels];
+    int32_t bias[out_channels];
+    int8_t output_c[out_channels], output_opt[out_channels];
+    static int32_t activation_min = -128;
+    static int32_t activation_max = 127;
+    int32_t input_offset = 0;
+    static int32_t out_offset = -5;
+    int32_t out_shift = -10;
+    int32_t out_mult = 0x59e492c4;
+    static int32_t row_start[9 + 1];
+    static uint16_t cols[256 * 9];
+    static int8_t values[256 * 9];
+    printf("\n######## Running %s ##########\n", __FUNCTION__);
+    for (int itr = 0; itr < 5; itr++) {
+        /* unstructured pruning, 60% and up, a row empty */
+        const uint16_t row_len = itr < 3 ? 3 * 64 + 5 : max_row_len;
+        const int pruned = itr < 3 ? 60 + 10 * itr : 75 + 10 * (itr - 3);
+        out_mult = INT32_MAX / row_len + rand() % INT16_MAX;
+        out_shift = itr == 0 ? SHIFT_MAX : -10 + rand() % 5;
+        input_offset = rand() % 256 - 128;
+        /* Generate input and filter data */
+        for (int i = 0; i < row_len; ++i) {
+            input[i] = rand() % 256 - 128;
+        }
+        for (int i = 0; i < row_len * out_channels; ++i) {
+            filter_data[i] = (i / row_len == 2 || rand() % 100 < pruned) ? 0 : rand() % 256 - 128;
+        }
+        for (int i = 0; i < out_channels; ++i) {
+            bias[i] = rand() % 65536 - 32768;
+        }
+
+        /* encoded offline, once */
+        int32_t size = esp_nn_get_sparse_s8_size(filter_data, out_channels, row_len);
+        if (size <= 0 || size >= row_len * out_channels) {
+            printf(ANSI_COLOR_RED"[%3d] failed, sparse size %d\n"ANSI_COLOR_RESET, itr, (int) size);
+            return;
+        }
+        esp_nn_encode_sparse_s8(filter_data, out_channels, row_len, row_start, cols, values);
+        sparse_s8_t sparse = {.rows = out_channels, .row_len = row_len, .row_start = row_start,
+                              .cols = cols, .col_size = row_len <= 256 ? 1 : 2,
+                              .values = values};
+
+        /* enable profiler */
+        profile_c_start();
+
+        /* C function */
+        esp_nn_fully_connected_s8_ansi(input, input_offset, row_len, filter_data, 0,
+                                       bias, output_c, out_channels, out_offset, out_shift,
+                                       out_mult, activation_min, activation_max);
+
+        total_c = profile_c_end();
+        profile_opt_start();
+
+        /* Sparse function */
+        esp_nn_fully_connected_sparse_s8(input, input_offset, &sparse, bias, output_opt, out_offset, out_shift,
+                                         out_mult, activation_min, activation_max);
+
+        /* disable profiler */
+        total_opt = profile_opt_end();
+
+        bool ret = CHECK_EQUAL(output_c, output_opt, out_channels);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed\n"ANSI_COLOR_RESET, itr);
+            return;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [row_len %d, out_ch %d, %d%% pruned, sparse %d bytes]"ANSI_COLOR_RESET,
+               itr, row_len, out_channels, pruned, (int) size);
+        printf("\tcycles: c %8u, opt %8u\n", total_c, total_opt);
+    }
+
+    /* dense filters, and columns of 2 bytes at 60%, are left as they are */
+    for (int i = 0; i < max_row_len * out_channels; ++i) {
+        filter_data[i] = rand() % 255 - 127;
+        filter_data[i] += filter_data[i] == 0;
+    }
+    if (esp_nn_get_sparse_s8_size(filter_data, out_channels, max_row_len) != 0) {
+        printf(ANSI_COLOR_RED"dense filter made sparse, failed\n"ANSI_COLOR_RESET);
+    }
+    for (int i = 0; i < max_row_len * out_channels; ++i) {
+        filter_data[i] = i % 5 < 3 ? 0 : filter_data[i];
+    }
+    if (esp_nn_get_sparse_s8_size(filter_data, out_channels, max_row_len) != 0) {
+        printf(ANSI_COLOR_RED"bigger sparse filter, failed\n"ANSI_COLOR_RESET);
+    }
+}
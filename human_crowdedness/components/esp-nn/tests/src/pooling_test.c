@@ -21,164 +21,315 @@
 #include <esp_nn.h>
 #include "test_utils.h"
 
+#define POOL_TEST_ITERATIONS    7
 
-void esp_nn_avg_pool_s8_test()
+/**
+ * width/height, channels etc look suspicious but it it true.
+ * It actually depends upon where in model this is actually placed.
+ * If at the end wd/ht tends to be smaller and depth larger.
+ */
+static void pool_test_params(int itr, uint16_t *input_wd, uint16_t *input_ht, uint16_t *channels,
+                             uint16_t *filter_wd, uint16_t *filter_ht, uint16_t *pad_wd, uint16_t *pad_ht,
+                             uint16_t *stride_wd, uint16_t *stride_ht,
+                             int32_t *activation_min, int32_t *activation_max)
 {
-    /* prepare data */
-    const uint16_t input_wd = 16;
-    const uint16_t input_ht = 16;
-    const uint16_t channels = 16; /* With TFLite example, I have seen it 256 */
-    const int size = input_wd * input_ht * channels;
-    int8_t *input, *output_c, *output_opt;
-    const int32_t activation_min = -128;
-    const int32_t activation_max = 127;
-    const uint16_t pad_wd = 1;
-    const uint16_t pad_ht = 1;
-    const uint16_t stride_wd = 1;
-    const uint16_t stride_ht = 1;
-    const uint16_t filter_ht = 3;
-    const uint16_t filter_wd = 3;
-    const uint16_t out_wd = input_wd / stride_wd;
-    const uint16_t out_ht = input_ht / stride_ht;
-    const int out_size = out_wd * out_ht * channels;
-
-    input = memalign(16, size);
-    output_c = memalign(16, out_size);
-    output_opt = memalign(16, out_size);
-
-    if (input == NULL || output_c == NULL || output_opt == NULL) {
-        printf(ANSI_COLOR_RED"%s allocations failed\n"ANSI_COLOR_RESET, __FUNCTION__);
-        goto avg_pool_s8_cleanup;
-    }
-    /**
-     * width/height, channels etc look suspicious but it it true.
-     * It actually depends upon where in model this is actually placed.
-     * If at the end wd/ht tends to be smaller and depth larger.
-     */
-
-    for (int i = 0; i < size; ++i) {
-        input[i] = rand() % 256 - 128;
+    *activation_min = -128;
+    *activation_max = 127;
+
+    switch (itr) {
+    case 0: // filter (3,3), pad (1,1)
+        *input_wd = 16; *input_ht = 16; *channels = 16;
+        *filter_wd = 3; *filter_ht = 3; *pad_wd = 1; *pad_ht = 1;
+        *stride_wd = 1; *stride_ht = 1;
+        break;
+    case 1: // stride (2,2), channels % 16 != 0, windows cut on the right
+        *input_wd = 16; *input_ht = 16; *channels = 24;
+        *filter_wd = 3; *filter_ht = 3; *pad_wd = 1; *pad_ht = 1;
+        *stride_wd = 2; *stride_ht = 2;
+        break;
+    case 2: // pooling of the whole input, as at the end of the model
+        *input_wd = 12; *input_ht = 12; *channels = 80;
+        *filter_wd = 12; *filter_ht = 12; *pad_wd = 0; *pad_ht = 0;
+        *stride_wd = 1; *stride_ht = 1;
+        break;
+    case 3: // filter (2,2), stride (2,2): windows do not overlap
+        *input_wd = 32; *input_ht = 32; *channels = 8;
+        *filter_wd = 2; *filter_ht = 2; *pad_wd = 0; *pad_ht = 0;
+        *stride_wd = 2; *stride_ht = 2;
+        break;
+    case 4: // filter (5,5), pad (2,2), more channels than a chunk, activation
+        *input_wd = 20; *input_ht = 20; *channels = 130;
+        *filter_wd = 5; *filter_ht = 5; *pad_wd = 2; *pad_ht = 2;
+        *stride_wd = 1; *stride_ht = 1;
+        *activation_min = -100;
+        *activation_max = 100;
+        break;
+    case 5: // stride larger than the filter
+        *input_wd = 17; *input_ht = 17; *channels = 4;
+        *filter_wd = 2; *filter_ht = 2; *pad_wd = 0; *pad_ht = 0;
+        *stride_wd = 3; *stride_ht = 3;
+        break;
+    default: // filter (4,2) not square, odd channels
+        *input_wd = 15; *input_ht = 11; *channels = 7;
+        *filter_wd = 4; *filter_ht = 2; *pad_wd = 1; *pad_ht = 0;
+        *stride_wd = 1; *stride_ht = 2;
+        break;
     }
+}
 
-    /* enable profiler */
-    profile_c_start();
+static uint16_t pool_out_size(uint16_t input, uint16_t filter, uint16_t pad, uint16_t stride)
+{
+    return (input + 2 * pad - filter + stride - 1) / stride + 1;
+}
 
-    /* C function */
-    esp_nn_avg_pool_s8_ansi(input, input_wd, input_ht, output_c, out_wd, out_ht,
-                              stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
-                              activation_min, activation_max, channels);
+void esp_nn_avg_pool_s8_test()
+{
+    int8_t *input = NULL, *output_c = NULL, *output_opt = NULL;
+    uint16_t input_wd, input_ht, channels, filter_wd, filter_ht;
+    uint16_t pad_wd, pad_ht, stride_wd, stride_ht;
+    int32_t activation_min, activation_max;
+    uint32_t total_c = 0, total_opt = 0;
 
-    profile_c_end();
-    profile_opt_start();
+    printf("\n######## Running %s ##########\n", __FUNCTION__);
+    for (int itr = 0; itr < POOL_TEST_ITERATIONS; itr++) {
+        /* prepare data */
+        pool_test_params(itr, &input_wd, &input_ht, &channels, &filter_wd, &filter_ht,
+                         &pad_wd, &pad_ht, &stride_wd, &stride_ht, &activation_min, &activation_max);
+        const uint16_t out_wd = pool_out_size(input_wd, filter_wd, pad_wd, stride_wd);
+        const uint16_t out_ht = pool_out_size(input_ht, filter_ht, pad_ht, stride_ht);
+        const int size = input_wd * input_ht * channels;
+        const int out_size = out_wd * out_ht * channels;
 
-    /* Optimized function */
-    esp_nn_avg_pool_s8(input, input_wd, input_ht, output_opt, out_wd, out_ht,
-                         stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
-                         activation_min, activation_max, channels);
+        input = memalign(16, size);
+        output_c = memalign(16, out_size);
+        output_opt = memalign(16, out_size);
 
-    /* disable profiler */
-    profile_opt_end();
+        if (input == NULL || output_c == NULL || output_opt == NULL) {
+            printf(ANSI_COLOR_RED"[%3d] allocations failed\n"ANSI_COLOR_RESET, itr);
+            goto avg_pool_s8_cleanup;
+        }
 
+        for (int i = 0; i < size; ++i) {
+            input[i] = rand() % 256 - 128;
+        }
 
-    bool ret = CHECK_EQUAL(output_c, output_opt, out_size);
-    if (ret == false) {
-        printf(ANSI_COLOR_RED"%s failed\n"ANSI_COLOR_RESET, __FUNCTION__);
-        printf("Output: \n");
-        PRINT_ARRAY_HEX(output_opt, out_wd * channels, out_ht);
-        printf("Expected: \n");
-        PRINT_ARRAY_HEX(output_c, out_wd * channels, out_ht);
-        printf("Input:\n");
-        PRINT_ARRAY_HEX(input, input_wd * channels, input_ht);
-        goto avg_pool_s8_cleanup;
-    }
-    printf(ANSI_COLOR_GREEN"%s passed\n"ANSI_COLOR_RESET, __FUNCTION__);
+        /* enable profiler */
+        profile_c_start();
 
-avg_pool_s8_cleanup:
-    if (input) {
-        free(input);
-    }
-    if (output_c) {
-        free(output_c);
-    }
-    if (output_opt) {
-        free(output_opt);
+        /* C function */
+        esp_nn_avg_pool_s8_ansi(input, input_wd, input_ht, output_c, out_wd, out_ht,
+                                stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
+                                activation_min, activation_max, channels);
+
+        total_c = profile_c_end();
+        profile_opt_start();
+
+        /* Optimized function */
+        esp_nn_avg_pool_s8(input, input_wd, input_ht, output_opt, out_wd, out_ht,
+                           stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
+                           activation_min, activation_max, channels);
+
+        /* disable profiler */
+        total_opt = profile_opt_end();
+
+        bool ret = CHECK_EQUAL(output_c, output_opt, out_size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed [ pad: (%d, %d), stride: (%d, %d)"
+                   " out: (%3d,%3d,%3d), filter: (%d, %d)]\n"ANSI_COLOR_RESET,
+                   itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd, out_ht,
+                   channels, filter_wd, filter_ht);
+#if 0
+            printf("Output: \n");
+            PRINT_ARRAY_HEX(output_opt, out_wd * channels, out_ht);
+            printf("Expected: \n");
+            PRINT_ARRAY_HEX(output_c, out_wd * channels, out_ht);
+            printf("Input:\n");
+            PRINT_ARRAY_HEX(input, input_wd * channels, input_ht);
+#endif
+            goto avg_pool_s8_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [ pad: (%d, %d), stride: (%d, %d)"
+               " out: (%3d,%3d,%3d), filter: (%d, %d)]"ANSI_COLOR_RESET,
+               itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd, out_ht,
+               channels, filter_wd, filter_ht);
+        printf("\tcycles: c %8u, opt %8u\n", total_c, total_opt);
+
+    avg_pool_s8_cleanup:
+        if (input) {
+            free(input);
+        }
+        if (output_c) {
+            free(output_c);
+        }
+        if (output_opt) {
+            free(output_opt);
+        }
+        input = output_c = output_opt = NULL;
     }
 }
 
-void esp_nn_max_pool_s8_test()
+void esp_nn_avg_pool_s16_test()
 {
-    /* prepare data */
-    const uint16_t input_wd = 16;
-    const uint16_t input_ht = 16;
-    const uint16_t channels = 16; /* With TFLite example, I have seen it 256 */
-    int8_t *input, *output_c, *output_opt;
-    const int size = input_wd * input_ht * channels;
-    const int32_t activation_min = -128;
-    const int32_t activation_max = 127;
-    const uint16_t pad_wd = 1;
-    const uint16_t pad_ht = 1;
-    const uint16_t stride_wd = 1;
-    const uint16_t stride_ht = 1;
-    const uint16_t filter_ht = 3;
-    const uint16_t filter_wd = 3;
-    const uint16_t out_wd = input_wd / stride_wd;
-    const uint16_t out_ht = input_ht / stride_ht;
-    const int out_size = out_wd * out_ht * channels;
-
-    input = memalign(16, size);
-    output_c = memalign(16, out_size);
-    output_opt = memalign(16, out_size);
-
-    if (input == NULL || output_c == NULL || output_opt == NULL) {
-        printf(ANSI_COLOR_RED"%s allocations failed\n"ANSI_COLOR_RESET, __FUNCTION__);
-        goto max_pool_s8_cleanup;
-    }
+    int16_t *input = NULL, *output_c = NULL, *output_opt = NULL;
+    uint16_t input_wd, input_ht, channels, filter_wd, filter_ht;
+    uint16_t pad_wd, pad_ht, stride_wd, stride_ht;
+    int32_t activation_min, activation_max;
+    uint32_t total_c = 0, total_opt = 0;
 
-    for (int i = 0; i < size; ++i) {
-        input[i] = rand() % 256 - 128;
-    }
+    printf("\n######## Running %s ##########\n", __FUNCTION__);
+    for (int itr = 0; itr < POOL_TEST_ITERATIONS; itr++) {
+        /* prepare data, same shapes as int8 with int16 activation range */
+        pool_test_params(itr, &input_wd, &input_ht, &channels, &filter_wd, &filter_ht,
+                         &pad_wd, &pad_ht, &stride_wd, &stride_ht, &activation_min, &activation_max);
+        activation_min = activation_min == -128 ? INT16_MIN : -25000;
+        activation_max = activation_max == 127 ? INT16_MAX : 25000;
+        const uint16_t out_wd = pool_out_size(input_wd, filter_wd, pad_wd, stride_wd);
+        const uint16_t out_ht = pool_out_size(input_ht, filter_ht, pad_ht, stride_ht);
+        const int size = input_wd * input_ht * channels;
+        const int out_size = out_wd * out_ht * channels;
+
+        input = memalign(16, size * sizeof(int16_t));
+        output_c = memalign(16, out_size * sizeof(int16_t));
+        output_opt = memalign(16, out_size * sizeof(int16_t));
 
-    /* enable profiler */
-    profile_c_start();
+        if (input == NULL || output_c == NULL || output_opt == NULL) {
+            printf(ANSI_COLOR_RED"[%3d] allocations failed\n"ANSI_COLOR_RESET, itr);
+            goto avg_pool_s16_cleanup;
+        }
 
-    /* C function */
-    esp_nn_max_pool_s8_ansi(input, input_wd, input_ht, output_c, out_wd, out_ht,
+        for (int i = 0; i < size; ++i) {
+            input[i] = rand() % 65536 - 32768;
+        }
+
+        /* enable profiler */
+        profile_c_start();
+
+        /* C function */
+        esp_nn_avg_pool_s16_ansi(input, input_wd, input_ht, output_c, out_wd, out_ht,
+                                 stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
+                                 activation_min, activation_max, channels);
+
+        total_c = profile_c_end();
+        profile_opt_start();
+
+        /* Optimized function */
+        esp_nn_avg_pool_s16(input, input_wd, input_ht, output_opt, out_wd, out_ht,
                             stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
                             activation_min, activation_max, channels);
 
-    profile_c_end();
-    profile_opt_start();
+        /* disable profiler */
+        total_opt = profile_opt_end();
 
-    /* Optimized function */
-    esp_nn_max_pool_s8(input, input_wd, input_ht, output_opt, out_wd, out_ht,
-                       stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
-                       activation_min, activation_max, channels);
+        bool ret = CHECK_EQUAL(output_c, output_opt, out_size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed [ pad: (%d, %d), stride: (%d, %d)"
+                   " out: (%3d,%3d,%3d), filter: (%d, %d)]\n"ANSI_COLOR_RESET,
+                   itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd, out_ht,
+                   channels, filter_wd, filter_ht);
+            goto avg_pool_s16_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [ pad: (%d, %d), stride: (%d, %d)"
+               " out: (%3d,%3d,%3d), filter: (%d, %d)]"ANSI_COLOR_RESET,
+               itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd, out_ht,
+               channels, filter_wd, filter_ht);
+        printf("\tcycles: c %8u, opt %8u\n", total_c, total_opt);
 
-    /* disable profiler */
-    profile_opt_end();
+    avg_pool_s16_cleanup:
+        if (input) {
+            free(input);
+        }
+        if (output_c) {
+            free(output_c);
+        }
+        if (output_opt) {
+            free(output_opt);
+        }
+        input = output_c = output_opt = NULL;
+    }
+}
 
+void esp_nn_max_pool_s8_test()
+{
+    int8_t *input = NULL, *output_c = NULL, *output_opt = NULL;
+    uint16_t input_wd, input_ht, channels, filter_wd, filter_ht;
+    uint16_t pad_wd, pad_ht, stride_wd, stride_ht;
+    int32_t activation_min, activation_max;
+    uint32_t total_c = 0, total_opt = 0;
 
-    bool ret = CHECK_EQUAL(output_c, output_opt, out_wd * out_ht * channels);
-    if (ret == false) {
-        printf(ANSI_COLOR_RED"%s failed\n"ANSI_COLOR_RESET, __FUNCTION__);
-        printf("Output: \n");
-        PRINT_ARRAY_HEX(output_opt, out_wd * out_ht * channels, 1);
-        printf("Expected: \n");
-        PRINT_ARRAY_HEX(output_c, out_wd * out_ht * channels, 1);
-        printf("Input:\n");
-        PRINT_ARRAY_HEX(input, 8, size / 8);
-        goto max_pool_s8_cleanup;
-    }
-    printf(ANSI_COLOR_GREEN"%s passed\n"ANSI_COLOR_RESET, __FUNCTION__);
+    printf("\n######## Running %s ##########\n", __FUNCTION__);
+    for (int itr = 0; itr < POOL_TEST_ITERATIONS; itr++) {
+        /* prepare data */
+        pool_test_params(itr, &input_wd, &input_ht, &channels, &filter_wd, &filter_ht,
+                         &pad_wd, &pad_ht, &stride_wd, &stride_ht, &activation_min, &activation_max);
+        const uint16_t out_wd = pool_out_size(input_wd, filter_wd, pad_wd, stride_wd);
+        const uint16_t out_ht = pool_out_size(input_ht, filter_ht, pad_ht, stride_ht);
+        const int size = input_wd * input_ht * channels;
+        const int out_size = out_wd * out_ht * channels;
 
-max_pool_s8_cleanup:
-    if (input) {
-        free(input);
-    }
-    if (output_c) {
-        free(output_c);
-    }
-    if (output_opt) {
-        free(output_opt);
+        input = memalign(16, size);
+        output_c = memalign(16, out_size);
+        output_opt = memalign(16, out_size);
+
+        if (input == NULL || output_c == NULL || output_opt == NULL) {
+            printf(ANSI_COLOR_RED"[%3d] allocations failed\n"ANSI_COLOR_RESET, itr);
+            goto max_pool_s8_cleanup;
+        }
+
+        for (int i = 0; i < size; ++i) {
+            input[i] = rand() % 256 - 128;
+        }
+
+        /* enable profiler */
+        profile_c_start();
+
+        /* C function */
+        esp_nn_max_pool_s8_ansi(input, input_wd, input_ht, output_c, out_wd, out_ht,
+                                stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
+                                activation_min, activation_max, channels);
+
+        total_c = profile_c_end();
+        profile_opt_start();
+
+        /* Optimized function */
+        esp_nn_max_pool_s8(input, input_wd, input_ht, output_opt, out_wd, out_ht,
+                           stride_wd, stride_ht, filter_wd, filter_ht, pad_wd, pad_ht,
+                           activation_min, activation_max, channels);
+
+        /* disable profiler */
+        total_opt = profile_opt_end();
+
+        bool ret = CHECK_EQUAL(output_c, output_opt, out_size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed [ pad: (%d, %d), stride: (%d, %d)"
+                   " out: (%3d,%3d,%3d), filter: (%d, %d)]\n"ANSI_COLOR_RESET,
+                   itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd, out_ht,
+                   channels, filter_wd, filter_ht);
+#if 0
+            printf("Output: \n");
+            PRINT_ARRAY_HEX(output_opt, out_wd * channels, out_ht);
+            printf("Expected: \n");
+            PRINT_ARRAY_HEX(output_c, out_wd * channels, out_ht);
+            printf("Input:\n");
+            PRINT_ARRAY_HEX(input, input_wd * channels, input_ht);
+#endif
+            goto max_pool_s8_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [ pad: (%d, %d), stride: (%d, %d)"
+               " out: (%3d,%3d,%3d), filter: (%d, %d)]"ANSI_COLOR_RESET,
+               itr, pad_wd, pad_ht, stride_wd, stride_ht, out_wd, out_ht,
+               channels, filter_wd, filter_ht);
+        printf("\tcycles: c %8u, opt %8u\n", total_c, total_opt);
+
+    max_pool_s8_cleanup:
+        if (input) {
+            free(input);
+        }
+        if (output_c) {
+            free(output_c);
+        }
+        if (output_opt) {
+            free(output_opt);
+        }
+        input = output_c = output_opt = NULL;
     }
 }
@@ -99,3 +99,93 @@ softmax_s8_cleanup:
         free (scratch_buf);
     }
 }
+
+#define SOFTMAX_LUT_TEST_ITERATIONS 8
+
+void esp_nn_softmax_s8_lut_test()
+{
+    /**
+     * leftovers of the vector loops, long rows, a cut-off of the exps and
+     * flat rows, whose exps sum to more than 256 and 512
+     */
+    const int32_t widths[SOFTMAX_LUT_TEST_ITERATIONS] = {1, 2, 7, 33, 300, 32, 300, 1001};
+    const int32_t heights[SOFTMAX_LUT_TEST_ITERATIONS] = {5, 3, 4, 2, 1, 8, 2, 2};
+    const int32_t shifts[SOFTMAX_LUT_TEST_ITERATIONS] = {7, 5, 3, 6, 7, 4, 1, 1};
+    const int32_t diff_mins[SOFTMAX_LUT_TEST_ITERATIONS] = {-128, -248, -31, -128, -4000, -80, -255, -255};
+    const int32_t mult = INT32_MAX / 2;
+    int32_t *lut = NULL;
+    int8_t *input = NULL, *out_ansi = NULL, *out_opt = NULL;
+
+    lut = memalign(4, ESP_NN_SOFTMAX_LUT_SIZE * sizeof(int32_t));
+    if (lut == NULL) {
+        printf(ANSI_COLOR_RED"%s lut alloc failed\n"ANSI_COLOR_RESET, __FUNCTION__);
+        return;
+    }
+
+    for (int itr = 0; itr < SOFTMAX_LUT_TEST_ITERATIONS; itr++) {
+        const int32_t width = widths[itr];
+        const int32_t height = heights[itr];
+        const int32_t shift = shifts[itr];
+        const int32_t diff_min = diff_mins[itr];
+        const int size = width * height;
+
+        input = memalign(16, size);
+        out_ansi = memalign(16, size);
+        out_opt = memalign(16, size);
+        if (input == NULL || out_ansi == NULL || out_opt == NULL) {
+            printf(ANSI_COLOR_RED"[%3d] allocations failed\n"ANSI_COLOR_RESET, itr);
+            goto softmax_s8_lut_cleanup;
+        }
+
+        /* Generate input data between -128 -> +127 */
+        for (int i = 0; i < size; ++i) {
+            input[i] = rand() % 256 - 128;
+        }
+
+        /* enable profiler */
+        profile_c_start();
+
+        /* C function */
+        esp_nn_softmax_s8_ansi(input, height, width, mult, shift, diff_min, out_ansi);
+
+        profile_c_end();
+
+        esp_nn_prepare_softmax_lut_s8(mult, shift, diff_min, lut);
+
+        profile_opt_start();
+
+        /* Optimized function */
+        esp_nn_softmax_s8_lut(input, height, width, lut, out_opt);
+
+        /* disable profiler */
+        profile_opt_end();
+
+        bool ret = CHECK_EQUAL(out_ansi, out_opt, size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed [ shift: %d, diff_min: %d, width: %d, height: %d ]\n"
+                   ANSI_COLOR_RESET, itr, shift, diff_min, width, height);
+            printf("Output: \n");
+            PRINT_ARRAY_HEX(out_opt, width, height);
+            printf("Expected: \n");
+            PRINT_ARRAY_HEX(out_ansi, width, height);
+            printf("Input:\n");
+            PRINT_ARRAY_HEX(input, width, height);
+            goto softmax_s8_lut_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [ shift: %d, diff_min: %d, width: %d, height: %d ]\n"
+               ANSI_COLOR_RESET, itr, shift, diff_min, width, height);
+
+softmax_s8_lut_cleanup:
+        if (input) {
+            free (input);
+        }
+        if (out_ansi) {
+            free (out_ansi);
+        }
+        if (out_opt) {
+            free (out_opt);
+        }
+        input = out_ansi = out_opt = NULL;
+    }
+    free (lut);
+}
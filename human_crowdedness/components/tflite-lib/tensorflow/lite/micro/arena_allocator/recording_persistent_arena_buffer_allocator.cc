@@ -0,0 +1,81 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/arena_allocator/recording_persistent_arena_buffer_allocator.h"
+
+#include <new>
+
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
+
+namespace tflite {
+
+RecordingPersistentArenaBufferAllocator::
+    RecordingPersistentArenaBufferAllocator(uint8_t* buffer,
+                                            size_t buffer_size)
+    : PersistentArenaBufferAllocator(buffer, buffer_size),
+      requested_bytes_(0),
+      used_bytes_(0),
+      alloc_count_(0) {}
+
+RecordingPersistentArenaBufferAllocator::
+    ~RecordingPersistentArenaBufferAllocator() {}
+
+RecordingPersistentArenaBufferAllocator*
+RecordingPersistentArenaBufferAllocator::Create(uint8_t* buffer_head,
+                                                size_t buffer_size) {
+  TFLITE_DCHECK(buffer_head != nullptr);
+  // Align the actually used area by the tail because persistent buffer grows
+  // from the bottom to top.
+  uint8_t* aligned_buffer_tail =
+      AlignPointerDown(buffer_head + buffer_size, MicroArenaBufferAlignment());
+  RecordingPersistentArenaBufferAllocator tmp =
+      RecordingPersistentArenaBufferAllocator(buffer_head,
+                                              aligned_buffer_tail - buffer_head);
+
+  uint8_t* allocator_buffer = tmp.AllocatePersistentBuffer(
+      sizeof(RecordingPersistentArenaBufferAllocator),
+      alignof(RecordingPersistentArenaBufferAllocator));
+  // Use the default copy constructor to populate internal states.
+  return new (allocator_buffer) RecordingPersistentArenaBufferAllocator(tmp);
+}
+
+size_t RecordingPersistentArenaBufferAllocator::GetRequestedBytes() const {
+  return requested_bytes_;
+}
+
+size_t RecordingPersistentArenaBufferAllocator::GetUsedBytes() const {
+  return used_bytes_;
+}
+
+size_t RecordingPersistentArenaBufferAllocator::GetAllocatedCount() const {
+  return alloc_count_;
+}
+
+uint8_t* RecordingPersistentArenaBufferAllocator::AllocatePersistentBuffer(
+    size_t size, size_t alignment) {
+  const size_t previous_used_bytes = GetPersistentUsedBytes();
+  uint8_t* result =
+      PersistentArenaBufferAllocator::AllocatePersistentBuffer(size, alignment);
+  if (result != nullptr) {
+    used_bytes_ += GetPersistentUsedBytes() - previous_used_bytes;
+    requested_bytes_ += size;
+    alloc_count_++;
+  }
+  return result;
+}
+
+}  // namespace tflite
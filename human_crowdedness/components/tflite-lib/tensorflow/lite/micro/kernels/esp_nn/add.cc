@@ -28,14 +28,10 @@ limitations under the License.
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
-#include <esp_timer.h>
-
 #if ESP_NN
 #include <esp_nn.h>
 #endif
 
-long long add_total_time = 0;
-
 namespace tflite {
 
 void EvalAdd(TfLiteContext* context, TfLiteNode* node, TfLiteAddParams* params,
@@ -141,6 +137,31 @@ TfLiteStatus EvalAddQuantized(TfLiteContext* context, TfLiteNode* node,
             tflite::micro::GetTensorShape(output),
             tflite::micro::GetTensorData<int16_t>(output));
       } else {
+#if ESP_NN
+        const int16_t *input1_data = tflite::micro::GetTensorData<int16_t>(input1);
+        const int16_t *input2_data = tflite::micro::GetTensorData<int16_t>(input2);
+        int16_t *out_data = tflite::micro::GetTensorData<int16_t>(output);
+
+        esp_nn_add_elementwise_s16(input1_data,
+                                   input2_data,
+                                   data->input1_offset,
+                                   data->input2_offset,
+                                   data->input1_multiplier,
+                                   data->input2_multiplier,
+                                   data->input1_shift,
+                                   data->input2_shift,
+                                   data->left_shift,
+                                   out_data,
+                                   data->output_offset,
+                                   data->output_multiplier,
+                                   data->output_shift,
+                                   data->output_activation_min,
+                                   data->output_activation_max,
+                                   MatchingElementsSize(tflite::micro::GetTensorShape(input1),
+                                                        tflite::micro::GetTensorShape(input2),
+                                                        tflite::micro::GetTensorShape(output))
+                                   );
+#else
         reference_ops::Add(op_params, tflite::micro::GetTensorShape(input1),
                            tflite::micro::GetTensorData<int16_t>(input1),
                            tflite::micro::GetTensorShape(input2),
@@ -148,6 +169,7 @@ TfLiteStatus EvalAddQuantized(TfLiteContext* context, TfLiteNode* node,
                            tflite::micro::GetTensorShape(output),
                            tflite::micro::GetTensorData<int16_t>(output),
                            false);
+#endif
       }
       break;
     }
@@ -178,8 +200,6 @@ TfLiteStatus AddEval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kAddOutputTensor);
 
-  long long start_time = esp_timer_get_time();
-
   if (output->type == kTfLiteFloat32) {
     EvalAdd(context, node, params, data, input1, input2, output);
   } else if (output->type == kTfLiteInt8 || output->type == kTfLiteInt16) {
@@ -190,7 +210,6 @@ TfLiteStatus AddEval(TfLiteContext* context, TfLiteNode* node) {
                 output->type);
     return kTfLiteError;
   }
-  add_total_time += esp_timer_get_time() - start_time;
 
   return kTfLiteOk;
 }
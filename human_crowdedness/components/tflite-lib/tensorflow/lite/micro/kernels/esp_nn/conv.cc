@@ -24,27 +24,20 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/conv_node_data.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/sparse_filter.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
-#include <esp_timer.h>
-
 #if ESP_NN
 #include <esp_nn.h>
 #endif
 
-
-long long conv_total_time = 0;
-
 namespace tflite {
 namespace {
 
-struct NodeData {
-  OpDataConv op_data;
-#if ESP_NN
-  int buffer_idx;
-#endif
-};
+using NodeData = EspNnConvNodeData;
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
@@ -67,6 +60,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TfLiteTensor* filter =
       micro_context->AllocateTempInputTensor(node, kConvWeightsTensor);
   TF_LITE_ENSURE(context, filter != nullptr);
+  TfLiteTensor* bias =
+      micro_context->AllocateTempInputTensor(node, kConvBiasTensor);
   TfLiteTensor* output =
       micro_context->AllocateTempOutputTensor(node, kConvOutputTensor);
   TF_LITE_ENSURE(context, output != nullptr);
@@ -111,6 +106,12 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       filter_height, output_width, output_height, input->type, &data->op_data));
 
 #if ESP_NN
+  data->jobs = 1;
+  data->sparse = nullptr;
+  TF_LITE_ENSURE_MSG(context,
+                     input->type == kTfLiteInt8 ||
+                         !IsEspNnSparseFilter(context, node, kConvWeightsTensor),
+                     "Sparse filters need int8 inputs.");
   if (input->type == kTfLiteInt8) {
     data_dims_t input_dims =  {
                                 .width = input_width, .height = input_height,
@@ -128,25 +129,139 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                                   .dilation = {0, 0}, .activation = {-128, 127}
                                 };
 
+    // The kernels that take a prepared buffer only use the scratch buffer
+    // for the im2col rows of the blocked convolution, and run without it.
     int scratch_buf_size = esp_nn_get_conv_scratch_size(
         &input_dims, &filter_dims, &output_dims, &conv_params);
+    if (!ESP_NN_CONV_ARENA_BUFFERS &&
+        esp_nn_get_conv_prepared_size(&input_dims, &filter_dims, &output_dims,
+                                      &conv_params) > 0) {
+      scratch_buf_size = 0;
+    }
     if (scratch_buf_size > 0) {
       TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
         context, scratch_buf_size, &data->buffer_idx));
     } else {
       data->buffer_idx = -1;
     }
+
+    // Big layers are split by output rows between the workers, every job
+    // with a scratch buffer of its own. Those copies only make the layer
+    // faster, layers that need one are not split without the arena for them.
+    const int64_t macs = static_cast<int64_t>(output_width) * output_height *
+                         output_dims.channels * filter_width * filter_height *
+                         input_dims.channels;
+    data->jobs = ESP_NN_CONV_ARENA_BUFFERS || scratch_buf_size == 0
+                     ? EspNnParallelJobs(macs, output_height)
+                     : 1;
+    for (int i = 0; i < data->jobs - 1; i++) {
+      data->job_buffer_idx[i] = -1;
+      if (scratch_buf_size > 0) {
+        TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+          context, scratch_buf_size, &data->job_buffer_idx[i]));
+      }
+    }
+
+    // 1x1 filters stored sparse in the model are run where they are, the
+    // dense ones have their weights transformed once, for the input offset of
+    // this model, when the arena has room for it.
+    data->prepared_buf = nullptr;
+    conv_params.in_offset = -data->op_data.input_zero_point;
+    const bool constant_weights = IsConstantTensor(filter) &&
+                                  (bias == nullptr || IsConstantTensor(bias));
+    if (IsEspNnSparseFilter(context, node, kConvWeightsTensor)) {
+      TF_LITE_ENSURE_MSG(
+          context,
+          filter_width == 1 && filter_height == 1 &&
+              data->op_data.padding.width == 0 &&
+              data->op_data.padding.height == 0 &&
+              params.dilation_width_factor == 1 &&
+              params.dilation_height_factor == 1,
+          "Sparse filters are only run as 1x1 convolutions without padding.");
+      TF_LITE_ENSURE_STATUS(PrepareEspNnSparseFilter(
+          context, node, kConvWeightsTensor, filter, output_dims.channels,
+          input_dims.channels, &data->sparse));
+    }
+    int prepared_buf_size = esp_nn_get_conv_prepared_size(
+        &input_dims, &filter_dims, &output_dims, &conv_params);
+    if (ESP_NN_CONV_ARENA_BUFFERS && prepared_buf_size > 0 &&
+        constant_weights && data->sparse == nullptr) {
+      data->prepared_buf =
+          context->AllocatePersistentBuffer(context, prepared_buf_size);
+      TF_LITE_ENSURE(context, data->prepared_buf != nullptr);
+      esp_nn_prepare_conv_s8(
+          &input_dims, &filter_dims, GetTensorData<int8_t>(filter),
+          bias != nullptr ? GetTensorData<int32_t>(bias) : nullptr,
+          &output_dims, &conv_params, data->prepared_buf);
+    }
   }
+#else
+  TF_LITE_ENSURE_MSG(context,
+                     !IsEspNnSparseFilter(context, node, kConvWeightsTensor),
+                     "Sparse filters need ESP-NN.");
 #endif
 
   micro_context->DeallocateTempTfLiteTensor(output);
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(filter);
+  if (bias != nullptr) {
+    micro_context->DeallocateTempTfLiteTensor(bias);
+  }
 
   return kTfLiteOk;
 }
 
 #if ESP_NN
+// A layer split by output rows between the workers.
+struct ConvJobs {
+  int jobs;
+  const data_dims_t* input_dims;
+  const int8_t* input_data;
+  const data_dims_t* filter_dims;
+  const int8_t* filter_data;
+  const int32_t* bias;
+  const data_dims_t* output_dims;
+  int8_t* output_data;
+  const conv_params_t* conv_params;
+  const quant_data_t* quant_data;
+  void* prepared_buf;
+  const sparse_s8_t* sparse;
+  void* scratch_bufs[kEspNnMaxJobs];
+};
+
+// Runs the rows of job `index` as a convolution of their own.
+void RunConvJob(void* ctx, int index) {
+  const ConvJobs& jobs = *static_cast<const ConvJobs*>(ctx);
+  const EspNnRowSlice slice = EspNnSliceRows(
+      index, jobs.jobs, jobs.output_dims->height,
+      jobs.conv_params->stride.height, jobs.conv_params->padding.height);
+
+  data_dims_t input_dims = *jobs.input_dims;
+  input_dims.height -= slice.input_row;
+  data_dims_t output_dims = *jobs.output_dims;
+  output_dims.height = slice.output_rows;
+  conv_params_t conv_params = *jobs.conv_params;
+  conv_params.padding.height = slice.pad_height;
+
+  // The buffers are per thread in esp-nn.
+  esp_nn_set_conv_scratch_buf(jobs.scratch_bufs[index]);
+  esp_nn_set_conv_prepared_buf(jobs.prepared_buf);
+  if (jobs.sparse != nullptr) {
+    esp_nn_conv_1x1_sparse_s8(
+        &input_dims,
+        jobs.input_data + slice.input_row * input_dims.width * input_dims.channels,
+        jobs.sparse, jobs.bias, &output_dims,
+        jobs.output_data + slice.output_row * output_dims.width * output_dims.channels,
+        &conv_params, jobs.quant_data);
+    return;
+  }
+  esp_nn_conv_s8(&input_dims,
+                 jobs.input_data + slice.input_row * input_dims.width * input_dims.channels,
+                 jobs.filter_dims, jobs.filter_data, jobs.bias, &output_dims,
+                 jobs.output_data + slice.output_row * output_dims.width * output_dims.channels,
+                 &conv_params, jobs.quant_data);
+}
+
 // Fixed-point per-channel-quantization convolution Int8 function wrapper.
 inline void EvalQuantizedPerChannel(
     TfLiteContext* context, TfLiteNode* node, const TfLiteConvParams& params,
@@ -202,6 +317,7 @@ inline void EvalQuantizedPerChannel(
       scratch_buf = context->GetScratchBuffer(context, data.buffer_idx);
     }
     esp_nn_set_conv_scratch_buf(scratch_buf);
+    esp_nn_set_conv_prepared_buf(data.prepared_buf);
 
     const int input_size = input_width * input_height * input_depth;
     const int output_size = output_width * output_height * output_depth;
@@ -227,6 +343,42 @@ inline void EvalQuantizedPerChannel(
                                 .mult = data.op_data.per_channel_output_multiplier
                               };
 
+    if (data.jobs > 1) {
+      ConvJobs jobs = {
+                        .jobs = data.jobs, .input_dims = &input_dims, .input_data = nullptr,
+                        .filter_dims = &filter_dims,
+                        .filter_data = tflite::micro::GetTensorData<int8_t>(filter),
+                        .bias = tflite::micro::GetTensorData<int32_t>(bias),
+                        .output_dims = &output_dims, .output_data = nullptr,
+                        .conv_params = &conv_params, .quant_data = &quant_data,
+                        .prepared_buf = data.prepared_buf, .sparse = data.sparse,
+                        .scratch_bufs = {scratch_buf}
+                      };
+      for (int i = 1; i < data.jobs; i++) {
+        jobs.scratch_bufs[i] = data.job_buffer_idx[i - 1] > -1
+            ? context->GetScratchBuffer(context, data.job_buffer_idx[i - 1])
+            : nullptr;
+      }
+      for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+        jobs.input_data = input_data + i_batch * input_size;
+        jobs.output_data = output_data + i_batch * output_size;
+        RunEspNnJobs(data.jobs, RunConvJob, &jobs);
+      }
+      return;
+    }
+
+    if (data.sparse != nullptr) {
+      for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+        esp_nn_conv_1x1_sparse_s8(&input_dims, input_data + i_batch * input_size,
+                                  data.sparse,
+                                  tflite::micro::GetTensorData<int32_t>(bias),
+                                  &output_dims,
+                                  output_data + i_batch * output_size,
+                                  &conv_params, &quant_data);
+      }
+      return;
+    }
+
     for (int i_batch = 0; i_batch < batch_size; i_batch++) {
       esp_nn_conv_s8(&input_dims, input_data + i_batch * input_size,
                      &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
@@ -249,6 +401,80 @@ inline void EvalQuantizedPerChannel(
         tflite::micro::GetTensorData<int8_t>(output));
   }
 }
+
+// Fixed-point per-channel-quantization convolution 16x8 function wrapper,
+// int64 bias.
+inline void EvalQuantizedPerChannel16x8(
+    const TfLiteConvParams& params, const NodeData& data,
+    const TfLiteEvalTensor* input, const TfLiteEvalTensor* filter,
+    const TfLiteEvalTensor* bias, TfLiteEvalTensor* output) {
+  if (params.dilation_width_factor == 1 && params.dilation_height_factor == 1) {
+    RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+    RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+    RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+
+    const int16_t *input_data = tflite::micro::GetTensorData<int16_t>(input);
+    int16_t *output_data = tflite::micro::GetTensorData<int16_t>(output);
+
+    const int batch_size = MatchingDim(input_shape, 0, output_shape, 0);
+    const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+    const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+    const int input_height = input_shape.Dims(1);
+    const int input_width = input_shape.Dims(2);
+    const int output_height = output_shape.Dims(1);
+    const int output_width = output_shape.Dims(2);
+
+    const int input_size = input_width * input_height * input_depth;
+    const int output_size = output_width * output_height * output_depth;
+
+    data_dims_t input_dims =  {
+                                .width = input_width, .height = input_height,
+                                .channels = input_depth, 1
+                              };
+    data_dims_t output_dims = {
+                                .width = output_width, .height = output_height,
+                                .channels = output_depth, 1
+                              };
+    data_dims_t filter_dims = {
+                                .width = filter_shape.Dims(2),
+                                .height = filter_shape.Dims(1), 0, 0
+                              };
+    // int16 zero points are 0, no offsets.
+    conv_params_t conv_params = {
+                                  .in_offset = 0, .out_offset = 0,
+                                  .stride = {params.stride_width, params.stride_height},
+                                  .padding = {data.op_data.padding.width, data.op_data.padding.height},
+                                  .dilation = {0, 0},
+                                  .activation = {data.op_data.output_activation_min,
+                                                 data.op_data.output_activation_max}
+                                };
+    quant_data_t quant_data = {
+                                .shift = data.op_data.per_channel_output_shift,
+                                .mult = data.op_data.per_channel_output_multiplier
+                              };
+
+    for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+      esp_nn_conv_s16(&input_dims, input_data + i_batch * input_size,
+                      &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
+                      tflite::micro::GetOptionalTensorData<int64_t>(bias),
+                      &output_dims, output_data + i_batch * output_size,
+                      &conv_params, &quant_data);
+    }
+  } else {
+    reference_integer_ops::ConvPerChannel(
+        ConvParamsQuantized(params, data.op_data),
+        data.op_data.per_channel_output_multiplier,
+        data.op_data.per_channel_output_shift,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<int16_t>(input),
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorData<int8_t>(filter),
+        tflite::micro::GetTensorShape(bias),
+        tflite::micro::GetOptionalTensorData<int64_t>(bias),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<int16_t>(output));
+  }
+}
 #endif
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
@@ -270,10 +496,12 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   const auto& data = *(static_cast<const NodeData*>(node->user_data));
 
   TF_LITE_ENSURE_EQ(context, input->type, output->type);
-  TF_LITE_ENSURE_MSG(context, input->type == filter->type,
-                     "Hybrid models are not supported on TFLite Micro.");
+  TF_LITE_ENSURE_MSG(
+      context,
+      input->type == filter->type ||
+          (input->type == kTfLiteInt16 && filter->type == kTfLiteInt8),
+      "Hybrid models are not supported on TFLite Micro.");
 
-  long long start_time = esp_timer_get_time();
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
       tflite::reference_ops::Conv(
@@ -306,6 +534,42 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           tflite::micro::GetTensorData<int32_t>(bias),
           tflite::micro::GetTensorShape(output),
           tflite::micro::GetTensorData<int8_t>(output));
+#endif
+      break;
+    }
+    case kTfLiteInt16: {
+      if (bias != nullptr && bias->type == kTfLiteInt32) {
+        // 32 bit accumulators, with the rounding of the int8 kernels.
+        reference_integer_ops::ConvPerChannel(
+            ConvParamsQuantized(params, data.op_data),
+            data.op_data.per_channel_output_multiplier,
+            data.op_data.per_channel_output_shift,
+            tflite::micro::GetTensorShape(input),
+            tflite::micro::GetTensorData<int16_t>(input),
+            tflite::micro::GetTensorShape(filter),
+            tflite::micro::GetTensorData<int8_t>(filter),
+            tflite::micro::GetTensorShape(bias),
+            tflite::micro::GetTensorData<int32_t>(bias),
+            tflite::micro::GetTensorShape(output),
+            tflite::micro::GetTensorData<int16_t>(output));
+        break;
+      }
+      TF_LITE_ENSURE(context, bias == nullptr || bias->type == kTfLiteInt64);
+#if ESP_NN
+      EvalQuantizedPerChannel16x8(params, data, input, filter, bias, output);
+#else
+      reference_integer_ops::ConvPerChannel(
+          ConvParamsQuantized(params, data.op_data),
+          data.op_data.per_channel_output_multiplier,
+          data.op_data.per_channel_output_shift,
+          tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorData<int16_t>(input),
+          tflite::micro::GetTensorShape(filter),
+          tflite::micro::GetTensorData<int8_t>(filter),
+          tflite::micro::GetTensorShape(bias),
+          tflite::micro::GetOptionalTensorData<int64_t>(bias),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<int16_t>(output));
 #endif
       break;
     }
@@ -329,9 +593,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(input->type), input->type);
       return kTfLiteError;
   }
-  long long time_this_instance = esp_timer_get_time() - start_time;
-  conv_total_time += time_this_instance;
-  // printf("time this conv instance: %llu\n", time_this_instance / 1000);
   return kTfLiteOk;
 }
 
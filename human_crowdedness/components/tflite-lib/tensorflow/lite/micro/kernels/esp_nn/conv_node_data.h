@@ -0,0 +1,55 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_CONV_NODE_DATA_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_CONV_NODE_DATA_H_
+
+#include <esp_nn_defs.h>
+
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
+
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+
+// The buffers that only make the convolutions faster take arena the ESP32 has
+// little of, so they are only requested with CONFIG_NN_CONV_ARENA_BUFFERS.
+#if defined(CONFIG_NN_CONV_ARENA_BUFFERS)
+#define ESP_NN_CONV_ARENA_BUFFERS 1
+#else
+#define ESP_NN_CONV_ARENA_BUFFERS 0
+#endif
+
+namespace tflite {
+
+// user_data of the ESP-NN CONV_2D and DEPTHWISE_CONV_2D nodes. The fused
+// depthwise + pointwise kernel runs their Prepare on its two halves and reads
+// the buffers back from here.
+struct EspNnConvNodeData {
+  OpDataConv op_data;
+  int buffer_idx;
+  void* prepared_buf;
+  // 1x1 int8 filter stored sparse in the model, see sparse_filter.h, nullptr
+  // to run on the dense filter. CONV_2D only.
+  const sparse_s8_t* sparse;
+  // Jobs the output rows are split into, see esp_nn_workers.h, and the
+  // scratch buffers of the jobs other than the first one.
+  int jobs;
+  int job_buffer_idx[kEspNnMaxJobs - 1];
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_CONV_NODE_DATA_H_
@@ -25,26 +25,19 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/conv_node_data.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
-#include <esp_timer.h>
-
 #if ESP_NN
 #include <esp_nn.h>
 #endif
 
-long long dc_total_time = 0;
-
 namespace tflite {
 namespace {
 
-struct NodeData {
-  OpDataConv op_data;
-#if ESP_NN
-  int buffer_idx;
-#endif
-};
+using NodeData = EspNnConvNodeData;
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
@@ -52,6 +45,46 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
 }
 
 #if ESP_NN
+// A layer split by output rows between the workers.
+struct DepthwiseConvJobs {
+  int jobs;
+  const data_dims_t* input_dims;
+  const int8_t* input_data;
+  const data_dims_t* filter_dims;
+  const int8_t* filter_data;
+  const int32_t* bias;
+  const data_dims_t* output_dims;
+  int8_t* output_data;
+  const dw_conv_params_t* conv_params;
+  const quant_data_t* quant_data;
+  void* prepared_buf;
+  void* scratch_bufs[kEspNnMaxJobs];
+};
+
+// Runs the rows of job `index` as a depthwise convolution of their own.
+void RunDepthwiseConvJob(void* ctx, int index) {
+  const DepthwiseConvJobs& jobs = *static_cast<const DepthwiseConvJobs*>(ctx);
+  const EspNnRowSlice slice = EspNnSliceRows(
+      index, jobs.jobs, jobs.output_dims->height,
+      jobs.conv_params->stride.height, jobs.conv_params->padding.height);
+
+  data_dims_t input_dims = *jobs.input_dims;
+  input_dims.height -= slice.input_row;
+  data_dims_t output_dims = *jobs.output_dims;
+  output_dims.height = slice.output_rows;
+  dw_conv_params_t conv_params = *jobs.conv_params;
+  conv_params.padding.height = slice.pad_height;
+
+  // The buffers are per thread in esp-nn.
+  esp_nn_set_depthwise_conv_scratch_buf(jobs.scratch_bufs[index]);
+  esp_nn_set_depthwise_conv_prepared_buf(jobs.prepared_buf);
+  esp_nn_depthwise_conv_s8(&input_dims,
+                           jobs.input_data + slice.input_row * input_dims.width * input_dims.channels,
+                           jobs.filter_dims, jobs.filter_data, jobs.bias, &output_dims,
+                           jobs.output_data + slice.output_row * output_dims.width * output_dims.channels,
+                           &conv_params, jobs.quant_data);
+}
+
 inline void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                                     const TfLiteDepthwiseConvParams& params,
                                     const NodeData& data,
@@ -114,6 +147,7 @@ inline void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
     }
 
     esp_nn_set_depthwise_conv_scratch_buf(scratch_buf);
+    esp_nn_set_depthwise_conv_prepared_buf(data.prepared_buf);
 
     data_dims_t input_dims =  {
                                 .width = input_width, .height = input_height,
@@ -136,6 +170,29 @@ inline void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                                 .mult = data.op_data.per_channel_output_multiplier
                               };
 
+    if (data.jobs > 1) {
+      DepthwiseConvJobs jobs = {
+                                 .jobs = data.jobs, .input_dims = &input_dims, .input_data = nullptr,
+                                 .filter_dims = &filter_dims,
+                                 .filter_data = tflite::micro::GetTensorData<int8_t>(filter),
+                                 .bias = tflite::micro::GetTensorData<int32_t>(bias),
+                                 .output_dims = &output_dims, .output_data = nullptr,
+                                 .conv_params = &conv_params, .quant_data = &quant_data,
+                                 .prepared_buf = data.prepared_buf, .scratch_bufs = {scratch_buf}
+                               };
+      for (int i = 1; i < data.jobs; i++) {
+        jobs.scratch_bufs[i] = data.job_buffer_idx[i - 1] > -1
+            ? context->GetScratchBuffer(context, data.job_buffer_idx[i - 1])
+            : nullptr;
+      }
+      for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+        jobs.input_data = input_data + i_batch * input_size;
+        jobs.output_data = output_data + i_batch * output_size;
+        RunEspNnJobs(data.jobs, RunDepthwiseConvJob, &jobs);
+      }
+      return;
+    }
+
     for (int i_batch = 0; i_batch < batch_size; i_batch++) {
       esp_nn_depthwise_conv_s8(&input_dims, input_data + i_batch * input_size,
                                &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
@@ -158,6 +215,82 @@ inline void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
         tflite::micro::GetTensorData<int8_t>(output));
   }
 }
+
+// 16x8 per-channel depthwise convolution, int64 bias.
+inline void EvalQuantizedPerChannel16x8(const TfLiteDepthwiseConvParams& params,
+                                        const NodeData& data,
+                                        const TfLiteEvalTensor* input,
+                                        const TfLiteEvalTensor* filter,
+                                        const TfLiteEvalTensor* bias,
+                                        TfLiteEvalTensor* output) {
+  if (params.dilation_width_factor == 1 && params.dilation_height_factor == 1) {
+    RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+    RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+    RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+
+    const int16_t *input_data = tflite::micro::GetTensorData<int16_t>(input);
+    int16_t *output_data = tflite::micro::GetTensorData<int16_t>(output);
+
+    const int input_height = input_shape.Dims(1);
+    const int input_width = input_shape.Dims(2);
+    const int input_depth = input_shape.Dims(3);
+    const int output_height = output_shape.Dims(1);
+    const int output_width = output_shape.Dims(2);
+    const int batch_size = MatchingDim(input_shape, 0, output_shape, 0);
+    const int output_depth = MatchingDim(filter_shape, 3, output_shape, 3);
+
+    const int input_size = input_width * input_height * input_depth;
+    const int output_size = output_width * output_height * output_depth;
+
+    data_dims_t input_dims =  {
+                                .width = input_width, .height = input_height,
+                                .channels = input_depth, 1
+                              };
+    data_dims_t output_dims = {
+                                .width = output_width, .height = output_height,
+                                .channels = output_depth, 1
+                              };
+    data_dims_t filter_dims = {
+                                .width = filter_shape.Dims(2),
+                                .height = filter_shape.Dims(1), 0, 0
+                              };
+    // int16 zero points are 0, no offsets.
+    dw_conv_params_t conv_params =  {
+                                      .in_offset = 0, .out_offset = 0,
+                                      .ch_mult = params.depth_multiplier,
+                                      .stride = {params.stride_width, params.stride_height},
+                                      .padding = {data.op_data.padding.width, data.op_data.padding.height},
+                                      .dilation = {0, 0},
+                                      .activation = {data.op_data.output_activation_min,
+                                                     data.op_data.output_activation_max}
+                                    };
+    quant_data_t quant_data = {
+                                .shift = data.op_data.per_channel_output_shift,
+                                .mult = data.op_data.per_channel_output_multiplier
+                              };
+
+    for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+      esp_nn_depthwise_conv_s16(&input_dims, input_data + i_batch * input_size,
+                                &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
+                                tflite::micro::GetOptionalTensorData<int64_t>(bias),
+                                &output_dims, output_data + i_batch * output_size,
+                                &conv_params, &quant_data);
+    }
+  } else {
+    reference_integer_ops::DepthwiseConvPerChannel(
+        DepthwiseConvParamsQuantized(params, data.op_data),
+        data.op_data.per_channel_output_multiplier,
+        data.op_data.per_channel_output_shift,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<int16_t>(input),
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorData<int8_t>(filter),
+        tflite::micro::GetTensorShape(bias),
+        tflite::micro::GetOptionalTensorData<int64_t>(bias),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<int16_t>(output));
+  }
+}
 #endif
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
@@ -223,6 +356,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       filter_height, output_width, output_height, input->type, &data->op_data));
 
 #if ESP_NN
+  data->jobs = 1;
+  data->sparse = nullptr;
   if (input->type == kTfLiteInt8) {
     data_dims_t input_dims =  {
                                 .width = input_width, .height = input_height,
@@ -249,6 +384,40 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     } else {
       data->buffer_idx = -1;
     }
+
+    // Big layers are split by output rows between the workers, every job
+    // with a scratch buffer of its own. Those copies only make the layer
+    // faster, layers that need one are not split without the arena for them.
+    const int64_t macs = static_cast<int64_t>(output_width) * output_height *
+                         output_dims.channels * filter_width * filter_height;
+    data->jobs = ESP_NN_CONV_ARENA_BUFFERS || scratch_buf_size == 0
+                     ? EspNnParallelJobs(macs, output_height)
+                     : 1;
+    for (int i = 0; i < data->jobs - 1; i++) {
+      data->job_buffer_idx[i] = -1;
+      if (scratch_buf_size > 0) {
+        TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+          context, scratch_buf_size, &data->job_buffer_idx[i]));
+      }
+    }
+
+    // Transform the weights once, for the input offset of this model, when
+    // the arena has room for it.
+    data->prepared_buf = nullptr;
+    conv_params.in_offset = -data->op_data.input_zero_point;
+    int prepared_buf_size = esp_nn_get_depthwise_conv_prepared_size(
+        &input_dims, &filter_dims, &output_dims, &conv_params);
+    if (ESP_NN_CONV_ARENA_BUFFERS && prepared_buf_size > 0 &&
+        IsConstantTensor(filter) &&
+        (bias == nullptr || IsConstantTensor(bias))) {
+      data->prepared_buf =
+          context->AllocatePersistentBuffer(context, prepared_buf_size);
+      TF_LITE_ENSURE(context, data->prepared_buf != nullptr);
+      esp_nn_prepare_depthwise_conv_s8(
+          &input_dims, &filter_dims, GetTensorData<int8_t>(filter),
+          bias != nullptr ? GetTensorData<int32_t>(bias) : nullptr,
+          &output_dims, &conv_params, data->prepared_buf);
+    }
   }
 #endif
 
@@ -279,7 +448,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           ? tflite::micro::GetEvalInput(context, node, kDepthwiseConvBiasTensor)
           : nullptr;
 
-  long long start_time = esp_timer_get_time();
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32:
       tflite::reference_ops::DepthwiseConv(
@@ -310,6 +478,25 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           tflite::micro::GetTensorData<int32_t>(bias),
           tflite::micro::GetTensorShape(output),
           tflite::micro::GetTensorData<int8_t>(output));
+#endif
+      break;
+    case kTfLiteInt16:
+      TF_LITE_ENSURE(context, bias == nullptr || bias->type == kTfLiteInt64);
+#if ESP_NN
+      EvalQuantizedPerChannel16x8(params, data, input, filter, bias, output);
+#else
+      reference_integer_ops::DepthwiseConvPerChannel(
+          DepthwiseConvParamsQuantized(params, data.op_data),
+          data.op_data.per_channel_output_multiplier,
+          data.op_data.per_channel_output_shift,
+          tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorData<int16_t>(input),
+          tflite::micro::GetTensorShape(filter),
+          tflite::micro::GetTensorData<int8_t>(filter),
+          tflite::micro::GetTensorShape(bias),
+          tflite::micro::GetOptionalTensorData<int64_t>(bias),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<int16_t>(output));
 #endif
       break;
     case kTfLiteUInt8:
@@ -330,9 +517,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(input->type), input->type);
       return kTfLiteError;
   }
-  long long time_this_instance = esp_timer_get_time() - start_time;
-  dc_total_time += time_this_instance;
-  // printf("time this dc instance: %llu\n", time_this_instance / 1000);
 
   return kTfLiteOk;
 }
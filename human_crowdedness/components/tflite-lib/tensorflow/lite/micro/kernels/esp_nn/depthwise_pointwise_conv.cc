@@ -0,0 +1,370 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/esp_nn/depthwise_pointwise_conv.h"
+
+#if ESP_NN_DEPTHWISE_POINTWISE_FUSION
+
+#include <algorithm>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/depthwise_conv.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/conv_node_data.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include <esp_nn.h>
+
+namespace tflite {
+namespace {
+
+constexpr int kDepthwiseInputTensor = 0;
+constexpr int kDepthwiseWeightsTensor = 1;
+constexpr int kDepthwiseBiasTensor = 2;
+constexpr int kPointwiseWeightsTensor = 3;
+constexpr int kPointwiseBiasTensor = 4;
+constexpr int kOutputTensor = 0;
+
+// Bytes of depthwise output kept at a time. A few rows of a MobileNet block
+// stay in cache between the two convolutions, where the whole intermediate
+// tensor would not.
+constexpr int kStripBytes = 1024;
+
+struct OpData {
+  // user_data of the two halves, as prepared by the DEPTHWISE_CONV_2D and
+  // CONV_2D kernels.
+  const EspNnConvNodeData* depthwise;
+  const EspNnConvNodeData* pointwise;
+  // Output rows of the depthwise convolution per strip.
+  int strip_rows;
+  // Jobs the strips are split into, see esp_nn_workers.h, each with a strip
+  // buffer of its own.
+  int jobs;
+  int strip_buffer_idx[kEspNnMaxJobs];
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+// Runs the Init and Prepare of `registration` on a node with the given tensors
+// and returns its user_data. The node itself is only needed for Prepare.
+const EspNnConvNodeData* PrepareHalf(TfLiteContext* context,
+                                     const TfLiteRegistration_V1& registration,
+                                     void* builtin_data, int input, int filter,
+                                     int bias, int output) {
+  int inputs[] = {3, input, filter, bias};
+  int outputs[] = {1, output};
+  TfLiteNode node = {};
+  node.inputs = reinterpret_cast<TfLiteIntArray*>(inputs);
+  node.outputs = reinterpret_cast<TfLiteIntArray*>(outputs);
+  node.builtin_data = builtin_data;
+  node.user_data = registration.init(context, nullptr, 0);
+  if (node.user_data == nullptr ||
+      registration.prepare(context, &node) != kTfLiteOk) {
+    return nullptr;
+  }
+  return static_cast<const EspNnConvNodeData*>(node.user_data);
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
+  OpData* data = static_cast<OpData*>(node->user_data);
+  auto* params =
+      static_cast<TfLiteDepthwisePointwiseConvParams*>(node->builtin_data);
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 5);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  // Both halves are prepared by their own kernels, so that quantization,
+  // scratch and prepared buffers are exactly the ones of the unfused graph.
+  data->depthwise = PrepareHalf(
+      context, Register_DEPTHWISE_CONV_2D(), params->depthwise,
+      node->inputs->data[kDepthwiseInputTensor],
+      node->inputs->data[kDepthwiseWeightsTensor],
+      node->inputs->data[kDepthwiseBiasTensor], params->intermediate);
+  TF_LITE_ENSURE(context, data->depthwise != nullptr);
+  data->pointwise = PrepareHalf(
+      context, Register_CONV_2D(), params->pointwise, params->intermediate,
+      node->inputs->data[kPointwiseWeightsTensor],
+      node->inputs->data[kPointwiseBiasTensor],
+      node->outputs->data[kOutputTensor]);
+  TF_LITE_ENSURE(context, data->pointwise != nullptr);
+
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* intermediate =
+      micro_context->AllocateTempTfLiteTensor(params->intermediate);
+  TF_LITE_ENSURE(context, intermediate != nullptr);
+  TF_LITE_ENSURE_EQ(context, intermediate->type, kTfLiteInt8);
+  const int out_height = intermediate->dims->data[1];
+  const int row_bytes = intermediate->dims->data[2] * intermediate->dims->data[3];
+  micro_context->DeallocateTempTfLiteTensor(intermediate);
+
+  TfLiteTensor* filter = micro_context->AllocateTempInputTensor(
+      node, kDepthwiseWeightsTensor);
+  TF_LITE_ENSURE(context, filter != nullptr);
+  const int filter_taps = filter->dims->data[1] * filter->dims->data[2];
+  micro_context->DeallocateTempTfLiteTensor(filter);
+  TfLiteTensor* output = micro_context->AllocateTempOutputTensor(node, kOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+  const int output_depth = output->dims->data[3];
+  micro_context->DeallocateTempTfLiteTensor(output);
+
+  data->strip_rows = std::max(1, std::min(out_height, kStripBytes / row_bytes));
+  const int strips = (out_height + data->strip_rows - 1) / data->strip_rows;
+
+  // The strips are split between the workers like the rows of the unfused
+  // kernels. Every job needs the scratch buffers of both halves, which they
+  // only requested for their own number of jobs.
+  const int64_t macs = static_cast<int64_t>(out_height) * row_bytes *
+                       (filter_taps + output_depth);
+  data->jobs = EspNnParallelJobs(macs, strips);
+  if (data->depthwise->buffer_idx > -1) {
+    data->jobs = std::min(data->jobs, data->depthwise->jobs);
+  }
+  if (data->pointwise->buffer_idx > -1) {
+    data->jobs = std::min(data->jobs, data->pointwise->jobs);
+  }
+  for (int i = 0; i < data->jobs; i++) {
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, data->strip_rows * row_bytes, &data->strip_buffer_idx[i]));
+  }
+  return kTfLiteOk;
+}
+
+// A fused node split by strips between the workers.
+struct StripJobs {
+  int jobs;
+  int strip_rows;
+  int out_height;
+  int stride_height;
+  int pad_height;
+  const data_dims_t* input_dims;
+  const int8_t* input_data;
+  const data_dims_t* filter_dims;
+  const int8_t* dw_filter_data;
+  const int32_t* dw_bias_data;
+  const dw_conv_params_t* dw_params;
+  const quant_data_t* dw_quant;
+  const data_dims_t* pw_filter_dims;
+  const int8_t* pw_filter_data;
+  const int32_t* pw_bias_data;
+  const conv_params_t* pw_params;
+  const quant_data_t* pw_quant;
+  const data_dims_t* strip_dims;
+  const data_dims_t* output_dims;
+  int8_t* output_data;
+  void* dw_prepared_buf;
+  void* pw_prepared_buf;
+  const sparse_s8_t* pw_sparse;
+  void* dw_scratch_bufs[kEspNnMaxJobs];
+  void* pw_scratch_bufs[kEspNnMaxJobs];
+  int8_t* strips[kEspNnMaxJobs];
+};
+
+// Runs the strips of job `index`, both convolutions one strip at a time.
+void RunStrips(void* ctx, int index) {
+  const StripJobs& jobs = *static_cast<const StripJobs*>(ctx);
+  const int strips = (jobs.out_height + jobs.strip_rows - 1) / jobs.strip_rows;
+  const int input_width = jobs.input_dims->width;
+  const int input_depth = jobs.input_dims->channels;
+  const int out_width = jobs.output_dims->width;
+  const int output_depth = jobs.output_dims->channels;
+  int8_t* strip = jobs.strips[index];
+
+  // The buffers are per thread in esp-nn, and kept until set again.
+  esp_nn_set_depthwise_conv_scratch_buf(jobs.dw_scratch_bufs[index]);
+  esp_nn_set_depthwise_conv_prepared_buf(jobs.dw_prepared_buf);
+  esp_nn_set_conv_scratch_buf(jobs.pw_scratch_bufs[index]);
+  esp_nn_set_conv_prepared_buf(jobs.pw_prepared_buf);
+
+  dw_conv_params_t dw_params = *jobs.dw_params;
+  for (int i = strips * index / jobs.jobs; i < strips * (index + 1) / jobs.jobs; i++) {
+    const int row = i * jobs.strip_rows;
+    const int rows = std::min(jobs.strip_rows, jobs.out_height - row);
+
+    // The strip starts at the first input row it reads. Only the first
+    // strips have rows of top padding left.
+    const int base_y = row * jobs.stride_height - jobs.pad_height;
+    const int first_row = std::max(0, base_y);
+    data_dims_t strip_in_dims = {.width = input_width,
+                                 .height = jobs.input_dims->height - first_row,
+                                 .channels = input_depth, 1};
+    data_dims_t strip_dims = {.width = out_width, .height = rows,
+                              .channels = jobs.strip_dims->channels, 1};
+    data_dims_t strip_out_dims = {.width = out_width, .height = rows,
+                                  .channels = output_depth, 1};
+    dw_params.padding.height = first_row - base_y;
+
+    esp_nn_depthwise_conv_s8(
+        &strip_in_dims, jobs.input_data + first_row * input_width * input_depth,
+        jobs.filter_dims, jobs.dw_filter_data, jobs.dw_bias_data, &strip_dims,
+        strip, &dw_params, jobs.dw_quant);
+    if (jobs.pw_sparse != nullptr) {
+      esp_nn_conv_1x1_sparse_s8(&strip_dims, strip, jobs.pw_sparse, jobs.pw_bias_data,
+                                &strip_out_dims,
+                                jobs.output_data + row * out_width * output_depth,
+                                jobs.pw_params, jobs.pw_quant);
+    } else {
+      esp_nn_conv_s8(&strip_dims, strip, jobs.pw_filter_dims, jobs.pw_filter_data,
+                     jobs.pw_bias_data, &strip_out_dims,
+                     jobs.output_data + row * out_width * output_depth,
+                     jobs.pw_params, jobs.pw_quant);
+    }
+  }
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+  const auto& params =
+      *(static_cast<const TfLiteDepthwisePointwiseConvParams*>(
+          node->builtin_data));
+  const EspNnConvNodeData& dw_data = *data.depthwise;
+  const EspNnConvNodeData& pw_data = *data.pointwise;
+
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kDepthwiseInputTensor);
+  const TfLiteEvalTensor* dw_filter =
+      tflite::micro::GetEvalInput(context, node, kDepthwiseWeightsTensor);
+  const TfLiteEvalTensor* dw_bias =
+      tflite::micro::GetEvalInput(context, node, kDepthwiseBiasTensor);
+  const TfLiteEvalTensor* pw_filter =
+      tflite::micro::GetEvalInput(context, node, kPointwiseWeightsTensor);
+  const TfLiteEvalTensor* pw_bias =
+      tflite::micro::GetEvalInput(context, node, kPointwiseBiasTensor);
+  const TfLiteEvalTensor* intermediate =
+      context->GetEvalTensor(context, params.intermediate);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+  RuntimeShape filter_shape = tflite::micro::GetTensorShape(dw_filter);
+  RuntimeShape strip_shape = tflite::micro::GetTensorShape(intermediate);
+  RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int input_depth = input_shape.Dims(3);
+  const int out_height = strip_shape.Dims(1);
+  const int out_width = strip_shape.Dims(2);
+  const int dw_depth = strip_shape.Dims(3);
+  const int output_depth = output_shape.Dims(3);
+  const int batch_size = MatchingDim(input_shape, 0, output_shape, 0);
+
+  const int stride_height = params.depthwise->stride_height;
+  const int pad_height = dw_data.op_data.padding.height;
+
+  data_dims_t input_dims = {.width = input_width, .height = input_height,
+                            .channels = input_depth, 1};
+  data_dims_t filter_dims = {.width = filter_shape.Dims(2),
+                             .height = filter_shape.Dims(1), 0, 0};
+  data_dims_t pw_filter_dims = {.width = 1, .height = 1, 0, 0};
+  data_dims_t strip_dims = {.width = out_width, .height = data.strip_rows,
+                            .channels = dw_depth, 1};
+  data_dims_t output_dims = {.width = out_width, .height = out_height,
+                             .channels = output_depth, 1};
+  const dw_conv_params_t dw_params = {
+      .in_offset = -dw_data.op_data.input_zero_point,
+      .out_offset = dw_data.op_data.output_zero_point,
+      .ch_mult = params.depthwise->depth_multiplier,
+      .stride = {params.depthwise->stride_width, stride_height},
+      .padding = {dw_data.op_data.padding.width, pad_height},
+      .dilation = {0, 0},
+      .activation = {dw_data.op_data.output_activation_min,
+                     dw_data.op_data.output_activation_max}};
+  const conv_params_t pw_params = {
+      .in_offset = -pw_data.op_data.input_zero_point,
+      .out_offset = pw_data.op_data.output_zero_point,
+      .stride = {1, 1}, .padding = {0, 0}, .dilation = {0, 0},
+      .activation = {pw_data.op_data.output_activation_min,
+                     pw_data.op_data.output_activation_max}};
+  const quant_data_t dw_quant = {
+      .shift = dw_data.op_data.per_channel_output_shift,
+      .mult = dw_data.op_data.per_channel_output_multiplier};
+  const quant_data_t pw_quant = {
+      .shift = pw_data.op_data.per_channel_output_shift,
+      .mult = pw_data.op_data.per_channel_output_multiplier};
+
+  StripJobs jobs = {};
+  jobs.jobs = data.jobs;
+  jobs.strip_rows = data.strip_rows;
+  jobs.out_height = out_height;
+  jobs.stride_height = stride_height;
+  jobs.pad_height = pad_height;
+  jobs.input_dims = &input_dims;
+  jobs.filter_dims = &filter_dims;
+  jobs.dw_filter_data = tflite::micro::GetTensorData<int8_t>(dw_filter);
+  jobs.dw_bias_data = tflite::micro::GetTensorData<int32_t>(dw_bias);
+  jobs.dw_params = &dw_params;
+  jobs.dw_quant = &dw_quant;
+  jobs.pw_filter_dims = &pw_filter_dims;
+  jobs.pw_filter_data = tflite::micro::GetTensorData<int8_t>(pw_filter);
+  jobs.pw_bias_data = tflite::micro::GetTensorData<int32_t>(pw_bias);
+  jobs.pw_params = &pw_params;
+  jobs.pw_quant = &pw_quant;
+  jobs.strip_dims = &strip_dims;
+  jobs.output_dims = &output_dims;
+  jobs.dw_prepared_buf = dw_data.prepared_buf;
+  jobs.pw_prepared_buf = pw_data.prepared_buf;
+  jobs.pw_sparse = pw_data.sparse;
+  for (int i = 0; i < data.jobs; i++) {
+    // The first job gets the buffers of the unsplit halves.
+    if (dw_data.buffer_idx > -1) {
+      jobs.dw_scratch_bufs[i] = context->GetScratchBuffer(
+          context, i == 0 ? dw_data.buffer_idx : dw_data.job_buffer_idx[i - 1]);
+    }
+    if (pw_data.buffer_idx > -1) {
+      jobs.pw_scratch_bufs[i] = context->GetScratchBuffer(
+          context, i == 0 ? pw_data.buffer_idx : pw_data.job_buffer_idx[i - 1]);
+    }
+    jobs.strips[i] = static_cast<int8_t*>(
+        context->GetScratchBuffer(context, data.strip_buffer_idx[i]));
+  }
+
+  for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+    jobs.input_data = tflite::micro::GetTensorData<int8_t>(input) +
+                      i_batch * input_height * input_width * input_depth;
+    jobs.output_data = tflite::micro::GetTensorData<int8_t>(output) +
+                       i_batch * out_height * out_width * output_depth;
+    RunEspNnJobs(data.jobs, RunStrips, &jobs);
+  }
+
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TfLiteRegistration_V1 Register_DEPTHWISE_POINTWISE_CONV_2D() {
+  TfLiteRegistration_V1 registration =
+      tflite::micro::RegisterOp(Init, Prepare, Eval);
+  registration.builtin_code = BuiltinOperator_CUSTOM;
+  registration.custom_name = "DEPTHWISE_CONV_2D+CONV_2D";
+  return registration;
+}
+
+}  // namespace tflite
+
+#endif  // ESP_NN_DEPTHWISE_POINTWISE_FUSION
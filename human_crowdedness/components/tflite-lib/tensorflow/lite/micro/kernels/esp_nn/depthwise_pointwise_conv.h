@@ -0,0 +1,57 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_DEPTHWISE_POINTWISE_CONV_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_DEPTHWISE_POINTWISE_CONV_H_
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+
+// The fused kernel runs the depthwise convolution on a few output rows at a
+// time. The esp32s3 depthwise kernels pad the whole input at once and cannot
+// start in the middle of it, so there is no fusion with them.
+#if ESP_NN && !(defined(CONFIG_NN_OPTIMIZED) && defined(CONFIG_IDF_TARGET_ESP32S3))
+#define ESP_NN_DEPTHWISE_POINTWISE_FUSION 1
+#else
+#define ESP_NN_DEPTHWISE_POINTWISE_FUSION 0
+#endif
+
+namespace tflite {
+
+// Parameters of a DEPTHWISE_CONV_2D followed by a 1x1 CONV_2D that reads its
+// output, run as one node.
+struct TfLiteDepthwisePointwiseConvParams {
+  // The builtin_data of the two nodes.
+  TfLiteDepthwiseConvParams* depthwise;
+  TfLiteConvParams* pointwise;
+  // The tensor between the two. Only its shape and quantization are used, it
+  // is never allocated.
+  int intermediate;
+};
+
+// Inputs: depthwise input, filter and bias, then pointwise filter and bias.
+// Output: the output of the pointwise convolution. The builtin_data of the
+// node is a TfLiteDepthwisePointwiseConvParams.
+//
+// Nodes are built by FuseDepthwisePointwiseConvs(), models do not contain
+// this operator.
+TfLiteRegistration_V1 Register_DEPTHWISE_POINTWISE_CONV_2D();
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_DEPTHWISE_POINTWISE_CONV_H_
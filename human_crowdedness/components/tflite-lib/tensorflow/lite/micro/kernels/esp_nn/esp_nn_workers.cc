@@ -0,0 +1,266 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
+
+#include <algorithm>
+
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#include <esp_nn.h>
+
+namespace tflite {
+namespace {
+
+constexpr int kMaxWorkers = kEspNnMaxJobs - 1;
+
+int64_t parallel_min_macs = kEspNnParallelMinMacs;
+int worker_count = 0;
+
+// The layer being run, set before the workers are woken up. Workers
+// [0, woken) run the jobs [1, woken].
+struct Batch {
+  void (*job)(void* ctx, int index);
+  void* ctx;
+  int woken;
+};
+
+Batch batch;
+bool stopping = false;
+
+#if defined(ESP_PLATFORM)
+
+// The convolutions need little stack, their buffers are in the arena.
+constexpr uint32_t kWorkerStackSize = 3 * 1024;
+
+struct Worker {
+  TaskHandle_t task;
+  SemaphoreHandle_t start;
+  int index;
+};
+
+Worker workers[kMaxWorkers];
+// Given once by every worker that is done with its job.
+SemaphoreHandle_t done = nullptr;
+
+void WorkerMain(void* arg) {
+  Worker* worker = static_cast<Worker*>(arg);
+  while (true) {
+    xSemaphoreTake(worker->start, portMAX_DELAY);
+    if (stopping) {
+      break;
+    }
+    batch.job(batch.ctx, worker->index + 1);
+    xSemaphoreGive(done);
+  }
+  xSemaphoreGive(done);
+  vTaskDelete(nullptr);
+}
+
+void WakeWorkers(int count) {
+  for (int i = 0; i < count; i++) {
+    xSemaphoreGive(workers[i].start);
+  }
+}
+
+void WaitForWorkers(int count) {
+  for (int i = 0; i < count; i++) {
+    xSemaphoreTake(done, portMAX_DELAY);
+  }
+}
+
+bool StartWorkers(int count, int core) {
+  done = xSemaphoreCreateCounting(kMaxWorkers, 0);
+  if (done == nullptr) {
+    return false;
+  }
+  const UBaseType_t priority = uxTaskPriorityGet(nullptr);
+  const BaseType_t affinity = core < 0 ? tskNO_AFFINITY : core;
+  for (int i = 0; i < count; i++) {
+    Worker& worker = workers[i];
+    worker.index = i;
+    worker.start = xSemaphoreCreateBinary();
+    if (worker.start == nullptr ||
+        xTaskCreatePinnedToCore(WorkerMain, "nn_worker", kWorkerStackSize,
+                                &worker, priority, &worker.task,
+                                affinity) != pdPASS) {
+      if (worker.start != nullptr) {
+        vSemaphoreDelete(worker.start);
+      }
+      if (i == 0) {
+        vSemaphoreDelete(done);
+        done = nullptr;
+      }
+      // The ones started are stopped by the caller.
+      worker_count = i;
+      return false;
+    }
+  }
+  worker_count = count;
+  return true;
+}
+
+void StopWorkers() {
+  stopping = true;
+  WakeWorkers(worker_count);
+  WaitForWorkers(worker_count);
+  for (int i = 0; i < worker_count; i++) {
+    vSemaphoreDelete(workers[i].start);
+  }
+  vSemaphoreDelete(done);
+  done = nullptr;
+  stopping = false;
+}
+
+#else
+
+std::thread workers[kMaxWorkers];
+std::mutex mutex;
+std::condition_variable wake;
+std::condition_variable finished;
+// Bumped for every batch, so that a worker runs each one once.
+uint32_t generation = 0;
+// Workers still running a job of the current batch.
+int running = 0;
+
+// Joins the workers left running at exit, before the above are destroyed.
+struct WorkerCleanup {
+  ~WorkerCleanup() { StopEspNnWorkers(); }
+} worker_cleanup;
+
+void WorkerMain(int index, uint32_t seen) {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [&] { return stopping || generation != seen; });
+    if (stopping) {
+      return;
+    }
+    seen = generation;
+    if (index < batch.woken) {
+      const Batch current = batch;
+      lock.unlock();
+      current.job(current.ctx, index + 1);
+      lock.lock();
+      if (--running == 0) {
+        finished.notify_one();
+      }
+    }
+  }
+}
+
+void WakeWorkers(int count) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    running = count;
+    generation++;
+  }
+  wake.notify_all();
+}
+
+void WaitForWorkers(int count) {
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [] { return running == 0; });
+}
+
+bool StartWorkers(int count, int core) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (int i = 0; i < count; i++) {
+    workers[i] = std::thread(WorkerMain, i, generation);
+  }
+  worker_count = count;
+  return true;
+}
+
+void StopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (int i = 0; i < worker_count; i++) {
+    workers[i].join();
+  }
+  stopping = false;
+}
+
+#endif
+
+}  // namespace
+
+bool StartEspNnWorkers(int count, int core) {
+  StopEspNnWorkers();
+  if (count <= 0) {
+    return true;
+  }
+  if (count > kMaxWorkers) {
+    return false;
+  }
+  if (!StartWorkers(count, core)) {
+    StopEspNnWorkers();
+    return false;
+  }
+  return true;
+}
+
+void StopEspNnWorkers() {
+  if (worker_count > 0) {
+    StopWorkers();
+    worker_count = 0;
+  }
+}
+
+int EspNnWorkerCount() { return worker_count; }
+
+void SetEspNnParallelMinMacs(int64_t macs) { parallel_min_macs = macs; }
+
+int EspNnParallelJobs(int64_t macs, int output_height) {
+#if ARCH_ESP32_S3
+  // The ESP32-S3 kernels pad the input by the same amount at the top and at
+  // the bottom, so the last rows of a layer cannot be run on their own.
+  return 1;
+#else
+  if (worker_count == 0 || macs < parallel_min_macs) {
+    return 1;
+  }
+  return std::max(1, std::min(worker_count + 1, output_height));
+#endif
+}
+
+void RunEspNnJobs(int jobs, void (*job)(void* ctx, int index), void* ctx) {
+  const int woken = std::min(jobs - 1, worker_count);
+  if (woken > 0) {
+    batch.job = job;
+    batch.ctx = ctx;
+    batch.woken = woken;
+    WakeWorkers(woken);
+  }
+  job(ctx, 0);
+  for (int index = woken + 1; index < jobs; index++) {
+    job(ctx, index);
+  }
+  if (woken > 0) {
+    WaitForWorkers(woken);
+  }
+}
+
+}  // namespace tflite
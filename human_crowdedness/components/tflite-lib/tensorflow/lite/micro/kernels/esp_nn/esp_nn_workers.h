@@ -0,0 +1,86 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_ESP_NN_WORKERS_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_ESP_NN_WORKERS_H_
+
+#include <stdint.h>
+
+namespace tflite {
+
+// Threads the ESP-NN CONV_2D and DEPTHWISE_CONV_2D kernels split the output
+// rows of their big layers with. The workers are FreeRTOS tasks on the ESP32
+// and std::threads on a host, started once and left waiting between layers.
+//
+// A kernel decides in Prepare how many jobs its layer is cut into, from the
+// workers running at that time, so they have to be started before the
+// interpreter allocates its tensors. The thread that invokes the interpreter
+// runs one of the jobs itself.
+
+// Most jobs a layer is cut into, the calling thread included.
+constexpr int kEspNnMaxJobs = 4;
+
+// Layers with fewer multiply-accumulates than this run on the calling thread
+// only, waking the workers would take longer than what they save.
+constexpr int64_t kEspNnParallelMinMacs = 64 * 1024;
+
+// Starts `count` workers, at most kEspNnMaxJobs - 1. On the ESP32 they are
+// pinned to `core` (any core if -1) and run at the priority of the caller.
+// Returns false if they could not all be started, then none are.
+bool StartEspNnWorkers(int count, int core = -1);
+
+// Stops the workers. The layers prepared with them run on the calling thread
+// alone from then on.
+void StopEspNnWorkers();
+
+int EspNnWorkerCount();
+
+// Overrides kEspNnParallelMinMacs for the layers prepared from now on.
+void SetEspNnParallelMinMacs(int64_t macs);
+
+// Jobs a layer of `macs` multiply-accumulates and `output_height` rows is cut
+// into with the current workers, 1 to run it on the calling thread only.
+int EspNnParallelJobs(int64_t macs, int output_height);
+
+// Runs job(ctx, i) for i in [0, jobs), i == 0 on the calling thread and the
+// rest on the workers, and returns when all of them are done. Jobs with no
+// worker left to take them run on the calling thread as well.
+void RunEspNnJobs(int jobs, void (*job)(void* ctx, int index), void* ctx);
+
+// Part of the output rows of a convolution, and where it starts in the input.
+// It is a convolution of its own: `input_row` is the first input row it reads
+// and `pad_height` what is left of the padding above it.
+struct EspNnRowSlice {
+  int output_row;
+  int output_rows;
+  int input_row;
+  int pad_height;
+};
+
+// Rows of job `index` out of `jobs` for a convolution with `output_height`
+// rows. All jobs get the same number of rows, give or take one.
+inline EspNnRowSlice EspNnSliceRows(int index, int jobs, int output_height,
+                                    int stride_height, int pad_height) {
+  EspNnRowSlice slice;
+  slice.output_row = output_height * index / jobs;
+  slice.output_rows = output_height * (index + 1) / jobs - slice.output_row;
+  const int first_row = slice.output_row * stride_height - pad_height;
+  slice.input_row = first_row > 0 ? first_row : 0;
+  slice.pad_height = first_row < 0 ? -first_row : 0;
+  return slice;
+}
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_ESP_NN_WORKERS_H_
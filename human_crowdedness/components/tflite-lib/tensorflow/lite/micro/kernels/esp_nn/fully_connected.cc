@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/sparse_filter.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
@@ -30,17 +31,19 @@ limitations under the License.
 #include <esp_nn.h>
 #endif
 
-#include <esp_timer.h>
-
-long long fc_total_time = 0;
-
 namespace tflite {
 namespace {
 
+struct NodeData {
+  OpDataFullyConnected op_data;
+  // Int8 filter stored sparse in the model, see sparse_filter.h, nullptr to
+  // run on the dense filter.
+  const sparse_s8_t* sparse;
+};
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context,
-                                           sizeof(OpDataFullyConnected));
+  return context->AllocatePersistentBuffer(context, sizeof(NodeData));
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
@@ -49,7 +52,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   TFLITE_DCHECK(node->builtin_data != nullptr);
 
-  auto* data = static_cast<OpDataFullyConnected*>(node->user_data);
+  auto* node_data = static_cast<NodeData*>(node->user_data);
+  OpDataFullyConnected* data = &node_data->op_data;
   const auto params =
       static_cast<const TfLiteFullyConnectedParams*>(node->builtin_data);
 
@@ -66,13 +70,36 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, output != nullptr);
 
   TF_LITE_ENSURE_TYPES_EQ(context, input->type, output->type);
-  TF_LITE_ENSURE_MSG(context, input->type == filter->type,
-                     "Hybrid models are not supported on TFLite Micro.");
+  TF_LITE_ENSURE_MSG(
+      context,
+      input->type == filter->type ||
+          (input->type == kTfLiteInt16 && filter->type == kTfLiteInt8),
+      "Hybrid models are not supported on TFLite Micro.");
 
   TF_LITE_ENSURE_OK(context, CalculateOpDataFullyConnected(
                                  context, params->activation, input->type,
                                  input, filter, bias, output, data));
 
+  node_data->sparse = nullptr;
+#if ESP_NN
+  // Weights stored sparse in the model are run where they are.
+  if (IsEspNnSparseFilter(context, node, kFullyConnectedWeightsTensor)) {
+    TF_LITE_ENSURE_MSG(
+        context,
+        input->type == kTfLiteInt8 && data->filter_zero_point == 0,
+        "Sparse filters need int8 inputs and no filter offset.");
+    const int filter_dim_count = filter->dims->size;
+    TF_LITE_ENSURE_STATUS(PrepareEspNnSparseFilter(
+        context, node, kFullyConnectedWeightsTensor, filter,
+        filter->dims->data[filter_dim_count - 2],
+        filter->dims->data[filter_dim_count - 1], &node_data->sparse));
+  }
+#else
+  TF_LITE_ENSURE_MSG(
+      context, !IsEspNnSparseFilter(context, node, kFullyConnectedWeightsTensor),
+      "Sparse filters need ESP-NN.");
+#endif
+
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(filter);
   if (bias != nullptr) {
@@ -97,11 +124,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       tflite::micro::GetEvalOutput(context, node, kFullyConnectedOutputTensor);
 
   TFLITE_DCHECK(node->user_data != nullptr);
-  const auto& data =
-      *(static_cast<const OpDataFullyConnected*>(node->user_data));
+  const auto& node_data = *(static_cast<const NodeData*>(node->user_data));
+  const OpDataFullyConnected& data = node_data.op_data;
 
-  long long start_time = esp_timer_get_time();
-  // Checks in Prepare ensure input, output and filter types are all the same.
+  // Checks in Prepare ensure input, output and filter types are all the same,
+  // but for the int8 filter of int16 inputs.
   switch (input->type) {
     case kTfLiteFloat32: {
       tflite::reference_ops::FullyConnected(
@@ -134,6 +161,22 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       int8_t *output_data = tflite::micro::GetTensorData<int8_t>(output);
       const int8_t *filter_data = tflite::micro::GetTensorData<int8_t>(filter);
 
+      if (node_data.sparse != nullptr) {
+        TFLITE_DCHECK_EQ(output_depth, filter_shape.Dims(filter_dim_count - 2));
+        for (int b = 0; b < batches; ++b) {
+          esp_nn_fully_connected_sparse_s8(input_data, -data.input_zero_point,
+                                           node_data.sparse, bias_data,
+                                           output_data, data.output_zero_point,
+                                           data.output_shift,
+                                           data.output_multiplier,
+                                           data.output_activation_min,
+                                           data.output_activation_max);
+          input_data += accum_depth;
+          output_data += output_depth;
+        }
+        break;
+      }
+
       for (int b = 0; b < batches; ++b) {
         esp_nn_fully_connected_s8(input_data, -data.input_zero_point,
                                   accum_depth,
@@ -160,6 +203,51 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       break;
     }
 
+    case kTfLiteInt16: {
+      const int64_t* bias_data =
+          nullptr != bias ? tflite::micro::GetTensorData<int64_t>(bias)
+                          : nullptr;
+#if ESP_NN
+      // int16 activations and int8 weights have no zero points in tflite,
+      // the reference path is left for those which do.
+      if (data.input_zero_point == 0 && data.filter_zero_point == 0 &&
+          data.output_zero_point == 0) {
+        const RuntimeShape& filter_shape = tflite::micro::GetTensorShape(filter);
+        const RuntimeShape& output_shape = tflite::micro::GetTensorShape(output);
+        const int filter_dim_count = filter_shape.DimensionsCount();
+        const int batches = output_shape.Dims(0);
+        const int output_depth = output_shape.Dims(1);
+        TFLITE_DCHECK_LE(output_depth, filter_shape.Dims(filter_dim_count - 2));
+        const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+
+        const int16_t *input_data = tflite::micro::GetTensorData<int16_t>(input);
+        int16_t *output_data = tflite::micro::GetTensorData<int16_t>(output);
+        const int8_t *filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+
+        for (int b = 0; b < batches; ++b) {
+          esp_nn_fully_connected_s16(input_data, accum_depth, filter_data,
+                                     bias_data, output_data, output_depth,
+                                     data.output_shift, data.output_multiplier,
+                                     data.output_activation_min,
+                                     data.output_activation_max);
+          input_data += accum_depth;
+          output_data += output_depth;
+        }
+        break;
+      }
+#endif
+      tflite::reference_integer_ops::FullyConnected(
+          FullyConnectedParamsQuantized(data),
+          tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorData<int16_t>(input),
+          tflite::micro::GetTensorShape(filter),
+          tflite::micro::GetTensorData<int8_t>(filter),
+          tflite::micro::GetTensorShape(bias), bias_data,
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<int16_t>(output));
+      break;
+    }
+
     case kTfLiteUInt8: {
       tflite::reference_ops::FullyConnected(
           FullyConnectedParamsQuantized(data),
@@ -179,7 +267,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
     }
   }
-  fc_total_time += esp_timer_get_time() - start_time;
   return kTfLiteOk;
 }
 
@@ -24,10 +24,6 @@ limitations under the License.
 #include <esp_nn.h>
 #endif
 
-#include <esp_timer.h>
-
-long long pooling_total_time = 0;
-
 namespace tflite {
 
 namespace {
@@ -89,6 +85,40 @@ void AverageEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
   }
 }
 
+void AverageEvalQuantized16(TfLiteContext* context, const TfLiteNode* node,
+                            const TfLitePoolParams* params, const OpDataPooling* data,
+                            const TfLiteEvalTensor* input,
+                            TfLiteEvalTensor* output) {
+  const RuntimeShape& input_shape = tflite::micro::GetTensorShape(input);
+  const RuntimeShape& output_shape = tflite::micro::GetTensorShape(output);
+  TFLITE_DCHECK_LE(data->activation_min, data->activation_max);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+
+  const int16_t *input_data = tflite::micro::GetTensorData<int16_t>(input);
+  int16_t *output_data = tflite::micro::GetTensorData<int16_t>(output);
+
+  const int input_size = input_width * input_height * depth;
+  const int output_size = output_width * output_height * depth;
+
+  for (int batch = 0; batch < batches; ++batch) {
+    esp_nn_avg_pool_s16(input_data, input_width, input_height,
+                        output_data, output_width, output_height,
+                        params->stride_width, params->stride_height,
+                        params->filter_width, params->filter_height,
+                        data->padding.width, data->padding.height,
+                        data->activation_min, data->activation_max, depth);
+    input_data += input_size;
+    output_data += output_size;
+  }
+}
+
 void MaxEvalQuantized(TfLiteContext* context, TfLiteNode* node,
                       TfLitePoolParams* params, const OpDataPooling* data,
                       const TfLiteEvalTensor* input, TfLiteEvalTensor* output) {
@@ -158,7 +188,6 @@ TfLiteStatus AverageEval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteEvalTensor* output =
       micro::GetEvalOutput(context, node, kPoolingOutputTensor);
 
-  long long start_time = esp_timer_get_time();
   // Inputs and outputs share the same type, guaranteed by the converter.
   switch (input->type) {
     case kTfLiteFloat32:
@@ -173,15 +202,18 @@ TfLiteStatus AverageEval(TfLiteContext* context, TfLiteNode* node) {
 #endif
       break;
     case kTfLiteInt16:
+#if ESP_NN
+      AverageEvalQuantized16(context, node, params, data, input, output);
+#else
       AveragePoolingEvalQuantized<int16_t>(context, node, params, data, input,
                                            output);
+#endif
       break;
     default:
       TF_LITE_KERNEL_LOG(context, "Input type %s is not currently supported",
                          TfLiteTypeGetName(input->type));
       return kTfLiteError;
   }
-  pooling_total_time += esp_timer_get_time() - start_time;
   return kTfLiteOk;
 }
 
@@ -198,7 +230,6 @@ TfLiteStatus MaxEval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteEvalTensor* output =
       micro::GetEvalOutput(context, node, kPoolingOutputTensor);
 
-  long long start_time = esp_timer_get_time();
   switch (input->type) {
     case kTfLiteFloat32:
       MaxPoolingEvalFloat(context, node, params, data, input, output);
@@ -220,7 +251,6 @@ TfLiteStatus MaxEval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(input->type));
       return kTfLiteError;
   }
-  pooling_total_time += esp_timer_get_time() - start_time;
   return kTfLiteOk;
 }
 
@@ -26,14 +26,10 @@ limitations under the License.
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
-#include <esp_timer.h>
-
 #if ESP_NN
 #include <esp_nn.h>
 #endif
 
-long long softmax_total_time = 0;
-
 namespace tflite {
 namespace {
 // Softmax parameter data that persists in user_data
@@ -42,7 +38,8 @@ const int kInt16LUTArraySize = 513;
 struct NodeData {
   SoftmaxParams op_data;
 #if ESP_NN
-  int buffer_idx;
+  // exps of `max - input`, built at Prepare for int8 -> int8.
+  int32_t* exp_lut;
 #endif
 };
 
@@ -62,9 +59,6 @@ void SoftmaxQuantized(TfLiteContext* context, const TfLiteEvalTensor* input,
           tflite::micro::GetTensorData<int16_t>(output));
     } else {
 #if ESP_NN
-      const int32_t input_beta_multiplier = data->op_data.input_multiplier;
-      const int32_t input_beta_left_shift = data->op_data.input_left_shift;
-      const int diff_min = data->op_data.diff_min;
       const RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
       const RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
       const int trailing_dim = input_shape.DimensionsCount() - 1;
@@ -74,13 +68,8 @@ void SoftmaxQuantized(TfLiteContext* context, const TfLiteEvalTensor* input,
           MatchingDim(input_shape, trailing_dim, output_shape, trailing_dim);
       const int8_t *in_ptr = tflite::micro::GetTensorData<int8_t>(input);
       int8_t *out_ptr = tflite::micro::GetTensorData<int8_t>(output);
-      void *scratch_buf = NULL;
-      if (data->buffer_idx > -1) {
-        scratch_buf = context->GetScratchBuffer(context, data->buffer_idx);
-      }
-      esp_nn_set_softmax_scratch_buf(scratch_buf);
-      esp_nn_softmax_s8(in_ptr, outer_size, depth, input_beta_multiplier,
-                        input_beta_left_shift, diff_min, out_ptr);
+      esp_nn_softmax_s8_lut(in_ptr, outer_size, depth, data->exp_lut,
+                            out_ptr);
 #else
       tflite::reference_ops::Softmax(
           data->op_data, tflite::micro::GetTensorShape(input),
@@ -105,7 +94,6 @@ static TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   NodeData data = *static_cast<NodeData*>(node->user_data);
 
-  long long start_time = esp_timer_get_time();
   switch (input->type) {
     case kTfLiteFloat32: {
       tflite::reference_ops::Softmax(
@@ -125,7 +113,6 @@ static TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(input->type), input->type);
       return kTfLiteError;
   }
-  softmax_total_time += esp_timer_get_time() - start_time;
   return kTfLiteOk;
 }
 
@@ -149,17 +136,14 @@ static TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       CalculateSoftmaxParams(context, input, output, params, op_data);
 
 #if ESP_NN
-  if (output->type == kTfLiteInt8 && input->type == kTfLiteInt8) {
-    const int32_t input_width = input->dims->data[1];
-    const int32_t input_height = input->dims->data[2];
-    int scratch_buf_size = esp_nn_get_softmax_scratch_size(input_width,
-                                                           input_height);
-    if (scratch_buf_size > 0) {
-      TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
-        context, scratch_buf_size, &data->buffer_idx));
-    } else {
-      data->buffer_idx = -1;
-    }
+  if (ret_val == kTfLiteOk && output->type == kTfLiteInt8 &&
+      input->type == kTfLiteInt8) {
+    data->exp_lut = static_cast<int32_t*>(context->AllocatePersistentBuffer(
+        context, ESP_NN_SOFTMAX_LUT_SIZE * sizeof(int32_t)));
+    TF_LITE_ENSURE(context, data->exp_lut != nullptr);
+    esp_nn_prepare_softmax_lut_s8(op_data->input_multiplier,
+                                  op_data->input_left_shift, op_data->diff_min,
+                                  data->exp_lut);
   }
 #endif
 
@@ -0,0 +1,136 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/esp_nn/sparse_filter.h"
+
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/micro/micro_context.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+const SparsityParameters* FilterSparsity(TfLiteContext* context,
+                                         const TfLiteNode* node,
+                                         int filter_index) {
+  return GetMicroContext(context)->GetTensorSparsity(
+      node->inputs->data[filter_index]);
+}
+
+}  // namespace
+
+bool IsEspNnSparseFilter(TfLiteContext* context, const TfLiteNode* node,
+                         int filter_index) {
+  return FilterSparsity(context, node, filter_index) != nullptr;
+}
+
+TfLiteStatus PrepareEspNnSparseFilter(TfLiteContext* context,
+                                      const TfLiteNode* node, int filter_index,
+                                      const TfLiteTensor* filter, int rows,
+                                      int row_len, const sparse_s8_t** sparse) {
+  *sparse = nullptr;
+  const SparsityParameters* sparsity =
+      FilterSparsity(context, node, filter_index);
+  if (sparsity == nullptr) {
+    return kTfLiteOk;
+  }
+
+  // Rows in the order of the shape, no blocks, and CSR on the last dimension.
+  const int dims = filter->dims->size;
+  const auto* order = sparsity->traversal_order();
+  const auto* dim_metadata = sparsity->dim_metadata();
+  TF_LITE_ENSURE_MSG(context, filter->type == kTfLiteInt8,
+                     "Sparse filters must be int8.");
+  TF_LITE_ENSURE(context, order != nullptr && dim_metadata != nullptr);
+  TF_LITE_ENSURE_EQ(context, static_cast<int>(order->size()), dims);
+  TF_LITE_ENSURE_EQ(context, static_cast<int>(dim_metadata->size()), dims);
+  TF_LITE_ENSURE_MSG(context,
+                     sparsity->block_map() == nullptr ||
+                         sparsity->block_map()->size() == 0,
+                     "Block sparse filters are not supported.");
+  int dense_rows = 1;
+  for (int i = 0; i < dims; i++) {
+    TF_LITE_ENSURE_EQ(context, order->Get(i), i);
+    const DimensionMetadata* dim = dim_metadata->Get(i);
+    if (i < dims - 1) {
+      TF_LITE_ENSURE_EQ(context, dim->format(), DimensionType_DENSE);
+      TF_LITE_ENSURE_EQ(context, dim->dense_size(), filter->dims->data[i]);
+      dense_rows *= dim->dense_size();
+    }
+  }
+  TF_LITE_ENSURE_EQ(context, dense_rows, rows);
+  TF_LITE_ENSURE_EQ(context, filter->dims->data[dims - 1], row_len);
+
+  const DimensionMetadata* csr = dim_metadata->Get(dims - 1);
+  TF_LITE_ENSURE_MSG(context, csr->format() == DimensionType_SPARSE_CSR,
+                     "The rows of a sparse filter must be CSR.");
+  const Int32Vector* segments = csr->array_segments_as_Int32Vector();
+  TF_LITE_ENSURE(context, segments != nullptr && segments->values() != nullptr);
+  TF_LITE_ENSURE_EQ(context, static_cast<int>(segments->values()->size()),
+                    rows + 1);
+  const int32_t* row_start = segments->values()->data();
+  const int nonzeros = row_start[rows];
+
+  // The model only keeps the nonzero values of the filter, one int8 each.
+  TF_LITE_ENSURE_EQ(context,
+                    GetMicroContext(context)->GetTensorBufferBytes(
+                        node->inputs->data[filter_index]),
+                    static_cast<size_t>(nonzeros));
+
+  const void* cols = nullptr;
+  const uint8_t* cols8 = nullptr;
+  const uint16_t* cols16 = nullptr;
+  int col_size = 0;
+  int cols_count = 0;
+  if (const Uint8Vector* indices8 = csr->array_indices_as_Uint8Vector()) {
+    TF_LITE_ENSURE(context, indices8->values() != nullptr && row_len <= 256);
+    cols = cols8 = indices8->values()->data();
+    cols_count = indices8->values()->size();
+    col_size = 1;
+  } else if (const Uint16Vector* indices16 =
+                 csr->array_indices_as_Uint16Vector()) {
+    TF_LITE_ENSURE(context, indices16->values() != nullptr);
+    cols = cols16 = indices16->values()->data();
+    cols_count = indices16->values()->size();
+    col_size = 2;
+  }
+  TF_LITE_ENSURE_MSG(context, cols != nullptr,
+                     "Sparse filters need uint8 or uint16 indices.");
+  TF_LITE_ENSURE_EQ(context, cols_count, nonzeros);
+  TF_LITE_ENSURE_EQ(context, row_start[0], 0);
+  for (int row = 0; row < rows; row++) {
+    TF_LITE_ENSURE(context, row_start[row] <= row_start[row + 1] &&
+                                row_start[row + 1] <= nonzeros);
+    for (int i = row_start[row]; i < row_start[row + 1]; i++) {
+      const int col = col_size == 1 ? cols8[i] : cols16[i];
+      TF_LITE_ENSURE_MSG(context, col < row_len,
+                         "Sparse filter column out of the row.");
+    }
+  }
+
+  sparse_s8_t* result = static_cast<sparse_s8_t*>(
+      context->AllocatePersistentBuffer(context, sizeof(sparse_s8_t)));
+  TF_LITE_ENSURE(context, result != nullptr);
+  result->rows = rows;
+  result->row_len = row_len;
+  result->row_start = row_start;
+  result->cols = cols;
+  result->col_size = col_size;
+  result->values = GetTensorData<int8_t>(filter);
+  *sparse = result;
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
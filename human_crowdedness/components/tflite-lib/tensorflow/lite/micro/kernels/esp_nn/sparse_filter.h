@@ -0,0 +1,45 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_SPARSE_FILTER_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_SPARSE_FILTER_H_
+
+#include <esp_nn_defs.h>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+// Int8 filters of FULLY_CONNECTED and 1x1 CONV_2D nodes can come sparse in the
+// model, as written by the sparsify_model host tool: one row per output
+// channel, all dimensions DENSE but the last one, which is SPARSE_CSR with
+// int32 segments and uint8 or uint16 indices, and the buffer of the tensor
+// holding only the values other than 0. See esp_nn_sparse_common.h.
+//
+// Sets `sparse` to nullptr for a dense filter, else to the rows, columns and
+// values where they are in the model. Only that description of them is in the
+// arena. Fails on a sparse filter that is not in that format or has a shape
+// other than `rows` x `row_len`.
+TfLiteStatus PrepareEspNnSparseFilter(TfLiteContext* context,
+                                      const TfLiteNode* node, int filter_index,
+                                      const TfLiteTensor* filter, int rows,
+                                      int row_len, const sparse_s8_t** sparse);
+
+// Whether the filter of input `filter_index` of `node` is sparse in the model.
+bool IsEspNnSparseFilter(TfLiteContext* context, const TfLiteNode* node,
+                         int filter_index);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_SPARSE_FILTER_H_
@@ -0,0 +1,312 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/memory_planner/search_memory_planner.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+
+SearchMemoryPlanner::SearchMemoryPlanner(int iterations, uint32_t seed)
+    : iterations_(iterations), seed_(seed != 0 ? seed : 1) {}
+
+SearchMemoryPlanner::~SearchMemoryPlanner() {
+  // We don't own the scratch buffer, so don't deallocate anything.
+}
+
+TfLiteStatus SearchMemoryPlanner::Init(unsigned char* scratch_buffer,
+                                       int scratch_buffer_size) {
+  buffer_count_ = 0;
+  offline_buffer_count_ = 0;
+  need_to_calculate_offsets_ = true;
+
+  max_buffer_count_ = scratch_buffer_size / per_buffer_size();
+
+  unsigned char* next_free = scratch_buffer;
+  requirements_ = reinterpret_cast<BufferRequirements*>(next_free);
+  next_free += sizeof(BufferRequirements) * max_buffer_count_;
+  int** int_arrays[] = {&order_, &best_order_, &offsets_, &best_offsets_,
+                        &placed_by_offset_};
+  for (int** array : int_arrays) {
+    *array = reinterpret_cast<int*>(next_free);
+    next_free += sizeof(int) * max_buffer_count_;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus SearchMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                            int last_time_used) {
+  return AddBuffer(size, first_time_used, last_time_used,
+                   kOnlinePlannedBuffer);
+}
+
+TfLiteStatus SearchMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                            int last_time_used,
+                                            int offline_offset) {
+  if (buffer_count_ >= max_buffer_count_) {
+    MicroPrintf("Too many buffers (max is %d)", max_buffer_count_);
+    return kTfLiteError;
+  }
+  BufferRequirements* current = &requirements_[buffer_count_];
+  current->size = size;
+  current->first_time_used = first_time_used;
+  current->last_time_used = last_time_used;
+  current->offline_offset = offline_offset;
+  if (offline_offset != kOnlinePlannedBuffer) {
+    offline_buffer_count_++;
+  }
+  ++buffer_count_;
+  need_to_calculate_offsets_ = true;
+  return kTfLiteOk;
+}
+
+void SearchMemoryPlanner::SortOnlineBuffers(Order order) {
+  auto key = [this, order](int id) -> int64_t {
+    const BufferRequirements& r = requirements_[id];
+    const int64_t lifetime = r.last_time_used - r.first_time_used + 1;
+    switch (order) {
+      case Order::kByLifetime:
+        return lifetime;
+      case Order::kBySizeTimesLifetime:
+        return r.size * lifetime;
+      case Order::kBySize:
+      default:
+        return r.size;
+    }
+  };
+
+  // Insertion sort, stable, and quick on the nearly sorted orders that the
+  // tensors of a model usually come in.
+  for (int i = offline_buffer_count_ + 1; i < buffer_count_; ++i) {
+    const int id = order_[i];
+    const int64_t id_key = key(id);
+    int j = i;
+    while (j > offline_buffer_count_ && key(order_[j - 1]) < id_key) {
+      order_[j] = order_[j - 1];
+      --j;
+    }
+    order_[j] = id;
+  }
+}
+
+size_t SearchMemoryPlanner::PlaceInOrder() {
+  // placed_by_offset_ holds the buffers placed so far, lowest offset first.
+  int placed = 0;
+  size_t memory_size = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const int id = order_[i];
+    const BufferRequirements& wanted = requirements_[id];
+
+    int offset = wanted.offline_offset;
+    if (offset == kOnlinePlannedBuffer) {
+      // The first gap between the buffers live at the same time that is big
+      // enough, or after all of them.
+      offset = 0;
+      for (int p = 0; p < placed; ++p) {
+        const int other_id = placed_by_offset_[p];
+        const BufferRequirements& other = requirements_[other_id];
+        if (other.first_time_used > wanted.last_time_used ||
+            wanted.first_time_used > other.last_time_used) {
+          continue;
+        }
+        if (offsets_[other_id] - offset >= wanted.size) {
+          break;
+        }
+        if (offsets_[other_id] + other.size > offset) {
+          offset = offsets_[other_id] + other.size;
+        }
+      }
+    }
+    offsets_[id] = offset;
+
+    int p = placed;
+    while (p > 0 && offsets_[placed_by_offset_[p - 1]] > offset) {
+      placed_by_offset_[p] = placed_by_offset_[p - 1];
+      --p;
+    }
+    placed_by_offset_[p] = id;
+    ++placed;
+
+    const size_t end = static_cast<size_t>(offset) + wanted.size;
+    if (end > memory_size) {
+      memory_size = end;
+    }
+  }
+  return memory_size;
+}
+
+void SearchMemoryPlanner::KeepPlan(size_t memory_size) {
+  best_memory_size_ = memory_size;
+  memcpy(best_order_, order_, sizeof(int) * buffer_count_);
+  memcpy(best_offsets_, offsets_, sizeof(int) * buffer_count_);
+}
+
+uint32_t SearchMemoryPlanner::NextRandom() {
+  // xorshift32.
+  random_state_ ^= random_state_ << 13;
+  random_state_ ^= random_state_ >> 17;
+  random_state_ ^= random_state_ << 5;
+  return random_state_;
+}
+
+void SearchMemoryPlanner::CalculateOffsetsIfNeeded() {
+  if (!need_to_calculate_offsets_) {
+    return;
+  }
+  need_to_calculate_offsets_ = false;
+  best_memory_size_ = SIZE_MAX;
+  random_state_ = seed_;
+
+  // The memory live at the start of the lifetime of every buffer, whose
+  // maximum is the lower bound.
+  lower_bound_ = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const int t = requirements_[i].first_time_used;
+    size_t live = 0;
+    for (int j = 0; j < buffer_count_; ++j) {
+      if (requirements_[j].first_time_used <= t &&
+          requirements_[j].last_time_used >= t) {
+        live += requirements_[j].size;
+      }
+    }
+    if (live > lower_bound_) {
+      lower_bound_ = live;
+    }
+  }
+
+  // Offline planned buffers first, then the rest last added first, which
+  // is how GreedyMemoryPlanner breaks the ties between buffers of a size.
+  int head = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    if (requirements_[i].offline_offset != kOnlinePlannedBuffer) {
+      order_[head++] = i;
+    }
+  }
+  for (int i = buffer_count_ - 1; i >= 0; --i) {
+    if (requirements_[i].offline_offset == kOnlinePlannedBuffer) {
+      order_[head++] = i;
+    }
+  }
+
+  const Order orders[] = {Order::kBySize, Order::kByLifetime,
+                          Order::kBySizeTimesLifetime};
+  for (Order order : orders) {
+    SortOnlineBuffers(order);
+    const size_t memory_size = PlaceInOrder();
+    if (order == Order::kBySize) {
+      size_order_memory_size_ = memory_size;
+    }
+    if (memory_size < best_memory_size_) {
+      KeepPlan(memory_size);
+    }
+  }
+
+  // Swap two buffers of the best order at a time, keeping the swaps that do
+  // not make the plan bigger, so that the search can cross plateaus.
+  const int online_count = buffer_count_ - offline_buffer_count_;
+  if (online_count >= 2) {
+    memcpy(order_, best_order_, sizeof(int) * buffer_count_);
+    for (int i = 0; i < iterations_ && best_memory_size_ > lower_bound_; ++i) {
+      const int a = offline_buffer_count_ + NextRandom() % online_count;
+      const int b = offline_buffer_count_ + NextRandom() % online_count;
+      if (a == b) {
+        continue;
+      }
+      const int swapped = order_[a];
+      order_[a] = order_[b];
+      order_[b] = swapped;
+      const size_t memory_size = PlaceInOrder();
+      if (memory_size <= best_memory_size_) {
+        KeepPlan(memory_size);
+      } else {
+        order_[b] = order_[a];
+        order_[a] = swapped;
+      }
+    }
+  }
+}
+
+size_t SearchMemoryPlanner::GetMaximumMemorySize() {
+  CalculateOffsetsIfNeeded();
+  return buffer_count_ > 0 ? best_memory_size_ : 0;
+}
+
+size_t SearchMemoryPlanner::GetLowerBound() {
+  CalculateOffsetsIfNeeded();
+  return lower_bound_;
+}
+
+size_t SearchMemoryPlanner::GetSizeOrderMemorySize() {
+  CalculateOffsetsIfNeeded();
+  return buffer_count_ > 0 ? size_order_memory_size_ : 0;
+}
+
+int SearchMemoryPlanner::GetBufferCount() { return buffer_count_; }
+
+TfLiteStatus SearchMemoryPlanner::GetOffsetForBuffer(int buffer_index,
+                                                     int* offset) {
+  CalculateOffsetsIfNeeded();
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    MicroPrintf("buffer index %d is outside range 0 to %d", buffer_index,
+                buffer_count_);
+    return kTfLiteError;
+  }
+  *offset = best_offsets_[buffer_index];
+  return kTfLiteOk;
+}
+
+void SearchMemoryPlanner::PrintMemoryPlan() {
+  CalculateOffsetsIfNeeded();
+  for (int i = 0; i < buffer_count_; ++i) {
+    MicroPrintf("%d: size=%d, offset=%d, first_used=%d last_used=%d", i,
+                requirements_[i].size, best_offsets_[i],
+                requirements_[i].first_time_used,
+                requirements_[i].last_time_used);
+  }
+  MicroPrintf("%d bytes, %d largest first, %d at least",
+              static_cast<int>(GetMaximumMemorySize()),
+              static_cast<int>(size_order_memory_size_),
+              static_cast<int>(lower_bound_));
+}
+
+bool SearchMemoryPlanner::DoAnyBuffersOverlap() {
+  CalculateOffsetsIfNeeded();
+  bool were_overlaps_found = false;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const BufferRequirements& a = requirements_[i];
+    for (int j = i + 1; j < buffer_count_; ++j) {
+      const BufferRequirements& b = requirements_[j];
+      if (a.first_time_used > b.last_time_used ||
+          b.first_time_used > a.last_time_used) {
+        continue;
+      }
+      if (best_offsets_[i] + a.size <= best_offsets_[j] ||
+          best_offsets_[j] + b.size <= best_offsets_[i]) {
+        continue;
+      }
+      were_overlaps_found = true;
+      MicroPrintf("Overlap: %d (%d=>%d, %d->%d) vs %d (%d=>%d, %d->%d)", i,
+                  a.first_time_used, a.last_time_used, best_offsets_[i],
+                  best_offsets_[i] + a.size, j, b.first_time_used,
+                  b.last_time_used, best_offsets_[j],
+                  best_offsets_[j] + b.size);
+    }
+  }
+  return were_overlaps_found;
+}
+
+}  // namespace tflite
@@ -0,0 +1,143 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_SEARCH_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_SEARCH_MEMORY_PLANNER_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+
+namespace tflite {
+
+// A memory planner that places every buffer at the lowest offset where it
+// fits, as GreedyMemoryPlanner does, but tries the buffers in several orders
+// and keeps the plan that needs the least memory:
+//  - largest first, the order of GreedyMemoryPlanner,
+//  - longest lived first,
+//  - largest size times lifetime first,
+//  - then random swaps of two buffers in the best order found so far, kept
+//    when the plan does not grow.
+// The random swaps start from a fixed seed, so the same buffers always get the
+// same plan. The search stops as soon as a plan needs no more than the most
+// memory that is live at the same time, which no plan can beat.
+//
+// Offline planned buffers keep their offsets and are placed first, as in
+// GreedyMemoryPlanner.
+class SearchMemoryPlanner : public MicroMemoryPlanner {
+ public:
+  // Swaps tried after the fixed orders. Every one of them costs a full
+  // placement, O(buffers^2).
+  static constexpr int kDefaultIterations = 256;
+
+  explicit SearchMemoryPlanner(int iterations = kDefaultIterations,
+                               uint32_t seed = 1);
+  ~SearchMemoryPlanner() override;
+
+  // The same as GreedyMemoryPlanner::Init(), with per_buffer_size() bytes of
+  // scratch per buffer.
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override;
+
+  TfLiteStatus AddBuffer(int size, int first_time_used,
+                         int last_time_used) override;
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
+                         int offline_offset) override;
+
+  size_t GetMaximumMemorySize() override;
+  int GetBufferCount() override;
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override;
+
+  // Prints the offset of every buffer and the size of the plan.
+  void PrintMemoryPlan() override;
+
+  // Debug method to check whether any buffer allocations are overlapping. This
+  // is an O(N^2) complexity operation, so only use for testing.
+  bool DoAnyBuffersOverlap();
+
+  // The most memory the buffers need at the same time. No plan is smaller.
+  size_t GetLowerBound();
+
+  // Memory of the plan of the first order, the one GreedyMemoryPlanner
+  // would make.
+  size_t GetSizeOrderMemorySize();
+
+  // Number of bytes required in order to plan a buffer.
+  static size_t per_buffer_size() {
+    return sizeof(BufferRequirements) +  // requirements_
+           sizeof(int) +                 // order_
+           sizeof(int) +                 // best_order_
+           sizeof(int) +                 // offsets_
+           sizeof(int) +                 // best_offsets_
+           sizeof(int);                  // placed_by_offset_
+  }
+
+ private:
+  struct BufferRequirements {
+    int size;
+    int offline_offset;
+    int first_time_used;
+    int last_time_used;
+  };
+
+  enum class Order { kBySize, kByLifetime, kBySizeTimesLifetime };
+
+  // Sorts the online buffers of order_, largest key first, keeping the order
+  // of the buffers with the same key.
+  void SortOnlineBuffers(Order order);
+
+  // Places the buffers in order_ into offsets_, and returns the memory the
+  // plan needs.
+  size_t PlaceInOrder();
+
+  // Makes order_ and offsets_ the best plan so far.
+  void KeepPlan(size_t memory_size);
+
+  // If there isn't an up to date plan, calculate a new one.
+  void CalculateOffsetsIfNeeded();
+
+  uint32_t NextRandom();
+
+  int iterations_;
+  uint32_t seed_;
+  uint32_t random_state_;
+
+  int max_buffer_count_ = 0;
+  int buffer_count_ = 0;
+  // Offline planned buffers go first in the orders, and are never moved.
+  int offline_buffer_count_ = 0;
+
+  BufferRequirements* requirements_ = nullptr;
+  int* order_ = nullptr;
+  int* best_order_ = nullptr;
+  int* offsets_ = nullptr;
+  int* best_offsets_ = nullptr;
+  int* placed_by_offset_ = nullptr;
+
+  size_t best_memory_size_ = 0;
+  size_t size_order_memory_size_ = 0;
+  size_t lower_bound_ = 0;
+
+  // Whether buffers have been added since the last plan was calculated.
+  bool need_to_calculate_offsets_ = true;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_SEARCH_MEMORY_PLANNER_H_
@@ -23,12 +23,30 @@ limitations under the License.
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
 #include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_op_fusion.h"
 
 namespace tflite {
 
 namespace {
 constexpr char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
 constexpr int kUninitializedLifetime = -1;
+
+// The tensors an operator creates or reads.
+struct OpTensors {
+  const int32_t* data;
+  int size;
+};
+
+OpTensors ToOpTensors(const TfLiteIntArray* array) {
+  return array == nullptr ? OpTensors{nullptr, 0}
+                          : OpTensors{array->data, array->size};
+}
+
+OpTensors ToOpTensors(const flatbuffers::Vector<int32_t>* vector) {
+  return vector == nullptr
+             ? OpTensors{nullptr, 0}
+             : OpTensors{vector->data(), static_cast<int>(vector->size())};
+}
 }  // namespace
 
 // Mark the given Allocation info as first created at the specified allocation
@@ -258,10 +276,34 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
     // Each operator has a new allocation scope.
     allocation_scope_count_++;
     const auto* op = subgraph->operators()->Get(i);
-    // Figure out when the first creation and use of each tensor is.
-    for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
-         ++n) {
+    // Nodes that fusion rewrote (see micro_op_fusion.h) no longer use all the
+    // tensors of their operator, their own ones are planned instead.
+    const NodeAndRegistration& node_and_registration =
+        allocations[subgraph_idx].node_and_registrations[i];
+    const bool fused = IsFusedNode(node_and_registration);
+    const OpTensors inputs = fused
+                                 ? ToOpTensors(node_and_registration.node.inputs)
+                                 : ToOpTensors(op->inputs());
+    const OpTensors outputs =
+        fused ? ToOpTensors(node_and_registration.node.outputs)
+              : ToOpTensors(op->outputs());
+    // The tensor between the nodes of a fused pair, the output of the first
+    // one, is never allocated.
+    for (size_t n = 0;
+         fused && op->outputs() != nullptr && n < op->outputs()->size(); ++n) {
       const int tensor_index = op->outputs()->Get(n);
+      bool used = false;
+      for (int m = 0; m < outputs.size; ++m) {
+        used |= outputs.data[m] == tensor_index;
+      }
+      if (!used) {
+        subgraph_allocation_info[tensor_index].needs_allocating = false;
+      }
+    }
+
+    // Figure out when the first creation and use of each tensor is.
+    for (int n = 0; n < outputs.size; ++n) {
+      const int tensor_index = outputs.data[n];
       AllocationInfo* current = &subgraph_allocation_info[tensor_index];
       UpdateFirstCreated(current, allocation_scope_count_);
     }
@@ -276,9 +318,8 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
                                      scratch_buffer_handles, allocations);
 
     // Figure out when the last use of each tensor is.
-    for (size_t n = 0; op->inputs() != nullptr && n < op->inputs()->size();
-         ++n) {
-      const int tensor_index = op->inputs()->Get(n);
+    for (int n = 0; n < inputs.size; ++n) {
+      const int tensor_index = inputs.data[n];
       // Optional bias tensors can have an index of -1 when they are omitted.
       if (tensor_index >= 0) {
         AllocationInfo* current = &subgraph_allocation_info[tensor_index];
@@ -288,9 +329,8 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
         UpdateLastUsed(current, allocation_scope_count_);
       }
     }
-    for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
-         ++n) {
-      const int tensor_index = op->outputs()->Get(n);
+    for (int n = 0; n < outputs.size; ++n) {
+      const int tensor_index = outputs.data[n];
       AllocationInfo* current = &subgraph_allocation_info[tensor_index];
       UpdateLastUsed(current, allocation_scope_count_);
     }
@@ -128,6 +128,9 @@ IPersistentBufferAllocator* CreatePersistentArenaAllocator(uint8_t* buffer_head,
   uint8_t* allocator_buffer =
       tmp.AllocatePersistentBuffer(sizeof(PersistentArenaBufferAllocator),
                                    alignof(PersistentArenaBufferAllocator));
+  if (allocator_buffer == nullptr) {
+    return nullptr;
+  }
   // Use the default copy constructor to populate internal states.
   return new (allocator_buffer) PersistentArenaBufferAllocator(tmp);
 }
@@ -142,6 +145,9 @@ INonPersistentBufferAllocator* CreateNonPersistentArenaAllocator(
       persistent_buffer_allocator->AllocatePersistentBuffer(
           sizeof(NonPersistentArenaBufferAllocator),
           alignof(NonPersistentArenaBufferAllocator));
+  if (allocator_buffer == nullptr) {
+    return nullptr;
+  }
   // Align the actually used area by the head because persistent buffer grows
   // from the head to bottom.
   uint8_t* aligned_buffer_head =
@@ -349,15 +355,28 @@ MicroAllocator::MicroAllocator(SingleArenaBufferAllocator* memory_allocator,
                                MicroMemoryPlanner* memory_planner)
     : non_persistent_buffer_allocator_(memory_allocator),
       persistent_buffer_allocator_(memory_allocator),
+      kernel_persistent_buffer_allocator_(memory_allocator),
+      memory_planner_(memory_planner),
+      model_is_allocating_(false) {}
+
+MicroAllocator::MicroAllocator(
+    IPersistentBufferAllocator* persistent_buffer_allocator,
+    INonPersistentBufferAllocator* non_persistent_buffer_allocator,
+    MicroMemoryPlanner* memory_planner)
+    : non_persistent_buffer_allocator_(non_persistent_buffer_allocator),
+      persistent_buffer_allocator_(persistent_buffer_allocator),
+      kernel_persistent_buffer_allocator_(persistent_buffer_allocator),
       memory_planner_(memory_planner),
       model_is_allocating_(false) {}
 
 MicroAllocator::MicroAllocator(
     IPersistentBufferAllocator* persistent_buffer_allocator,
+    IPersistentBufferAllocator* kernel_persistent_buffer_allocator,
     INonPersistentBufferAllocator* non_persistent_buffer_allocator,
     MicroMemoryPlanner* memory_planner)
     : non_persistent_buffer_allocator_(non_persistent_buffer_allocator),
       persistent_buffer_allocator_(persistent_buffer_allocator),
+      kernel_persistent_buffer_allocator_(kernel_persistent_buffer_allocator),
       memory_planner_(memory_planner),
       model_is_allocating_(false) {}
 
@@ -436,6 +455,53 @@ MicroAllocator* MicroAllocator::Create(uint8_t* persistent_tensor_arena,
   return allocator;
 }
 
+MicroAllocator* MicroAllocator::Create(uint8_t* persistent_tensor_arena,
+                                       size_t persistent_arena_size,
+                                       uint8_t* non_persistent_tensor_arena,
+                                       size_t non_persistent_arena_size,
+                                       MicroMemoryPlanner* memory_planner) {
+  TFLITE_DCHECK(persistent_tensor_arena != nullptr);
+  TFLITE_DCHECK(non_persistent_tensor_arena != nullptr);
+  TFLITE_DCHECK(persistent_tensor_arena != non_persistent_tensor_arena);
+  TFLITE_DCHECK(memory_planner != nullptr);
+
+  IPersistentBufferAllocator* persistent_buffer_allocator =
+      CreatePersistentArenaAllocator(persistent_tensor_arena,
+                                     persistent_arena_size);
+  if (persistent_buffer_allocator == nullptr) {
+    return nullptr;
+  }
+
+  // The non persistent arena has a head and a tail of its own, and the
+  // allocator that keeps them lives in the persistent arena.
+  uint8_t* memory_allocator_buffer =
+      persistent_buffer_allocator->AllocatePersistentBuffer(
+          sizeof(SingleArenaBufferAllocator),
+          alignof(SingleArenaBufferAllocator));
+  uint8_t* micro_allocator_buffer =
+      persistent_buffer_allocator->AllocatePersistentBuffer(
+          sizeof(MicroAllocator), alignof(MicroAllocator));
+  if (memory_allocator_buffer == nullptr || micro_allocator_buffer == nullptr) {
+    return nullptr;
+  }
+  uint8_t* aligned_arena =
+      AlignPointerUp(non_persistent_tensor_arena, MicroArenaBufferAlignment());
+  uint8_t* aligned_arena_tail =
+      AlignPointerDown(non_persistent_tensor_arena + non_persistent_arena_size,
+                       MicroArenaBufferAlignment());
+  if (aligned_arena_tail <= aligned_arena) {
+    return nullptr;
+  }
+  SingleArenaBufferAllocator* memory_allocator =
+      new (memory_allocator_buffer) SingleArenaBufferAllocator(
+          aligned_arena, aligned_arena_tail - aligned_arena);
+
+  MicroAllocator* allocator = new (micro_allocator_buffer)
+      MicroAllocator(persistent_buffer_allocator, memory_allocator,
+                     memory_allocator, memory_planner);
+  return allocator;
+}
+
 SubgraphAllocations* MicroAllocator::StartModelAllocation(const Model* model) {
   TFLITE_DCHECK(model != nullptr);
 
@@ -453,7 +519,7 @@ SubgraphAllocations* MicroAllocator::StartModelAllocation(const Model* model) {
           sizeof(MicroBuiltinDataAllocator),
           alignof(MicroBuiltinDataAllocator));
   builtin_data_allocator_ = new (data_allocator_buffer)
-      MicroBuiltinDataAllocator(persistent_buffer_allocator_);
+      MicroBuiltinDataAllocator(kernel_persistent_buffer_allocator_);
 
   if (InitScratchBufferData() != kTfLiteOk) {
     return nullptr;
@@ -498,7 +564,7 @@ TfLiteStatus MicroAllocator::FinishModelAllocation(
 }
 
 void* MicroAllocator::AllocatePersistentBuffer(size_t bytes) {
-  return persistent_buffer_allocator_->AllocatePersistentBuffer(
+  return kernel_persistent_buffer_allocator_->AllocatePersistentBuffer(
       bytes, MicroArenaBufferAlignment());
 }
 
@@ -575,7 +641,23 @@ TfLiteStatus MicroAllocator::FinishPrepareNodeAllocations(int node_id) {
 
 size_t MicroAllocator::used_bytes() const {
   return non_persistent_buffer_allocator_->GetNonPersistentUsedBytes() +
-         persistent_buffer_allocator_->GetPersistentUsedBytes();
+         persistent_used_bytes();
+}
+
+size_t MicroAllocator::persistent_used_bytes() const {
+  return persistent_buffer_allocator_->GetPersistentUsedBytes() +
+         kernel_persistent_used_bytes();
+}
+
+size_t MicroAllocator::kernel_persistent_used_bytes() const {
+  if (kernel_persistent_buffer_allocator_ == persistent_buffer_allocator_) {
+    return 0;
+  }
+  return kernel_persistent_buffer_allocator_->GetPersistentUsedBytes();
+}
+
+size_t MicroAllocator::non_persistent_used_bytes() const {
+  return non_persistent_buffer_allocator_->GetNonPersistentUsedBytes();
 }
 
 TfLiteStatus MicroAllocator::AllocateNodeAndRegistrations(
@@ -673,6 +755,7 @@ TfLiteTensor* MicroAllocator::AllocateTempTfLiteTensor(
   // This value is allocated from temporary arena space. It is guaranteed to be
   // around for at least the scope of the calling function. Since this struct
   // allocation takes place in temp space, no need to own or cleanup.
+  has_temp_allocations_ = true;
   TfLiteTensor* tensor = reinterpret_cast<TfLiteTensor*>(
       non_persistent_buffer_allocator_->AllocateTemp(sizeof(TfLiteTensor),
                                                      alignof(TfLiteTensor)));
@@ -704,6 +787,7 @@ TfLiteTensor* MicroAllocator::AllocateTempTfLiteTensor(
 }
 
 uint8_t* MicroAllocator::AllocateTempBuffer(size_t size, size_t alignment) {
+  has_temp_allocations_ = true;
   return non_persistent_buffer_allocator_->AllocateTemp(size, alignment);
 }
 
@@ -712,7 +796,10 @@ void MicroAllocator::DeallocateTempBuffer(uint8_t* buffer) {
 }
 
 TfLiteStatus MicroAllocator::ResetTempAllocations() {
-  return non_persistent_buffer_allocator_->ResetTempAllocations();
+  TF_LITE_ENSURE_STATUS(
+      non_persistent_buffer_allocator_->ResetTempAllocations());
+  has_temp_allocations_ = false;
+  return kTfLiteOk;
 }
 
 bool MicroAllocator::IsAllTempDeallocated() {
@@ -766,7 +853,7 @@ TfLiteStatus MicroAllocator::AllocateVariables(
             TfLiteEvalTensorByteLength(&eval_tensors[i], &buffer_size));
 
         eval_tensors[i].data.data =
-            persistent_buffer_allocator_->AllocatePersistentBuffer(
+            kernel_persistent_buffer_allocator_->AllocatePersistentBuffer(
                 buffer_size, MicroArenaBufferAlignment());
 
         if (eval_tensors[i].data.data == nullptr) {
@@ -908,7 +995,7 @@ TfLiteStatus MicroAllocator::AllocateScratchBufferHandles(
   // Allocate a consecutive block of memory store the scratch buffer handles.
   // This alignment ensures quick lookup during inference time for the model:
   *scratch_buffer_handles = reinterpret_cast<ScratchBufferHandle*>(
-      persistent_buffer_allocator_->AllocatePersistentBuffer(
+      kernel_persistent_buffer_allocator_->AllocatePersistentBuffer(
           sizeof(ScratchBufferHandle) * handle_count,
           alignof(ScratchBufferHandle)));
 
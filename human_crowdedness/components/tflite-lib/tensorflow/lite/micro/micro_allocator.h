@@ -142,6 +142,20 @@ class MicroAllocator {
                                 uint8_t* non_persistent_tensor_arena,
                                 size_t non_persistent_arena_size);
 
+  // Same as above, but with a memory planner that the caller owns instead of
+  // a GreedyMemoryPlanner in the persistent arena, and with what the kernels
+  // read while they run kept next to the tensors. The planned tensors, the
+  // scratch buffers and the temporary allocations go in the head of the non
+  // persistent arena, and the kernel buffers, builtin data, variable tensors
+  // and scratch buffer handles in its tail. Only the structs of the tensors,
+  // nodes and registrations, their quantization parameters and the allocators
+  // go in the persistent arena.
+  static MicroAllocator* Create(uint8_t* persistent_tensor_arena,
+                                size_t persistent_arena_size,
+                                uint8_t* non_persistent_tensor_arena,
+                                size_t non_persistent_arena_size,
+                                MicroMemoryPlanner* memory_planner);
+
   // Returns the fixed amount of memory overhead of MicroAllocator.
   static size_t GetDefaultTailUsage(bool is_memory_planner_given);
 
@@ -211,6 +225,10 @@ class MicroAllocator {
   // already deallocated.
   virtual bool IsAllTempDeallocated();
 
+  // Whether anything was allocated from the temporary memory since the last
+  // ResetTempAllocations(), which there is no need to call otherwise.
+  bool HasTempAllocations() const { return has_temp_allocations_; }
+
   // Allocates persistent buffer which has the same life time as the allocator.
   // The memory is immediately available and is allocated from the tail of the
   // arena.
@@ -233,6 +251,16 @@ class MicroAllocator {
   // `FinishModelAllocation`. Otherwise, it will return 0.
   size_t used_bytes() const;
 
+  // The two parts of used_bytes(). With a single arena they are the head and
+  // the tail of it.
+  size_t persistent_used_bytes() const;
+  size_t non_persistent_used_bytes() const;
+
+  // The part of persistent_used_bytes() that is in the tail of the non
+  // persistent arena, with the two arena Create() that takes a planner. Zero
+  // when all of it is in one place.
+  size_t kernel_persistent_used_bytes() const;
+
   TfLiteBridgeBuiltinDataAllocator* GetBuiltinDataAllocator();
 
  protected:
@@ -241,6 +269,12 @@ class MicroAllocator {
   MicroAllocator(IPersistentBufferAllocator* persistent_buffer_allocator,
                  INonPersistentBufferAllocator* non_persistent_buffer_allocator,
                  MicroMemoryPlanner* memory_planner);
+  // With the persistent allocations the kernels read while they run in
+  // `kernel_persistent_buffer_allocator` rather than with the rest.
+  MicroAllocator(IPersistentBufferAllocator* persistent_buffer_allocator,
+                 IPersistentBufferAllocator* kernel_persistent_buffer_allocator,
+                 INonPersistentBufferAllocator* non_persistent_buffer_allocator,
+                 MicroMemoryPlanner* memory_planner);
   virtual ~MicroAllocator();
 
   // Allocates an array in the arena to hold pointers to the node and
@@ -306,6 +340,10 @@ class MicroAllocator {
   INonPersistentBufferAllocator* non_persistent_buffer_allocator_;
   IPersistentBufferAllocator* persistent_buffer_allocator_;
 
+  // Where the persistent buffers, builtin data, variable tensors and scratch
+  // buffer handles go, which Eval reads. Usually persistent_buffer_allocator_.
+  IPersistentBufferAllocator* kernel_persistent_buffer_allocator_;
+
   // Allocator used to allocate persistent builtin data.
   TfLiteBridgeBuiltinDataAllocator* builtin_data_allocator_;
 
@@ -314,6 +352,8 @@ class MicroAllocator {
 
   bool model_is_allocating_;
 
+  bool has_temp_allocations_ = false;
+
   // Holds the number of ScratchBufferRequest instances stored in the head
   // section when a model is allocating.
   size_t scratch_buffer_request_count_ = 0;
@@ -117,6 +117,29 @@ TfLiteEvalTensor* MicroContext::GetEvalTensor(int tensor_idx) {
               .tensors[tensor_idx];
 }
 
+const SparsityParameters* MicroContext::GetTensorSparsity(int tensor_idx) {
+  if (model_ == nullptr) {
+    return nullptr;
+  }
+  const SubGraph* subgraph =
+      model_->subgraphs()->Get(graph_.GetCurrentSubgraphIndex());
+  return subgraph->tensors()->Get(tensor_idx)->sparsity();
+}
+
+size_t MicroContext::GetTensorBufferBytes(int tensor_idx) {
+  if (model_ == nullptr) {
+    return 0;
+  }
+  const SubGraph* subgraph =
+      model_->subgraphs()->Get(graph_.GetCurrentSubgraphIndex());
+  const Buffer* buffer =
+      model_->buffers()->Get(subgraph->tensors()->Get(tensor_idx)->buffer());
+  if (buffer == nullptr || buffer->data() == nullptr) {
+    return 0;
+  }
+  return buffer->data()->size();
+}
+
 void MicroContext::SetScratchBufferHandles(
     ScratchBufferHandle* scratch_buffer_handles) {
   scratch_buffer_handles_ = scratch_buffer_handles;
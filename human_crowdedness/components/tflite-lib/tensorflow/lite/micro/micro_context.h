@@ -107,6 +107,17 @@ class MicroContext {
   // Virtual so that it can be faked for kernel tests.
   virtual TfLiteEvalTensor* GetEvalTensor(int tensor_idx);
 
+  // Returns the sparsity of the tensor at a given index as it is in the model,
+  // or nullptr for a dense tensor. The data of a sparse tensor only holds its
+  // values other than 0, which kernels that support them read in place.
+  // Virtual so that it can be faked for kernel tests.
+  virtual const SparsityParameters* GetTensorSparsity(int tensor_idx);
+
+  // Returns the size in bytes of the data of a tensor as it is in the model,
+  // which for a sparse tensor is the number of values it keeps times their
+  // size, or 0 for a tensor without data in the model.
+  virtual size_t GetTensorBufferBytes(int tensor_idx);
+
   // Sets the State of MemoryPlanning MicroContext
   void SetInterpreterState(MicroContext::InterpreterState state);
 
@@ -151,36 +151,35 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
                 subgraph_idx, subgraphs_->size());
     return kTfLiteError;
   }
-  uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
-  for (size_t i = 0; i < operators_size; ++i) {
-    TfLiteNode* node =
-        &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
-    const TfLiteRegistration_V1* registration =
-        subgraph_allocations_[subgraph_idx]
-            .node_and_registrations[i]
-            .registration;
-
-// This ifdef is needed (even though ScopedMicroProfiler itself is a no-op with
-// -DTF_LITE_STRIP_ERROR_STRINGS) because the function OpNameFromRegistration is
-// only defined for builds with the error strings.
-#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
-    ScopedMicroProfiler scoped_profiler(
-        OpNameFromRegistration(registration),
-        reinterpret_cast<MicroProfilerInterface*>(context_->profiler));
-#endif
+  if (plans_ == nullptr) {
+    TF_LITE_ENSURE_STATUS(BuildExecutionPlans());
+  }
 
-    TFLITE_DCHECK(registration->invoke);
-    TfLiteStatus invoke_status = registration->invoke(context_, node);
+  const MicroExecutionPlan& plan = plans_[subgraph_idx];
+  MicroProfilerInterface* profiler =
+      reinterpret_cast<MicroProfilerInterface*>(context_->profiler);
+  for (int i = 0; i < plan.size; ++i) {
+    const MicroPlanStep& step = plan.steps[i];
+
+    TfLiteStatus invoke_status;
+    {
+      ScopedMicroProfiler scoped_profiler(step.op_name, subgraph_idx, i,
+                                          profiler);
+      invoke_status = step.invoke(context_, step.node);
+    }
 
     // All TfLiteTensor structs used in the kernel are allocated from temp
     // memory in the allocator. This creates a chain of allocations in the
     // temp section. The call below resets the chain of allocations to
-    // prepare for the next call.
-    allocator_->ResetTempAllocations();
+    // prepare for the next call. Most kernels allocate nothing there once
+    // prepared, and then there is nothing to reset.
+    if (allocator_->HasTempAllocations()) {
+      allocator_->ResetTempAllocations();
+    }
 
     if (invoke_status == kTfLiteError) {
       MicroPrintf("Node %s (number %d) failed to invoke with status %d",
-                  OpNameFromRegistration(registration), i, invoke_status);
+                  step.op_name, i, invoke_status);
       return kTfLiteError;
     } else if (invoke_status != kTfLiteOk) {
       return invoke_status;
@@ -190,6 +189,52 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroGraph::BuildExecutionPlans() {
+  MicroExecutionPlan* plans =
+      static_cast<MicroExecutionPlan*>(allocator_->AllocatePersistentBuffer(
+          sizeof(MicroExecutionPlan) * subgraphs_->size()));
+  if (plans == nullptr) {
+    MicroPrintf("Failed to allocate the execution plans");
+    return kTfLiteError;
+  }
+
+  for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_->size();
+       subgraph_idx++) {
+    uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
+    MicroPlanStep* steps =
+        static_cast<MicroPlanStep*>(allocator_->AllocatePersistentBuffer(
+            sizeof(MicroPlanStep) * operators_size));
+    if (steps == nullptr && operators_size > 0) {
+      MicroPrintf("Failed to allocate the execution plan of subgraph %d",
+                  subgraph_idx);
+      return kTfLiteError;
+    }
+    for (size_t i = 0; i < operators_size; ++i) {
+      NodeAndRegistration& node_and_registration =
+          subgraph_allocations_[subgraph_idx].node_and_registrations[i];
+      const TfLiteRegistration_V1* registration =
+          node_and_registration.registration;
+      if (registration->invoke == nullptr) {
+        MicroPrintf("Node %s (number %d) has no invoke function",
+                    OpNameFromRegistration(registration), i);
+        return kTfLiteError;
+      }
+      steps[i].invoke = registration->invoke;
+      steps[i].node = &node_and_registration.node;
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+      steps[i].op_name = OpNameFromRegistration(registration);
+#else
+      steps[i].op_name = nullptr;
+#endif
+    }
+    plans[subgraph_idx].steps = steps;
+    plans[subgraph_idx].size = static_cast<int>(operators_size);
+  }
+  plans_ = plans;
+
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroGraph::ResetVariableTensors() {
   for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_->size();
        subgraph_idx++) {
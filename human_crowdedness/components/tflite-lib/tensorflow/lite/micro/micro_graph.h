@@ -23,6 +23,22 @@ limitations under the License.
 
 namespace tflite {
 
+// One operator of a subgraph, as InvokeSubgraph() runs it.
+struct MicroPlanStep {
+  TfLiteStatus (*invoke)(TfLiteContext* context, TfLiteNode* node);
+  TfLiteNode* node;
+  // Name of the operator for the profiler and the errors, nullptr in builds
+  // without error strings.
+  const char* op_name;
+};
+
+// The operators of a subgraph in the order they run, resolved from the
+// flatbuffer and the registrations once the tensors are allocated.
+struct MicroExecutionPlan {
+  MicroPlanStep* steps;
+  int size;
+};
+
 // Abstracts the details of interacting with the tflite::Model.
 //
 // Provides methods to access, initialize, prepare, invoke and free any
@@ -54,6 +70,12 @@ class MicroGraph {
   // in the model.
   virtual TfLiteStatus InvokeSubgraph(int subgraph_idx);
 
+  // Builds the execution plan of every subgraph in the persistent arena,
+  // about 12 bytes per operator on 32-bit targets. Must be called once all the
+  // operators are prepared. From then on InvokeSubgraph runs the plans instead
+  // of walking the model.
+  virtual TfLiteStatus BuildExecutionPlans();
+
   // Zeros out all variable tensors in all subgraphs in the model.
   virtual TfLiteStatus ResetVariableTensors();
 
@@ -95,6 +117,7 @@ class MicroGraph {
   int current_subgraph_index_;
   MicroResourceVariables* resource_variables_;
   const flatbuffers::Vector<flatbuffers::Offset<SubGraph>>* subgraphs_;
+  MicroExecutionPlan* plans_ = nullptr;
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_context.h"
 #include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_op_fusion.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler_interface.h"
 #include "tensorflow/lite/micro/tflite_bridge/flatbuffer_conversions_bridge.h"
@@ -198,6 +199,11 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
 
   TF_LITE_ENSURE_STATUS(PrepareNodeAndRegistrationDataFromFlatbuffer());
 
+  if (op_fusion_) {
+    TF_LITE_ENSURE_STATUS(FuseDepthwisePointwiseConvs(
+        model_, graph_.GetAllocations(), &allocator_));
+  }
+
   micro_context_.SetInterpreterState(MicroContext::InterpreterState::kInit);
   TF_LITE_ENSURE_STATUS(graph_.InitSubgraphs());
 
@@ -258,6 +264,9 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
     }
   }
 
+  // Every operator is prepared, what Invoke() runs is known from now on.
+  TF_LITE_ENSURE_STATUS(graph_.BuildExecutionPlans());
+
   TF_LITE_ENSURE_STATUS(Reset());
 
   tensors_allocated_ = true;
@@ -121,6 +121,13 @@ class MicroInterpreter {
 
   TfLiteStatus initialization_status() const { return initialization_status_; }
 
+  // Whether AllocateTensors() runs pairs of nodes as one fused node where a
+  // fused kernel exists (see micro_op_fusion.h). Off by default: the fused
+  // nodes skip the tensor between the two, but add strip buffers and node
+  // data, so they only pay off for models where that tensor sets the peak.
+  // Must be set before AllocateTensors().
+  void SetOpFusion(bool enabled) { op_fusion_ = enabled; }
+
   // Populates node and registration pointers representing the inference graph
   // of the model from values inside the flatbuffer (loaded from the TfLiteModel
   // instance). Persistent data (e.g. operator data) is allocated from the
@@ -153,6 +160,7 @@ class MicroInterpreter {
   MicroAllocator& allocator_;
   MicroGraph graph_;
   bool tensors_allocated_;
+  bool op_fusion_ = false;
 
   TfLiteStatus initialization_status_;
 
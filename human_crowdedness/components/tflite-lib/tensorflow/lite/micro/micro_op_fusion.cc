@@ -0,0 +1,249 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_op_fusion.h"
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/depthwise_conv.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/depthwise_pointwise_conv.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+#if ESP_NN_DEPTHWISE_POINTWISE_FUSION
+
+namespace {
+
+TfLiteStatus FusedAwayEval(TfLiteContext* context, TfLiteNode* node) {
+  return kTfLiteOk;
+}
+
+const TfLiteRegistration_V1* FusedRegistration() {
+  static const TfLiteRegistration_V1 registration =
+      Register_DEPTHWISE_POINTWISE_CONV_2D();
+  return &registration;
+}
+
+// Registration left on the depthwise node of a fused pair.
+const TfLiteRegistration_V1* FusedAwayRegistration() {
+  static const TfLiteRegistration_V1 registration = {
+      /*init=*/nullptr,
+      /*free=*/nullptr,
+      /*prepare=*/nullptr,
+      /*invoke=*/FusedAwayEval,
+      /*profiling_string=*/nullptr,
+      /*builtin_code=*/BuiltinOperator_CUSTOM,
+      /*custom_name=*/"DEPTHWISE_CONV_2D(fused)",
+      /*version=*/0};
+  return &registration;
+}
+
+bool IsInt8(const SubGraph* subgraph, int tensor_index) {
+  return tensor_index >= 0 &&
+         subgraph->tensors()->Get(tensor_index)->type() == TensorType_INT8;
+}
+
+int ElementCount(const Tensor* tensor) {
+  int count = 1;
+  for (size_t i = 0; tensor->shape() != nullptr && i < tensor->shape()->size();
+       ++i) {
+    count *= tensor->shape()->Get(i);
+  }
+  return count;
+}
+
+bool Contains(const TfLiteIntArray* array, int tensor_index) {
+  for (int i = 0; array != nullptr && i < array->size; ++i) {
+    if (array->data[i] == tensor_index) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Contains(const flatbuffers::Vector<int32_t>* vector, int tensor_index) {
+  for (size_t i = 0; vector != nullptr && i < vector->size(); ++i) {
+    if (vector->Get(i) == tensor_index) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Whether node `i` (DEPTHWISE_CONV_2D) and node `i + 1` (1x1 CONV_2D) can run
+// as one DEPTHWISE_POINTWISE_CONV_2D node.
+bool CanFuse(const SubGraph* subgraph, const NodeAndRegistration* nodes,
+             uint32_t operators_size, uint32_t i) {
+  const NodeAndRegistration& dw = nodes[i];
+  const NodeAndRegistration& pw = nodes[i + 1];
+
+  // Only the ESP-NN kernels, whose buffers the fused node knows about.
+  if (dw.registration->builtin_code != BuiltinOperator_DEPTHWISE_CONV_2D ||
+      dw.registration->invoke != Register_DEPTHWISE_CONV_2D().invoke ||
+      pw.registration->builtin_code != BuiltinOperator_CONV_2D ||
+      pw.registration->invoke != Register_CONV_2D().invoke) {
+    return false;
+  }
+  if (dw.node.inputs->size != 3 || dw.node.outputs->size != 1 ||
+      pw.node.inputs->size != 3 || pw.node.outputs->size != 1) {
+    return false;
+  }
+
+  const int intermediate = dw.node.outputs->data[0];
+  if (pw.node.inputs->data[kConvInputTensor] != intermediate ||
+      pw.node.inputs->data[kConvWeightsTensor] == intermediate ||
+      pw.node.inputs->data[kConvBiasTensor] == intermediate) {
+    return false;
+  }
+  if (!IsInt8(subgraph, dw.node.inputs->data[kDepthwiseConvInputTensor]) ||
+      !IsInt8(subgraph, intermediate) ||
+      !IsInt8(subgraph, pw.node.outputs->data[0])) {
+    return false;
+  }
+
+  const Tensor* tensor = subgraph->tensors()->Get(intermediate);
+  if (tensor->is_variable() || tensor->shape() == nullptr ||
+      tensor->shape()->size() != 4 || tensor->shape()->Get(0) != 1) {
+    return false;
+  }
+  // The fused node keeps the depthwise input alive until the pointwise output
+  // is written, where the intermediate tensor was alive before. A bigger input
+  // (strides of 2) would raise the peak of the arena.
+  const int input = dw.node.inputs->data[kDepthwiseConvInputTensor];
+  if (ElementCount(subgraph->tensors()->Get(input)) > ElementCount(tensor)) {
+    return false;
+  }
+  const int pw_filter = pw.node.inputs->data[kConvWeightsTensor];
+  const auto* pw_filter_shape = subgraph->tensors()->Get(pw_filter)->shape();
+  if (pw_filter_shape == nullptr || pw_filter_shape->size() != 4 ||
+      pw_filter_shape->Get(1) != 1 || pw_filter_shape->Get(2) != 1) {
+    return false;
+  }
+
+  const auto* dw_params =
+      static_cast<const TfLiteDepthwiseConvParams*>(dw.node.builtin_data);
+  const auto* pw_params =
+      static_cast<const TfLiteConvParams*>(pw.node.builtin_data);
+  if (dw_params == nullptr || pw_params == nullptr ||
+      dw_params->dilation_width_factor != 1 ||
+      dw_params->dilation_height_factor != 1 ||
+      pw_params->stride_width != 1 || pw_params->stride_height != 1 ||
+      pw_params->dilation_width_factor != 1 ||
+      pw_params->dilation_height_factor != 1) {
+    return false;
+  }
+
+  // Nothing else may read the intermediate tensor, it is never allocated.
+  if (Contains(subgraph->inputs(), intermediate) ||
+      Contains(subgraph->outputs(), intermediate)) {
+    return false;
+  }
+  for (uint32_t j = 0; j < operators_size; ++j) {
+    if (j != i + 1 && Contains(nodes[j].node.inputs, intermediate)) {
+      return false;
+    }
+    if (j != i && Contains(nodes[j].node.outputs, intermediate)) {
+      return false;
+    }
+    if (Contains(nodes[j].node.intermediates, intermediate)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TfLiteIntArray* AllocateIntArray(MicroAllocator* allocator, int size) {
+  auto* array = static_cast<TfLiteIntArray*>(
+      allocator->AllocatePersistentBuffer(TfLiteIntArrayGetSizeInBytes(size)));
+  if (array != nullptr) {
+    array->size = size;
+  }
+  return array;
+}
+
+TfLiteStatus Fuse(NodeAndRegistration* dw, NodeAndRegistration* pw,
+                  MicroAllocator* allocator) {
+  auto* params = static_cast<TfLiteDepthwisePointwiseConvParams*>(
+      allocator->AllocatePersistentBuffer(
+          sizeof(TfLiteDepthwisePointwiseConvParams)));
+  TfLiteIntArray* inputs = AllocateIntArray(allocator, 5);
+  TfLiteIntArray* empty = AllocateIntArray(allocator, 0);
+  if (params == nullptr || inputs == nullptr || empty == nullptr) {
+    MicroPrintf("Failed to allocate memory for a fused node");
+    return kTfLiteError;
+  }
+  params->depthwise =
+      static_cast<TfLiteDepthwiseConvParams*>(dw->node.builtin_data);
+  params->pointwise = static_cast<TfLiteConvParams*>(pw->node.builtin_data);
+  params->intermediate = dw->node.outputs->data[0];
+
+  inputs->data[0] = dw->node.inputs->data[kDepthwiseConvInputTensor];
+  inputs->data[1] = dw->node.inputs->data[kDepthwiseConvWeightsTensor];
+  inputs->data[2] = dw->node.inputs->data[kDepthwiseConvBiasTensor];
+  inputs->data[3] = pw->node.inputs->data[kConvWeightsTensor];
+  inputs->data[4] = pw->node.inputs->data[kConvBiasTensor];
+
+  pw->node.inputs = inputs;
+  pw->node.builtin_data = params;
+  pw->registration = FusedRegistration();
+
+  dw->node.inputs = empty;
+  dw->node.outputs = empty;
+  dw->registration = FusedAwayRegistration();
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+bool IsFusedNode(const NodeAndRegistration& node) {
+  return node.registration == FusedRegistration() ||
+         node.registration == FusedAwayRegistration();
+}
+
+TfLiteStatus FuseDepthwisePointwiseConvs(const Model* model,
+                                         SubgraphAllocations* allocations,
+                                         MicroAllocator* allocator) {
+  for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
+       subgraph_idx++) {
+    const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+    NodeAndRegistration* nodes =
+        allocations[subgraph_idx].node_and_registrations;
+    const uint32_t operators_size = NumSubgraphOperators(subgraph);
+    for (uint32_t i = 0; i + 1 < operators_size; ++i) {
+      if (CanFuse(subgraph, nodes, operators_size, i)) {
+        TF_LITE_ENSURE_STATUS(Fuse(&nodes[i], &nodes[i + 1], allocator));
+        ++i;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+#else
+
+TfLiteStatus FuseDepthwisePointwiseConvs(const Model* model,
+                                         SubgraphAllocations* allocations,
+                                         MicroAllocator* allocator) {
+  return kTfLiteOk;
+}
+
+bool IsFusedNode(const NodeAndRegistration& node) { return false; }
+
+#endif  // ESP_NN_DEPTHWISE_POINTWISE_FUSION
+
+}  // namespace tflite
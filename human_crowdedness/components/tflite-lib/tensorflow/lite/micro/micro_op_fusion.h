@@ -0,0 +1,46 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_OP_FUSION_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_OP_FUSION_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Rewrites the nodes of all subgraphs so that each DEPTHWISE_CONV_2D whose
+// output is only read by the 1x1 CONV_2D right after it runs together with
+// it, as one DEPTHWISE_POINTWISE_CONV_2D node (see
+// kernels/esp_nn/depthwise_pointwise_conv.h). The tensor between the two is
+// then never allocated.
+//
+// Operators are counted from the flatbuffer, so the depthwise node stays in
+// place as a node without inputs or outputs that does nothing.
+//
+// Must run after the nodes are built from the flatbuffer and before they are
+// initialized. Does nothing in builds without the ESP-NN kernels.
+TfLiteStatus FuseDepthwisePointwiseConvs(const Model* model,
+                                         SubgraphAllocations* allocations,
+                                         MicroAllocator* allocator);
+
+// Whether FuseDepthwisePointwiseConvs() rewrote a node, as either node of a
+// fused pair. The tensors such a node uses are no longer the ones of its
+// operator in the flatbuffer.
+bool IsFusedNode(const NodeAndRegistration& node);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_OP_FUSION_H_
@@ -99,6 +99,8 @@ class ScopedMicroProfiler {
  public:
   explicit ScopedMicroProfiler(const char* tag,
                                MicroProfilerInterface* profiler) {}
+  ScopedMicroProfiler(const char* tag, int subgraph_index, int node_index,
+                      MicroProfilerInterface* profiler) {}
 };
 
 #else
@@ -123,6 +125,17 @@ class ScopedMicroProfiler {
     }
   }
 
+  // The event of the invocation of a node, see
+  // MicroProfilerInterface::BeginNodeEvent.
+  ScopedMicroProfiler(const char* tag, int subgraph_index, int node_index,
+                      MicroProfilerInterface* profiler)
+      : profiler_(profiler) {
+    if (profiler_ != nullptr) {
+      event_handle_ =
+          profiler_->BeginNodeEvent(tag, subgraph_index, node_index);
+    }
+  }
+
   ~ScopedMicroProfiler() {
     if (profiler_ != nullptr) {
       profiler_->EndEvent(event_handle_);
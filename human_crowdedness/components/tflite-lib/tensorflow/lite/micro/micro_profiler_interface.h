@@ -31,6 +31,15 @@ class MicroProfilerInterface {
 
   // Marks the end of an event associated with event_handle.
   virtual void EndEvent(uint32_t event_handle) = 0;
+
+  // Marks the start of the invocation of node `node_index` of subgraph
+  // `subgraph_index`, ended with EndEvent as any other event. Profilers that
+  // keep statistics per node override it, the others get a BeginEvent with the
+  // name of the op as the tag.
+  virtual uint32_t BeginNodeEvent(const char* tag, int subgraph_index,
+                                  int node_index) {
+    return BeginEvent(tag);
+  }
 };
 
 }  // namespace tflite
@@ -0,0 +1,295 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_stats_profiler.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_string.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kSubBucketBits = 2;
+static_assert(1 << kSubBucketBits == kMicroStatsBucketsPerOctave,
+              "4 buckets per octave");
+// Highest bit of the first duration that is not in an exact bucket.
+constexpr int kFirstOctave = 3;
+static_assert(1 << kFirstOctave == kMicroStatsExactBuckets,
+              "exact buckets up to the first octave");
+
+// Appends to `buffer`, counting what did not fit so that it can be told.
+class Writer {
+ public:
+  Writer(uint8_t* buffer, size_t capacity)
+      : buffer_(buffer), capacity_(capacity) {}
+
+  void Bytes(const void* data, size_t len) {
+    if (size_ + len <= capacity_) {
+      memcpy(buffer_ + size_, data, len);
+    }
+    size_ += len;
+  }
+
+  void U8(uint8_t value) { Bytes(&value, 1); }
+
+  void U32(uint32_t value) {
+    const uint8_t bytes[4] = {
+        static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+        static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)};
+    Bytes(bytes, sizeof(bytes));
+  }
+
+  // Text from MicroSnprintf, which is cut to the room left in `line`.
+  void Line(const char* line) { Bytes(line, strlen(line)); }
+
+  // Size written, 0 if it did not fit.
+  size_t Finish(size_t reserve) const {
+    return size_ + reserve <= capacity_ ? size_ : 0;
+  }
+
+ private:
+  uint8_t* buffer_;
+  size_t capacity_;
+  size_t size_ = 0;
+};
+
+const char* TagOf(const MicroNodeStats& stats) {
+  return stats.tag != nullptr ? stats.tag : "";
+}
+
+}  // namespace
+
+MicroStatsProfiler::MicroStatsProfiler(MicroNodeStats* nodes, int max_nodes)
+    : nodes_(nodes), max_nodes_(max_nodes) {
+  Reset();
+}
+
+void MicroStatsProfiler::Reset() {
+  memset(nodes_, 0, sizeof(MicroNodeStats) * max_nodes_);
+  num_nodes_ = 0;
+  dropped_events_ = 0;
+}
+
+uint32_t MicroStatsProfiler::BeginEvent(const char* tag) {
+  return kIgnoredEvent;
+}
+
+uint32_t MicroStatsProfiler::BeginNodeEvent(const char* tag,
+                                            int subgraph_index,
+                                            int node_index) {
+  if (subgraph_index != 0) {
+    return kIgnoredEvent;
+  }
+  if (node_index < 0 || node_index >= max_nodes_) {
+    dropped_events_++;
+    return kIgnoredEvent;
+  }
+  nodes_[node_index].tag = tag;
+  nodes_[node_index].start_ticks = GetCurrentTimeTicks();
+  return static_cast<uint32_t>(node_index);
+}
+
+void MicroStatsProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle == kIgnoredEvent) {
+    return;
+  }
+  const int node_index = static_cast<int>(event_handle);
+  MicroNodeStats& stats = nodes_[node_index];
+  AddSample(node_index, stats.tag, GetCurrentTimeTicks() - stats.start_ticks);
+}
+
+void MicroStatsProfiler::AddSample(int node_index, const char* tag,
+                                   uint32_t ticks) {
+  if (node_index < 0 || node_index >= max_nodes_) {
+    dropped_events_++;
+    return;
+  }
+  MicroNodeStats& stats = nodes_[node_index];
+  stats.tag = tag;
+  if (stats.count == 0 || ticks < stats.min_ticks) {
+    stats.min_ticks = ticks;
+  }
+  if (ticks > stats.max_ticks) {
+    stats.max_ticks = ticks;
+  }
+  stats.count++;
+  stats.total_ticks += ticks;
+  stats.histogram[BucketOf(ticks)]++;
+  if (node_index >= num_nodes_) {
+    num_nodes_ = node_index + 1;
+  }
+}
+
+int MicroStatsProfiler::BucketOf(uint32_t ticks) {
+  if (ticks < static_cast<uint32_t>(kMicroStatsExactBuckets)) {
+    return static_cast<int>(ticks);
+  }
+  const int octave = 31 - __builtin_clz(ticks);
+  const int sub_bucket =
+      (ticks >> (octave - kSubBucketBits)) & (kMicroStatsBucketsPerOctave - 1);
+  const int bucket = kMicroStatsExactBuckets +
+                     (octave - kFirstOctave) * kMicroStatsBucketsPerOctave +
+                     sub_bucket;
+  return bucket < kMicroStatsBuckets ? bucket : kMicroStatsBuckets - 1;
+}
+
+uint32_t MicroStatsProfiler::BucketStart(int bucket) {
+  if (bucket < kMicroStatsExactBuckets) {
+    return static_cast<uint32_t>(bucket);
+  }
+  const int octave =
+      (bucket - kMicroStatsExactBuckets) / kMicroStatsBucketsPerOctave +
+      kFirstOctave;
+  const uint32_t sub_bucket =
+      (bucket - kMicroStatsExactBuckets) % kMicroStatsBucketsPerOctave;
+  return (kMicroStatsBucketsPerOctave + sub_bucket)
+         << (octave - kSubBucketBits);
+}
+
+uint32_t MicroStatsProfiler::MeanTicks(int node_index) const {
+  const MicroNodeStats& stats = nodes_[node_index];
+  if (stats.count == 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>((stats.total_ticks + stats.count / 2) /
+                               stats.count);
+}
+
+uint32_t MicroStatsProfiler::PercentileTicks(int node_index,
+                                             int permille) const {
+  const MicroNodeStats& stats = nodes_[node_index];
+  if (stats.count == 0) {
+    return 0;
+  }
+  // Invocations at or under the percentile, at least one.
+  uint64_t rank = (static_cast<uint64_t>(stats.count) * permille + 999) / 1000;
+  if (rank == 0) {
+    rank = 1;
+  }
+  if (rank >= stats.count) {
+    return stats.max_ticks;
+  }
+  uint64_t seen = 0;
+  int bucket = 0;
+  for (; bucket < kMicroStatsBuckets - 1; bucket++) {
+    seen += stats.histogram[bucket];
+    if (seen >= rank) {
+      break;
+    }
+  }
+  // The middle of the bucket, within what was seen.
+  uint32_t ticks = BucketStart(bucket);
+  if (bucket >= kMicroStatsExactBuckets && bucket < kMicroStatsBuckets - 1) {
+    ticks += (BucketStart(bucket + 1) - ticks) / 2;
+  }
+  if (ticks < stats.min_ticks) {
+    ticks = stats.min_ticks;
+  }
+  if (ticks > stats.max_ticks) {
+    ticks = stats.max_ticks;
+  }
+  return ticks;
+}
+
+size_t MicroStatsProfiler::WriteJson(char* buffer, size_t capacity) const {
+  Writer writer(reinterpret_cast<uint8_t*>(buffer), capacity);
+  char line[160];
+
+  MicroSnprintf(line, sizeof(line),
+                "{\"ticks_per_second\":%u,\"dropped\":%u,\"nodes\":[",
+                ticks_per_second(), dropped_events_);
+  writer.Line(line);
+  bool first = true;
+  for (int i = 0; i < num_nodes_; i++) {
+    const MicroNodeStats& stats = nodes_[i];
+    if (stats.count == 0) {
+      continue;
+    }
+    MicroSnprintf(line, sizeof(line),
+                  "%s{\"node\":%d,\"op\":\"%s\",\"count\":%u,\"min\":%u,"
+                  "\"max\":%u,\"mean\":%u,\"p50\":%u,\"p99\":%u}",
+                  first ? "" : ",", i, TagOf(stats), stats.count,
+                  stats.min_ticks, stats.max_ticks, MeanTicks(i),
+                  PercentileTicks(i, 500), PercentileTicks(i, 990));
+    writer.Line(line);
+    first = false;
+  }
+  writer.Line("]}");
+
+  // Room for the '\0'.
+  const size_t size = writer.Finish(1);
+  if (size > 0) {
+    buffer[size] = '\0';
+  }
+  return size;
+}
+
+size_t MicroStatsProfiler::WriteBinary(uint8_t* buffer,
+                                       size_t capacity) const {
+  Writer writer(buffer, capacity);
+  int nodes = 0;
+  for (int i = 0; i < num_nodes_; i++) {
+    nodes += nodes_[i].count > 0;
+  }
+
+  writer.Bytes("TFPS", 4);
+  writer.U8(kBinaryVersion);
+  writer.U8(static_cast<uint8_t>(nodes < 255 ? nodes : 255));
+  writer.U32(ticks_per_second());
+  writer.U32(dropped_events_);
+  for (int i = 0, written = 0; i < num_nodes_ && written < 255; i++) {
+    const MicroNodeStats& stats = nodes_[i];
+    if (stats.count == 0) {
+      continue;
+    }
+    const char* tag = TagOf(stats);
+    const size_t tag_len = strlen(tag) < 255 ? strlen(tag) : 255;
+    writer.U8(static_cast<uint8_t>(tag_len));
+    writer.Bytes(tag, tag_len);
+    writer.U32(stats.count);
+    writer.U32(stats.min_ticks);
+    writer.U32(stats.max_ticks);
+    writer.U32(MeanTicks(i));
+    writer.U32(PercentileTicks(i, 500));
+    writer.U32(PercentileTicks(i, 990));
+    written++;
+  }
+  return writer.Finish(0);
+}
+
+void MicroStatsProfiler::Log() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  MicroPrintf("node op count min max mean p50 p99 (ticks, %u per second)",
+              ticks_per_second());
+  for (int i = 0; i < num_nodes_; i++) {
+    const MicroNodeStats& stats = nodes_[i];
+    if (stats.count == 0) {
+      continue;
+    }
+    MicroPrintf("%d %s %u %u %u %u %u %u", i, TagOf(stats), stats.count,
+                stats.min_ticks, stats.max_ticks, MeanTicks(i),
+                PercentileTicks(i, 500), PercentileTicks(i, 990));
+  }
+  if (dropped_events_ > 0) {
+    MicroPrintf("%u events of nodes past the first %d dropped",
+                dropped_events_, max_nodes_);
+  }
+#endif
+}
+
+}  // namespace tflite
@@ -0,0 +1,122 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_STATS_PROFILER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_STATS_PROFILER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+namespace tflite {
+
+// Durations below this many ticks have a bucket each in the histograms, the
+// longer ones 4 buckets per power of two, up to 2^21 ticks (2 s at the 1 MHz
+// of the ESP32 timer). Longer ones all go to the last bucket.
+constexpr int kMicroStatsExactBuckets = 8;
+constexpr int kMicroStatsBucketsPerOctave = 4;
+constexpr int kMicroStatsBuckets = 80;
+
+// Statistics of the invocations of one node.
+struct MicroNodeStats {
+  const char* tag;
+  uint32_t count;
+  uint32_t min_ticks;
+  uint32_t max_ticks;
+  uint64_t total_ticks;
+  uint32_t start_ticks;
+  uint32_t histogram[kMicroStatsBuckets];
+};
+
+// Keeps running statistics of every node of the main subgraph: invocations,
+// min, max and mean ticks, and a histogram to estimate percentiles from. It
+// takes the same memory after millions of invocations as after the first one,
+// in an array of MicroNodeStats given by the caller, one per node.
+//
+// Events other than the invocations of the nodes of subgraph 0 are ignored.
+// The nodes of other subgraphs run inside the IF or WHILE node that calls
+// them, which gets their time.
+class MicroStatsProfiler : public MicroProfilerInterface {
+ public:
+  // `nodes` must outlive the profiler. Nodes from `max_nodes` on are not
+  // counted, see dropped_events().
+  MicroStatsProfiler(MicroNodeStats* nodes, int max_nodes);
+  virtual ~MicroStatsProfiler() = default;
+
+  virtual uint32_t BeginEvent(const char* tag) override;
+  virtual uint32_t BeginNodeEvent(const char* tag, int subgraph_index,
+                                  int node_index) override;
+  virtual void EndEvent(uint32_t event_handle) override;
+
+  // Adds an invocation of `ticks` to a node, as EndEvent does.
+  void AddSample(int node_index, const char* tag, uint32_t ticks);
+
+  // Forgets all the invocations.
+  void Reset();
+
+  // Nodes seen so far, the highest index plus one.
+  int num_nodes() const { return num_nodes_; }
+  const MicroNodeStats& node(int node_index) const {
+    return nodes_[node_index];
+  }
+  uint32_t dropped_events() const { return dropped_events_; }
+
+  // Mean ticks of a node, 0 if it was never invoked.
+  uint32_t MeanTicks(int node_index) const;
+
+  // Estimated ticks under which `permille` thousandths of the invocations of
+  // a node took, 500 for the median. Exact below kMicroStatsExactBuckets,
+  // within 1/8 of the value above, and never outside [min, max].
+  uint32_t PercentileTicks(int node_index, int permille) const;
+
+  // Writes the statistics as JSON:
+  //   {"ticks_per_second":1000000,"dropped":0,"nodes":[
+  //     {"node":0,"op":"CONV_2D","count":10,"min":..,"max":..,"mean":..,
+  //      "p50":..,"p99":..},...]}
+  // Returns its length without the terminating '\0', or 0 if it does not fit
+  // in `capacity` bytes.
+  size_t WriteJson(char* buffer, size_t capacity) const;
+
+  // Writes the same as a compact little endian record:
+  //   "TFPS", version (u8), nodes (u8), ticks per second (u32), dropped (u32)
+  //   and per node: op name length (u8), op name, count, min, max, mean, p50
+  //   and p99 (u32 each).
+  // Returns its size, or 0 if it does not fit in `capacity` bytes.
+  size_t WriteBinary(uint8_t* buffer, size_t capacity) const;
+
+  // Prints the statistics in a human readable table.
+  void Log() const;
+
+  static constexpr uint8_t kBinaryVersion = 1;
+
+  // Bucket of a duration, and the smallest duration of a bucket.
+  static int BucketOf(uint32_t ticks);
+  static uint32_t BucketStart(int bucket);
+
+ private:
+  static constexpr uint32_t kIgnoredEvent = UINT32_MAX;
+
+  MicroNodeStats* nodes_;
+  int max_nodes_;
+  int num_nodes_ = 0;
+  uint32_t dropped_events_ = 0;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_STATS_PROFILER_H_
@@ -26,13 +26,26 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/micro_time.h"
 
-#if defined(TF_LITE_USE_CTIME)
+#if defined(TF_LITE_USE_ESP_TIMER)
+#include <esp_timer.h>
+#elif defined(TF_LITE_USE_CTIME)
 #include <ctime>
 #endif
 
 namespace tflite {
 
-#if !defined(TF_LITE_USE_CTIME)
+#if defined(TF_LITE_USE_ESP_TIMER)
+
+// Microseconds of the ESP-IDF high resolution timer, which the host build has
+// a monotonic shim of. The 32 bit ticks wrap after an hour and 11 minutes,
+// which the differences of the profilers handle.
+uint32_t ticks_per_second() { return 1000000; }
+
+uint32_t GetCurrentTimeTicks() {
+  return static_cast<uint32_t>(esp_timer_get_time());
+}
+
+#elif !defined(TF_LITE_USE_CTIME)
 
 // Reference implementation of the ticks_per_second() function that's required
 // for a platform to support Tensorflow Lite for Microcontrollers profiling.
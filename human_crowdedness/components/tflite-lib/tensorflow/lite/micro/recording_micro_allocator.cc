@@ -16,11 +16,13 @@ limitations under the License.
 #include "tensorflow/lite/micro/recording_micro_allocator.h"
 
 #include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/arena_allocator/recording_persistent_arena_buffer_allocator.h"
 #include "tensorflow/lite/micro/arena_allocator/recording_single_arena_buffer_allocator.h"
 #include "tensorflow/lite/micro/compatibility.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -42,6 +44,15 @@ RecordingMicroAllocator::RecordingMicroAllocator(
     : MicroAllocator(recording_memory_allocator, memory_planner),
       recording_memory_allocator_(recording_memory_allocator) {}
 
+RecordingMicroAllocator::RecordingMicroAllocator(
+    RecordingPersistentArenaBufferAllocator* persistent_allocator,
+    RecordingSingleArenaBufferAllocator* memory_allocator,
+    MicroMemoryPlanner* memory_planner)
+    : MicroAllocator(persistent_allocator, memory_allocator, memory_allocator,
+                     memory_planner),
+      recording_memory_allocator_(memory_allocator),
+      recording_persistent_allocator_(persistent_allocator) {}
+
 RecordingMicroAllocator* RecordingMicroAllocator::Create(uint8_t* tensor_arena,
                                                          size_t arena_size) {
   RecordingSingleArenaBufferAllocator* simple_memory_allocator =
@@ -61,6 +72,68 @@ RecordingMicroAllocator* RecordingMicroAllocator::Create(uint8_t* tensor_arena,
   return allocator;
 }
 
+RecordingMicroAllocator* RecordingMicroAllocator::Create(
+    uint8_t* tensor_arena, size_t arena_size,
+    MicroMemoryPlanner* memory_planner) {
+  uint8_t* aligned_arena =
+      AlignPointerUp(tensor_arena, MicroArenaBufferAlignment());
+  size_t aligned_arena_size = tensor_arena + arena_size - aligned_arena;
+  RecordingSingleArenaBufferAllocator* simple_memory_allocator =
+      RecordingSingleArenaBufferAllocator::Create(aligned_arena,
+                                                  aligned_arena_size);
+  TFLITE_DCHECK(simple_memory_allocator != nullptr);
+
+  uint8_t* allocator_buffer = simple_memory_allocator->AllocatePersistentBuffer(
+      sizeof(RecordingMicroAllocator), alignof(RecordingMicroAllocator));
+  RecordingMicroAllocator* allocator = new (allocator_buffer)
+      RecordingMicroAllocator(simple_memory_allocator, memory_planner);
+  return allocator;
+}
+
+RecordingMicroAllocator* RecordingMicroAllocator::Create(
+    uint8_t* persistent_tensor_arena, size_t persistent_arena_size,
+    uint8_t* non_persistent_tensor_arena, size_t non_persistent_arena_size,
+    MicroMemoryPlanner* memory_planner) {
+  TFLITE_DCHECK(non_persistent_tensor_arena != nullptr);
+  TFLITE_DCHECK(persistent_tensor_arena != non_persistent_tensor_arena);
+  TFLITE_DCHECK(memory_planner != nullptr);
+
+  RecordingPersistentArenaBufferAllocator* persistent_allocator =
+      RecordingPersistentArenaBufferAllocator::Create(persistent_tensor_arena,
+                                                      persistent_arena_size);
+  if (persistent_allocator == nullptr) {
+    return nullptr;
+  }
+
+  // As in MicroAllocator::Create(), the allocator of the non persistent arena
+  // keeps its state in the persistent arena.
+  uint8_t* memory_allocator_buffer =
+      persistent_allocator->AllocatePersistentBuffer(
+          sizeof(RecordingSingleArenaBufferAllocator),
+          alignof(RecordingSingleArenaBufferAllocator));
+  uint8_t* allocator_buffer = persistent_allocator->AllocatePersistentBuffer(
+      sizeof(RecordingMicroAllocator), alignof(RecordingMicroAllocator));
+  if (memory_allocator_buffer == nullptr || allocator_buffer == nullptr) {
+    return nullptr;
+  }
+  uint8_t* aligned_arena =
+      AlignPointerUp(non_persistent_tensor_arena, MicroArenaBufferAlignment());
+  uint8_t* aligned_arena_tail =
+      AlignPointerDown(non_persistent_tensor_arena + non_persistent_arena_size,
+                       MicroArenaBufferAlignment());
+  if (aligned_arena_tail <= aligned_arena) {
+    return nullptr;
+  }
+  RecordingSingleArenaBufferAllocator* memory_allocator =
+      new (memory_allocator_buffer) RecordingSingleArenaBufferAllocator(
+          aligned_arena, aligned_arena_tail - aligned_arena);
+
+  RecordingMicroAllocator* allocator = new (allocator_buffer)
+      RecordingMicroAllocator(persistent_allocator, memory_allocator,
+                              memory_planner);
+  return allocator;
+}
+
 RecordedAllocation RecordingMicroAllocator::GetRecordedAllocation(
     RecordedAllocationType allocation_type) const {
   switch (allocation_type) {
@@ -83,6 +156,33 @@ RecordedAllocation RecordingMicroAllocator::GetRecordedAllocation(
   return RecordedAllocation();
 }
 
+RecordedAllocation
+RecordingMicroAllocator::GetRecordedPersistentArenaAllocation(
+    RecordedAllocationType allocation_type) const {
+  return recorded_persistent_arena_data_[static_cast<int>(allocation_type)];
+}
+
+RecordedAllocation* RecordingMicroAllocator::MutableRecordedAllocation(
+    RecordedAllocationType allocation_type) {
+  switch (allocation_type) {
+    case RecordedAllocationType::kTfLiteEvalTensorData:
+      return &recorded_tflite_eval_tensor_data_;
+    case RecordedAllocationType::kPersistentTfLiteTensorData:
+      return &recorded_persistent_tflite_tensor_data_;
+    case RecordedAllocationType::kPersistentTfLiteTensorQuantizationData:
+      return &recorded_persistent_tflite_tensor_quantization_data_;
+    case RecordedAllocationType::kPersistentBufferData:
+      return &recorded_persistent_buffer_data_;
+    case RecordedAllocationType::kTfLiteTensorVariableBufferData:
+      return &recorded_tflite_tensor_variable_buffer_data_;
+    case RecordedAllocationType::kNodeAndRegistrationArray:
+      return &recorded_node_and_registration_array_data_;
+    case RecordedAllocationType::kOpData:
+      return &recorded_op_data_;
+  }
+  return &recorded_op_data_;
+}
+
 const RecordingSingleArenaBufferAllocator*
 RecordingMicroAllocator::GetSimpleMemoryAllocator() const {
   return recording_memory_allocator_;
@@ -90,11 +190,11 @@ RecordingMicroAllocator::GetSimpleMemoryAllocator() const {
 
 void RecordingMicroAllocator::PrintAllocations() const {
   MicroPrintf("[RecordingMicroAllocator] Arena allocation total %d bytes",
-              recording_memory_allocator_->GetUsedBytes());
+              used_bytes());
   MicroPrintf("[RecordingMicroAllocator] Arena allocation head %d bytes",
-              recording_memory_allocator_->GetNonPersistentUsedBytes());
+              non_persistent_used_bytes());
   MicroPrintf("[RecordingMicroAllocator] Arena allocation tail %d bytes",
-              recording_memory_allocator_->GetPersistentUsedBytes());
+              persistent_used_bytes());
   PrintRecordedAllocation(RecordedAllocationType::kTfLiteEvalTensorData,
                           "TfLiteEvalTensor data", "allocations");
   PrintRecordedAllocation(RecordedAllocationType::kPersistentTfLiteTensorData,
@@ -115,9 +215,10 @@ void RecordingMicroAllocator::PrintAllocations() const {
 }
 
 void* RecordingMicroAllocator::AllocatePersistentBuffer(size_t bytes) {
-  RecordedAllocation allocations = SnapshotAllocationUsage();
+  AllocationSnapshot allocations = SnapshotAllocationUsage();
   void* buffer = MicroAllocator::AllocatePersistentBuffer(bytes);
-  RecordAllocationUsage(allocations, recorded_persistent_buffer_data_);
+  RecordAllocationUsage(allocations,
+                        RecordedAllocationType::kPersistentBufferData);
 
   return buffer;
 }
@@ -139,13 +240,13 @@ void RecordingMicroAllocator::PrintRecordedAllocation(
 
 TfLiteStatus RecordingMicroAllocator::AllocateNodeAndRegistrations(
     const Model* model, SubgraphAllocations* subgraph_allocations) {
-  RecordedAllocation allocations = SnapshotAllocationUsage();
+  AllocationSnapshot allocations = SnapshotAllocationUsage();
 
   TfLiteStatus status =
       MicroAllocator::AllocateNodeAndRegistrations(model, subgraph_allocations);
 
   RecordAllocationUsage(allocations,
-                        recorded_node_and_registration_array_data_);
+                        RecordedAllocationType::kNodeAndRegistrationArray);
 
   for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
        subgraph_idx++) {
@@ -170,12 +271,13 @@ TfLiteStatus RecordingMicroAllocator::AllocateNodeAndRegistrations(
 
 TfLiteStatus RecordingMicroAllocator::AllocateTfLiteEvalTensors(
     const Model* model, SubgraphAllocations* subgraph_allocations) {
-  RecordedAllocation allocations = SnapshotAllocationUsage();
+  AllocationSnapshot allocations = SnapshotAllocationUsage();
 
   TfLiteStatus status =
       MicroAllocator::AllocateTfLiteEvalTensors(model, subgraph_allocations);
 
-  RecordAllocationUsage(allocations, recorded_tflite_eval_tensor_data_);
+  RecordAllocationUsage(allocations,
+                        RecordedAllocationType::kTfLiteEvalTensorData);
 
   for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
        subgraph_idx++) {
@@ -194,58 +296,85 @@ TfLiteStatus RecordingMicroAllocator::AllocateTfLiteEvalTensors(
 TfLiteStatus RecordingMicroAllocator::AllocateVariables(
     const SubGraph* subgraph, TfLiteEvalTensor* eval_tensors,
     const int32_t* offline_planner_offsets) {
-  RecordedAllocation allocations = SnapshotAllocationUsage();
+  AllocationSnapshot allocations = SnapshotAllocationUsage();
 
   TfLiteStatus status = MicroAllocator::AllocateVariables(
       subgraph, eval_tensors, offline_planner_offsets);
 
-  RecordAllocationUsage(allocations,
-                        recorded_tflite_tensor_variable_buffer_data_);
+  RecordAllocationUsage(
+      allocations, RecordedAllocationType::kTfLiteTensorVariableBufferData);
   return status;
 }
 
 TfLiteTensor*
 RecordingMicroAllocator::AllocatePersistentTfLiteTensorInternal() {
-  RecordedAllocation allocations = SnapshotAllocationUsage();
+  AllocationSnapshot allocations = SnapshotAllocationUsage();
 
   TfLiteTensor* result =
       MicroAllocator::AllocatePersistentTfLiteTensorInternal();
 
-  RecordAllocationUsage(allocations, recorded_persistent_tflite_tensor_data_);
+  RecordAllocationUsage(allocations,
+                        RecordedAllocationType::kPersistentTfLiteTensorData);
   return result;
 }
 
 TfLiteStatus RecordingMicroAllocator::PopulateTfLiteTensorFromFlatbuffer(
     const Model* model, TfLiteTensor* tensor, int tensor_index,
     int subgraph_index, bool allocate_temp) {
-  RecordedAllocation allocations = SnapshotAllocationUsage();
+  AllocationSnapshot allocations = SnapshotAllocationUsage();
 
   TfLiteStatus status = MicroAllocator::PopulateTfLiteTensorFromFlatbuffer(
       model, tensor, tensor_index, subgraph_index, allocate_temp);
 
-  RecordAllocationUsage(allocations,
-                        recorded_persistent_tflite_tensor_quantization_data_);
+  RecordAllocationUsage(
+      allocations,
+      RecordedAllocationType::kPersistentTfLiteTensorQuantizationData);
   return status;
 }
 
-RecordedAllocation RecordingMicroAllocator::SnapshotAllocationUsage() const {
-  return {/*requested_bytes=*/recording_memory_allocator_->GetRequestedBytes(),
-          /*used_bytes=*/recording_memory_allocator_->GetUsedBytes(),
-          /*count=*/recording_memory_allocator_->GetAllocatedCount()};
+RecordingMicroAllocator::AllocationSnapshot
+RecordingMicroAllocator::SnapshotAllocationUsage() const {
+  AllocationSnapshot snapshot = {
+      {/*requested_bytes=*/recording_memory_allocator_->GetRequestedBytes(),
+       /*used_bytes=*/recording_memory_allocator_->GetUsedBytes(),
+       /*count=*/recording_memory_allocator_->GetAllocatedCount()},
+      {}};
+  if (recording_persistent_allocator_ != nullptr) {
+    snapshot.persistent_arena = {
+        /*requested_bytes=*/recording_persistent_allocator_
+            ->GetRequestedBytes(),
+        /*used_bytes=*/recording_persistent_allocator_->GetUsedBytes(),
+        /*count=*/recording_persistent_allocator_->GetAllocatedCount()};
+    snapshot.all.requested_bytes += snapshot.persistent_arena.requested_bytes;
+    snapshot.all.used_bytes += snapshot.persistent_arena.used_bytes;
+    snapshot.all.count += snapshot.persistent_arena.count;
+  }
+  return snapshot;
 }
 
 void RecordingMicroAllocator::RecordAllocationUsage(
-    const RecordedAllocation& snapshotted_allocation,
-    RecordedAllocation& recorded_allocation) {
+    const AllocationSnapshot& snapshotted_allocation,
+    RecordedAllocationType allocation_type) {
+  const AllocationSnapshot current = SnapshotAllocationUsage();
+  RecordedAllocation& recorded_allocation =
+      *MutableRecordedAllocation(allocation_type);
   recorded_allocation.requested_bytes +=
-      recording_memory_allocator_->GetRequestedBytes() -
-      snapshotted_allocation.requested_bytes;
+      current.all.requested_bytes - snapshotted_allocation.all.requested_bytes;
   recorded_allocation.used_bytes +=
-      recording_memory_allocator_->GetUsedBytes() -
-      snapshotted_allocation.used_bytes;
+      current.all.used_bytes - snapshotted_allocation.all.used_bytes;
   recorded_allocation.count +=
-      recording_memory_allocator_->GetAllocatedCount() -
-      snapshotted_allocation.count;
+      current.all.count - snapshotted_allocation.all.count;
+
+  RecordedAllocation& persistent_arena =
+      recorded_persistent_arena_data_[static_cast<int>(allocation_type)];
+  persistent_arena.requested_bytes +=
+      current.persistent_arena.requested_bytes -
+      snapshotted_allocation.persistent_arena.requested_bytes;
+  persistent_arena.used_bytes +=
+      current.persistent_arena.used_bytes -
+      snapshotted_allocation.persistent_arena.used_bytes;
+  persistent_arena.count += current.persistent_arena.count -
+                            snapshotted_allocation.persistent_arena.count;
 }
 
 }  // namespace tflite
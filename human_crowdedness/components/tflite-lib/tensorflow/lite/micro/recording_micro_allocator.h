@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_MICRO_RECORDING_MICRO_ALLOCATOR_H_
 #define TENSORFLOW_LITE_MICRO_RECORDING_MICRO_ALLOCATOR_H_
 
+#include "tensorflow/lite/micro/arena_allocator/recording_persistent_arena_buffer_allocator.h"
 #include "tensorflow/lite/micro/arena_allocator/recording_single_arena_buffer_allocator.h"
 #include "tensorflow/lite/micro/compatibility.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
@@ -49,14 +50,32 @@ struct RecordedAllocation {
 // inside the arena. A summary of allocations can be logged through the
 // ErrorReporter by invoking LogAllocations(). This special allocator requires
 // an instance of RecordingSingleArenaBufferAllocator to capture allocations in
-// the head and tail. Arena allocation recording can be retrieved by type
-// through the GetRecordedAllocation() function. This class should only be used
-// for auditing memory usage or integration testing.
+// the head and tail, and, with two arenas, a
+// RecordingPersistentArenaBufferAllocator to capture the ones in the persistent
+// arena. Arena allocation recording can be retrieved by type through the
+// GetRecordedAllocation() function. This class should only be used for
+// auditing memory usage or integration testing.
 class RecordingMicroAllocator : public MicroAllocator {
  public:
   static RecordingMicroAllocator* Create(uint8_t* tensor_arena,
                                          size_t arena_size);
 
+  // Same as above, but with a memory planner that the caller owns, and with
+  // the arena aligned first, as in MicroAllocator::Create().
+  static RecordingMicroAllocator* Create(uint8_t* tensor_arena,
+                                         size_t arena_size,
+                                         MicroMemoryPlanner* memory_planner);
+
+  // Same as above, with a persistent and a non persistent arena as in
+  // MicroAllocator::Create(). The recorded types are persistent, but the
+  // persistent buffers and variable tensors are in the tail of the non
+  // persistent arena, see GetRecordedPersistentArenaAllocation().
+  static RecordingMicroAllocator* Create(uint8_t* persistent_tensor_arena,
+                                         size_t persistent_arena_size,
+                                         uint8_t* non_persistent_tensor_arena,
+                                         size_t non_persistent_arena_size,
+                                         MicroMemoryPlanner* memory_planner);
+
   // Returns the fixed amount of memory overhead of RecordingMicroAllocator.
   static size_t GetDefaultTailUsage();
 
@@ -64,6 +83,13 @@ class RecordingMicroAllocator : public MicroAllocator {
   RecordedAllocation GetRecordedAllocation(
       RecordedAllocationType allocation_type) const;
 
+  // With two arenas, the part of GetRecordedAllocation() in the persistent
+  // arena, the rest being in the tail of the non persistent one. All zero with
+  // a single arena.
+  RecordedAllocation GetRecordedPersistentArenaAllocation(
+      RecordedAllocationType allocation_type) const;
+
+  // With two arenas, the allocator of the non persistent one.
   const RecordingSingleArenaBufferAllocator* GetSimpleMemoryAllocator() const;
 
   // Logs out through the ErrorReporter all allocation recordings by type
@@ -96,16 +122,32 @@ class RecordingMicroAllocator : public MicroAllocator {
  private:
   RecordingMicroAllocator(RecordingSingleArenaBufferAllocator* memory_allocator,
                           MicroMemoryPlanner* memory_planner);
+  RecordingMicroAllocator(
+      RecordingPersistentArenaBufferAllocator* persistent_allocator,
+      RecordingSingleArenaBufferAllocator* memory_allocator,
+      MicroMemoryPlanner* memory_planner);
 
   void PrintRecordedAllocation(RecordedAllocationType allocation_type,
                                const char* allocation_name,
                                const char* allocation_description) const;
 
-  RecordedAllocation SnapshotAllocationUsage() const;
-  void RecordAllocationUsage(const RecordedAllocation& snapshotted_allocation,
-                             RecordedAllocation& recorded_allocation);
+  // The usage of all the arenas, and of the persistent one alone.
+  struct AllocationSnapshot {
+    RecordedAllocation all;
+    RecordedAllocation persistent_arena;
+  };
+
+  AllocationSnapshot SnapshotAllocationUsage() const;
+  void RecordAllocationUsage(const AllocationSnapshot& snapshotted_allocation,
+                             RecordedAllocationType allocation_type);
+  RecordedAllocation* MutableRecordedAllocation(
+      RecordedAllocationType allocation_type);
 
-  const RecordingSingleArenaBufferAllocator* recording_memory_allocator_;
+  const RecordingSingleArenaBufferAllocator* recording_memory_allocator_ =
+      nullptr;
+  // Only set with two arenas.
+  const RecordingPersistentArenaBufferAllocator*
+      recording_persistent_allocator_ = nullptr;
 
   RecordedAllocation recorded_tflite_eval_tensor_data_ = {};
   RecordedAllocation recorded_persistent_tflite_tensor_data_ = {};
@@ -117,6 +159,10 @@ class RecordingMicroAllocator : public MicroAllocator {
   // TODO(b/187993291): Re-enable OpData allocating tracking.
   RecordedAllocation recorded_op_data_ = {};
 
+  // The part of the above in the persistent arena, by RecordedAllocationType.
+  RecordedAllocation recorded_persistent_arena_data_
+      [static_cast<int>(RecordedAllocationType::kOpData) + 1] = {};
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
@@ -0,0 +1,199 @@
+/**
+ * @file bench_deferred_log.cc
+ * @brief Compares the frame time jitter of printing with iostream and with
+ * the deferred log.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Usage: bench_deferred_log [-n frames] [-w work us] [-b baud]
+ *
+ * Every frame does a fixed amount of work and logs its score. The console is
+ * simulated as a UART that blocks the writer for as long as the bytes take to
+ * go out, which is what the board does at 115200 bauds. The first run formats
+ * with iostream and flushes with std::endl in the frame, as the main loop used
+ * to. The second one logs to the deferred log, which another thread drains.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "deferred_log.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_us(bench_clock::time_point start) {
+
+  return std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+
+}
+
+/**
+ * @brief Console that blocks for as long as a UART takes to send the bytes.
+ */
+class UartConsole : public LogWriter {
+
+ public:
+
+  explicit UartConsole(long baud) : us_per_byte_(10e6 / baud) {}
+
+  void write(const char*, size_t len) override {
+    std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(us_per_byte_ * len));
+    bytes += len;
+  }
+
+  size_t bytes = 0;
+
+ private:
+
+  double us_per_byte_;
+
+};
+
+/**
+ * @brief Stream buffer that sends everything to the console when flushed.
+ */
+class UartStreamBuf : public std::stringbuf {
+
+ public:
+
+  explicit UartStreamBuf(UartConsole* console) : console_(console) {}
+
+ protected:
+
+  int sync() override {
+    std::string pending = str();
+    console_->write(pending.data(), pending.size());
+    str("");
+    return 0;
+  }
+
+ private:
+
+  UartConsole* console_;
+
+};
+
+// Work of a frame that the compiler cannot remove.
+static volatile float sink;
+
+static void frame_work(double us) {
+
+  auto start = bench_clock::now();
+  float acc = 0;
+  while (elapsed_us(start) < us) {
+    for (int i = 0; i < 100; i++) {
+      acc += sqrtf((float) i);
+    }
+  }
+  sink = acc;
+
+}
+
+/**
+ * @brief Print the spread of the frame times.
+ */
+static void report(const char* name, std::vector<double> frame_us) {
+
+  double sum = 0;
+  double sum_sq = 0;
+  for (double us : frame_us) {
+    sum += us;
+    sum_sq += us * us;
+  }
+  double mean = sum / frame_us.size();
+  double stddev = sqrt(std::max(0.0, sum_sq / frame_us.size() - mean * mean));
+
+  std::sort(frame_us.begin(), frame_us.end());
+  printf("%-10s mean %8.1f us  p50 %8.1f us  p99 %8.1f us  max %8.1f us  stddev %7.1f us\n", name, mean,
+         frame_us[frame_us.size() / 2], frame_us[frame_us.size() * 99 / 100], frame_us.back(), stddev);
+
+}
+
+int main(int argc, char** argv) {
+
+  long frames = 300;
+  double work_us = 5000;
+  long baud = 115200;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:w:b:")) != -1) {
+    if (opt == 'n') {
+      frames = atol(optarg);
+    } else if (opt == 'w') {
+      work_us = atof(optarg);
+    } else if (opt == 'b') {
+      baud = atol(optarg);
+    } else {
+      fprintf(stderr, "Usage: %s [-n frames] [-w work us] [-b baud]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (frames <= 0 || baud <= 0) {
+    fprintf(stderr, "Nothing to do\n");
+    return 2;
+  }
+
+  std::vector<float> scores(frames);
+  srand(1);
+  for (float& score : scores) {
+    score = (float) rand() / RAND_MAX;
+  }
+
+  // The frames with iostream, flushed in the frame.
+  UartConsole iostream_console(baud);
+  UartStreamBuf buf(&iostream_console);
+  std::ostream out(&buf);
+  std::vector<double> iostream_us;
+  for (long i = 0; i < frames; i++) {
+    auto start = bench_clock::now();
+    frame_work(work_us);
+    out << "People score: " << scores[i] * 100 << std::endl;
+    iostream_us.push_back(elapsed_us(start));
+  }
+
+  // The frames with the deferred log, drained by another thread.
+  UartConsole deferred_console(baud);
+  DeferredLog<32> log;
+  std::atomic<bool> done(false);
+  std::thread drainer([&] {
+    while (!done.load()) {
+      log.drain(&deferred_console);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    log.drain(&deferred_console);
+  });
+  std::vector<double> deferred_us;
+  for (long i = 0; i < frames; i++) {
+    auto start = bench_clock::now();
+    frame_work(work_us);
+    DLOG_INFO(log, "People score: %g", scores[i] * 100);
+    deferred_us.push_back(elapsed_us(start));
+  }
+  done = true;
+  drainer.join();
+
+  printf("frames:    %ld of %.0f us, console at %ld bauds\n", frames, work_us, baud);
+  report("iostream", iostream_us);
+  report("deferred", deferred_us);
+  printf("dropped:   %u\n", log.dropped());
+
+  return 0;
+
+}
@@ -0,0 +1,759 @@
+/**
+ * @file bench_esp_nn.cc
+ * @brief Times the esp-nn kernels of every backend on the layers of the model.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Usage: bench_esp_nn [options]
+ *
+ *   -w calls      Untimed calls before the timed ones (default: 3).
+ *   -r reps       Timed repetitions, each at least 50 us long (default: 15).
+ *   -f text       Only the layers with this text in their name.
+ *   -j file       Write the results as JSON.
+ *   -c file       Write the results as CSV.
+ *   -b file       Compare the median times against a CSV of a previous run.
+ *   -t tolerance  Fail if a kernel is slower than this fraction over the
+ *                 baseline (default: 0.25).
+ *
+ * The layers are the ones of the person detection model, read from its
+ * flatbuffer, and a sweep of other shapes usual in small vision models. Every
+ * layer runs on the ANSI C, the generic optimized and, when built with them,
+ * the SIMD kernels, with random data and the quantization of the model. The
+ * outputs of all the backends must be the same as the ANSI C ones.
+ *
+ * The "macs" are multiply-accumulates for the convolutions and the fully
+ * connected layers, inputs read per window for the pooling layers and inputs
+ * for the softmax. The "bytes" are the inputs, the weights and the outputs.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include <esp_nn_ansi_headers.h>
+#if CONFIG_NN_SIMD
+#include <esp_nn_simd.h>
+#endif
+}
+
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+#include "model.h"
+
+enum class Op { conv, depthwise_conv, avg_pool, max_pool, fully_connected, softmax };
+
+enum Backend { backend_ansi, backend_opt, backend_simd, backend_count };
+
+static const char* const backend_names[backend_count] = {"ansi", "opt", "simd"};
+
+#if CONFIG_NN_SIMD
+static const int backends = backend_count;
+#else
+static const int backends = backend_simd;
+#endif
+
+// Each repetition calls the kernel enough times to last this long, so that
+// the small kernels are not only the resolution of the clock.
+constexpr double min_rep_ns = 50000;
+
+/**
+ * @brief One layer to time, in NHWC.
+ *
+ * The fully connected layers and the softmax are rows of `in_c` inputs,
+ * `in_h` of them for the softmax, and `out_c` outputs.
+ */
+struct Layer {
+  std::string name;
+  Op op;
+  int in_w, in_h, in_c;
+  int out_w, out_h, out_c;
+  int filter_w, filter_h;
+  int stride_w, stride_h;
+  int pad_w, pad_h;
+  int ch_mult;
+  int in_offset, out_offset;
+};
+
+struct Result {
+  const Layer* layer;
+  Backend backend;
+  double macs;
+  double bytes;
+  double min_ns;
+  double median_ns;
+  bool match;
+};
+
+typedef std::chrono::steady_clock bench_clock;
+
+static const char* op_name(Op op) {
+
+  switch (op) {
+    case Op::conv: return "conv";
+    case Op::depthwise_conv: return "depthwise_conv";
+    case Op::avg_pool: return "avg_pool";
+    case Op::max_pool: return "max_pool";
+    case Op::fully_connected: return "fully_connected";
+    case Op::softmax: return "softmax";
+  }
+  return "?";
+
+}
+
+static bool is_conv(Op op) {
+
+  return op == Op::conv || op == Op::depthwise_conv;
+
+}
+
+static bool is_pool(Op op) {
+
+  return op == Op::avg_pool || op == Op::max_pool;
+
+}
+
+/**
+ * @brief Shape of a layer, without commas to keep the CSV simple.
+ */
+static std::string shape_of(const Layer& l) {
+
+  char text[128];
+  if (l.op == Op::fully_connected) {
+    snprintf(text, sizeof(text), "%d->%d", l.in_c, l.out_c);
+  } else if (l.op == Op::softmax) {
+    snprintf(text, sizeof(text), "%dx%d", l.in_h, l.in_c);
+  } else {
+    snprintf(text, sizeof(text), "%dx%dx%d->%dx%dx%d k%dx%d s%dx%d p%dx%d",
+             l.in_w, l.in_h, l.in_c, l.out_w, l.out_h, l.out_c,
+             l.filter_w, l.filter_h, l.stride_w, l.stride_h, l.pad_w, l.pad_h);
+  }
+  return text;
+
+}
+
+static double macs_of(const Layer& l) {
+
+  const double outputs = (double) l.out_w * l.out_h * l.out_c;
+  switch (l.op) {
+    case Op::conv: return outputs * l.filter_w * l.filter_h * l.in_c;
+    case Op::depthwise_conv:
+    case Op::avg_pool:
+    case Op::max_pool: return outputs * l.filter_w * l.filter_h;
+    case Op::fully_connected: return (double) l.in_c * l.out_c;
+    case Op::softmax: return (double) l.in_h * l.in_c;
+  }
+  return 0;
+
+}
+
+static size_t input_size(const Layer& l) {
+
+  return (size_t) l.in_w * l.in_h * l.in_c;
+
+}
+
+static size_t output_size(const Layer& l) {
+
+  return l.op == Op::softmax ? input_size(l) : (size_t) l.out_w * l.out_h * l.out_c;
+
+}
+
+static size_t filter_size(const Layer& l) {
+
+  switch (l.op) {
+    case Op::conv: return (size_t) l.out_c * l.filter_w * l.filter_h * l.in_c;
+    case Op::depthwise_conv: return (size_t) l.out_c * l.filter_w * l.filter_h;
+    case Op::fully_connected: return (size_t) l.out_c * l.in_c;
+    default: return 0;
+  }
+
+}
+
+static double bytes_of(const Layer& l) {
+
+  const bool has_bias = is_conv(l.op) || l.op == Op::fully_connected;
+  return (double) input_size(l) + filter_size(l) + output_size(l) + (has_bias ? 4.0 * l.out_c : 0);
+
+}
+
+/**
+ * @brief Padding of TFLite for SAME, before the first row and column.
+ */
+static int same_padding(int in, int out, int stride, int filter) {
+
+  return std::max(((out - 1) * stride + filter - in) / 2, 0);
+
+}
+
+static Layer conv_layer(const char* name, Op op, int in_w, int in_h, int in_c, int out_c,
+                        int filter, int stride, bool same, int ch_mult = 1) {
+
+  Layer l = {};
+  l.name = name;
+  l.op = op;
+  l.in_w = in_w;
+  l.in_h = in_h;
+  l.in_c = in_c;
+  l.out_c = op == Op::depthwise_conv ? in_c * ch_mult : (is_pool(op) ? in_c : out_c);
+  l.filter_w = l.filter_h = filter;
+  l.stride_w = l.stride_h = stride;
+  l.out_w = same ? (in_w + stride - 1) / stride : (in_w - filter) / stride + 1;
+  l.out_h = same ? (in_h + stride - 1) / stride : (in_h - filter) / stride + 1;
+  l.pad_w = same ? same_padding(in_w, l.out_w, stride, filter) : 0;
+  l.pad_h = same ? same_padding(in_h, l.out_h, stride, filter) : 0;
+  l.ch_mult = ch_mult;
+  l.in_offset = 128;
+  l.out_offset = -128;
+  return l;
+
+}
+
+static Layer row_layer(const char* name, Op op, int rows, int in_c, int out_c) {
+
+  Layer l = {};
+  l.name = name;
+  l.op = op;
+  l.in_w = 1;
+  l.in_h = rows;
+  l.in_c = in_c;
+  l.out_w = 1;
+  l.out_h = rows;
+  l.out_c = out_c;
+  l.in_offset = 128;
+  l.out_offset = -128;
+  return l;
+
+}
+
+/**
+ * @brief Shapes that are not in the person detection model: other filter
+ * sizes, channel multipliers and the ops it does not use.
+ */
+static std::vector<Layer> sweep_layers() {
+
+  return {
+    conv_layer("sweep/conv_3x3_24x24x16", Op::conv, 24, 24, 16, 16, 3, 1, true),
+    conv_layer("sweep/conv_5x5_16x16x8", Op::conv, 16, 16, 8, 16, 5, 1, true),
+    conv_layer("sweep/conv_1x1_12x12x64", Op::conv, 12, 12, 64, 128, 1, 1, true),
+    conv_layer("sweep/conv_1x1_6x6x256", Op::conv, 6, 6, 256, 256, 1, 1, true),
+    conv_layer("sweep/depthwise_3x3_48x48x16", Op::depthwise_conv, 48, 48, 16, 0, 3, 1, true),
+    conv_layer("sweep/depthwise_3x3_s2_24x24x32", Op::depthwise_conv, 24, 24, 32, 0, 3, 2, true),
+    conv_layer("sweep/depthwise_5x5_12x12x64", Op::depthwise_conv, 12, 12, 64, 0, 5, 1, true),
+    conv_layer("sweep/depthwise_3x3_mult2_12x12x16", Op::depthwise_conv, 12, 12, 16, 0, 3, 1, true, 2),
+    conv_layer("sweep/max_pool_2x2_24x24x32", Op::max_pool, 24, 24, 32, 0, 2, 2, false),
+    conv_layer("sweep/avg_pool_3x3_12x12x64", Op::avg_pool, 12, 12, 64, 0, 3, 1, true),
+    row_layer("sweep/fully_connected_256x64", Op::fully_connected, 1, 256, 64),
+    row_layer("sweep/fully_connected_1024x10", Op::fully_connected, 1, 1024, 10),
+    row_layer("sweep/softmax_1x1001", Op::softmax, 1, 1001, 1001),
+    row_layer("sweep/softmax_16x10", Op::softmax, 16, 10, 10),
+  };
+
+}
+
+static int zero_point(const tflite::Tensor* tensor) {
+
+  const tflite::QuantizationParameters* q = tensor->quantization();
+  if (q == nullptr || q->zero_point() == nullptr || q->zero_point()->size() == 0) {
+    return 0;
+  }
+  return (int) q->zero_point()->Get(0);
+
+}
+
+static int dim(const tflite::Tensor* tensor, int i) {
+
+  return tensor->shape() != nullptr && (int) tensor->shape()->size() > i ? tensor->shape()->Get(i) : 1;
+
+}
+
+/**
+ * @brief The layers of the model that run on esp-nn, in the order they run.
+ */
+static std::vector<Layer> model_layers() {
+
+  std::vector<Layer> layers;
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+  const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+  const auto* tensors = subgraph->tensors();
+
+  for (uint32_t i = 0; i < subgraph->operators()->size(); i++) {
+    const tflite::Operator* op = subgraph->operators()->Get(i);
+    const tflite::BuiltinOperator code = tflite::GetBuiltinCode(model->operator_codes()->Get(op->opcode_index()));
+    const tflite::Tensor* input = tensors->Get(op->inputs()->Get(0));
+    const tflite::Tensor* output = tensors->Get(op->outputs()->Get(0));
+    if (input->type() != tflite::TensorType_INT8 || output->type() != tflite::TensorType_INT8) {
+      continue;
+    }
+
+    Layer l = {};
+    l.in_w = dim(input, 2);
+    l.in_h = dim(input, 1);
+    l.in_c = dim(input, 3);
+    l.out_w = dim(output, 2);
+    l.out_h = dim(output, 1);
+    l.out_c = dim(output, 3);
+    l.ch_mult = 1;
+    l.in_offset = -zero_point(input);
+    l.out_offset = zero_point(output);
+
+    tflite::Padding padding = tflite::Padding_VALID;
+    if (code == tflite::BuiltinOperator_CONV_2D) {
+      const tflite::Conv2DOptions* options = op->builtin_options_as_Conv2DOptions();
+      const tflite::Tensor* filter = tensors->Get(op->inputs()->Get(1));
+      l.op = Op::conv;
+      l.filter_w = dim(filter, 2);
+      l.filter_h = dim(filter, 1);
+      l.stride_w = options->stride_w();
+      l.stride_h = options->stride_h();
+      padding = options->padding();
+    } else if (code == tflite::BuiltinOperator_DEPTHWISE_CONV_2D) {
+      const tflite::DepthwiseConv2DOptions* options = op->builtin_options_as_DepthwiseConv2DOptions();
+      const tflite::Tensor* filter = tensors->Get(op->inputs()->Get(1));
+      l.op = Op::depthwise_conv;
+      l.filter_w = dim(filter, 2);
+      l.filter_h = dim(filter, 1);
+      l.stride_w = options->stride_w();
+      l.stride_h = options->stride_h();
+      l.ch_mult = l.out_c / l.in_c;
+      padding = options->padding();
+    } else if (code == tflite::BuiltinOperator_AVERAGE_POOL_2D ||
+               code == tflite::BuiltinOperator_MAX_POOL_2D) {
+      const tflite::Pool2DOptions* options = op->builtin_options_as_Pool2DOptions();
+      l.op = code == tflite::BuiltinOperator_AVERAGE_POOL_2D ? Op::avg_pool : Op::max_pool;
+      l.filter_w = options->filter_width();
+      l.filter_h = options->filter_height();
+      l.stride_w = options->stride_w();
+      l.stride_h = options->stride_h();
+      padding = options->padding();
+    } else if (code == tflite::BuiltinOperator_FULLY_CONNECTED) {
+      const tflite::Tensor* filter = tensors->Get(op->inputs()->Get(1));
+      l.op = Op::fully_connected;
+      l.in_c = dim(filter, 1);
+      l.in_w = l.in_h = l.out_w = l.out_h = 1;
+      l.out_c = dim(filter, 0);
+    } else if (code == tflite::BuiltinOperator_SOFTMAX) {
+      const int dims = input->shape() != nullptr ? (int) input->shape()->size() : 1;
+      int rows = 1;
+      for (int d = 0; d + 1 < dims; d++) {
+        rows *= dim(input, d);
+      }
+      l = row_layer("", Op::softmax, rows, dim(input, dims - 1), dim(input, dims - 1));
+    } else {
+      continue;
+    }
+    if (padding == tflite::Padding_SAME) {
+      l.pad_w = same_padding(l.in_w, l.out_w, l.stride_w, l.filter_w);
+      l.pad_h = same_padding(l.in_h, l.out_h, l.stride_h, l.filter_h);
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "model/%02u_%s", i, op_name(l.op));
+    l.name = name;
+    layers.push_back(l);
+  }
+
+  return layers;
+
+}
+
+/**
+ * @brief Data of a layer, the same for all the backends.
+ */
+struct LayerData {
+  std::vector<int8_t> input, filter;
+  std::vector<int32_t> bias, mult, shift, lut;
+  std::vector<int8_t> outputs[backend_count];
+  // 16 byte aligned buffers of the optimized and SIMD kernels.
+  std::unique_ptr<int32_t[]> scratch, prepared;
+};
+
+static uint32_t seed = 1;
+
+static uint32_t next_random() {
+
+  seed = seed * 1664525 + 1013904223;
+  return seed >> 8;
+
+}
+
+static void fill_layer(const Layer& l, LayerData* d) {
+
+  d->input.resize(input_size(l));
+  d->filter.resize(filter_size(l));
+  d->bias.resize(l.out_c);
+  d->mult.resize(l.out_c);
+  d->shift.resize(l.out_c);
+  for (int8_t& v : d->input) v = (int8_t) next_random();
+  for (int8_t& v : d->filter) v = (int8_t) next_random();
+  for (int32_t& v : d->bias) v = (int32_t) (next_random() % 8192) - 4096;
+  // Multipliers in [0.5, 1) and the shifts of int8 models.
+  for (int32_t& v : d->mult) v = (int32_t) (0x40000000u + next_random() % 0x3fffffffu);
+  for (int32_t& v : d->shift) v = -5 - (int32_t) (next_random() % 5);
+  for (int b = 0; b < backend_count; b++) {
+    d->outputs[b].assign(output_size(l), 0);
+  }
+
+}
+
+static void conv_params_of(const Layer& l, data_dims_t* input, data_dims_t* filter,
+                           data_dims_t* output, conv_params_t* params) {
+
+  *input = {l.in_w, l.in_h, l.in_c, 1};
+  *filter = {l.filter_w, l.filter_h, 0, 0};
+  *output = {l.out_w, l.out_h, l.out_c, 1};
+  *params = {l.in_offset, l.out_offset, {l.stride_w, l.stride_h}, {l.pad_w, l.pad_h}, {1, 1}, {-128, 127}};
+
+}
+
+static void dw_params_of(const Layer& l, data_dims_t* input, data_dims_t* filter,
+                         data_dims_t* output, dw_conv_params_t* params) {
+
+  *input = {l.in_w, l.in_h, l.in_c, 1};
+  *filter = {l.filter_w, l.filter_h, 0, 0};
+  *output = {l.out_w, l.out_h, l.out_c, 1};
+  *params = {l.in_offset, l.out_offset, l.ch_mult, {l.stride_w, l.stride_h}, {l.pad_w, l.pad_h}, {1, 1}, {-128, 127}};
+
+}
+
+static int32_t* aligned_buffer(std::unique_ptr<int32_t[]>* buffer, int bytes) {
+
+  buffer->reset(bytes > 0 ? new int32_t[(bytes + 15) / 4] : nullptr);
+  return buffer->get();
+
+}
+
+/**
+ * @brief Set the scratch and prepared buffers of a backend for a layer, as the
+ * TFLite kernels do at Prepare.
+ */
+static void prepare_layer(const Layer& l, Backend backend, LayerData* d) {
+
+  data_dims_t input, filter, output;
+  if (l.op == Op::conv) {
+    conv_params_t params;
+    conv_params_of(l, &input, &filter, &output, &params);
+    if (backend == backend_ansi) {
+      esp_nn_set_conv_scratch_buf_ansi(
+          aligned_buffer(&d->scratch, esp_nn_get_conv_scratch_size_ansi(&input, &filter, &output, &params)));
+      return;
+    }
+    int32_t* scratch = aligned_buffer(&d->scratch, esp_nn_get_conv_scratch_size_opt(&input, &filter, &output, &params));
+    int32_t* prepared = aligned_buffer(&d->prepared, esp_nn_get_conv_prepared_size_opt(&input, &filter, &output, &params));
+    if (prepared) {
+      esp_nn_prepare_conv_s8_opt(&input, &filter, d->filter.data(), d->bias.data(), &output, &params, prepared);
+    }
+    esp_nn_set_conv_scratch_buf_opt(scratch);
+    esp_nn_set_conv_prepared_buf_opt(prepared);
+#if CONFIG_NN_SIMD
+    esp_nn_set_conv_scratch_buf_simd(scratch);
+    esp_nn_set_conv_prepared_buf_simd(prepared);
+#endif
+  } else if (l.op == Op::depthwise_conv) {
+    dw_conv_params_t params;
+    dw_params_of(l, &input, &filter, &output, &params);
+    if (backend == backend_ansi) {
+      esp_nn_set_depthwise_conv_scratch_buf_ansi(
+          aligned_buffer(&d->scratch, esp_nn_get_depthwise_conv_scratch_size_ansi(&input, &filter, &output, &params)));
+      return;
+    }
+    int32_t* scratch = aligned_buffer(&d->scratch, esp_nn_get_depthwise_conv_scratch_size_opt(&input, &filter, &output, &params));
+    int32_t* prepared = aligned_buffer(&d->prepared, esp_nn_get_depthwise_conv_prepared_size_opt(&input, &filter, &output, &params));
+    if (prepared) {
+      esp_nn_prepare_depthwise_conv_s8_opt(&input, &filter, d->filter.data(), d->bias.data(), &output, &params, prepared);
+    }
+    esp_nn_set_depthwise_conv_scratch_buf_opt(scratch);
+    esp_nn_set_depthwise_conv_prepared_buf_opt(prepared);
+#if CONFIG_NN_SIMD
+    esp_nn_set_depthwise_conv_prepared_buf_simd(prepared);
+#endif
+  } else if (l.op == Op::softmax) {
+    // The kernel of the model, the exps from a table made at Prepare.
+    d->lut.resize(ESP_NN_SOFTMAX_LUT_SIZE);
+    esp_nn_prepare_softmax_lut_s8_ansi(d->mult[0], 7, -248, d->lut.data());
+  }
+
+}
+
+static void run_layer(const Layer& l, Backend backend, LayerData* d) {
+
+  int8_t* out = d->outputs[backend].data();
+  data_dims_t input, filter, output;
+  quant_data_t quant = {d->shift.data(), d->mult.data()};
+
+  switch (l.op) {
+    case Op::conv: {
+      conv_params_t params;
+      conv_params_of(l, &input, &filter, &output, &params);
+      auto* kernel = backend == backend_ansi ? esp_nn_conv_s8_ansi : esp_nn_conv_s8_opt;
+#if CONFIG_NN_SIMD
+      if (backend == backend_simd) kernel = esp_nn_conv_s8_simd;
+#endif
+      kernel(&input, d->input.data(), &filter, d->filter.data(), d->bias.data(), &output, out, &params, &quant);
+      break;
+    }
+    case Op::depthwise_conv: {
+      dw_conv_params_t params;
+      dw_params_of(l, &input, &filter, &output, &params);
+      auto* kernel = backend == backend_ansi ? esp_nn_depthwise_conv_s8_ansi : esp_nn_depthwise_conv_s8_opt;
+#if CONFIG_NN_SIMD
+      if (backend == backend_simd) kernel = esp_nn_depthwise_conv_s8_simd;
+#endif
+      kernel(&input, d->input.data(), &filter, d->filter.data(), d->bias.data(), &output, out, &params, &quant);
+      break;
+    }
+    case Op::avg_pool:
+    case Op::max_pool: {
+      auto* kernel = l.op == Op::avg_pool ? (backend == backend_ansi ? esp_nn_avg_pool_s8_ansi : esp_nn_avg_pool_s8_opt)
+                                          : (backend == backend_ansi ? esp_nn_max_pool_s8_ansi : esp_nn_max_pool_s8_opt);
+#if CONFIG_NN_SIMD
+      // The average pooling has no SIMD kernel, the optimized one is used.
+      if (backend == backend_simd && l.op == Op::max_pool) kernel = esp_nn_max_pool_s8_simd;
+#endif
+      kernel(d->input.data(), l.in_w, l.in_h, out, l.out_w, l.out_h, l.stride_w, l.stride_h,
+             l.filter_w, l.filter_h, l.pad_w, l.pad_h, -128, 127, l.in_c);
+      break;
+    }
+    case Op::fully_connected: {
+      // The generic optimizations have none, the ANSI C kernel is used.
+      auto* kernel = esp_nn_fully_connected_s8_ansi;
+#if CONFIG_NN_SIMD
+      if (backend == backend_simd) kernel = esp_nn_fully_connected_s8_simd;
+#endif
+      kernel(d->input.data(), l.in_offset, l.in_c, d->filter.data(), 0, d->bias.data(), out, l.out_c,
+             l.out_offset, d->shift[0], d->mult[0], -128, 127);
+      break;
+    }
+    case Op::softmax: {
+      auto* kernel = backend == backend_ansi ? esp_nn_softmax_s8_lut_ansi : esp_nn_softmax_s8_lut_opt;
+#if CONFIG_NN_SIMD
+      if (backend == backend_simd) kernel = esp_nn_softmax_s8_lut_simd;
+#endif
+      kernel(d->input.data(), l.in_h, l.in_c, d->lut.data(), out);
+      break;
+    }
+  }
+
+}
+
+static double elapsed_ns(bench_clock::time_point start) {
+
+  return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+
+}
+
+static Result time_layer(const Layer& l, Backend backend, LayerData* d, int warmup, int reps) {
+
+  prepare_layer(l, backend, d);
+
+  // The warmup calls also tell how many calls make a repetition.
+  double warmup_ns = 0;
+  for (int i = 0; i < std::max(warmup, 1); i++) {
+    auto start = bench_clock::now();
+    run_layer(l, backend, d);
+    warmup_ns = elapsed_ns(start);
+  }
+  const int calls = std::max(1, (int) (min_rep_ns / std::max(warmup_ns, 1.0)));
+
+  std::vector<double> times;
+  for (int r = 0; r < reps; r++) {
+    auto start = bench_clock::now();
+    for (int i = 0; i < calls; i++) {
+      run_layer(l, backend, d);
+    }
+    times.push_back(elapsed_ns(start) / calls);
+  }
+  std::sort(times.begin(), times.end());
+
+  Result result;
+  result.layer = &l;
+  result.backend = backend;
+  result.macs = macs_of(l);
+  result.bytes = bytes_of(l);
+  result.min_ns = times.front();
+  result.median_ns = times[times.size() / 2];
+  result.match = d->outputs[backend] == d->outputs[backend_ansi];
+  return result;
+
+}
+
+static bool write_json(const char* path, const std::vector<Result>& results, int warmup, int reps) {
+
+  FILE* f = fopen(path, "w");
+  if (!f) {
+    return false;
+  }
+
+  fprintf(f, "{\n  \"warmup\": %d,\n  \"repetitions\": %d,\n  \"results\": [", warmup, reps);
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result& r = results[i];
+    fprintf(f, "%s\n    {\"layer\": \"%s\", \"op\": \"%s\", \"backend\": \"%s\", \"shape\": \"%s\", "
+               "\"macs\": %.0f, \"bytes\": %.0f, \"min_ns\": %.1f, \"median_ns\": %.1f, "
+               "\"mac_per_s\": %.4g, \"bytes_per_s\": %.4g, \"match\": %s}",
+            i ? "," : "", r.layer->name.c_str(), op_name(r.layer->op), backend_names[r.backend],
+            shape_of(*r.layer).c_str(), r.macs, r.bytes, r.min_ns, r.median_ns,
+            r.macs * 1e9 / r.median_ns, r.bytes * 1e9 / r.median_ns, r.match ? "true" : "false");
+  }
+  fprintf(f, "\n  ]\n}\n");
+  fclose(f);
+
+  return true;
+
+}
+
+static bool write_csv(const char* path, const std::vector<Result>& results) {
+
+  FILE* f = fopen(path, "w");
+  if (!f) {
+    return false;
+  }
+
+  fprintf(f, "layer,op,backend,shape,macs,bytes,min_ns,median_ns,mac_per_s,bytes_per_s,match\n");
+  for (const Result& r : results) {
+    fprintf(f, "%s,%s,%s,%s,%.0f,%.0f,%.1f,%.1f,%.4g,%.4g,%d\n",
+            r.layer->name.c_str(), op_name(r.layer->op), backend_names[r.backend],
+            shape_of(*r.layer).c_str(), r.macs, r.bytes, r.min_ns, r.median_ns,
+            r.macs * 1e9 / r.median_ns, r.bytes * 1e9 / r.median_ns, r.match);
+  }
+  fclose(f);
+
+  return true;
+
+}
+
+/**
+ * @brief Load the median times of a CSV written by -c, by layer and backend.
+ *
+ * @returns False if the file could not be read.
+ */
+static bool load_baseline(const char* path, std::map<std::string, double>* medians) {
+
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    return false;
+  }
+
+  char line[512];
+  while (fgets(line, sizeof(line), f)) {
+    std::vector<std::string> fields;
+    char* save = nullptr;
+    for (char* field = strtok_r(line, ",\n", &save); field; field = strtok_r(nullptr, ",\n", &save)) {
+      fields.push_back(field);
+    }
+    if (fields.size() >= 8 && fields[0] != "layer") {
+      (*medians)[fields[0] + "/" + fields[2]] = atof(fields[7].c_str());
+    }
+  }
+  fclose(f);
+
+  return true;
+
+}
+
+static void usage(const char* name) {
+
+  fprintf(stderr, "Usage: %s [-w calls] [-r reps] [-f text] [-j file] [-c file] [-b file] [-t tolerance]\n", name);
+
+}
+
+int main(int argc, char** argv) {
+
+  int warmup = 3;
+  int reps = 15;
+  const char* filter = "";
+  const char* json_path = nullptr;
+  const char* csv_path = nullptr;
+  const char* baseline_path = nullptr;
+  double tolerance = 0.25;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "w:r:f:j:c:b:t:")) != -1) {
+    switch (opt) {
+      case 'w': warmup = atoi(optarg); break;
+      case 'r': reps = std::max(atoi(optarg), 1); break;
+      case 'f': filter = optarg; break;
+      case 'j': json_path = optarg; break;
+      case 'c': csv_path = optarg; break;
+      case 'b': baseline_path = optarg; break;
+      case 't': tolerance = atof(optarg); break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+
+  std::map<std::string, double> baseline;
+  if (baseline_path && !load_baseline(baseline_path, &baseline)) {
+    fprintf(stderr, "Could not read %s\n", baseline_path);
+    return 1;
+  }
+
+  std::vector<Layer> layers = model_layers();
+  for (const Layer& l : sweep_layers()) {
+    layers.push_back(l);
+  }
+
+  std::vector<Result> results;
+  int mismatches = 0;
+  int regressions = 0;
+
+  printf("%-36s %-5s %12s %12s %10s %10s\n", "layer", "", "median us", "min us", "GMAC/s", "GB/s");
+  for (const Layer& l : layers) {
+    if (l.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    LayerData data;
+    fill_layer(l, &data);
+    // The ANSI C kernel first, the others are checked against its output.
+    for (int b = 0; b < backends; b++) {
+      Result r = time_layer(l, (Backend) b, &data, warmup, reps);
+      results.push_back(r);
+
+      const char* note = r.match ? "" : "  output mismatch";
+      mismatches += !r.match;
+      auto it = baseline.find(l.name + "/" + backend_names[b]);
+      char regression[64] = "";
+      if (it != baseline.end() && r.median_ns > it->second * (1 + tolerance)) {
+        snprintf(regression, sizeof(regression), "  %+.0f%% over the baseline",
+                 100 * (r.median_ns / it->second - 1));
+        regressions++;
+      }
+      printf("%-36s %-5s %12.2f %12.2f %10.3f %10.3f%s%s\n", b == 0 ? l.name.c_str() : "",
+             backend_names[b], r.median_ns / 1000, r.min_ns / 1000,
+             r.macs / r.median_ns, r.bytes / r.median_ns, note, regression);
+    }
+  }
+
+  if (json_path && !write_json(json_path, results, warmup, reps)) {
+    fprintf(stderr, "Could not write %s\n", json_path);
+    return 1;
+  }
+  if (csv_path && !write_csv(csv_path, results)) {
+    fprintf(stderr, "Could not write %s\n", csv_path);
+    return 1;
+  }
+
+  if (mismatches) {
+    printf("%d kernels do not give the same output as the ANSI C ones\n", mismatches);
+  }
+  if (regressions) {
+    printf("%d kernels are more than %.0f%% slower than the baseline\n", regressions, 100 * tolerance);
+  }
+
+  return mismatches || regressions ? 1 : 0;
+
+}
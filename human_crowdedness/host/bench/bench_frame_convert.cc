@@ -0,0 +1,79 @@
+/**
+ * @file bench_frame_convert.cc
+ * @brief Microbenchmark of the camera frame to model input conversion.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Usage: bench_frame_convert [iterations]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "frame_convert.h"
+
+// Same as cam_size in camera_ctrl.h, which we cannot include here.
+constexpr size_t frame_size = 96 * 96;
+
+typedef void (*convert_fn)(const uint8_t*, int8_t*, size_t);
+
+/**
+ * @brief Time a converter.
+ *
+ * @param fn The converter to time.
+ * @param src The frame to convert.
+ * @param dst Where to put the result.
+ * @param iterations How many frames to convert.
+ *
+ * @returns The average time per frame in nanoseconds.
+ */
+static double time_converter(convert_fn fn, const uint8_t* src, int8_t* dst, int iterations) {
+
+  // Warm up the caches first.
+  for (int i = 0; i < 100; i++) {
+    fn(src, dst, frame_size);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    fn(src, dst, frame_size);
+    // Stop the compiler from hoisting the call out of the loop.
+    asm volatile("" : : "r"(dst) : "memory");
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+
+}
+
+int main(int argc, char** argv) {
+
+  int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+
+  static uint8_t src[frame_size];
+  static int8_t dst[frame_size];
+  for (size_t i = 0; i < frame_size; i++) {
+    src[i] = (uint8_t) rand();
+  }
+
+  double bytewise_ns = time_converter(convert_frame_to_input_bytewise, src, dst, iterations);
+  double wordwise_ns = time_converter(convert_frame_to_input, src, dst, iterations);
+
+  printf("frame: %zu pixels, %d iterations\n", frame_size, iterations);
+  printf("bytewise: %10.1f ns/frame\n", bytewise_ns);
+  printf("wordwise: %10.1f ns/frame\n", wordwise_ns);
+  printf("speedup:  %10.2fx\n", bytewise_ns / wordwise_ns);
+
+  return 0;
+
+}
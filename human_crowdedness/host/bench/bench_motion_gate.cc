@@ -0,0 +1,138 @@
+/**
+ * @file bench_motion_gate.cc
+ * @brief Measures how much inference the motion gate saves on a replay.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Usage: bench_motion_gate [-n frames] <frames directory | synthetic>
+ *
+ * The frames are replayed twice: once running the model on all of them, and
+ * once only on the ones the gate lets through, reusing the last score for the
+ * rest. Both the CPU time and the verdicts of the two runs are compared.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame_sources.h"
+#include "motion_gate.h"
+#include "person_detector.h"
+
+constexpr int frame_width = 96;
+constexpr int frame_height = 96;
+constexpr size_t arena_size = 96 * 1024;
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_ns(bench_clock::time_point start) {
+
+  return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+
+}
+
+/**
+ * @brief Open the frames again from the beginning.
+ */
+static std::unique_ptr<FrameSource> open_source(const std::string& name) {
+
+  if (name == "synthetic") {
+    return std::unique_ptr<FrameSource>(new SyntheticFrameSource(frame_width, frame_height, 0, 1));
+  }
+
+  DirectoryFrameSource* dir = new DirectoryFrameSource(frame_width * frame_height, false);
+  std::unique_ptr<FrameSource> source(dir);
+  if (dir->open(name.c_str()) <= 0) {
+    fprintf(stderr, "No frames found in %s\n", name.c_str());
+    exit(1);
+  }
+
+  return source;
+
+}
+
+int main(int argc, char** argv) {
+
+  long max_frames = 1000;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    if (opt == 'n') {
+      max_frames = atol(optarg);
+    } else {
+      fprintf(stderr, "Usage: %s [-n frames] <frames directory | synthetic>\n", argv[0]);
+      return 2;
+    }
+  }
+  std::string name = optind < argc ? argv[optind] : "synthetic";
+
+  std::unique_ptr<uint8_t[]> arena(new uint8_t[arena_size]);
+  PersonDetector detector;
+  if (detector.init(arena.get(), arena_size) != person_detector_ok) {
+    fprintf(stderr, "Detector init failed\n");
+    return 1;
+  }
+
+  // First, the model on every frame.
+  std::vector<float> scores;
+  double full_ns = 0;
+  std::unique_ptr<FrameSource> source = open_source(name);
+  while ((long) scores.size() < max_frames && source->get_image(detector.input()) == frame_source_ok) {
+    float score = 0;
+    auto start = bench_clock::now();
+    detector.invoke(&score);
+    full_ns += elapsed_ns(start);
+    scores.push_back(score);
+  }
+
+  // Then, only when the gate says so.
+  MotionGate<frame_width, frame_height> gate;
+  double gated_ns = 0;
+  double gate_ns = 0;
+  size_t agree = 0;
+  float score = 0;
+  source = open_source(name);
+  for (size_t i = 0; i < scores.size(); i++) {
+    source->get_image(detector.input());
+    auto start = bench_clock::now();
+    bool infer = gate.should_infer(detector.input());
+    gate_ns += elapsed_ns(start);
+    if (infer) {
+      start = bench_clock::now();
+      detector.invoke(&score);
+      gated_ns += elapsed_ns(start);
+    }
+    agree += (score >= 0.5f) == (scores[i] >= 0.5f);
+  }
+  gated_ns += gate_ns;
+
+  size_t frames = scores.size();
+  if (frames == 0) {
+    fprintf(stderr, "No frames replayed\n");
+    return 1;
+  }
+
+  printf("frames:            %zu\n", frames);
+  printf("skipped:           %u (%.1f%%)\n", gate.skipped(), 100.0 * gate.skipped() / frames);
+  printf("gate:              %10.1f ns/frame\n", gate_ns / frames);
+  printf("invoke every frame:%10.1f us/frame\n", full_ns / frames / 1000);
+  printf("gated:             %10.1f us/frame\n", gated_ns / frames / 1000);
+  printf("CPU saved:         %10.1f%%\n", 100.0 * (full_ns - gated_ns) / full_ns);
+  printf("same verdict:      %10.1f%%\n", 100.0 * agree / frames);
+
+  return 0;
+
+}
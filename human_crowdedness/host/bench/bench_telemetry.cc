@@ -0,0 +1,112 @@
+/**
+ * @file bench_telemetry.cc
+ * @brief Compares the binary telemetry with the text the loop printed before.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Usage: bench_telemetry [-n results]
+ *
+ * The same results are written as the "People score" lines of the main loop
+ * into a string stream, and as records into payloads. Both the CPU time and
+ * the bytes per result are reported.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+#include "telemetry.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_ns(bench_clock::time_point start) {
+
+  return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+
+}
+
+int main(int argc, char** argv) {
+
+  long results = 100000;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    if (opt == 'n') {
+      results = atol(optarg);
+    } else {
+      fprintf(stderr, "Usage: %s [-n results]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (results <= 0) {
+    fprintf(stderr, "Nothing to do\n");
+    return 2;
+  }
+
+  // Results of a steady loop, about a second apart.
+  std::vector<float> scores(results);
+  std::vector<TelemetryRecord> records(results);
+  uint32_t now_ms = 0;
+  srand(1);
+  for (long i = 0; i < results; i++) {
+    scores[i] = (float) rand() / RAND_MAX;
+    now_ms += 990 + rand() % 20;
+    TelemetryRecord& record = records[i];
+    record.timestamp_ms = now_ms;
+    record.state = (uint8_t) (rand() % 3);
+    record.stage_us[cycle_capture] = 200 + rand() % 100;
+    record.stage_us[cycle_convert] = 150 + rand() % 50;
+    record.stage_us[cycle_invoke] = 640000 + rand() % 8000;
+    record.stage_us[cycle_post] = 100 + rand() % 50;
+    record.stage_us[cycle_sleep] = 345000 + rand() % 16000;
+    record.faults = 0;
+  }
+
+  // The printing path of the main loop.
+  std::ostringstream text;
+  auto start = bench_clock::now();
+  for (long i = 0; i < results; i++) {
+    text << "People score: " << scores[i] * 100 << std::endl;
+  }
+  double text_ns = elapsed_ns(start);
+  size_t text_bytes = text.str().size();
+
+  // The records, quantizing the score as the loop does.
+  uint8_t payload[telemetry_payload_size];
+  TelemetryWriter writer(payload, sizeof(payload));
+  size_t binary_bytes = 0;
+  size_t payloads = 0;
+  start = bench_clock::now();
+  for (long i = 0; i < results; i++) {
+    records[i].score = telemetry_quantize_score(scores[i]);
+    if (!writer.append(records[i])) {
+      binary_bytes += writer.size();
+      payloads++;
+      writer.reset();
+      writer.append(records[i]);
+    }
+  }
+  binary_bytes += writer.size();
+  payloads++;
+  double binary_ns = elapsed_ns(start);
+
+  printf("results:           %ld\n", results);
+  printf("text:              %10.1f ns/result %6.1f bytes/result\n", text_ns / results, (double) text_bytes / results);
+  printf("binary:            %10.1f ns/result %6.1f bytes/result\n", binary_ns / results, (double) binary_bytes / results);
+  printf("records/payload:   %10.1f\n", (double) results / payloads);
+
+  return 0;
+
+}
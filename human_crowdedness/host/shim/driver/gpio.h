@@ -0,0 +1,48 @@
+/**
+ * @file driver/gpio.h
+ * @brief Host replacement for the ESP-IDF GPIO driver.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Only declarations, for main/ to be compiled on the host, nothing links.
+*/
+
+#ifndef HOST_DRIVER_GPIO_H_
+#define HOST_DRIVER_GPIO_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum { GPIO_MODE_DISABLE, GPIO_MODE_INPUT, GPIO_MODE_OUTPUT } gpio_mode_t;
+typedef enum { GPIO_PULLUP_DISABLE, GPIO_PULLUP_ENABLE } gpio_pullup_t;
+typedef enum { GPIO_PULLDOWN_DISABLE, GPIO_PULLDOWN_ENABLE } gpio_pulldown_t;
+typedef enum { GPIO_INTR_DISABLE } gpio_int_type_t;
+
+typedef struct {
+  uint64_t pin_bit_mask;
+  gpio_mode_t mode;
+  gpio_pullup_t pull_up_en;
+  gpio_pulldown_t pull_down_en;
+  gpio_int_type_t intr_type;
+} gpio_config_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t gpio_config(const gpio_config_t* config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HOST_DRIVER_GPIO_H_
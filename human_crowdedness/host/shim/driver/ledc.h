@@ -0,0 +1,27 @@
+/**
+ * @file driver/ledc.h
+ * @brief Host replacement for the ESP-IDF LED PWM driver.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Only declarations, for main/ to be compiled on the host, nothing links.
+ * As on the board, it brings driver/gpio.h in.
+*/
+
+#ifndef HOST_DRIVER_LEDC_H_
+#define HOST_DRIVER_LEDC_H_
+
+#include "driver/gpio.h"
+
+typedef enum { LEDC_CHANNEL_0 } ledc_channel_t;
+typedef enum { LEDC_TIMER_0 } ledc_timer_t;
+
+#endif  // HOST_DRIVER_LEDC_H_
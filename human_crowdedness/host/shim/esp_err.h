@@ -0,0 +1,28 @@
+/**
+ * @file esp_err.h
+ * @brief Host replacement for the ESP-IDF error codes.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Only declarations, for main/ to be compiled on the host, nothing links.
+*/
+
+#ifndef HOST_ESP_ERR_H_
+#define HOST_ESP_ERR_H_
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+#endif  // HOST_ESP_ERR_H_
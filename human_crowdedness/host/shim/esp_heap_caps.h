@@ -0,0 +1,39 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host replacement for the ESP-IDF capability based heap.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Only declarations, for main/ to be compiled on the host, nothing links.
+*/
+
+#ifndef HOST_ESP_HEAP_CAPS_H_
+#define HOST_ESP_HEAP_CAPS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void* ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HOST_ESP_HEAP_CAPS_H_
@@ -0,0 +1,33 @@
+/**
+ * @file esp_system.h
+ * @brief Host replacement for the ESP-IDF system API.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Only declarations, for main/ to be compiled on the host, nothing links.
+*/
+
+#ifndef HOST_ESP_SYSTEM_H_
+#define HOST_ESP_SYSTEM_H_
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void esp_restart(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HOST_ESP_SYSTEM_H_
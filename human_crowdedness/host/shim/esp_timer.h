@@ -0,0 +1,37 @@
+/**
+ * @file esp_timer.h
+ * @brief Host replacement for the ESP-IDF high resolution timer.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Only the part that tflite-lib and esp-nn use is provided.
+*/
+
+#ifndef HOST_ESP_TIMER_H_
+#define HOST_ESP_TIMER_H_
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @brief Get the time since some fixed point in the past.
+ *
+ * @returns The time in microseconds.
+ */
+static inline int64_t esp_timer_get_time(void) {
+
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+}
+
+#endif  // HOST_ESP_TIMER_H_
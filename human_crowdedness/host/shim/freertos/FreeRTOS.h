@@ -0,0 +1,37 @@
+/**
+ * @file freertos/FreeRTOS.h
+ * @brief Host replacement for the FreeRTOS of ESP-IDF.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Only declarations, for main/ to be compiled on the host, nothing links.
+ * As on the board, it brings esp_heap_caps.h in.
+*/
+
+#ifndef HOST_FREERTOS_FREERTOS_H_
+#define HOST_FREERTOS_FREERTOS_H_
+
+#include <stdint.h>
+
+#include "esp_heap_caps.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
+#define configTICK_RATE_HZ 100
+#define pdMS_TO_TICKS(ms) ((TickType_t) (((TickType_t) (ms) * configTICK_RATE_HZ) / 1000))
+
+#endif  // HOST_FREERTOS_FREERTOS_H_
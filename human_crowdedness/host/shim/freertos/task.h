@@ -0,0 +1,40 @@
+/**
+ * @file freertos/task.h
+ * @brief Host replacement for the FreeRTOS tasks of ESP-IDF.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Only declarations, for main/ to be compiled on the host, nothing links.
+*/
+
+#ifndef HOST_FREERTOS_TASK_H_
+#define HOST_FREERTOS_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack_depth,
+                                   void* parameters, UBaseType_t priority, TaskHandle_t* created_task,
+                                   BaseType_t core_id);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HOST_FREERTOS_TASK_H_
@@ -0,0 +1,45 @@
+/**
+ * @file sensor.h
+ * @brief Host replacement for the sensor API of esp32-camera.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Only declarations, for main/ to be compiled on the host, nothing links.
+*/
+
+#ifndef HOST_SENSOR_H_
+#define HOST_SENSOR_H_
+
+typedef enum {
+  PIXFORMAT_RGB565,
+  PIXFORMAT_YUV422,
+  PIXFORMAT_GRAYSCALE,
+  PIXFORMAT_JPEG,
+  PIXFORMAT_RGB888,
+} pixformat_t;
+
+typedef enum {
+  FRAMESIZE_96X96,
+  FRAMESIZE_QQVGA,
+  FRAMESIZE_QCIF,
+  FRAMESIZE_HQVGA,
+  FRAMESIZE_QVGA,
+  FRAMESIZE_CIF,
+  FRAMESIZE_VGA,
+} framesize_t;
+
+typedef struct _sensor sensor_t;
+struct _sensor {
+  int (*set_vflip)(sensor_t* sensor, int enable);
+  int (*set_hmirror)(sensor_t* sensor, int enable);
+};
+
+#endif  // HOST_SENSOR_H_
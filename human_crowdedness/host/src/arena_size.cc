@@ -0,0 +1,444 @@
+/**
+ * @file arena_size.cc
+ * @brief Measures the tensor arena a model needs.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Allocates the tensors of a model through RecordingMicroAllocator, with the
+ * memory planner PersonDetector uses, and then looks for the smallest arena in
+ * which the model still allocates and runs. Then does the same for the arena
+ * of the activations when the structs of the graph have an arena of their own,
+ * as PersonDetector::init() with two arenas does, which keeps what the kernels
+ * allocate next to the activations. Prints a summary, and
+ * optionally writes the whole breakdown as JSON and a header with the sizes.
+ *
+ * The buffers in the JSON are the tensors planned in the arena, by index, and
+ * the scratch buffers of the kernels, with -1 as tensor.
+ *
+ * The structures in the persistent part of the arena are full of pointers, so
+ * the sizes only hold for the pointer size of the build the tool runs in. The
+ * header refuses to build for another one: for the board, build the host tools
+ * for a 32-bit target and write main/person_detect_arena.h, which main.cc then
+ * takes instead of its own guess.
+ *
+ * The convolutions split among the ESP-NN workers take scratch space for every
+ * job, so the arena is measured with as many workers as main.cc starts, and the
+ * header records how many that was.
+ *
+ * Usage: arena_size [options]
+ *
+ *   -m file    The .tflite model (default: the embedded person detection one).
+ *   -a bytes   Size of the arena to measure in (default: 1 MB).
+ *   -j file    Write the breakdown as JSON.
+ *   -H file    Write a header with the arena size.
+ *   -n name    Prefix of the constants in the header (default: person_detect).
+ *   -w workers ESP-NN workers running while the model is prepared (default: 1,
+ *              the inference_workers of main.cc).
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+#include "model.h"
+#include "offline_plan.h"
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/memory_planner/search_memory_planner.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/recording_micro_allocator.h"
+
+constexpr size_t default_arena_size = 1024 * 1024;
+constexpr int default_workers = 1;
+
+#if defined(CONFIG_NN_CONV_ARENA_BUFFERS)
+constexpr bool conv_arena_buffers = true;
+#else
+constexpr bool conv_arena_buffers = false;
+#endif
+
+/**
+ * @brief Keeps every buffer the allocator plans, and passes it on.
+ */
+class RecordingMemoryPlanner : public tflite::MicroMemoryPlanner {
+
+ public:
+
+  struct Buffer {
+    int size;
+    int first_time_used;
+    int last_time_used;
+    int offset;
+  };
+
+  explicit RecordingMemoryPlanner(tflite::MicroMemoryPlanner* planner) : planner_(planner) {}
+
+  TfLiteStatus Init(unsigned char* scratch_buffer, int scratch_buffer_size) override {
+    buffers.clear();
+    return planner_->Init(scratch_buffer, scratch_buffer_size);
+  }
+
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used) override {
+    return AddBuffer(size, first_time_used, last_time_used, tflite::kOnlinePlannedBuffer);
+  }
+
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used, int offline_offset) override {
+    buffers.push_back({size, first_time_used, last_time_used, offline_offset});
+    return planner_->AddBuffer(size, first_time_used, last_time_used, offline_offset);
+  }
+
+  size_t GetMaximumMemorySize() override {
+    planned_size = planner_->GetMaximumMemorySize();
+    return planned_size;
+  }
+
+  int GetBufferCount() override { return planner_->GetBufferCount(); }
+
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override {
+    TfLiteStatus status = planner_->GetOffsetForBuffer(buffer_index, offset);
+    if (status == kTfLiteOk && buffer_index >= 0 && buffer_index < (int) buffers.size()) {
+      buffers[buffer_index].offset = *offset;
+    }
+    return status;
+  }
+
+  std::vector<Buffer> buffers;
+  size_t planned_size = 0;
+
+ private:
+
+  tflite::MicroMemoryPlanner* planner_;
+
+};
+
+/**
+ * @brief How an arena of a given size was used.
+ */
+struct ArenaUse {
+  size_t persistent;
+  size_t non_persistent;
+  size_t kernel_persistent;  // The part of `persistent` in the non persistent arena, with two.
+};
+
+/**
+ * @brief Whether the model allocates and runs in an arena of `size` bytes.
+ *
+ * Allocates as PersonDetector does, with the same allocator and planner, and
+ * with the ESP-NN workers that are running, which have to be the ones of the
+ * board.
+ *
+ * @param arena At least `size` bytes, aligned to MicroArenaBufferAlignment().
+ * @param persistent_arena An arena of its own for the structs of the graph, or
+ * null to keep them in `arena`.
+ * @param persistent_size The size of the persistent arena in bytes.
+ * @param use Gets how the arenas were used, if it worked.
+ */
+static bool fits(const tflite::Model* model, const tflite::MicroOpResolver& resolver, uint8_t* arena, size_t size, uint8_t* persistent_arena, size_t persistent_size, ArenaUse* use) {
+
+  tflite::SearchMemoryPlanner planner;
+  tflite::RecordingMicroAllocator* allocator = persistent_arena
+    ? tflite::RecordingMicroAllocator::Create(persistent_arena, persistent_size, arena, size, &planner)
+    : tflite::RecordingMicroAllocator::Create(arena, size, &planner);
+  if (allocator == nullptr) {
+    return false;
+  }
+
+  tflite::MicroInterpreter interpreter(model, resolver, allocator);
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    return false;
+  }
+  for (size_t i = 0; i < interpreter.inputs_size(); i++) {
+    memset(interpreter.input(i)->data.raw, 0, interpreter.input(i)->bytes);
+  }
+  if (interpreter.Invoke() != kTfLiteOk) {
+    return false;
+  }
+
+  use->persistent = allocator->persistent_used_bytes();
+  use->non_persistent = allocator->non_persistent_used_bytes();
+  use->kernel_persistent = allocator->kernel_persistent_used_bytes();
+  return true;
+
+}
+
+/**
+ * @brief The most memory the buffers need at the same time.
+ */
+static size_t live_bound(const std::vector<RecordingMemoryPlanner::Buffer>& buffers) {
+
+  size_t bound = 0;
+  for (const auto& at : buffers) {
+    size_t live = 0;
+    for (const auto& b : buffers) {
+      if (b.first_time_used <= at.first_time_used && b.last_time_used >= at.first_time_used) {
+        live += b.size;
+      }
+    }
+    bound = live > bound ? live : bound;
+  }
+  return bound;
+
+}
+
+static void usage(const char* name) {
+
+  fprintf(stderr, "Usage: %s [-m file] [-a bytes] [-j file] [-H file] [-n name] [-w workers]\n", name);
+
+}
+
+int main(int argc, char** argv) {
+
+  const char* model_path = nullptr;
+  size_t arena_size = default_arena_size;
+  const char* json_path = nullptr;
+  const char* header_path = nullptr;
+  std::string name = "person_detect";
+  int workers = default_workers;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "m:a:j:H:n:w:")) != -1) {
+    switch (opt) {
+      case 'm': model_path = optarg; break;
+      case 'a': arena_size = strtoul(optarg, nullptr, 10); break;
+      case 'j': json_path = optarg; break;
+      case 'H': header_path = optarg; break;
+      case 'n': name = optarg; break;
+      case 'w': workers = atoi(optarg); break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+  if (optind != argc || workers < 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  // The model, checked if it came from a file.
+  std::vector<uint8_t> model_data;
+  if (model_path) {
+    FILE* f = fopen(model_path, "rb");
+    if (!f) {
+      fprintf(stderr, "Could not read %s\n", model_path);
+      return 1;
+    }
+    uint8_t chunk[4096];
+    size_t len;
+    while ((len = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+      model_data.insert(model_data.end(), chunk, chunk + len);
+    }
+    fclose(f);
+  } else {
+    model_data.assign(g_person_detect_model_data, g_person_detect_model_data + g_person_detect_model_data_len);
+  }
+  flatbuffers::Verifier verifier(model_data.data(), model_data.size());
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    fprintf(stderr, "%s is not a TensorFlow Lite model\n", model_path ? model_path : "The model");
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+
+  tflite::AllOpsResolver resolver;
+  std::vector<uint8_t> arena_buffer(arena_size + tflite::MicroArenaBufferAlignment());
+  uint8_t* arena = tflite::AlignPointerUp(arena_buffer.data(), tflite::MicroArenaBufferAlignment());
+
+  // The convolutions are split when they are prepared, so the workers go first,
+  // and stay for the recording pass and every arena tried after it.
+  if (!tflite::StartEspNnWorkers(workers)) {
+    fprintf(stderr, "Cannot start %d workers\n", workers);
+    return 1;
+  }
+
+  // Everything the recording allocator sees.
+  tflite::SearchMemoryPlanner search;
+  RecordingMemoryPlanner planner(&search);
+  tflite::RecordingMicroAllocator* recording = tflite::RecordingMicroAllocator::Create(arena, arena_size, &planner);
+  if (recording == nullptr) {
+    fprintf(stderr, "An arena of %zu bytes is too small\n", arena_size);
+    return 1;
+  }
+  {
+    tflite::MicroInterpreter interpreter(model, resolver, recording);
+    if (interpreter.AllocateTensors() != kTfLiteOk) {
+      fprintf(stderr, "Could not allocate the tensors in %zu bytes\n", arena_size);
+      return 1;
+    }
+  }
+
+  // Read before the arena is used again.
+  const struct {
+    tflite::RecordedAllocationType type;
+    const char* name;
+  } categories[] = {
+    {tflite::RecordedAllocationType::kTfLiteEvalTensorData, "eval_tensors"},
+    {tflite::RecordedAllocationType::kPersistentTfLiteTensorData, "persistent_tensors"},
+    {tflite::RecordedAllocationType::kPersistentTfLiteTensorQuantizationData, "quantization"},
+    {tflite::RecordedAllocationType::kPersistentBufferData, "persistent_buffers"},
+    {tflite::RecordedAllocationType::kTfLiteTensorVariableBufferData, "variable_buffers"},
+    {tflite::RecordedAllocationType::kNodeAndRegistrationArray, "nodes_and_registrations"},
+    {tflite::RecordedAllocationType::kOpData, "op_data"},
+  };
+  constexpr size_t category_count = sizeof(categories) / sizeof(categories[0]);
+  tflite::RecordedAllocation recorded[category_count];
+  for (size_t i = 0; i < category_count; i++) {
+    recorded[i] = recording->GetRecordedAllocation(categories[i].type);
+  }
+  const size_t recording_used = recording->used_bytes();
+
+  // The first buffers planned are the tensors of the first subgraph, in
+  // order, which are at the same offsets every time we plan them.
+  std::vector<int32_t> offsets;
+  size_t used;
+  tflite::SearchMemoryPlanner tensor_search;
+  if (!plan_tensor_offsets(model, resolver, &tensor_search, arena, arena_size, &offsets, &used)) {
+    fprintf(stderr, "Could not allocate the tensors in %zu bytes\n", arena_size);
+    return 1;
+  }
+  std::vector<int> buffer_tensor(planner.buffers.size(), -1);
+  for (size_t i = 0, b = 0; i < offsets.size() && b < buffer_tensor.size(); i++) {
+    if (offsets[i] == tflite::kOnlinePlannedBuffer) {
+      continue;
+    }
+    if (planner.buffers[b].offset != offsets[i]) {
+      fprintf(stderr, "The buffers are not the tensors of the model\n");
+      return 1;
+    }
+    buffer_tensor[b++] = i;
+  }
+
+  // The smallest arena, between what the plan needs, which leaves no room for
+  // the rest, and what the recording allocator took, which has bigger
+  // structures of its own.
+  const size_t alignment = tflite::MicroArenaBufferAlignment();
+  size_t low = planner.planned_size / alignment * alignment;
+  size_t high = tflite::AlignSizeUp(recording_used, alignment) + alignment;
+  ArenaUse use;
+  if (!fits(model, resolver, arena, high, nullptr, 0, &use)) {
+    fprintf(stderr, "The model does not run in %zu bytes\n", high);
+    return 1;
+  }
+  while (high - low > alignment) {
+    const size_t middle = low + (high - low) / 2 / alignment * alignment;
+    if (fits(model, resolver, arena, middle, nullptr, 0, &use)) {
+      high = middle;
+    } else {
+      low = middle;
+    }
+  }
+  const size_t minimal = high;
+  fits(model, resolver, arena, minimal, nullptr, 0, &use);
+
+  // The smallest activation arena, with what the kernels keep, next to a
+  // persistent arena as big as the whole one, which is plenty. It needs at
+  // least what the head needed, and at most the whole arena.
+  std::vector<uint8_t> persistent_buffer(minimal + alignment);
+  uint8_t* persistent_arena = tflite::AlignPointerUp(persistent_buffer.data(), alignment);
+  low = use.non_persistent / alignment * alignment;
+  low = low > alignment ? low - alignment : 0;
+  high = minimal;
+  ArenaUse split;
+  if (!fits(model, resolver, arena, high, persistent_arena, minimal, &split)) {
+    fprintf(stderr, "The model does not run in two arenas of %zu bytes\n", high);
+    return 1;
+  }
+  while (high - low > alignment) {
+    const size_t middle = low + (high - low) / 2 / alignment * alignment;
+    if (fits(model, resolver, arena, middle, persistent_arena, minimal, &split)) {
+      high = middle;
+    } else {
+      low = middle;
+    }
+  }
+  const size_t minimal_activation = high;
+  fits(model, resolver, arena, minimal_activation, persistent_arena, minimal, &split);
+  const size_t split_persistent = split.persistent - split.kernel_persistent;
+
+  const size_t bound = live_bound(planner.buffers);
+  const double fragmentation = planner.planned_size > 0 ? 1.0 - (double) bound / planner.planned_size : 0.0;
+
+  printf("arena:          %zu bytes (%zu-byte pointers, %d workers, conv buffers %s)\n", minimal, sizeof(void*),
+         workers, conv_arena_buffers ? "on" : "off");
+  printf("persistent:     %zu bytes\n", use.persistent);
+  printf("non-persistent: %zu bytes\n", use.non_persistent);
+  printf("split:          %zu bytes of activations and %zu kept by the kernels, %zu persistent\n", split.non_persistent,
+         split.kernel_persistent, split_persistent);
+  printf("plan:           %zu bytes for %zu buffers, %zu live at most, %.1f%% fragmentation\n",
+         planner.planned_size, planner.buffers.size(), bound, 100.0 * fragmentation);
+
+  if (json_path) {
+    FILE* f = fopen(json_path, "w");
+    if (!f) {
+      fprintf(stderr, "Could not write %s\n", json_path);
+      return 1;
+    }
+    fprintf(f, "{\"pointer_size\":%zu,\"workers\":%d,\"arena_size\":%zu,\"persistent\":%zu,\"non_persistent\":%zu,\n",
+            sizeof(void*), workers, minimal, use.persistent, use.non_persistent);
+    fprintf(f, "\"split\":{\"activation_arena_size\":%zu,\"kernel_persistent\":%zu,\"persistent\":%zu},\n",
+            minimal_activation, split.kernel_persistent, split_persistent);
+    fprintf(f, "\"plan\":{\"size\":%zu,\"live_bound\":%zu,\"fragmentation\":%.4f},\n", planner.planned_size, bound, fragmentation);
+    fprintf(f, "\"categories\":[");
+    for (size_t i = 0; i < category_count; i++) {
+      fprintf(f, "%s\n{\"name\":\"%s\",\"requested\":%zu,\"used\":%zu,\"count\":%zu}", i ? "," : "",
+              categories[i].name, recorded[i].requested_bytes, recorded[i].used_bytes, recorded[i].count);
+    }
+    fprintf(f, "],\n\"buffers\":[");
+    for (size_t i = 0; i < planner.buffers.size(); i++) {
+      const RecordingMemoryPlanner::Buffer& b = planner.buffers[i];
+      fprintf(f, "%s\n{\"tensor\":%d,\"bytes\":%d,\"first\":%d,\"last\":%d,\"offset\":%d}", i ? "," : "",
+              buffer_tensor[i], b.size, b.first_time_used, b.last_time_used, b.offset);
+    }
+    fprintf(f, "]}\n");
+    fclose(f);
+  }
+
+  if (header_path) {
+    FILE* f = fopen(header_path, "w");
+    if (!f) {
+      fprintf(stderr, "Could not write %s\n", header_path);
+      return 1;
+    }
+    std::string guard = name;
+    for (char& c : guard) {
+      c = toupper((unsigned char) c);
+    }
+    guard += "_ARENA_H_";
+    fprintf(f, "// Generated by arena_size from %s, do not edit.\n\n", model_path ? model_path : "g_person_detect_model_data");
+    fprintf(f, "#ifndef %s\n#define %s\n\n#include <stddef.h>\n\n", guard.c_str(), guard.c_str());
+    fprintf(f, "// The persistent structures in the arena hold pointers.\n");
+    fprintf(f, "static_assert(sizeof(void*) == %zu, \"the arena was measured for %zu-byte pointers\");\n\n", sizeof(void*), sizeof(void*));
+    fprintf(f, "// The split convolutions take scratch space for every job, so the arena\n");
+    fprintf(f, "// only holds with as many ESP-NN workers running as this.\n");
+    fprintf(f, "constexpr int %s_arena_workers = %d;\n\n", name.c_str(), workers);
+    fprintf(f, "// And the convolutions only keep their faster buffers in the arena with\n");
+    fprintf(f, "// CONFIG_NN_CONV_ARENA_BUFFERS.\n");
+    fprintf(f, "constexpr bool %s_arena_conv_buffers = %s;\n\n", name.c_str(),
+            conv_arena_buffers ? "true" : "false");
+    fprintf(f, "constexpr size_t %s_arena_persistent_size = %zu;\n", name.c_str(), use.persistent);
+    fprintf(f, "constexpr size_t %s_arena_non_persistent_size = %zu;\n\n", name.c_str(), use.non_persistent);
+    fprintf(f, "// The smallest arena the model runs in, and room to align it.\n");
+    fprintf(f, "constexpr size_t %s_arena_size = %zu;\n\n", name.c_str(), minimal + alignment);
+    fprintf(f, "// The same with the structs of the graph in an arena of their own.\n");
+    fprintf(f, "constexpr size_t %s_activation_arena_size = %zu;\n", name.c_str(), minimal_activation + alignment);
+    fprintf(f, "constexpr size_t %s_persistent_arena_size = %zu;\n\n", name.c_str(), split_persistent + alignment);
+    fprintf(f, "#endif  // %s\n", guard.c_str());
+    fclose(f);
+  }
+
+  return 0;
+
+}
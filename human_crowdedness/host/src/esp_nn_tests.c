@@ -0,0 +1,74 @@
+/**
+ * @file esp_nn_tests.c
+ * @brief Runs the esp-nn test suite on the host.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * The same as components/esp-nn/test_app, but the "cycles" it prints are
+ * nanoseconds of the host clock. Every test prints "failed" when the
+ * optimized kernel does not give exactly the same output as the ANSI C one.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <test_functions.h>
+
+static uint64_t start_c, start_opt;
+
+static uint64_t now_ns(void) {
+
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+
+}
+
+void profile_c_start() {
+  start_c = now_ns();
+}
+
+uint32_t profile_c_end() {
+  return (uint32_t) (now_ns() - start_c);
+}
+
+void profile_opt_start() {
+  start_opt = now_ns();
+}
+
+uint32_t profile_opt_end() {
+  return (uint32_t) (now_ns() - start_opt);
+}
+
+int main(void) {
+
+  esp_nn_add_elementwise_s8_test();
+  esp_nn_mul_elementwise_s8_test();
+  esp_nn_depthwise_conv_s8_test();
+  esp_nn_conv_s8_test();
+  esp_nn_conv_1x1_sparse_s8_test();
+  esp_nn_relu6_s8_test();
+  esp_nn_avg_pool_s8_test();
+  esp_nn_max_pool_s8_test();
+  esp_nn_fully_connected_s8_test();
+  esp_nn_fully_connected_sparse_s8_test();
+  esp_nn_softmax_s8_test();
+  esp_nn_softmax_s8_lut_test();
+
+  esp_nn_depthwise_conv_s16_test();
+  esp_nn_conv_s16_test();
+  esp_nn_avg_pool_s16_test();
+  esp_nn_fully_connected_s16_test();
+
+  return 0;
+
+}
@@ -0,0 +1,251 @@
+/**
+ * @file frame_sources.cc
+ * @brief Frame sources that replace the camera on the host.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include "frame_sources.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "frame_convert.h"
+
+/**
+ * @brief Check if a string ends with a given suffix.
+ */
+static bool ends_with(const std::string& str, const char* suffix) {
+
+  size_t len = strlen(suffix);
+  return str.size() >= len && str.compare(str.size() - len, len, suffix) == 0;
+
+}
+
+/**
+ * @brief Read the next number of a PGM header, skipping blanks and comments.
+ *
+ * @param f The file, right before the number.
+ * @param value Where the number will be stored.
+ *
+ * @returns True if a number was read.
+ */
+static bool read_pgm_number(FILE* f, int* value) {
+
+  int c = fgetc(f);
+  while (c != EOF && (isspace(c) || c == '#')) {
+    if (c == '#') {
+      while (c != EOF && c != '\n') {
+        c = fgetc(f);
+      }
+    }
+    c = fgetc(f);
+  }
+
+  if (c == EOF || !isdigit(c)) {
+    return false;
+  }
+
+  *value = 0;
+  while (c != EOF && isdigit(c)) {
+    *value = *value * 10 + (c - '0');
+    c = fgetc(f);
+  }
+
+  // The single blank after the last number of the header is part of it.
+  return c != EOF && isspace(c);
+
+}
+
+/**
+ * @brief Read the pixels of a binary 8-bit PGM file.
+ *
+ * @returns True if the file is a PGM of exactly len pixels.
+ */
+static bool read_pgm(FILE* f, uint8_t* pixels, size_t len) {
+
+  char magic[2];
+  int width, height, max_value;
+  if (fread(magic, 1, 2, f) != 2 || magic[0] != 'P' || magic[1] != '5') {
+    return false;
+  }
+  if (!read_pgm_number(f, &width) || !read_pgm_number(f, &height) || !read_pgm_number(f, &max_value)) {
+    return false;
+  }
+  if ((size_t) width * height != len || max_value <= 0 || max_value > 255) {
+    return false;
+  }
+
+  return fread(pixels, 1, len, f) == len;
+
+}
+
+/**
+ * @brief Read the pixels of a raw grayscale file.
+ *
+ * @returns True if the file has exactly len pixels.
+ */
+static bool read_raw(FILE* f, uint8_t* pixels, size_t len) {
+
+  if (fread(pixels, 1, len, f) != len) {
+    return false;
+  }
+
+  // Anything after the frame means it is not the size we expected.
+  return fgetc(f) == EOF;
+
+}
+
+int DirectoryFrameSource::open(const char* dir) {
+
+  DIR* d = opendir(dir);
+  if (!d) {
+    return -1;
+  }
+
+  files_.clear();
+  std::string base(dir);
+  if (!base.empty() && base.back() != '/') {
+    base += '/';
+  }
+
+  while (struct dirent* entry = readdir(d)) {
+    std::string name(entry->d_name);
+    if (ends_with(name, ".pgm") || ends_with(name, ".raw")) {
+      files_.push_back(base + name);
+    }
+  }
+  closedir(d);
+
+  // Replay in a stable order, readdir() does not give one.
+  std::sort(files_.begin(), files_.end());
+  next_ = 0;
+  current_ = 0;
+
+  return (int) files_.size();
+
+}
+
+int DirectoryFrameSource::get_image(int8_t* img) {
+
+  if (next_ == files_.size()) {
+    if (!loop_ || files_.empty()) {
+      return frame_source_end;
+    }
+    next_ = 0;
+  }
+
+  current_ = next_++;
+  const std::string& path = files_[current_];
+
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) {
+    return frame_source_error;
+  }
+
+  bool ok = ends_with(path, ".pgm") ? read_pgm(f, pixels_.data(), frame_size_) : read_raw(f, pixels_.data(), frame_size_);
+  fclose(f);
+
+  if (!ok) {
+    return frame_source_error;
+  }
+
+  // Same conversion the camera frames go through.
+  convert_frame_to_input(pixels_.data(), img, frame_size_);
+
+  return frame_source_ok;
+
+}
+
+constexpr uint32_t SyntheticFrameSource::period;
+
+/**
+ * @brief Small hash used as a stateless random number generator.
+ */
+static inline uint32_t mix(uint32_t x) {
+
+  x ^= x >> 16;
+  x *= 0x7feb352d;
+  x ^= x >> 15;
+  x *= 0x846ca68b;
+  x ^= x >> 16;
+  return x;
+
+}
+
+void SyntheticFrameSource::render(uint32_t index, int8_t* img) const {
+
+  uint32_t phase = index % period;
+
+  // The blob walks across the picture during the first half of the loop, and
+  // the room is empty during the second one.
+  bool busy = phase < period / 2;
+  int blob_w = width_ / 4;
+  int blob_h = height_ / 2;
+  int blob_x = (int) (phase * (width_ + blob_w) / (period / 2)) - blob_w;
+  int blob_y = height_ / 3;
+
+  uint32_t frame_seed = mix(seed_ ^ mix(index));
+
+  for (int y = 0; y < height_; y++) {
+    for (int x = 0; x < width_; x++) {
+      // Dim gradient plus a bit of sensor noise.
+      int pixel = 40 + (x + y) / 4 + (int) (mix(frame_seed + y * width_ + x) & 0xf);
+      if (busy && x >= blob_x && x < blob_x + blob_w && y >= blob_y && y < blob_y + blob_h) {
+        pixel += 140;
+      }
+      if (pixel > 255) {
+        pixel = 255;
+      }
+      img[y * width_ + x] = (int8_t) (pixel ^ 0x80);
+    }
+  }
+
+}
+
+int SyntheticFrameSource::get_image(int8_t* img) {
+
+  if (frames_ != 0 && next_ == frames_) {
+    return frame_source_end;
+  }
+
+  render(next_++, img);
+
+  return frame_source_ok;
+
+}
+
+int FaultyFrameSource::get_image(int8_t* img) {
+
+  if (failing_reinits_ > 0 || failing_reads_ > 0) {
+    if (failing_reads_ > 0) {
+      failing_reads_--;
+    }
+    faults_++;
+    return frame_source_error;
+  }
+
+  return source_->get_image(img);
+
+}
+
+void FaultyFrameSource::reinit() {
+
+  reinits_++;
+  if (failing_reinits_ > 0) {
+    failing_reinits_--;
+  }
+
+}
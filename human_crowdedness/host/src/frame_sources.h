@@ -0,0 +1,186 @@
+/**
+ * @file frame_sources.h
+ * @brief Frame sources that replace the camera on the host.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef HOST_FRAME_SOURCES_H_
+#define HOST_FRAME_SOURCES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "frame_source.h"
+
+/**
+ * @brief Replays the frames recorded in a directory.
+ *
+ * Every binary PGM (.pgm) or raw grayscale (.raw) file in the directory is a
+ * frame, and they are replayed in name order. A frame must have exactly the
+ * number of pixels of the model input, other files are ignored.
+ */
+class DirectoryFrameSource : public FrameSource {
+
+ public:
+
+  /**
+   * @brief Build the source.
+   *
+   * @param frame_size The number of pixels of every frame.
+   * @param loop Whether to start again from the first frame after the last.
+   */
+  DirectoryFrameSource(size_t frame_size, bool loop)
+      : frame_size_(frame_size), loop_(loop), pixels_(frame_size) {}
+
+  /**
+   * @brief List the frames of a directory.
+   *
+   * @param dir The directory.
+   *
+   * @returns The number of frames found, or -1 if it could not be read.
+   */
+  int open(const char* dir);
+
+  int get_image(int8_t* img) override;
+
+  /**
+   * @brief The path of the last frame given by get_image().
+   */
+  const std::string& current() const { return files_[current_]; }
+
+ private:
+
+  size_t frame_size_;
+  bool loop_;
+
+  std::vector<std::string> files_;
+  size_t next_ = 0;
+  size_t current_ = 0;
+
+  std::vector<uint8_t> pixels_;
+
+};
+
+/**
+ * @brief Generates a looping, reproducible scene.
+ *
+ * Renders a noisy background with a bright blob that walks in and out of the
+ * picture, so that the model gets a mix of empty and busy frames. Frame i is
+ * always the same for the same seed, whatever was generated before it.
+ */
+class SyntheticFrameSource : public FrameSource {
+
+ public:
+
+  /**
+   * @brief Build the source.
+   *
+   * @param width The width of the frames in pixels.
+   * @param height The height of the frames in pixels.
+   * @param frames How many frames to give before ending, 0 for no end.
+   * @param seed The seed of the noise.
+   */
+  SyntheticFrameSource(int width, int height, uint32_t frames, uint32_t seed)
+      : width_(width), height_(height), frames_(frames), seed_(seed) {}
+
+  int get_image(int8_t* img) override;
+
+  /**
+   * @brief Render one frame without moving to the next one.
+   *
+   * @param index The frame number.
+   * @param img Where the signed pixels will be stored.
+   */
+  void render(uint32_t index, int8_t* img) const;
+
+  /**
+   * @brief The number of frames in one loop of the scene.
+   */
+  static constexpr uint32_t period = 64;
+
+ private:
+
+  int width_;
+  int height_;
+  uint32_t frames_;
+  uint32_t seed_;
+
+  uint32_t next_ = 0;
+
+};
+
+/**
+ * @brief Wraps another source and makes it fail on purpose.
+ *
+ * Fails the way the camera does: a few reads that go wrong and then work
+ * again, or a driver that stays broken until it is restarted a number of
+ * times. The frames of the wrapped source are not consumed while failing.
+ */
+class FaultyFrameSource : public FrameSource {
+
+ public:
+
+  /**
+   * @brief Build the source.
+   *
+   * @param source The source that gives the frames when nothing fails. It must
+   * outlive this one.
+   */
+  explicit FaultyFrameSource(FrameSource* source) : source_(source) {}
+
+  int get_image(int8_t* img) override;
+
+  /**
+   * @brief Make the next reads fail, and then work again.
+   *
+   * @param reads How many reads will fail.
+   */
+  void fail_reads(uint32_t reads) { failing_reads_ = reads; }
+
+  /**
+   * @brief Make every read fail until the source is restarted.
+   *
+   * @param reinits How many restarts it takes to fix it.
+   */
+  void fail_until_reinits(uint32_t reinits) { failing_reinits_ = reinits; }
+
+  /**
+   * @brief Restart the source, as the camera driver is restarted.
+   */
+  void reinit();
+
+  /**
+   * @brief The number of reads that failed.
+   */
+  uint32_t faults() const { return faults_; }
+
+  /**
+   * @brief The number of restarts.
+   */
+  uint32_t reinits() const { return reinits_; }
+
+ private:
+
+  FrameSource* source_;
+
+  uint32_t failing_reads_ = 0;
+  uint32_t failing_reinits_ = 0;
+
+  uint32_t faults_ = 0;
+  uint32_t reinits_ = 0;
+
+};
+
+#endif  // HOST_FRAME_SOURCES_H_
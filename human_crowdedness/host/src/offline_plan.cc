@@ -0,0 +1,139 @@
+/**
+ * @file offline_plan.cc
+ * @brief Plans the tensors of a model on the host and embeds the plan in it.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include "offline_plan.h"
+
+#include <string.h>
+
+#include <memory>
+
+#include "flatbuffers/default_allocator.h"
+#include "flatbuffers/flatbuffers.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+
+// The name and version of the metadata read by micro_allocation_info.cc.
+static const char offline_plan_metadata[] = "OfflineMemoryAllocation";
+constexpr int32_t offline_plan_version = 1;
+
+/**
+ * @brief An interpreter that lets us look at its tensors once allocated.
+ */
+class PlanReader : public tflite::MicroInterpreter {
+
+ public:
+
+  using tflite::MicroInterpreter::MicroInterpreter;
+
+  TfLiteEvalTensor* eval_tensor(int index) {
+    return context().GetEvalTensor(&context(), index);
+  }
+
+};
+
+bool plan_tensor_offsets(const tflite::Model* model, const tflite::MicroOpResolver& resolver, tflite::MicroMemoryPlanner* planner, uint8_t* arena, size_t arena_size, std::vector<int32_t>* offsets, size_t* arena_used) {
+
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(arena, arena_size, planner);
+  if (allocator == nullptr) {
+    return false;
+  }
+
+  PlanReader interpreter(model, resolver, allocator);
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    return false;
+  }
+
+  // The plan starts at the head of the arena, where the allocator aligned the
+  // arena to. The planner cannot be asked for its size any more, as its
+  // scratch was in the arena, but the only other tensors in the arena are the
+  // variables at the tail.
+  const uint8_t* head = tflite::AlignPointerUp(arena, tflite::MicroArenaBufferAlignment());
+  const uint8_t* arena_end = arena + arena_size;
+
+  const auto* tensors = model->subgraphs()->Get(0)->tensors();
+  offsets->assign(tensors->size(), tflite::kOnlinePlannedBuffer);
+  for (size_t i = 0; i < tensors->size(); i++) {
+    const uint8_t* data = static_cast<const uint8_t*>(interpreter.eval_tensor(i)->data.data);
+    if (data >= head && data < arena_end && !tensors->Get(i)->is_variable()) {
+      (*offsets)[i] = data - head;
+    }
+  }
+  *arena_used = interpreter.arena_used_bytes();
+
+  return true;
+
+}
+
+bool embed_offline_plan(const uint8_t* model_data, size_t model_size, const std::vector<int32_t>& offsets, std::vector<uint8_t>* planned) {
+
+  flatbuffers::Verifier verifier(model_data, model_size);
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    return false;
+  }
+
+  std::unique_ptr<tflite::ModelT> model(tflite::GetModel(model_data)->UnPack());
+  if (model->subgraphs.empty() || model->subgraphs[0]->tensors.size() != offsets.size()) {
+    return false;
+  }
+
+  // Version, subgraph, number of tensors, and then their offsets.
+  std::vector<int32_t> words = {offline_plan_version, 0, (int32_t) offsets.size()};
+  words.insert(words.end(), offsets.begin(), offsets.end());
+  std::unique_ptr<tflite::BufferT> buffer(new tflite::BufferT());
+  buffer->data.resize(words.size() * sizeof(int32_t));
+  memcpy(buffer->data.data(), words.data(), buffer->data.size());
+
+  // A plan already there is replaced, the buffer it had is left unused.
+  tflite::MetadataT* metadata = nullptr;
+  for (auto& m : model->metadata) {
+    if (m->name == offline_plan_metadata) {
+      metadata = m.get();
+    }
+  }
+  if (metadata == nullptr) {
+    model->metadata.emplace_back(new tflite::MetadataT());
+    metadata = model->metadata.back().get();
+    metadata->name = offline_plan_metadata;
+  }
+  metadata->buffer = model->buffers.size();
+  model->buffers.push_back(std::move(buffer));
+
+  // This copy of flatbuffers has no allocator of its own.
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder builder(model_size + words.size() * sizeof(int32_t), &allocator);
+  tflite::FinishModelBuffer(builder, tflite::Model::Pack(builder, model.get()));
+  planned->assign(builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize());
+
+  return true;
+
+}
+
+void write_model_source(FILE* f, const std::vector<uint8_t>& model_data, const char* name, const char* what) {
+
+  fprintf(f, "// This is a TensorFlow Lite model file %s,\n", what);
+  fprintf(f, "// converted into a C data array.\n\n");
+  fprintf(f, "#include \"model.h\"\n\n");
+  fprintf(f, "// Keep model aligned to 8 bytes to guarantee aligned 64-bit accesses.\n");
+  fprintf(f, "alignas(8) const unsigned char %s[] = {", name);
+  for (size_t i = 0; i < model_data.size(); i++) {
+    fprintf(f, i % 13 == 0 ? "\n    0x%02x," : " 0x%02x,", model_data[i]);
+  }
+  fprintf(f, "\n};\n");
+  fprintf(f, "const int %s_len = %zu;\n", name, model_data.size());
+
+}
@@ -0,0 +1,80 @@
+/**
+ * @file offline_plan.h
+ * @brief Plans the tensors of a model on the host and embeds the plan in it.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef HOST_OFFLINE_PLAN_H_
+#define HOST_OFFLINE_PLAN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+/**
+ * @brief Where a memory planner puts the tensors of a model.
+ *
+ * Allocates the tensors of the model in the arena as AllocateTensors() does,
+ * with the given planner, and reads back where every tensor of the first
+ * subgraph ended up.
+ *
+ * @param model The model.
+ * @param resolver The operators of the model.
+ * @param planner The memory planner to allocate with. Its scratch is in the
+ * arena, so only what it keeps elsewhere, like the sizes SearchMemoryPlanner
+ * reports, can be asked afterwards.
+ * @param arena The arena to allocate in.
+ * @param arena_size The size of the arena in bytes.
+ * @param offsets Gets the offset of every tensor from the start of the planned
+ * memory, or -1 for the tensors the planner did not place (constant,
+ * variable and unused ones).
+ * @param arena_used Gets how much of the arena the interpreter used.
+ *
+ * @returns False if the tensors could not be allocated.
+ */
+bool plan_tensor_offsets(const tflite::Model* model, const tflite::MicroOpResolver& resolver, tflite::MicroMemoryPlanner* planner, uint8_t* arena, size_t arena_size, std::vector<int32_t>* offsets, size_t* arena_used);
+
+/**
+ * @brief Copy a model with offline planned tensors.
+ *
+ * Adds (or replaces) the "OfflineMemoryAllocation" metadata, which the
+ * allocator takes as the offsets of the tensors instead of planning them.
+ *
+ * @param model_data The flatbuffer of the model.
+ * @param model_size The size of the flatbuffer in bytes.
+ * @param offsets The offset of every tensor of the first subgraph, from
+ * plan_tensor_offsets().
+ * @param planned Gets the flatbuffer of the planned model.
+ *
+ * @returns False if the model is not valid or the offsets are not one per
+ * tensor.
+ */
+bool embed_offline_plan(const uint8_t* model_data, size_t model_size, const std::vector<int32_t>& offsets, std::vector<uint8_t>* planned);
+
+/**
+ * @brief Write a model as a C source file, like main/model.cc.
+ *
+ * @param f Where to write.
+ * @param model_data The flatbuffer of the model.
+ * @param name The name of the array, whose length is in name##_len.
+ * @param what What was done to the model, for the comment at the top, like
+ * "with its tensors planned offline by plan_memory".
+ */
+void write_model_source(FILE* f, const std::vector<uint8_t>& model_data, const char* name, const char* what);
+
+#endif  // HOST_OFFLINE_PLAN_H_
@@ -0,0 +1,127 @@
+/**
+ * @file plan_memory.cc
+ * @brief Plans the tensors of the person detection model offline.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Searches a plan for the tensors of the model with SearchMemoryPlanner, with
+ * as many tries as we like as it runs on the host, and writes the model with
+ * the plan in its metadata. The board then takes the offsets as they are,
+ * whatever planner it has. To use it, replace main/model.cc with the source
+ * written by -c.
+ *
+ * Usage: plan_memory [options]
+ *
+ *   -a bytes       Size of the tensor arena (default: 112 KB).
+ *   -i iterations  Swaps tried after the fixed orders (default: 4096).
+ *   -o file        Write the planned model as a .tflite file.
+ *   -c file        Write the planned model as a C source file.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "model.h"
+#include "offline_plan.h"
+#include "tensorflow/lite/micro/memory_planner/search_memory_planner.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+// The same as person_detect_replay.
+constexpr size_t default_arena_size = 112 * 1024;
+
+constexpr int default_iterations = 4096;
+
+static void usage(const char* name) {
+
+  fprintf(stderr, "Usage: %s [-a bytes] [-i iterations] [-o file] [-c file]\n", name);
+
+}
+
+int main(int argc, char** argv) {
+
+  size_t arena_size = default_arena_size;
+  int iterations = default_iterations;
+  const char* model_path = nullptr;
+  const char* source_path = nullptr;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "a:i:o:c:")) != -1) {
+    switch (opt) {
+      case 'a': arena_size = strtoul(optarg, nullptr, 10); break;
+      case 'i': iterations = atoi(optarg); break;
+      case 'o': model_path = optarg; break;
+      case 'c': source_path = optarg; break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+  if (optind != argc) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  // The same operators as PersonDetector.
+  tflite::MicroMutableOpResolver<5> resolver;
+  resolver.AddAveragePool2D();
+  resolver.AddConv2D();
+  resolver.AddDepthwiseConv2D();
+  resolver.AddReshape();
+  resolver.AddSoftmax();
+
+  std::vector<uint8_t> arena(arena_size + tflite::MicroArenaBufferAlignment());
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+  tflite::SearchMemoryPlanner planner(iterations);
+  std::vector<int32_t> offsets;
+  size_t arena_used;
+  if (!plan_tensor_offsets(model, resolver, &planner, arena.data(), arena.size(), &offsets, &arena_used)) {
+    fprintf(stderr, "Could not allocate the tensors in %zu bytes\n", arena_size);
+    return 1;
+  }
+
+  int planned_tensors = 0;
+  for (int32_t offset : offsets) {
+    planned_tensors += offset != tflite::kOnlinePlannedBuffer;
+  }
+  printf("%d of %zu tensors planned in %zu bytes (largest first: %zu, at least: %zu), %zu bytes of arena used\n",
+         planned_tensors, offsets.size(), planner.GetMaximumMemorySize(),
+         planner.GetSizeOrderMemorySize(), planner.GetLowerBound(), arena_used);
+
+  std::vector<uint8_t> planned;
+  if (!embed_offline_plan(g_person_detect_model_data, g_person_detect_model_data_len, offsets, &planned)) {
+    fprintf(stderr, "Could not add the plan to the model\n");
+    return 1;
+  }
+
+  if (model_path) {
+    FILE* f = fopen(model_path, "wb");
+    if (!f || fwrite(planned.data(), 1, planned.size(), f) != planned.size()) {
+      fprintf(stderr, "Could not write %s\n", model_path);
+      return 1;
+    }
+    fclose(f);
+  }
+
+  if (source_path) {
+    FILE* f = fopen(source_path, "w");
+    if (!f) {
+      fprintf(stderr, "Could not write %s\n", source_path);
+      return 1;
+    }
+    write_model_source(f, planned, "g_person_detect_model_data", "with its tensors planned offline by plan_memory");
+    fclose(f);
+  }
+
+  return 0;
+
+}
@@ -0,0 +1,253 @@
+/**
+ * @file replay.cc
+ * @brief Replays recorded or synthetic frames through the person detector.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Usage: person_detect_replay [options] <frames directory | synthetic>
+ *
+ *   -n frames     Stop after this many frames (default: all of the directory,
+ *                 1000 synthetic ones).
+ *   -l            Loop over the directory until -n frames were replayed.
+ *   -a bytes      Size of the tensor arena (default: 112 KB).
+ *   -r file       Record the people score of every frame in a file.
+ *   -b file       Compare the people scores against the ones in a file.
+ *   -t tolerance  Fail if a score drifts more than this from the baseline.
+ *   -j workers    Split the big convolutions with this many more threads
+ *                 (default: 0, at most 3).
+ *   -p file       Write the statistics of every operator in a JSON file.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "frame_source.h"
+#include "frame_sources.h"
+#include "person_detector.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
+#include "tensorflow/lite/micro/micro_stats_profiler.h"
+
+// A bit more than alloc_size in main.cc (96 KB), as the interpreter structures
+// in the arena are full of pointers, which are twice as big on the host.
+constexpr size_t default_arena_size = 112 * 1024;
+
+// Same as the input of the model.
+constexpr int frame_width = 96;
+constexpr int frame_height = 96;
+
+// More than the operators of the model, and room for their report.
+constexpr int max_profiled_nodes = 64;
+constexpr size_t profile_report_size = 16 * 1024;
+
+/**
+ * @brief Load the scores of a previous run.
+ *
+ * @returns False if the file could not be read.
+ */
+static bool load_scores(const char* path, std::vector<float>* scores) {
+
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    return false;
+  }
+
+  float score;
+  while (fscanf(f, "%f", &score) == 1) {
+    scores->push_back(score);
+  }
+  fclose(f);
+
+  return true;
+
+}
+
+static void usage(const char* name) {
+
+  fprintf(stderr, "Usage: %s [-n frames] [-l] [-a bytes] [-r file] [-b file] [-t tolerance] [-j workers] [-p file] <frames directory | synthetic>\n", name);
+
+}
+
+int main(int argc, char** argv) {
+
+  long max_frames = -1;
+  bool loop = false;
+  size_t arena_size = default_arena_size;
+  const char* record_path = nullptr;
+  const char* baseline_path = nullptr;
+  float tolerance = 0.0f;
+  int workers = 0;
+  const char* profile_path = nullptr;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:la:r:b:t:j:p:")) != -1) {
+    switch (opt) {
+      case 'n': max_frames = atol(optarg); break;
+      case 'l': loop = true; break;
+      case 'a': arena_size = (size_t) atol(optarg); break;
+      case 'r': record_path = optarg; break;
+      case 'b': baseline_path = optarg; break;
+      case 't': tolerance = (float) atof(optarg); break;
+      case 'j': workers = atoi(optarg); break;
+      case 'p': profile_path = optarg; break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+  if (optind != argc - 1) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  // Pick where the frames come from.
+  std::unique_ptr<FrameSource> source;
+  std::string input_name(argv[optind]);
+  if (input_name == "synthetic") {
+    if (max_frames < 0) {
+      max_frames = 1000;
+    }
+    source.reset(new SyntheticFrameSource(frame_width, frame_height, 0, 1));
+  } else {
+    DirectoryFrameSource* dir = new DirectoryFrameSource(frame_width * frame_height, loop);
+    source.reset(dir);
+    int found = dir->open(input_name.c_str());
+    if (found <= 0) {
+      fprintf(stderr, "No frames found in %s\n", input_name.c_str());
+      return 1;
+    }
+    if (loop && max_frames < 0) {
+      max_frames = found;
+    }
+  }
+
+  std::vector<float> baseline;
+  if (baseline_path && !load_scores(baseline_path, &baseline)) {
+    fprintf(stderr, "Cannot read the baseline %s\n", baseline_path);
+    return 1;
+  }
+
+  FILE* record = nullptr;
+  if (record_path && !(record = fopen(record_path, "w"))) {
+    fprintf(stderr, "Cannot write the scores to %s\n", record_path);
+    return 1;
+  }
+
+  // The convolutions are split when they are prepared, so the workers go first.
+  if (!tflite::StartEspNnWorkers(workers)) {
+    fprintf(stderr, "Cannot start %d workers\n", workers);
+    return 1;
+  }
+
+  // Build the detector like the board does, timing every operator if asked.
+  std::unique_ptr<tflite::MicroNodeStats[]> node_stats(new tflite::MicroNodeStats[max_profiled_nodes]);
+  tflite::MicroStatsProfiler profiler(node_stats.get(), max_profiled_nodes);
+  std::unique_ptr<uint8_t[]> arena(new uint8_t[arena_size]);
+  PersonDetector detector;
+  int status = detector.init(arena.get(), arena_size, profile_path ? &profiler : nullptr);
+  if (status != person_detector_ok) {
+    fprintf(stderr, "Detector init failed (%d)\n", status);
+    return 1;
+  }
+
+  long frames = 0;
+  long people = 0;
+  long compared = 0;
+  double drift_sum = 0;
+  float drift_max = 0;
+  double invoke_ns = 0;
+
+  auto start = std::chrono::steady_clock::now();
+
+  while (max_frames < 0 || frames < max_frames) {
+
+    status = source->get_image(detector.input());
+    if (status == frame_source_end) {
+      break;
+    }
+    if (status != frame_source_ok) {
+      fprintf(stderr, "Frame %ld could not be read\n", frames);
+      return 1;
+    }
+
+    float score = 0;
+    auto invoke_start = std::chrono::steady_clock::now();
+    if (detector.invoke(&score) != person_detector_ok) {
+      fprintf(stderr, "Prediction failed on frame %ld\n", frames);
+      return 1;
+    }
+    invoke_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - invoke_start).count();
+
+    if (score >= 0.5f) {
+      people++;
+    }
+
+    if (record) {
+      // Enough digits to read back exactly the same float.
+      fprintf(record, "%.9g\n", score);
+    }
+
+    if ((size_t) frames < baseline.size()) {
+      float drift = fabsf(score - baseline[frames]);
+      drift_sum += drift;
+      drift_max = drift > drift_max ? drift : drift_max;
+      compared++;
+    }
+
+    frames++;
+
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (record) {
+    fclose(record);
+  }
+
+  printf("frames:       %ld\n", frames);
+  printf("people:       %ld\n", people);
+  printf("arena used:   %zu bytes\n", detector.arena_used_bytes());
+  printf("time:         %.3f s\n", seconds);
+  printf("frames/sec:   %.1f\n", frames / seconds);
+  printf("invoke:       %.1f us/frame\n", frames ? invoke_ns / frames / 1000 : 0);
+  printf("workers:      %d\n", tflite::EspNnWorkerCount());
+
+  if (profile_path) {
+    std::unique_ptr<char[]> report(new char[profile_report_size]);
+    size_t len = profiler.WriteJson(report.get(), profile_report_size);
+    FILE* f = fopen(profile_path, "w");
+    if (len == 0 || !f || fwrite(report.get(), 1, len, f) != len) {
+      fprintf(stderr, "Cannot write the profile to %s\n", profile_path);
+      if (f) {
+        fclose(f);
+      }
+      return 1;
+    }
+    fclose(f);
+    printf("profiled:     %d operators\n", profiler.num_nodes());
+  }
+
+  if (baseline_path) {
+    printf("compared:     %ld\n", compared);
+    printf("drift mean:   %.6f\n", compared ? drift_sum / compared : 0);
+    printf("drift max:    %.6f\n", drift_max);
+    if (compared != frames || drift_max > tolerance) {
+      printf("FAIL: scores drifted from the baseline\n");
+      return 1;
+    }
+  }
+
+  return 0;
+
+}
@@ -0,0 +1,233 @@
+/**
+ * @file sparse_model.cc
+ * @brief Stores the pruned filters of a model sparse, on the host.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include "sparse_model.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <memory>
+
+#include <esp_nn.h>
+
+#include "flatbuffers/default_allocator.h"
+#include "flatbuffers/flatbuffers.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+/**
+ * @brief Whether a tensor has constant data of its whole shape.
+ */
+static bool has_data(const tflite::ModelT& model, const tflite::TensorT& tensor, size_t bytes) {
+
+  return tensor.buffer > 0 && tensor.buffer < model.buffers.size() &&
+         model.buffers[tensor.buffer]->data.size() == bytes;
+
+}
+
+/**
+ * @brief The filters the ESP-NN kernels can run sparse.
+ *
+ * Int8 filters of 1x1 CONV_2D without dilation and of FULLY_CONNECTED, on int8
+ * inputs, without zero points, that are dense yet, and that are the only
+ * tensor of their buffer and the input of no other operator.
+ */
+static std::vector<tflite::TensorT*> sparse_candidates(tflite::ModelT* model) {
+
+  std::vector<int> buffer_tensors(model->buffers.size());
+  for (auto& subgraph : model->subgraphs) {
+    for (auto& tensor : subgraph->tensors) {
+      if (tensor->buffer < buffer_tensors.size()) {
+        buffer_tensors[tensor->buffer]++;
+      }
+    }
+  }
+
+  std::vector<tflite::TensorT*> candidates;
+  for (auto& subgraph : model->subgraphs) {
+    std::vector<int> uses(subgraph->tensors.size());
+    for (auto& op : subgraph->operators) {
+      for (int input : op->inputs) {
+        if (input >= 0) {
+          uses[input]++;
+        }
+      }
+    }
+
+    for (auto& op : subgraph->operators) {
+      const tflite::BuiltinOperator code = tflite::GetBuiltinCode(model->operator_codes[op->opcode_index].get());
+      if (op->inputs.size() < 2 || op->inputs[0] < 0 || op->inputs[1] < 0) {
+        continue;
+      }
+      const tflite::TensorT& input = *subgraph->tensors[op->inputs[0]];
+      tflite::TensorT* filter = subgraph->tensors[op->inputs[1]].get();
+      const std::vector<int32_t>& shape = filter->shape;
+
+      if (code == tflite::BuiltinOperator_CONV_2D) {
+        const tflite::Conv2DOptionsT* options = op->builtin_options.AsConv2DOptions();
+        if (shape.size() != 4 || shape[1] != 1 || shape[2] != 1 || options == nullptr ||
+            options->dilation_w_factor != 1 || options->dilation_h_factor != 1) {
+          continue;
+        }
+      } else if (code == tflite::BuiltinOperator_FULLY_CONNECTED) {
+        const tflite::FullyConnectedOptionsT* options = op->builtin_options.AsFullyConnectedOptions();
+        if (shape.size() != 2 || (options != nullptr &&
+            options->weights_format != tflite::FullyConnectedOptionsWeightsFormat_DEFAULT)) {
+          continue;
+        }
+      } else {
+        continue;
+      }
+
+      size_t weights = 1;
+      for (int32_t dim : shape) {
+        weights *= dim;
+      }
+      if (input.type != tflite::TensorType_INT8 || filter->type != tflite::TensorType_INT8 ||
+          filter->sparsity != nullptr || !has_data(*model, *filter, weights) ||
+          uses[op->inputs[1]] != 1 || buffer_tensors[filter->buffer] != 1) {
+        continue;
+      }
+      if (filter->quantization != nullptr &&
+          std::any_of(filter->quantization->zero_point.begin(), filter->quantization->zero_point.end(),
+                      [](int64_t zero_point) { return zero_point != 0; })) {
+        continue;
+      }
+      candidates.push_back(filter);
+    }
+  }
+  return candidates;
+
+}
+
+/**
+ * @brief Pack a model back into a flatbuffer.
+ */
+static void pack_model(tflite::ModelT* model, size_t size_hint, std::vector<uint8_t>* out) {
+
+  // This copy of flatbuffers has no allocator of its own.
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder builder(size_hint, &allocator);
+  tflite::FinishModelBuffer(builder, tflite::Model::Pack(builder, model));
+  out->assign(builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize());
+
+}
+
+static std::unique_ptr<tflite::ModelT> unpack_model(const uint8_t* model_data, size_t model_size) {
+
+  flatbuffers::Verifier verifier(model_data, model_size);
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    return nullptr;
+  }
+  return std::unique_ptr<tflite::ModelT>(tflite::GetModel(model_data)->UnPack());
+
+}
+
+bool prune_model_filters(const uint8_t* model_data, size_t model_size, int percent, std::vector<uint8_t>* pruned) {
+
+  std::unique_ptr<tflite::ModelT> model = unpack_model(model_data, model_size);
+  if (model == nullptr) {
+    return false;
+  }
+
+  for (tflite::TensorT* filter : sparse_candidates(model.get())) {
+    std::vector<uint8_t>& data = model->buffers[filter->buffer]->data;
+    int8_t* weights = reinterpret_cast<int8_t*>(data.data());
+    std::vector<size_t> order(data.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [weights](size_t a, size_t b) {
+      return abs(weights[a]) < abs(weights[b]);
+    });
+    for (size_t i = 0; i < order.size() * percent / 100; i++) {
+      weights[order[i]] = 0;
+    }
+  }
+
+  pack_model(model.get(), model_size, pruned);
+  return true;
+
+}
+
+bool sparsify_model(const uint8_t* model_data, size_t model_size, std::vector<uint8_t>* sparse, SparseModelStats* stats) {
+
+  std::unique_ptr<tflite::ModelT> model = unpack_model(model_data, model_size);
+  if (model == nullptr) {
+    return false;
+  }
+
+  SparseModelStats done = {};
+  for (tflite::TensorT* filter : sparse_candidates(model.get())) {
+    done.filters++;
+    std::vector<uint8_t>& data = model->buffers[filter->buffer]->data;
+    const int8_t* weights = reinterpret_cast<const int8_t*>(data.data());
+    const int dims = filter->shape.size();
+    const int32_t row_len = filter->shape[dims - 1];
+    const int32_t rows = data.size() / row_len;
+    const int32_t size = esp_nn_get_sparse_s8_size(weights, rows, row_len);
+    if (size == 0) {
+      continue;
+    }
+
+    // Encoded with room for every weight, then cut to the ones kept.
+    tflite::Int32VectorT row_start;
+    row_start.values.resize(rows + 1);
+    std::vector<int8_t> values(data.size());
+    std::unique_ptr<tflite::DimensionMetadataT> csr(new tflite::DimensionMetadataT());
+    csr->format = tflite::DimensionType_SPARSE_CSR;
+    if (row_len <= UINT8_MAX + 1) {
+      tflite::Uint8VectorT cols;
+      cols.values.resize(data.size());
+      esp_nn_encode_sparse_s8(weights, rows, row_len, row_start.values.data(), cols.values.data(), values.data());
+      cols.values.resize(row_start.values[rows]);
+      csr->array_indices.Set(std::move(cols));
+    } else {
+      tflite::Uint16VectorT cols;
+      cols.values.resize(data.size());
+      esp_nn_encode_sparse_s8(weights, rows, row_len, row_start.values.data(), cols.values.data(), values.data());
+      cols.values.resize(row_start.values[rows]);
+      csr->array_indices.Set(std::move(cols));
+    }
+    values.resize(row_start.values[rows]);
+    csr->array_segments.Set(std::move(row_start));
+
+    // Rows in the order of the shape, the last dimension compressed.
+    std::unique_ptr<tflite::SparsityParametersT> sparsity(new tflite::SparsityParametersT());
+    for (int i = 0; i < dims; i++) {
+      sparsity->traversal_order.push_back(i);
+      if (i < dims - 1) {
+        std::unique_ptr<tflite::DimensionMetadataT> dense(new tflite::DimensionMetadataT());
+        dense->format = tflite::DimensionType_DENSE;
+        dense->dense_size = filter->shape[i];
+        sparsity->dim_metadata.push_back(std::move(dense));
+      }
+    }
+    sparsity->dim_metadata.push_back(std::move(csr));
+    filter->sparsity = std::move(sparsity);
+
+    done.sparse_filters++;
+    done.dense_bytes += data.size();
+    done.sparse_bytes += size;
+    data.assign(values.begin(), values.end());
+  }
+
+  pack_model(model.get(), model_size, sparse);
+  if (stats != nullptr) {
+    *stats = done;
+  }
+  return true;
+
+}
@@ -0,0 +1,72 @@
+/**
+ * @file sparse_model.h
+ * @brief Stores the pruned filters of a model sparse, on the host.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef HOST_SPARSE_MODEL_H_
+#define HOST_SPARSE_MODEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+/**
+ * @brief What sparsify_model() did to a model.
+ */
+typedef struct {
+
+  int filters;            /*!< Filters the ESP-NN kernels can run sparse. */
+  int sparse_filters;     /*!< Of those, the ones stored sparse. */
+  size_t dense_bytes;     /*!< Bytes of the sparse filters when they were dense. */
+  size_t sparse_bytes;    /*!< Bytes of their rows, columns and values now. */
+
+} SparseModelStats;
+
+/**
+ * @brief Copy a model with its filters pruned by magnitude.
+ *
+ * Sets to 0 the `percent` percent of the weights with the smallest magnitude
+ * of every filter that sparsify_model() would consider. This is only good to
+ * measure what sparse filters save, the accuracy of a model pruned this way is
+ * not looked after, which pruning while training does.
+ *
+ * @param model_data The flatbuffer of the model.
+ * @param model_size The size of the flatbuffer in bytes.
+ * @param percent The percentage of zeros of every filter.
+ * @param pruned Gets the flatbuffer of the pruned model.
+ *
+ * @returns False if the model is not valid.
+ */
+bool prune_model_filters(const uint8_t* model_data, size_t model_size, int percent, std::vector<uint8_t>* pruned);
+
+/**
+ * @brief Copy a model with its pruned filters stored sparse.
+ *
+ * The int8 filters of 1x1 CONV_2D and FULLY_CONNECTED operators on int8
+ * inputs, without zero points, are encoded as esp_nn_encode_sparse_s8() does
+ * when at least ESP_NN_SPARSE_MIN_ZERO_WEIGHTS percent of their weights are 0
+ * and the encoding is smaller. The rows and columns go into the sparsity
+ * parameters of the tensor, CSR on its last dimension, and its buffer keeps
+ * only the values other than 0, which the ESP-NN kernels read where they are.
+ *
+ * @param model_data The flatbuffer of the model.
+ * @param model_size The size of the flatbuffer in bytes.
+ * @param sparse Gets the flatbuffer of the sparse model.
+ * @param stats Gets what was done, can be nullptr.
+ *
+ * @returns False if the model is not valid.
+ */
+bool sparsify_model(const uint8_t* model_data, size_t model_size, std::vector<uint8_t>* sparse, SparseModelStats* stats);
+
+#endif  // HOST_SPARSE_MODEL_H_
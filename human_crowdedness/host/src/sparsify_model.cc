@@ -0,0 +1,133 @@
+/**
+ * @file sparsify_model.cc
+ * @brief Stores the pruned filters of the person detection model sparse.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Encodes the pruned 1x1 convolution and fully connected filters of the model
+ * without their zeros, in the sparsity parameters of their tensors, so that
+ * the smaller filters are what goes to flash and the ESP-NN kernels read them
+ * there, with no copy in the arena. Filters with too few zeros stay dense. To
+ * use it, replace main/model.cc with the source written by -c, and size the
+ * arena again with arena_size.
+ *
+ * Usage: sparsify_model [options]
+ *
+ *   -m file        Read the model from a .tflite file instead of main/model.cc.
+ *   -z percent     Prune every filter by magnitude to this percentage of zeros
+ *                  first, to measure what sparse filters save. The model is not
+ *                  retrained, so do not ship it.
+ *   -o file        Write the sparse model as a .tflite file.
+ *   -c file        Write the sparse model as a C source file.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "model.h"
+#include "offline_plan.h"
+#include "sparse_model.h"
+
+static void usage(const char* name) {
+
+  fprintf(stderr, "Usage: %s [-m file] [-z percent] [-o file] [-c file]\n", name);
+
+}
+
+static bool read_file(const char* path, std::vector<uint8_t>* data) {
+
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    return false;
+  }
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+    data->insert(data->end(), chunk, chunk + n);
+  }
+  fclose(f);
+  return !data->empty();
+
+}
+
+int main(int argc, char** argv) {
+
+  const char* input_path = nullptr;
+  int prune_percent = -1;
+  const char* model_path = nullptr;
+  const char* source_path = nullptr;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "m:z:o:c:")) != -1) {
+    switch (opt) {
+      case 'm': input_path = optarg; break;
+      case 'z': prune_percent = atoi(optarg); break;
+      case 'o': model_path = optarg; break;
+      case 'c': source_path = optarg; break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+  if (optind != argc || prune_percent > 100) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> model;
+  if (!input_path) {
+    model.assign(g_person_detect_model_data, g_person_detect_model_data + g_person_detect_model_data_len);
+  } else if (!read_file(input_path, &model)) {
+    fprintf(stderr, "Could not read %s\n", input_path);
+    return 1;
+  }
+
+  if (prune_percent >= 0) {
+    std::vector<uint8_t> pruned;
+    if (!prune_model_filters(model.data(), model.size(), prune_percent, &pruned)) {
+      fprintf(stderr, "Could not prune the model\n");
+      return 1;
+    }
+    model.swap(pruned);
+  }
+
+  std::vector<uint8_t> sparse;
+  SparseModelStats stats;
+  if (!sparsify_model(model.data(), model.size(), &sparse, &stats)) {
+    fprintf(stderr, "Could not read the model\n");
+    return 1;
+  }
+  printf("%d of %d filters sparse, %zu bytes of weights in %zu, model %zu bytes from %zu\n",
+         stats.sparse_filters, stats.filters, stats.dense_bytes, stats.sparse_bytes, sparse.size(), model.size());
+
+  if (model_path) {
+    FILE* f = fopen(model_path, "wb");
+    if (!f || fwrite(sparse.data(), 1, sparse.size(), f) != sparse.size()) {
+      fprintf(stderr, "Could not write %s\n", model_path);
+      return 1;
+    }
+    fclose(f);
+  }
+
+  if (source_path) {
+    FILE* f = fopen(source_path, "w");
+    if (!f) {
+      fprintf(stderr, "Could not write %s\n", source_path);
+      return 1;
+    }
+    write_model_source(f, sparse, "g_person_detect_model_data", "with its pruned filters stored sparse by sparsify_model");
+    fclose(f);
+  }
+
+  return 0;
+
+}
@@ -0,0 +1,140 @@
+/**
+ * @file test_crowd_classifier.cc
+ * @brief Checks the smoothing and the hysteresis of the crowdedness verdict.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <math.h>
+#include <stdio.h>
+
+#include "crowd_classifier.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+static int test_single_frame_window() {
+
+  // With a window of one frame only the hysteresis is left.
+  CrowdClassifier<1> classifier;
+  CrowdEvent event;
+
+  CHECK(classifier.state() == crowd_empty);
+  CHECK(!classifier.update(0.3f, &event));
+  CHECK(classifier.update(0.5f, &event));
+  CHECK(event.from == crowd_empty && event.to == crowd_some && event.frame == 1);
+
+  // Going a bit below the enter threshold is not enough to leave.
+  CHECK(!classifier.update(0.45f, &event));
+  CHECK(classifier.update(0.39f, &event));
+  CHECK(event.to == crowd_empty);
+
+  // Straight to full and back down through both exits.
+  CHECK(classifier.update(0.9f, &event));
+  CHECK(event.from == crowd_empty && event.to == crowd_full);
+  CHECK(!classifier.update(0.6f, &event));
+  CHECK(classifier.update(0.5f, &event));
+  CHECK(event.to == crowd_some);
+  CHECK(classifier.update(0.7f, &event));
+  CHECK(event.to == crowd_full);
+  CHECK(classifier.update(0.1f, &event));
+  CHECK(event.from == crowd_full && event.to == crowd_empty);
+
+  // Out of range scores are clamped.
+  CHECK(classifier.update(7.0f, &event));
+  CHECK(classifier.smoothed_score() == 1.0f);
+  CHECK(classifier.update(NAN, &event));
+  CHECK(classifier.smoothed_score() == 0.0f);
+
+  return 0;
+
+}
+
+static int test_window() {
+
+  CrowdClassifier<4> classifier;
+  CrowdEvent event;
+
+  // A single busy frame in an empty room is not enough.
+  CHECK(!classifier.update(0.0f, &event));
+  CHECK(!classifier.update(0.0f, &event));
+  CHECK(!classifier.update(0.0f, &event));
+  CHECK(!classifier.update(0.0f, &event));
+  CHECK(!classifier.update(1.0f, &event));
+  CHECK(fabsf(classifier.smoothed_score() - 0.25f) < 1e-4f);
+
+  // But two out of the last four are, and three are a full room.
+  CHECK(classifier.update(1.0f, &event));
+  CHECK(event.to == crowd_some);
+  CHECK(classifier.update(1.0f, &event));
+  CHECK(event.to == crowd_full && fabsf(event.score - 0.75f) < 1e-4f);
+
+  // A score that flickers around the old 0.5 threshold every frame gives a
+  // single event, where the frame by frame verdict would change every time.
+  classifier.reset();
+  int events = 0;
+  int raw_changes = 0;
+  int raw_result = 0;
+  for (int i = 0; i < 1000; i++) {
+    float score = (i % 2) ? 0.56f : 0.46f;
+    int result = score >= 0.5f ? 1 : 0;
+    raw_changes += result != raw_result;
+    raw_result = result;
+    events += classifier.update(score, &event);
+  }
+  CHECK(raw_changes == 999);
+  CHECK(events == 1 && classifier.state() == crowd_some);
+
+  // Millions of frames later the running sum has not drifted.
+  for (int i = 0; i < 3000000; i++) {
+    classifier.update((i % 256) / 255.0f, &event);
+  }
+  for (int i = 0; i < 4; i++) {
+    classifier.update(0.25f, &event);
+  }
+  CHECK(fabsf(classifier.smoothed_score() - 0.25f) < 1e-4f);
+  CHECK(classifier.state() == crowd_empty);
+
+  return 0;
+
+}
+
+static int test_thresholds() {
+
+  // Custom thresholds are honoured.
+  CrowdThresholds thresholds = {0.2f, 0.1f, 0.3f, 0.25f};
+  CrowdClassifier<1> classifier(thresholds);
+  CrowdEvent event;
+
+  CHECK(classifier.update(0.2f, &event) && event.to == crowd_some);
+  CHECK(classifier.update(0.3f, &event) && event.to == crowd_full);
+  CHECK(!classifier.update(0.26f, &event));
+  CHECK(classifier.update(0.0f, &event) && event.to == crowd_empty);
+
+  return 0;
+
+}
+
+int main() {
+
+  if (test_single_frame_window() || test_window() || test_thresholds()) {
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
@@ -0,0 +1,175 @@
+/**
+ * @file test_deferred_log.cc
+ * @brief Checks the log ring, its formatting and the removal of levels.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// Debug messages are removed from this file.
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+#include "deferred_log.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+/**
+ * @brief Clock that only moves when told to.
+ */
+class MockClock : public Clock {
+
+ public:
+
+  uint64_t now_us() override { return now_; }
+
+  uint64_t now_ = 0;
+
+};
+
+/**
+ * @brief Keeps the lines it gets.
+ */
+class LineCollector : public LogWriter {
+
+ public:
+
+  void write(const char* line, size_t len) override { lines.push_back(std::string(line, len)); }
+
+  std::vector<std::string> lines;
+
+};
+
+static int side_effects = 0;
+
+static int count_side_effect() {
+  return ++side_effects;
+}
+
+static int test_format() {
+
+  MockClock clock;
+  DeferredLog<8> log(&clock);
+  LineCollector out;
+
+  clock.now_ = 12345678;
+  CHECK(DLOG_INFO(log, "score %.1f%% after %u frames", 0.4567f * 100, (size_t) 42));
+  clock.now_ = 2000000;
+  CHECK(DLOG_WARN(log, "%s %d %05d %x", "state", -3, 17, 255u));
+  CHECK(DLOG_ERROR(log, "%lu, then too few: %d %d", 7ul, 1));
+  CHECK(DLOG_INFO(log, "one character %c", 'k'));
+  CHECK(log.size() == 4);
+
+  CHECK(log.drain(&out) == 4 && log.size() == 0);
+  CHECK(out.lines.size() == 4);
+  CHECK(out.lines[0] == "[I 12.345] score 45.7% after 42 frames\n");
+  CHECK(out.lines[1] == "[W 2.000] state -3 00017 ff\n");
+  CHECK(out.lines[2] == "[E 2.000] 7, then too few: 1 \n");
+  CHECK(out.lines[3] == "[I 2.000] one character k\n");
+
+  // Lines that do not fit are cut, but still end in a newline.
+  LogRecord record = {0, "%s and more", DLOG_LEVEL_INFO, 1, {}};
+  record.args[0].s = "a message much longer than the line";
+  char line[24];
+  size_t len = log_format(record, line, sizeof(line));
+  CHECK(len == sizeof(line) - 1 && line[len - 1] == '\n' && line[len] == '\0');
+  CHECK(strncmp(line, "[I 0.000] a message", 19) == 0);
+
+  // Messages above the level are not even evaluated.
+  DLOG_DEBUG(log, "%d", count_side_effect());
+  CHECK(side_effects == 0 && log.size() == 0);
+  DLOG_INFO(log, "%d", count_side_effect());
+  CHECK(side_effects == 1 && log.size() == 1);
+
+  return 0;
+
+}
+
+static int test_full() {
+
+  DeferredLog<4> log;
+  LineCollector out;
+
+  // The ring never blocks: what does not fit is dropped, and reported.
+  for (int i = 0; i < 6; i++) {
+    CHECK(DLOG_INFO(log, "message %d", i) == (i < 4));
+  }
+  CHECK(log.dropped() == 2);
+
+  CHECK(log.drain(&out, 2) == 2);
+  CHECK(out.lines.size() == 3);
+  CHECK(out.lines[0] == "[W 0.000] 2 log messages dropped\n");
+  CHECK(out.lines[1] == "[I 0.000] message 0\n");
+
+  CHECK(DLOG_INFO(log, "message %d", 6));
+  CHECK(log.drain(&out) == 3);
+  CHECK(out.lines.size() == 6);
+  CHECK(out.lines[5] == "[I 0.000] message 6\n");
+
+  return 0;
+
+}
+
+static int test_threads() {
+
+  // One task logs as fast as it can while another drains, nothing is lost or
+  // reordered apart from the dropped messages.
+  constexpr uint32_t messages = 20000;
+  DeferredLog<64> log;
+
+  std::thread producer([&log] {
+    for (uint32_t i = 0; i < messages; i++) {
+      while (!DLOG_INFO(log, "%u", i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t expected = 0;
+  bool ordered = true;
+  LogRecord record;
+  while (expected < messages) {
+    if (log.pop(&record)) {
+      ordered = ordered && record.argc == 1 && record.args[0].u == expected;
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  CHECK(ordered);
+  CHECK(log.size() == 0 && !log.pop(&record));
+
+  return 0;
+
+}
+
+int main() {
+
+  if (test_format() || test_full() || test_threads()) {
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
@@ -0,0 +1,163 @@
+/**
+ * @file test_duty_cycle.cc
+ * @brief Checks the duty cycling policy and its timings with a mock clock.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+
+#include "duty_cycle.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+/**
+ * @brief Clock that only moves when told to.
+ */
+class MockClock : public Clock {
+
+ public:
+
+  uint64_t now_us() override { return now_; }
+
+  void advance_ms(uint32_t ms) { now_ += (uint64_t) ms * 1000; }
+  void advance_us(uint32_t us) { now_ += us; }
+
+ private:
+
+  uint64_t now_ = 1000000;
+
+};
+
+// Small numbers that are easy to follow.
+constexpr DutyCycleConfig test_config = {100, 800, 2, 0.5f, 5};
+
+/**
+ * @brief Run one cycle with the given stage times and sleep what was asked.
+ *
+ * @returns The sleep the scheduler asked for.
+ */
+template <size_t History>
+static uint32_t run_cycle(MockClock* clock, DutyCycleScheduler<History>* scheduler,
+                          CrowdState state, uint32_t invoke_ms) {
+
+  scheduler->begin_cycle();
+  clock->advance_ms(2);
+  scheduler->mark(cycle_capture);
+  clock->advance_us(300);
+  scheduler->mark(cycle_convert);
+  clock->advance_ms(invoke_ms);
+  scheduler->mark(cycle_invoke);
+  clock->advance_us(700);
+  uint32_t sleep_ms = scheduler->end_cycle(state);
+  clock->advance_ms(sleep_ms);
+  return sleep_ms;
+
+}
+
+static int test_policy() {
+
+  MockClock clock;
+  DutyCycleScheduler<8> scheduler(&clock, test_config);
+
+  // Busy room: the shortest period, minus the 3 ms + invoke of the cycle.
+  CHECK(run_cycle(&clock, &scheduler, crowd_some, 10) == 100 - 13);
+  CHECK(run_cycle(&clock, &scheduler, crowd_full, 10) == 100 - 13);
+
+  // The room empties: the change itself keeps the short period, then it
+  // doubles every two empty cycles until the maximum.
+  CHECK(run_cycle(&clock, &scheduler, crowd_empty, 10) == 100 - 13);
+  CHECK(run_cycle(&clock, &scheduler, crowd_empty, 10) == 100 - 13);
+  CHECK(run_cycle(&clock, &scheduler, crowd_empty, 10) == 200 - 13);
+  CHECK(scheduler.period_ms() == 200);
+  uint32_t sleep_ms = 0;
+  for (int i = 0; i < 20; i++) {
+    sleep_ms = run_cycle(&clock, &scheduler, crowd_empty, 10);
+  }
+  CHECK(scheduler.period_ms() == 800);
+  CHECK(sleep_ms == 800 - 13);
+
+  // People again: straight back to the shortest period.
+  CHECK(run_cycle(&clock, &scheduler, crowd_some, 10) == 100 - 13);
+  CHECK(scheduler.period_ms() == 100);
+
+  // A slow model stretches the period so that the loop is busy at most half
+  // of the time.
+  CHECK(run_cycle(&clock, &scheduler, crowd_some, 77) == 80);
+
+  // The sleep never goes below the minimum.
+  DutyCycleConfig no_duty = test_config;
+  no_duty.max_duty = 1.0f;
+  DutyCycleScheduler<8> greedy(&clock, no_duty);
+  CHECK(run_cycle(&clock, &greedy, crowd_some, 200) == 5);
+
+  return 0;
+
+}
+
+static int test_timings() {
+
+  MockClock clock;
+  DutyCycleScheduler<4> scheduler(&clock, test_config);
+
+  CHECK(scheduler.size() == 0);
+
+  for (uint32_t i = 1; i <= 6; i++) {
+    run_cycle(&clock, &scheduler, crowd_some, i);
+  }
+
+  // Only the last four cycles are kept, the newest one first.
+  CHECK(scheduler.size() == 4);
+  for (size_t age = 0; age < 4; age++) {
+    const CycleTiming& t = scheduler.timing(age);
+    CHECK(t.us[cycle_capture] == 2000);
+    CHECK(t.us[cycle_convert] == 300);
+    CHECK(t.us[cycle_invoke] == (6 - age) * 1000);
+    CHECK(t.us[cycle_post] == 700);
+  }
+
+  // The sleep is the planned one until the next cycle measures the real one.
+  CHECK(scheduler.timing(0).us[cycle_sleep] == (100 - 9) * 1000);
+  scheduler.begin_cycle();
+  CHECK(scheduler.timing(0).us[cycle_sleep] == (100 - 9) * 1000);
+  clock.advance_ms(3);
+  scheduler.end_cycle(crowd_some);
+  CHECK(scheduler.timing(1).us[cycle_sleep] == (100 - 9) * 1000);
+  clock.advance_ms(150);
+  scheduler.begin_cycle();
+  CHECK(scheduler.timing(0).us[cycle_sleep] == 150 * 1000);
+
+  CycleTiming average;
+  scheduler.average(&average);
+  CHECK(average.us[cycle_capture] == (3 * 2000 + 0) / 4);
+  CHECK(average.us[cycle_invoke] == (6000 + 5000 + 4000) / 4);
+  CHECK(average.us[cycle_post] == (3 * 700 + 3000) / 4);
+
+  return 0;
+
+}
+
+int main() {
+
+  if (test_policy() || test_timings()) {
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
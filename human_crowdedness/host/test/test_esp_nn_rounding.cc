@@ -0,0 +1,86 @@
+/**
+ * @file test_esp_nn_rounding.cc
+ * @brief Checks the rounding divisions of esp-nn for every exponent.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+ *
+ * Built with the undefined behaviour sanitizer, which stops the test at the
+ * first overflowing shift or addition.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <common_functions.h>
+#include <softmax_common.h>
+#if CONFIG_NN_SIMD
+#include <esp_nn_simd_common.h>
+#endif
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+// Rounding to the nearest, half away from zero, as gemmlowp does it.
+static int32_t reference_div(int32_t val, int32_t exponent) {
+
+  const int64_t mask = ((int64_t) 1 << exponent) - 1;
+  const int64_t remainder = (int64_t) val & mask;
+  const int64_t threshold = (mask >> 1) + (val < 0);
+  return (int32_t) (((int64_t) val >> exponent) + (remainder > threshold));
+
+}
+
+int main() {
+
+  const int32_t values[] = {
+    0, 1, -1, 2, -2, 3, -3, 1000, -1000, 1 << 30, -(1 << 30), (1 << 30) + 1, -(1 << 30) - 1,
+    INT32_MAX, INT32_MAX - 1, INT32_MIN, INT32_MIN + 1,
+  };
+
+  // The requantization of softmax divides by up to 2^31, where the mask once
+  // overflowed.
+  for (int32_t exponent = 0; exponent <= 31; exponent++) {
+    for (int32_t val : values) {
+      CHECK(esp_nn_div_by_power_of_two(val, exponent) == reference_div(val, exponent));
+    }
+  }
+  CHECK(esp_nn_div_by_power_of_two(INT32_MIN, 31) == -1);
+  CHECK(esp_nn_div_by_power_of_two(1 << 30, 31) == 1);
+  CHECK(esp_nn_div_by_power_of_two((1 << 30) - 1, 31) == 0);
+
+#if CONFIG_NN_SIMD
+  for (int32_t exponent = 0; exponent <= 31; exponent++) {
+    for (int32_t val : values) {
+      const v8i32_t result = simd_div_by_power_of_two((v8i32_t) {} + val, (v8i32_t) {} + exponent);
+      for (int lane = 0; lane < SIMD_LANES; lane++) {
+        CHECK(result[lane] == reference_div(val, exponent));
+      }
+    }
+  }
+#endif
+
+  // A row of exps summing to 512 or more gives -128 everywhere instead of a
+  // shift by 32.
+  for (int32_t sum = 1; sum < (1 << 19); sum = sum * 3 / 2 + 1) {
+    int32_t shifted_scale, bits_over_unit;
+    esp_nn_softmax_row_scale(sum << SOFTMAX_ACCUM_BITS, &shifted_scale, &bits_over_unit);
+    CHECK(bits_over_unit >= 0 && bits_over_unit <= 31);
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
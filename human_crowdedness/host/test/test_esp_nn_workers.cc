@@ -0,0 +1,151 @@
+/**
+ * @file test_esp_nn_workers.cc
+ * @brief Runs the model with the convolutions split between worker threads.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "frame_sources.h"
+#include "model.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+// The same as test_person_detector.cc, plus the buffers of the extra jobs.
+constexpr size_t arena_size = 128 * 1024;
+alignas(16) static uint8_t arenas[4][arena_size];
+
+static std::atomic<int> runs[8];
+
+static void count_job(void* ctx, int index) {
+  runs[index]++;
+}
+
+int main() {
+
+  // Every row goes to exactly one job.
+  for (int height = 1; height < 20; height++) {
+    for (int jobs = 1; jobs <= tflite::kEspNnMaxJobs && jobs <= height; jobs++) {
+      int next_row = 0;
+      for (int i = 0; i < jobs; i++) {
+        const tflite::EspNnRowSlice slice = tflite::EspNnSliceRows(i, jobs, height, 2, 1);
+        CHECK(slice.output_row == next_row);
+        CHECK(slice.output_rows > 0);
+        CHECK(slice.input_row + 1 - slice.pad_height == slice.output_row * 2);
+        next_row += slice.output_rows;
+      }
+      CHECK(next_row == height);
+    }
+  }
+
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+
+  tflite::MicroMutableOpResolver<5> resolver;
+  resolver.AddAveragePool2D();
+  resolver.AddConv2D();
+  resolver.AddDepthwiseConv2D();
+  resolver.AddReshape();
+  resolver.AddSoftmax();
+
+  // The layers are split when they are prepared.
+  tflite::MicroInterpreter single(model, resolver, arenas[0], arena_size);
+  single.SetOpFusion(true);
+  CHECK(single.AllocateTensors() == kTfLiteOk);
+  tflite::MicroInterpreter single_unfused(model, resolver, arenas[1], arena_size);
+  single_unfused.SetOpFusion(false);
+  CHECK(single_unfused.AllocateTensors() == kTfLiteOk);
+
+  CHECK(tflite::StartEspNnWorkers(3));
+  CHECK(tflite::EspNnWorkerCount() == 3);
+  CHECK(tflite::EspNnParallelJobs(tflite::kEspNnParallelMinMacs - 1, 96) == 1);
+  CHECK(tflite::EspNnParallelJobs(tflite::kEspNnParallelMinMacs, 96) == 4);
+  CHECK(tflite::EspNnParallelJobs(tflite::kEspNnParallelMinMacs, 3) == 3);
+
+  // Each job runs once, the ones with no worker left on the calling thread.
+  for (int jobs = 1; jobs <= 8; jobs++) {
+    for (int i = 0; i < 8; i++) {
+      runs[i] = 0;
+    }
+    tflite::RunEspNnJobs(jobs, count_job, nullptr);
+    for (int i = 0; i < 8; i++) {
+      CHECK(runs[i] == (i < jobs ? 1 : 0));
+    }
+  }
+
+  // Every layer split, down to the smallest ones.
+  tflite::SetEspNnParallelMinMacs(0);
+  tflite::MicroInterpreter split(model, resolver, arenas[2], arena_size);
+  split.SetOpFusion(true);
+  CHECK(split.AllocateTensors() == kTfLiteOk);
+  tflite::MicroInterpreter split_unfused(model, resolver, arenas[3], arena_size);
+  split_unfused.SetOpFusion(false);
+  CHECK(split_unfused.AllocateTensors() == kTfLiteOk);
+  tflite::SetEspNnParallelMinMacs(tflite::kEspNnParallelMinMacs);
+
+  printf("arena: %zu bytes split, %zu bytes on one thread\n",
+         split.arena_used_bytes(), single.arena_used_bytes());
+
+  tflite::MicroInterpreter* interpreters[] = {&single, &single_unfused, &split, &split_unfused};
+
+  // All of them give exactly the same scores, for scenes and for noise. The
+  // workers are stopped for the last frames, the split layers still run.
+  SyntheticFrameSource source(96, 96, 0, 1);
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < SyntheticFrameSource::period; i += 8) {
+    if (i == SyntheticFrameSource::period / 2) {
+      tflite::StopEspNnWorkers();
+      CHECK(tflite::EspNnWorkerCount() == 0);
+    }
+
+    // The arenas reuse the input for later tensors, it is copied first.
+    static int8_t frame[96 * 96];
+    if (i % 16 == 0) {
+      source.render(i, frame);
+    } else {
+      for (size_t p = 0; p < sizeof(frame); p++) {
+        seed = seed * 1664525 + 1013904223;
+        frame[p] = (int8_t) (seed >> 24);
+      }
+    }
+    for (tflite::MicroInterpreter* interpreter : interpreters) {
+      TfLiteTensor* input = interpreter->input(0);
+      CHECK(input->bytes == sizeof(frame));
+      memcpy(input->data.int8, frame, sizeof(frame));
+      CHECK(interpreter->Invoke() == kTfLiteOk);
+    }
+
+    TfLiteTensor* expected = single.output(0);
+    for (tflite::MicroInterpreter* interpreter : interpreters) {
+      TfLiteTensor* output = interpreter->output(0);
+      CHECK(output->bytes == expected->bytes);
+      CHECK(memcmp(output->data.int8, expected->data.int8, expected->bytes) == 0);
+    }
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
@@ -0,0 +1,147 @@
+/**
+ * @file test_execution_plan.cc
+ * @brief Tests that the interpreter runs the operators from its execution plan.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tensorflow/lite/micro/kernels/softmax.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_context.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "frame_sources.h"
+#include "model.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+// The same as test_person_detector.cc.
+constexpr size_t arena_size = 112 * 1024;
+alignas(16) static uint8_t arenas[2][arena_size];
+
+/**
+ * @brief Keeps the nodes in the order they ran.
+ */
+class NodeOrderProfiler : public tflite::MicroProfilerInterface {
+
+ public:
+
+  uint32_t BeginEvent(const char* tag) override { return 0; }
+
+  uint32_t BeginNodeEvent(const char* tag, int subgraph_index, int node_index) override {
+    if (count < (int) (sizeof(nodes) / sizeof(nodes[0]))) {
+      nodes[count] = node_index;
+      tags[count] = tag;
+    }
+    count++;
+    return 0;
+  }
+
+  void EndEvent(uint32_t event_handle) override {}
+
+  int nodes[64];
+  const char* tags[64];
+  int count = 0;
+
+};
+
+static TfLiteRegistration_V1 softmax;
+static int temp_allocating_invokes = 0;
+
+// SOFTMAX that takes its input as a temporary TfLiteTensor every time it runs,
+// as some kernels do.
+static TfLiteStatus TempAllocatingSoftmaxEval(TfLiteContext* context, TfLiteNode* node) {
+  tflite::MicroContext* micro_context = tflite::GetMicroContext(context);
+  TfLiteTensor* input = micro_context->AllocateTempInputTensor(node, 0);
+  if (input == nullptr) {
+    return kTfLiteError;
+  }
+  micro_context->DeallocateTempTfLiteTensor(input);
+  temp_allocating_invokes++;
+  return softmax.invoke(context, node);
+}
+
+int main() {
+
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+  const int operators = model->subgraphs()->Get(0)->operators()->size();
+
+  tflite::MicroMutableOpResolver<5> resolver;
+  resolver.AddAveragePool2D();
+  resolver.AddConv2D();
+  resolver.AddDepthwiseConv2D();
+  resolver.AddReshape();
+  resolver.AddSoftmax();
+
+  softmax = tflite::Register_SOFTMAX();
+  TfLiteRegistration_V1 temp_allocating_softmax = softmax;
+  temp_allocating_softmax.invoke = TempAllocatingSoftmaxEval;
+  tflite::MicroMutableOpResolver<5> temp_resolver;
+  temp_resolver.AddAveragePool2D();
+  temp_resolver.AddConv2D();
+  temp_resolver.AddDepthwiseConv2D();
+  temp_resolver.AddReshape();
+  temp_resolver.AddSoftmax(temp_allocating_softmax);
+
+  NodeOrderProfiler profiler;
+  tflite::MicroInterpreter reference(model, resolver, arenas[0], arena_size);
+  CHECK(reference.AllocateTensors() == kTfLiteOk);
+  // Our own allocator, to look at its temporary allocations.
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(arenas[1], arena_size);
+  CHECK(allocator != nullptr);
+  tflite::MicroInterpreter interpreter(model, temp_resolver, allocator, nullptr, &profiler);
+  CHECK(interpreter.AllocateTensors() == kTfLiteOk);
+  CHECK(!allocator->HasTempAllocations());
+
+  // Every node in the order of the model, once per inference, the temporary
+  // allocations reset after the node that made them, and the same scores.
+  SyntheticFrameSource source(96, 96, 0, 1);
+  constexpr int inferences = 50;
+  for (int i = 0; i < inferences; i++) {
+    static int8_t frame[96 * 96];
+    source.render(i, frame);
+    memcpy(reference.input(0)->data.int8, frame, sizeof(frame));
+    memcpy(interpreter.input(0)->data.int8, frame, sizeof(frame));
+    CHECK(reference.Invoke() == kTfLiteOk);
+
+    profiler.count = 0;
+    CHECK(interpreter.Invoke() == kTfLiteOk);
+    CHECK(profiler.count == operators);
+    for (int node = 0; node < operators; node++) {
+      CHECK(profiler.nodes[node] == node);
+    }
+    CHECK(strcmp(profiler.tags[operators - 1], "SOFTMAX") == 0);
+    CHECK(!allocator->HasTempAllocations());
+
+    TfLiteTensor* expected = reference.output(0);
+    TfLiteTensor* output = interpreter.output(0);
+    CHECK(output->bytes == expected->bytes);
+    CHECK(memcmp(output->data.int8, expected->data.int8, expected->bytes) == 0);
+  }
+  CHECK(temp_allocating_invokes == inferences);
+
+  printf("%d operators, %d inferences\n", operators, inferences);
+  printf("PASS\n");
+  return 0;
+
+}
@@ -0,0 +1,185 @@
+/**
+ * @file test_fault_recovery.cc
+ * @brief Checks the recovery from faults with a frame source that fails.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+
+#include "fault_recovery.h"
+#include "frame_sources.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+constexpr int frame_width = 96;
+constexpr int frame_height = 96;
+
+/**
+ * @brief What happened in a run of the capture loop.
+ */
+struct RunResult {
+  uint32_t frames;
+  uint32_t restarts;
+  uint32_t waited_ms;
+  uint32_t longest_wait_ms;
+};
+
+/**
+ * @brief Read frames the way the capture task does, until enough of them got
+ * through or the board would have been restarted.
+ */
+static RunResult run(FaultyFrameSource* source, FaultRecovery* recovery, uint32_t frames) {
+
+  static int8_t img[frame_width * frame_height];
+  RunResult result = {};
+
+  while (result.frames < frames) {
+
+    if (source->get_image(img) == frame_source_ok) {
+      recovery->succeeded();
+      result.frames++;
+      continue;
+    }
+
+    switch (recovery->failed(fault_capture)) {
+      case fault_action_retry:
+        result.waited_ms += recovery->backoff_ms();
+        if (recovery->backoff_ms() > result.longest_wait_ms) {
+          result.longest_wait_ms = recovery->backoff_ms();
+        }
+        break;
+      case fault_action_reinit:
+        source->reinit();
+        break;
+      case fault_action_restart:
+        result.restarts++;
+        return result;
+    }
+
+  }
+
+  return result;
+
+}
+
+static int test_glitch() {
+
+  SyntheticFrameSource scene(frame_width, frame_height, 0, 1);
+  FaultyFrameSource source(&scene);
+  FaultRecovery recovery;
+
+  // A couple of bad reads are retried, with a longer wait the second time.
+  source.fail_reads(2);
+  RunResult result = run(&source, &recovery, 10);
+  CHECK(result.frames == 10 && result.restarts == 0);
+  CHECK(result.waited_ms == 50 + 100);
+  CHECK(source.faults() == 2 && source.reinits() == 0);
+  CHECK(recovery.faults(fault_capture) == 2 && recovery.reinits() == 0);
+  CHECK(!recovery.recovering() && recovery.backoff_ms() == 0);
+
+  // The next glitch starts from the shortest wait again.
+  source.fail_reads(1);
+  result = run(&source, &recovery, 1);
+  CHECK(result.waited_ms == 50);
+  CHECK(recovery.faults(fault_capture) == 3);
+
+  return 0;
+
+}
+
+static int test_reinit() {
+
+  SyntheticFrameSource scene(frame_width, frame_height, 0, 1);
+  FaultyFrameSource source(&scene);
+  FaultRecovery recovery;
+
+  // A driver that stays broken is restarted after the retries, and then the
+  // frames come again without restarting the board.
+  source.fail_until_reinits(1);
+  RunResult result = run(&source, &recovery, 10);
+  CHECK(result.frames == 10 && result.restarts == 0);
+  CHECK(result.waited_ms == 50 + 100 + 200);
+  CHECK(source.faults() == 4 && source.reinits() == 1);
+  CHECK(recovery.reinits() == 1);
+
+  // One that needs two restarts gets them.
+  source.fail_until_reinits(2);
+  result = run(&source, &recovery, 10);
+  CHECK(result.frames == 10 && result.restarts == 0);
+  CHECK(source.reinits() == 3);
+
+  return 0;
+
+}
+
+static int test_dead() {
+
+  SyntheticFrameSource scene(frame_width, frame_height, 0, 1);
+  FaultyFrameSource source(&scene);
+  FaultRecovery recovery;
+
+  // A dead camera ends in a restart after every retry and reinit was tried.
+  source.fail_until_reinits(100);
+  RunResult result = run(&source, &recovery, 10);
+  CHECK(result.frames == 0 && result.restarts == 1);
+  CHECK(source.reinits() == 2);
+  CHECK(source.faults() == 3 * 4);
+  CHECK(recovery.recovering());
+
+  // Without reinits, the retries go straight to a restart, and the waits stop
+  // growing at the limit.
+  const FaultRecoveryConfig config = {6, 50, 400, 0};
+  FaultRecovery bounded(config);
+  source.fail_until_reinits(100);
+  result = run(&source, &bounded, 10);
+  CHECK(result.restarts == 1 && source.reinits() == 2);
+  CHECK(result.longest_wait_ms == 400);
+  CHECK(result.waited_ms == 50 + 100 + 200 + 400 + 400 + 400);
+
+  return 0;
+
+}
+
+static int test_counters() {
+
+  FaultRecovery recovery;
+
+  CHECK(recovery.failed(fault_frame_timeout) == fault_action_retry);
+  CHECK(recovery.failed(fault_invoke) == fault_action_retry);
+  CHECK(recovery.failed(fault_invoke) == fault_action_retry);
+  recovery.succeeded();
+
+  CHECK(recovery.faults(fault_capture) == 0);
+  CHECK(recovery.faults(fault_frame_timeout) == 1);
+  CHECK(recovery.faults(fault_invoke) == 2);
+  CHECK(recovery.total_faults() == 3);
+
+  return 0;
+
+}
+
+int main() {
+
+  if (test_glitch() || test_reinit() || test_dead() || test_counters()) {
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
@@ -0,0 +1,114 @@
+/**
+ * @file test_frame_convert.cc
+ * @brief Checks the word-wide frame conversion against the bytewise one.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame_convert.h"
+
+int main() {
+
+  const size_t max_len = 96 * 96 + 37;
+  uint8_t src[max_len + 8];
+  int8_t expected[max_len + 8];
+  int8_t got[max_len + 8];
+
+  for (size_t i = 0; i < sizeof(src); i++) {
+    src[i] = (uint8_t) rand();
+  }
+
+  // Try every length around the word size and every misalignment of both
+  // buffers, plus a full frame.
+  const size_t lens[] = {0, 1, 3, 7, 8, 9, 15, 16, 31, 32, 33, 63, 64, 65, 96 * 96, max_len};
+  for (size_t len : lens) {
+    for (int src_off = 0; src_off < 8; src_off++) {
+      for (int dst_off = 0; dst_off < 8; dst_off++) {
+        if (len + src_off > sizeof(src) || len + dst_off > sizeof(got)) {
+          continue;
+        }
+        memset(got, 0x55, sizeof(got));
+        memset(expected, 0x55, sizeof(expected));
+        convert_frame_to_input_bytewise(src + src_off, expected + dst_off, len);
+        convert_frame_to_input(src + src_off, got + dst_off, len);
+        if (memcmp(expected, got, sizeof(got)) != 0) {
+          printf("FAIL: len %zu, src offset %d, dst offset %d\n", len, src_off, dst_off);
+          return 1;
+        }
+      }
+    }
+  }
+
+  // The conversion must also work in place, as that is how the frame buffer
+  // can be reused without a copy.
+  uint8_t in_place[96 * 96];
+  memcpy(in_place, src, sizeof(in_place));
+  convert_frame_to_input_bytewise(src, expected, sizeof(in_place));
+  convert_frame_to_input(in_place, (int8_t *) in_place, sizeof(in_place));
+  if (memcmp(expected, in_place, sizeof(in_place)) != 0) {
+    printf("FAIL: in place conversion\n");
+    return 1;
+  }
+
+  // Check the actual values at the edges of the range.
+  const uint8_t edges[] = {0, 127, 128, 255};
+  int8_t edges_out[4];
+  convert_frame_to_input(edges, edges_out, 4);
+  if (edges_out[0] != -128 || edges_out[1] != -1 || edges_out[2] != 0 || edges_out[3] != 127) {
+    printf("FAIL: edge values\n");
+    return 1;
+  }
+
+  // Cropping without scaling is a strided copy.
+  const size_t frame_w = 320, frame_h = 240;
+  static uint8_t frame[frame_w * frame_h];
+  for (size_t i = 0; i < sizeof(frame); i++) {
+    frame[i] = (uint8_t) rand();
+  }
+  static int8_t tile[96 * 96];
+  crop_frame_to_input(frame, frame_w, 224, 144, 96, tile, 96);
+  for (size_t y = 0; y < 96; y++) {
+    for (size_t x = 0; x < 96; x++) {
+      if (tile[y * 96 + x] != (int8_t) (frame[(144 + y) * frame_w + 224 + x] ^ 0x80)) {
+        printf("FAIL: crop at %zu, %zu\n", x, y);
+        return 1;
+      }
+    }
+  }
+
+  // Scaling down by two takes every other pixel, scaling up repeats them.
+  crop_frame_to_input(frame, frame_w, 10, 20, 192, tile, 96);
+  for (size_t y = 0; y < 96; y++) {
+    for (size_t x = 0; x < 96; x++) {
+      if (tile[y * 96 + x] != (int8_t) (frame[(20 + 2 * y + 1) * frame_w + 10 + 2 * x + 1] ^ 0x80)) {
+        printf("FAIL: scaled down crop at %zu, %zu\n", x, y);
+        return 1;
+      }
+    }
+  }
+  crop_frame_to_input(frame, frame_w, 5, 7, 48, tile, 96);
+  for (size_t y = 0; y < 96; y++) {
+    for (size_t x = 0; x < 96; x++) {
+      if (tile[y * 96 + x] != (int8_t) (frame[(7 + y / 2) * frame_w + 5 + x / 2] ^ 0x80)) {
+        printf("FAIL: scaled up crop at %zu, %zu\n", x, y);
+        return 1;
+      }
+    }
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
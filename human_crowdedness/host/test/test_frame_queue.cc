@@ -0,0 +1,199 @@
+/**
+ * @file test_frame_queue.cc
+ * @brief Checks the latest-frame-wins queue between capture and inference.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "frame_queue.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+// Stand-in for the camera frame buffers.
+struct StubFrame {
+  uint32_t seq;
+  std::atomic<bool> in_use;
+};
+
+constexpr int fb_count = 2;
+
+/**
+ * @brief Stand-in for the camera driver.
+ *
+ * Like the real one, it only has fb_count buffers and the producer has to
+ * wait until one is given back before it can get a new frame.
+ */
+class StubFrameSource {
+
+ public:
+
+  StubFrame* get() {
+    while (true) {
+      for (auto& fb : frames_) {
+        bool expected = false;
+        if (fb.in_use.compare_exchange_strong(expected, true)) {
+          fb.seq = next_seq_++;
+          return &fb;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void put(StubFrame* fb) {
+    fb->in_use = false;
+    returned_++;
+  }
+
+  uint32_t produced() { return next_seq_; }
+  uint32_t returned() { return returned_; }
+
+ private:
+
+  StubFrame frames_[fb_count] = {};
+  uint32_t next_seq_ = 0;
+  std::atomic<uint32_t> returned_{0};
+
+};
+
+static int test_single_thread() {
+
+  FrameQueue<int, 2> queue;
+  int out = -1;
+  int dropped = -1;
+
+  // Empty queue.
+  CHECK(!queue.try_pop(&out));
+  CHECK(!queue.pop(&out, 1));
+
+  // Frames come out in order while there is room.
+  CHECK(!queue.push(1, &dropped));
+  CHECK(!queue.push(2, &dropped));
+  CHECK(queue.size() == 2);
+
+  // When full, the oldest one is dropped.
+  CHECK(queue.push(3, &dropped));
+  CHECK(dropped == 1);
+  CHECK(queue.dropped() == 1);
+  CHECK(queue.pushed() == 3);
+
+  CHECK(queue.try_pop(&out) && out == 2);
+  CHECK(queue.pop(&out, 1) && out == 3);
+  CHECK(queue.size() == 0);
+
+  // With room for a single frame the newest one always wins.
+  FrameQueue<int, 1> latest;
+  for (int i = 0; i < 10; i++) {
+    latest.push(i, &dropped);
+  }
+  CHECK(latest.try_pop(&out) && out == 9);
+  CHECK(latest.dropped() == 9);
+
+  // Closing keeps what is there, refuses new frames and wakes up waiters.
+  queue.push(4, &dropped);
+  queue.close();
+  CHECK(queue.push(5, &dropped) && dropped == 5);
+  CHECK(queue.pop(&out, 1000) && out == 4);
+  CHECK(!queue.pop(&out, 1000));
+
+  return 0;
+
+}
+
+static int test_pipeline() {
+
+  StubFrameSource source;
+  FrameQueue<StubFrame*, fb_count - 1> queue;
+  const uint32_t frames_to_consume = 200;
+
+  std::atomic<bool> stop{false};
+  std::atomic<uint32_t> dropped_returned{0};
+
+  // Capture stage: as fast as the source goes.
+  std::thread capture([&] {
+    while (!stop) {
+      StubFrame* fb = source.get();
+      StubFrame* dropped = nullptr;
+      if (queue.push(fb, &dropped)) {
+        source.put(dropped);
+        dropped_returned++;
+      }
+    }
+  });
+
+  // Inference stage: slower than the camera.
+  uint32_t consumed = 0;
+  int64_t last_seq = -1;
+  bool in_order = true;
+  while (consumed < frames_to_consume) {
+    StubFrame* fb = nullptr;
+    if (!queue.pop(&fb, 1000)) {
+      break;
+    }
+    if ((int64_t) fb->seq <= last_seq) {
+      in_order = false;
+    }
+    last_seq = fb->seq;
+    source.put(fb);
+    consumed++;
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+
+  stop = true;
+  queue.close();
+  capture.join();
+
+  // Give back whatever is left in the queue.
+  StubFrame* fb = nullptr;
+  uint32_t leftover = 0;
+  while (queue.try_pop(&fb)) {
+    source.put(fb);
+    leftover++;
+  }
+
+  CHECK(consumed == frames_to_consume);
+  CHECK(in_order);
+
+  // The camera was never starved for long: it kept producing while we were
+  // busy, and the frames we could not process were dropped, not queued.
+  CHECK(source.produced() > consumed);
+  CHECK(queue.dropped() > 0);
+
+  // Every frame was given back exactly once.
+  CHECK(source.returned() == source.produced());
+  CHECK(source.produced() == consumed + dropped_returned + leftover);
+
+  return 0;
+
+}
+
+int main() {
+
+  if (test_single_thread() || test_pipeline()) {
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
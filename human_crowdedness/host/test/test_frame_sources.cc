@@ -0,0 +1,146 @@
+/**
+ * @file test_frame_sources.cc
+ * @brief Checks the frame sources that replace the camera on the host.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "frame_sources.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+constexpr int width = 96;
+constexpr int height = 96;
+constexpr size_t frame_size = width * height;
+
+static void write_file(const std::string& path, const char* header, uint8_t value, size_t len) {
+
+  FILE* f = fopen(path.c_str(), "wb");
+  fputs(header, f);
+  for (size_t i = 0; i < len; i++) {
+    fputc(value, f);
+  }
+  fclose(f);
+
+}
+
+static int test_directory() {
+
+  char dir[] = "/tmp/frame_sources_XXXXXX";
+  CHECK(mkdtemp(dir) != nullptr);
+  std::string base(dir);
+
+  // Written out of order, replayed in name order. The comment in the header
+  // must be skipped, and files of the wrong kind or size must not be frames.
+  write_file(base + "/b.raw", "", 200, frame_size);
+  write_file(base + "/a.pgm", "P5\n# from the board\n96 96\n255\n", 10, frame_size);
+  write_file(base + "/c.pgm", "P5 96 95 255\n", 30, width * 95);
+  write_file(base + "/d.raw", "", 40, frame_size + 1);
+  write_file(base + "/notes.txt", "", 0, 4);
+
+  DirectoryFrameSource source(frame_size, false);
+  CHECK(source.open(dir) == 4);
+
+  static int8_t img[frame_size];
+  CHECK(source.get_image(img) == frame_source_ok);
+  CHECK(source.current() == base + "/a.pgm");
+  CHECK(img[0] == 10 - 128 && img[frame_size - 1] == 10 - 128);
+
+  CHECK(source.get_image(img) == frame_source_ok);
+  CHECK(source.current() == base + "/b.raw");
+  CHECK(img[0] == 200 - 128 && img[frame_size - 1] == 200 - 128);
+
+  // 96x95 and one pixel too many.
+  CHECK(source.get_image(img) == frame_source_error);
+  CHECK(source.get_image(img) == frame_source_error);
+  CHECK(source.get_image(img) == frame_source_end);
+
+  // Looping starts again from the first frame.
+  DirectoryFrameSource looping(frame_size, true);
+  CHECK(looping.open(dir) == 4);
+  for (int i = 0; i < 4; i++) {
+    looping.get_image(img);
+  }
+  CHECK(looping.get_image(img) == frame_source_ok);
+  CHECK(looping.current() == base + "/a.pgm");
+
+  CHECK(source.open("/nonexistent/frames") == -1);
+
+  for (const char* name : {"/a.pgm", "/b.raw", "/c.pgm", "/d.raw", "/notes.txt"}) {
+    unlink((base + name).c_str());
+  }
+  rmdir(dir);
+
+  return 0;
+
+}
+
+static int test_synthetic() {
+
+  static int8_t first[frame_size];
+  static int8_t again[frame_size];
+  static int8_t other[frame_size];
+
+  // A limited number of frames, then the end.
+  SyntheticFrameSource source(width, height, 3, 7);
+  CHECK(source.get_image(first) == frame_source_ok);
+  CHECK(source.get_image(other) == frame_source_ok);
+  CHECK(source.get_image(other) == frame_source_ok);
+  CHECK(source.get_image(other) == frame_source_end);
+
+  // Frames do not depend on what was generated before them.
+  source.render(0, again);
+  CHECK(memcmp(first, again, frame_size) == 0);
+
+  // But they do depend on the seed and on the frame number.
+  SyntheticFrameSource reseeded(width, height, 0, 8);
+  reseeded.render(0, other);
+  CHECK(memcmp(first, other, frame_size) != 0);
+  source.render(1, other);
+  CHECK(memcmp(first, other, frame_size) != 0);
+
+  // The empty half of the loop has no blob, so it is darker.
+  long busy_sum = 0, empty_sum = 0;
+  source.render(SyntheticFrameSource::period / 4, first);
+  source.render(SyntheticFrameSource::period * 3 / 4, other);
+  for (size_t i = 0; i < frame_size; i++) {
+    busy_sum += first[i];
+    empty_sum += other[i];
+  }
+  CHECK(busy_sum > empty_sum);
+
+  return 0;
+
+}
+
+int main() {
+
+  if (test_directory() || test_synthetic()) {
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
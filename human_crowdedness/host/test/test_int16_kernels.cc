@@ -0,0 +1,286 @@
+/**
+ * @file test_int16_kernels.cc
+ * @brief Checks the int16 activation esp-nn kernels against the tflite reference ones.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <initializer_list>
+#include <vector>
+
+extern "C" {
+#include <esp_nn_ansi_headers.h>
+}
+
+#include "tensorflow/lite/kernels/internal/reference/add.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/depthwise_conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/pooling.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+static uint32_t seed = 1;
+
+/**
+ * @brief Random value in [lo, hi].
+ */
+static int32_t random_in(int32_t lo, int32_t hi) {
+  seed = seed * 1664525 + 1013904223;
+  return lo + (int32_t) ((seed >> 8) % (uint32_t) (hi - lo + 1));
+}
+
+template <typename T>
+static std::vector<T> random_vector(size_t size, int32_t lo, int32_t hi) {
+  std::vector<T> v(size);
+  for (T& x : v) {
+    x = (T) random_in(lo, hi);
+  }
+  return v;
+}
+
+/**
+ * @brief Multipliers in [0.5, 1) and right shifts that keep the outputs in
+ * the int16 range most of the time, but still saturating some of them.
+ */
+static void random_quant(int size, std::vector<int32_t>* mult, std::vector<int32_t>* shift) {
+  mult->resize(size);
+  shift->resize(size);
+  for (int i = 0; i < size; i++) {
+    (*mult)[i] = random_in(1 << 30, INT32_MAX);
+    (*shift)[i] = random_in(-12, -4);
+  }
+}
+
+static tflite::RuntimeShape make_shape(std::initializer_list<int32_t> dims) {
+  return tflite::RuntimeShape(dims.size(), dims.begin());
+}
+
+static int out_size(int in, int filter, int stride, int pad) {
+  return (in + 2 * pad - filter) / stride + 1;
+}
+
+static int test_conv(bool depthwise) {
+  for (int iter = 0; iter < 12; iter++) {
+    const int in_wd = random_in(3, 12), in_ht = random_in(3, 12);
+    const int in_ch = depthwise ? random_in(1, 80) : random_in(1, 40);
+    const int ch_mult = depthwise ? random_in(1, 2) : 1;
+    const int out_ch = depthwise ? in_ch * ch_mult : random_in(1, 20);
+    const int filter_wd = random_in(1, 3), filter_ht = random_in(1, 3);
+    const int stride = random_in(1, 2);
+    const int pad_wd = random_in(0, filter_wd / 2), pad_ht = random_in(0, filter_ht / 2);
+    const int out_wd = out_size(in_wd, filter_wd, stride, pad_wd);
+    const int out_ht = out_size(in_ht, filter_ht, stride, pad_ht);
+    const int filter_size = depthwise ? filter_wd * filter_ht * out_ch
+                                      : out_ch * filter_wd * filter_ht * in_ch;
+
+    std::vector<int16_t> input = random_vector<int16_t>(in_wd * in_ht * in_ch, INT16_MIN, INT16_MAX);
+    std::vector<int8_t> filter = random_vector<int8_t>(filter_size, -127, 127);
+    std::vector<int64_t> bias = random_vector<int64_t>(out_ch, -(1 << 20), 1 << 20);
+    std::vector<int32_t> mult, shift;
+    random_quant(out_ch, &mult, &shift);
+    const int32_t act_min = iter % 3 == 0 ? 0 : INT16_MIN;
+    const int32_t act_max = INT16_MAX;
+
+    const tflite::RuntimeShape input_shape = make_shape({1, in_ht, in_wd, in_ch});
+    const tflite::RuntimeShape filter_shape = depthwise
+        ? make_shape({1, filter_ht, filter_wd, out_ch})
+        : make_shape({out_ch, filter_ht, filter_wd, in_ch});
+    const tflite::RuntimeShape bias_shape = make_shape({out_ch});
+    const tflite::RuntimeShape output_shape = make_shape({1, out_ht, out_wd, out_ch});
+    const int output_size = out_wd * out_ht * out_ch;
+
+    std::vector<int16_t> expected(output_size), ansi(output_size), opt(output_size);
+
+    data_dims_t input_dims = {in_wd, in_ht, in_ch, 1};
+    data_dims_t filter_dims = {filter_wd, filter_ht, depthwise ? 1 : in_ch, 1};
+    data_dims_t output_dims = {out_wd, out_ht, out_ch, 1};
+    quant_data_t quant_data = {shift.data(), mult.data()};
+
+    if (depthwise) {
+      tflite::DepthwiseParams params = {};
+      params.padding_values.width = pad_wd;
+      params.padding_values.height = pad_ht;
+      params.stride_width = stride;
+      params.stride_height = stride;
+      params.dilation_width_factor = 1;
+      params.dilation_height_factor = 1;
+      params.depth_multiplier = ch_mult;
+      params.quantized_activation_min = act_min;
+      params.quantized_activation_max = act_max;
+      tflite::reference_integer_ops::DepthwiseConvPerChannel(
+          params, mult.data(), shift.data(), input_shape, input.data(), filter_shape,
+          filter.data(), bias_shape, bias.data(), output_shape, expected.data());
+
+      dw_conv_params_t conv_params = {0, 0, ch_mult, {stride, stride}, {pad_wd, pad_ht},
+                                      {1, 1}, {act_min, act_max}};
+      esp_nn_depthwise_conv_s16_ansi(&input_dims, input.data(), &filter_dims, filter.data(),
+                                     bias.data(), &output_dims, ansi.data(), &conv_params, &quant_data);
+      esp_nn_depthwise_conv_s16_opt(&input_dims, input.data(), &filter_dims, filter.data(),
+                                    bias.data(), &output_dims, opt.data(), &conv_params, &quant_data);
+    } else {
+      tflite::ConvParams params = {};
+      params.padding_values.width = pad_wd;
+      params.padding_values.height = pad_ht;
+      params.stride_width = stride;
+      params.stride_height = stride;
+      params.dilation_width_factor = 1;
+      params.dilation_height_factor = 1;
+      params.quantized_activation_min = act_min;
+      params.quantized_activation_max = act_max;
+      tflite::reference_integer_ops::ConvPerChannel(
+          params, mult.data(), shift.data(), input_shape, input.data(), filter_shape,
+          filter.data(), bias_shape, bias.data(), output_shape, expected.data());
+
+      conv_params_t conv_params = {0, 0, {stride, stride}, {pad_wd, pad_ht},
+                                   {1, 1}, {act_min, act_max}};
+      esp_nn_conv_s16_ansi(&input_dims, input.data(), &filter_dims, filter.data(),
+                           bias.data(), &output_dims, ansi.data(), &conv_params, &quant_data);
+      esp_nn_conv_s16_opt(&input_dims, input.data(), &filter_dims, filter.data(),
+                          bias.data(), &output_dims, opt.data(), &conv_params, &quant_data);
+    }
+
+    CHECK(memcmp(expected.data(), ansi.data(), output_size * sizeof(int16_t)) == 0);
+    CHECK(memcmp(expected.data(), opt.data(), output_size * sizeof(int16_t)) == 0);
+  }
+  return 0;
+}
+
+static int test_fully_connected() {
+  for (int iter = 0; iter < 8; iter++) {
+    // Long rows, to go through more than one chunk of the 32 bit sums.
+    const int row_len = random_in(1, 700);
+    const int out_ch = random_in(1, 13);
+
+    std::vector<int16_t> input = random_vector<int16_t>(row_len, INT16_MIN, INT16_MAX);
+    std::vector<int8_t> filter = random_vector<int8_t>(out_ch * row_len, -127, 127);
+    std::vector<int64_t> bias = random_vector<int64_t>(out_ch, -(1 << 20), 1 << 20);
+    std::vector<int32_t> mult, shift;
+    random_quant(1, &mult, &shift);
+    shift[0] -= 4;
+
+    tflite::FullyConnectedParams params = {};
+    params.output_multiplier = mult[0];
+    params.output_shift = shift[0];
+    params.quantized_activation_min = INT16_MIN;
+    params.quantized_activation_max = INT16_MAX;
+
+    std::vector<int16_t> expected(out_ch), ansi(out_ch), opt(out_ch);
+    tflite::reference_integer_ops::FullyConnected(
+        params, make_shape({1, row_len}), input.data(),
+        make_shape({out_ch, row_len}), filter.data(),
+        make_shape({out_ch}), bias.data(),
+        make_shape({1, out_ch}), expected.data());
+
+    esp_nn_fully_connected_s16_ansi(input.data(), row_len, filter.data(), bias.data(), ansi.data(),
+                                    out_ch, shift[0], mult[0], INT16_MIN, INT16_MAX);
+    esp_nn_fully_connected_s16_opt(input.data(), row_len, filter.data(), bias.data(), opt.data(),
+                                   out_ch, shift[0], mult[0], INT16_MIN, INT16_MAX);
+
+    CHECK(memcmp(expected.data(), ansi.data(), out_ch * sizeof(int16_t)) == 0);
+    CHECK(memcmp(expected.data(), opt.data(), out_ch * sizeof(int16_t)) == 0);
+  }
+  return 0;
+}
+
+static int test_add() {
+  const int size = 1000;
+  std::vector<int16_t> input1 = random_vector<int16_t>(size, INT16_MIN, INT16_MAX);
+  std::vector<int16_t> input2 = random_vector<int16_t>(size, INT16_MIN, INT16_MAX);
+
+  // What the add kernel prepares for the general scales of int16.
+  tflite::ArithmeticParams params = {};
+  params.left_shift = 15;
+  params.input1_multiplier = random_in(1 << 30, INT32_MAX);
+  params.input1_shift = -1;
+  params.input2_multiplier = random_in(1 << 30, INT32_MAX);
+  params.input2_shift = -2;
+  params.output_multiplier = random_in(1 << 30, INT32_MAX);
+  params.output_shift = -13;
+  params.quantized_activation_min = INT16_MIN;
+  params.quantized_activation_max = INT16_MAX;
+
+  std::vector<int16_t> expected(size), actual(size);
+  const tflite::RuntimeShape shape = make_shape({1, size});
+  tflite::reference_ops::Add(params, shape, input1.data(), shape, input2.data(),
+                             shape, expected.data(), false);
+
+  esp_nn_add_elementwise_s16_ansi(input1.data(), input2.data(), 0, 0,
+                                  params.input1_multiplier, params.input2_multiplier,
+                                  params.input1_shift, params.input2_shift, params.left_shift,
+                                  actual.data(), 0, params.output_multiplier, params.output_shift,
+                                  INT16_MIN, INT16_MAX, size);
+
+  CHECK(memcmp(expected.data(), actual.data(), size * sizeof(int16_t)) == 0);
+  return 0;
+}
+
+static int test_avg_pool() {
+  for (int iter = 0; iter < 12; iter++) {
+    const int in_wd = random_in(2, 16), in_ht = random_in(2, 16);
+    const int channels = random_in(1, 40);
+    const int filter_wd = random_in(1, in_wd), filter_ht = random_in(1, in_ht);
+    const int stride = random_in(1, 2);
+    const int pad_wd = random_in(0, filter_wd / 2), pad_ht = random_in(0, filter_ht / 2);
+    const int out_wd = out_size(in_wd, filter_wd, stride, pad_wd);
+    const int out_ht = out_size(in_ht, filter_ht, stride, pad_ht);
+    const int output_size = out_wd * out_ht * channels;
+
+    std::vector<int16_t> input = random_vector<int16_t>(in_wd * in_ht * channels, INT16_MIN, INT16_MAX);
+
+    tflite::PoolParams params = {};
+    params.padding_values.width = pad_wd;
+    params.padding_values.height = pad_ht;
+    params.stride_width = stride;
+    params.stride_height = stride;
+    params.filter_width = filter_wd;
+    params.filter_height = filter_ht;
+    params.quantized_activation_min = iter % 3 == 0 ? 0 : INT16_MIN;
+    params.quantized_activation_max = INT16_MAX;
+
+    std::vector<int16_t> expected(output_size), ansi(output_size), opt(output_size);
+    CHECK(tflite::reference_integer_ops::AveragePool(
+        params, make_shape({1, in_ht, in_wd, channels}), input.data(),
+        make_shape({1, out_ht, out_wd, channels}), expected.data()));
+
+    esp_nn_avg_pool_s16_ansi(input.data(), in_wd, in_ht, ansi.data(), out_wd, out_ht,
+                             stride, stride, filter_wd, filter_ht, pad_wd, pad_ht,
+                             params.quantized_activation_min, INT16_MAX, channels);
+    esp_nn_avg_pool_s16_opt(input.data(), in_wd, in_ht, opt.data(), out_wd, out_ht,
+                            stride, stride, filter_wd, filter_ht, pad_wd, pad_ht,
+                            params.quantized_activation_min, INT16_MAX, channels);
+
+    CHECK(memcmp(expected.data(), ansi.data(), output_size * sizeof(int16_t)) == 0);
+    CHECK(memcmp(expected.data(), opt.data(), output_size * sizeof(int16_t)) == 0);
+  }
+  return 0;
+}
+
+int main() {
+
+  CHECK(test_conv(false) == 0);
+  CHECK(test_conv(true) == 0);
+  CHECK(test_fully_connected() == 0);
+  CHECK(test_add() == 0);
+  CHECK(test_avg_pool() == 0);
+
+  printf("PASS\n");
+  return 0;
+
+}
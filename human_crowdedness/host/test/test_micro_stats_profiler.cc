@@ -0,0 +1,151 @@
+/**
+ * @file test_micro_stats_profiler.cc
+ * @brief Tests the statistics of every operator kept by MicroStatsProfiler.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "frame_sources.h"
+#include "person_detector.h"
+#include "tensorflow/lite/micro/micro_stats_profiler.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+using tflite::MicroNodeStats;
+using tflite::MicroStatsProfiler;
+
+// The same as test_person_detector.cc.
+constexpr size_t arena_size = 112 * 1024;
+alignas(16) static uint8_t arena[arena_size];
+
+constexpr int max_nodes = 64;
+static MicroNodeStats nodes[max_nodes];
+
+static uint32_t read_u32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+int main() {
+
+  // Exact buckets for the shortest durations, then 4 per power of two, every
+  // bucket starting where the previous one ends.
+  for (uint32_t ticks = 0; ticks < 8; ticks++) {
+    CHECK(MicroStatsProfiler::BucketOf(ticks) == (int) ticks);
+  }
+  CHECK(MicroStatsProfiler::BucketOf(8) == 8);
+  CHECK(MicroStatsProfiler::BucketOf(9) == 8);
+  CHECK(MicroStatsProfiler::BucketOf(10) == 9);
+  CHECK(MicroStatsProfiler::BucketOf(16) == 12);
+  CHECK(MicroStatsProfiler::BucketOf(0xffffffff) == tflite::kMicroStatsBuckets - 1);
+  for (int b = 1; b < tflite::kMicroStatsBuckets; b++) {
+    const uint32_t start = MicroStatsProfiler::BucketStart(b);
+    CHECK(start > MicroStatsProfiler::BucketStart(b - 1));
+    CHECK(MicroStatsProfiler::BucketOf(start) == b);
+    CHECK(MicroStatsProfiler::BucketOf(start - 1) == b - 1);
+  }
+
+  // Known samples: 1..1000 ticks on node 2, nothing on nodes 0 and 1.
+  MicroStatsProfiler profiler(nodes, max_nodes);
+  for (uint32_t ticks = 1000; ticks >= 1; ticks--) {
+    profiler.AddSample(2, "TEST", ticks);
+  }
+  CHECK(profiler.num_nodes() == 3);
+  CHECK(profiler.node(0).count == 0);
+  CHECK(profiler.node(2).count == 1000);
+  CHECK(profiler.node(2).min_ticks == 1);
+  CHECK(profiler.node(2).max_ticks == 1000);
+  CHECK(profiler.MeanTicks(2) == 501);
+  const uint32_t p50 = profiler.PercentileTicks(2, 500);
+  const uint32_t p99 = profiler.PercentileTicks(2, 990);
+  CHECK(p50 >= 500 - 500 / 8 && p50 <= 500 + 500 / 8);
+  CHECK(p99 >= 990 - 990 / 8 && p99 <= 1000);
+  CHECK(profiler.PercentileTicks(2, 0) == 1);
+  CHECK(profiler.PercentileTicks(2, 1000) == 1000);
+  profiler.AddSample(max_nodes, "TEST", 1);
+  CHECK(profiler.dropped_events() == 1);
+
+  // Only the invoked nodes are reported.
+  static char json[512];
+  CHECK(profiler.WriteJson(json, 16) == 0);
+  size_t len = profiler.WriteJson(json, sizeof(json));
+  CHECK(len > 0 && len == strlen(json));
+  char expected[256];
+  snprintf(expected, sizeof(expected),
+           "{\"ticks_per_second\":%u,\"dropped\":1,\"nodes\":[{\"node\":2,\"op\":\"TEST\",\"count\":1000,"
+           "\"min\":1,\"max\":1000,\"mean\":501,\"p50\":%u,\"p99\":%u}]}",
+           (unsigned) tflite::ticks_per_second(), (unsigned) p50, (unsigned) p99);
+  CHECK(strcmp(json, expected) == 0);
+
+  static uint8_t binary[256];
+  CHECK(profiler.WriteBinary(binary, 20) == 0);
+  len = profiler.WriteBinary(binary, sizeof(binary));
+  CHECK(len == 14 + 1 + 4 + 6 * 4);
+  CHECK(memcmp(binary, "TFPS", 4) == 0);
+  CHECK(binary[4] == MicroStatsProfiler::kBinaryVersion);
+  CHECK(binary[5] == 1);
+  CHECK(read_u32(binary + 6) == tflite::ticks_per_second());
+  CHECK(read_u32(binary + 10) == 1);
+  CHECK(binary[14] == 4 && memcmp(binary + 15, "TEST", 4) == 0);
+  const uint32_t fields[6] = {1000, 1, 1000, 501, p50, p99};
+  for (int i = 0; i < 6; i++) {
+    CHECK(read_u32(binary + 19 + 4 * i) == fields[i]);
+  }
+
+  profiler.Reset();
+  CHECK(profiler.num_nodes() == 0);
+  CHECK(profiler.dropped_events() == 0);
+
+  // Through the interpreter: every node of the model once per inference,
+  // under the name of its operator.
+  PersonDetector detector;
+  CHECK(detector.init(arena, arena_size, &profiler) == person_detector_ok);
+  SyntheticFrameSource source(96, 96, 0, 1);
+  constexpr uint32_t inferences = 5;
+  for (uint32_t i = 0; i < inferences; i++) {
+    float score;
+    source.render(i, detector.input());
+    CHECK(detector.invoke(&score) == person_detector_ok);
+  }
+  CHECK(profiler.num_nodes() > 1);
+  CHECK(profiler.dropped_events() == 0);
+  uint64_t total = 0;
+  for (int i = 0; i < profiler.num_nodes(); i++) {
+    const MicroNodeStats& node = profiler.node(i);
+    CHECK(node.count == inferences);
+    CHECK(node.tag != nullptr && node.tag[0] != '\0');
+    CHECK(node.min_ticks <= node.max_ticks);
+    CHECK(profiler.PercentileTicks(i, 500) >= node.min_ticks);
+    CHECK(profiler.PercentileTicks(i, 990) <= node.max_ticks);
+    total += node.total_ticks;
+  }
+  CHECK(strcmp(profiler.node(profiler.num_nodes() - 1).tag, "SOFTMAX") == 0);
+  CHECK(total > 0);
+
+  static char report[8192];
+  CHECK(profiler.WriteJson(report, sizeof(report)) > 0);
+  CHECK(strstr(report, "\"op\":\"SOFTMAX\"") != nullptr);
+
+  printf("%d operators, %llu ticks in %u inferences\n", profiler.num_nodes(),
+         (unsigned long long) total, (unsigned) inferences);
+  printf("PASS\n");
+  return 0;
+
+}
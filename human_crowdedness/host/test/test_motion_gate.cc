@@ -0,0 +1,148 @@
+/**
+ * @file test_motion_gate.cc
+ * @brief Checks when the motion gate lets frames through to the model.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "motion_gate.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+constexpr int width = 96;
+constexpr int height = 96;
+constexpr int frame_size = width * height;
+
+// Fill a frame with a gray level plus a bit of noise, in the model format.
+static void fill(int8_t* img, int gray, int noise) {
+
+  for (int i = 0; i < frame_size; i++) {
+    int pixel = gray + (noise ? rand() % (2 * noise + 1) - noise : 0);
+    pixel = pixel < 0 ? 0 : (pixel > 255 ? 255 : pixel);
+    img[i] = (int8_t) (pixel ^ 0x80);
+  }
+
+}
+
+// Paint a bright square.
+static void paint(int8_t* img, int x0, int y0, int side) {
+
+  for (int y = y0; y < y0 + side; y++) {
+    for (int x = x0; x < x0 + side; x++) {
+      img[y * width + x] = (int8_t) (250 ^ 0x80);
+    }
+  }
+
+}
+
+static int test_static_scene() {
+
+  static int8_t img[frame_size];
+  MotionGate<width, height> gate;
+
+  // The first frame always goes through, and sensor noise does not.
+  fill(img, 100, 0);
+  CHECK(gate.should_infer(img));
+  for (int i = 0; i < 20; i++) {
+    fill(img, 100, 8);
+    CHECK(!gate.should_infer(img));
+  }
+  CHECK(gate.frames() == 21 && gate.skipped() == 20);
+
+  // Someone small walking in through a corner is enough.
+  fill(img, 100, 8);
+  paint(img, 0, 0, 16);
+  CHECK(gate.should_infer(img));
+
+  // And they become the new reference.
+  CHECK(!gate.should_infer(img));
+
+  // Walking out again is a change too.
+  fill(img, 100, 0);
+  CHECK(gate.should_infer(img));
+
+  return 0;
+
+}
+
+static int test_max_skipped() {
+
+  static int8_t img[frame_size];
+  MotionGateConfig config = default_motion_gate_config;
+  config.max_skipped = 3;
+  MotionGate<width, height> gate(config);
+
+  fill(img, 50, 0);
+  CHECK(gate.should_infer(img));
+  for (int round = 0; round < 3; round++) {
+    CHECK(!gate.should_infer(img));
+    CHECK(!gate.should_infer(img));
+    CHECK(!gate.should_infer(img));
+    CHECK(gate.should_infer(img));
+  }
+
+  // 0 never skips.
+  config.max_skipped = 0;
+  MotionGate<width, height> never(config);
+  for (int i = 0; i < 5; i++) {
+    CHECK(never.should_infer(img));
+  }
+
+  // Resetting forces the next frame through.
+  CHECK(!gate.should_infer(img));
+  gate.reset();
+  CHECK(gate.should_infer(img));
+
+  return 0;
+
+}
+
+static int test_histogram() {
+
+  static int8_t img[frame_size];
+
+  // With the regions out of the way, a global change still goes through
+  // because of the histogram, but a small one does not.
+  MotionGateConfig config = default_motion_gate_config;
+  config.region_threshold = 255;
+  MotionGate<width, height> gate(config);
+
+  fill(img, 100, 0);
+  CHECK(gate.should_infer(img));
+  fill(img, 102, 0);
+  CHECK(!gate.should_infer(img));
+  fill(img, 180, 0);
+  CHECK(gate.should_infer(img));
+
+  return 0;
+
+}
+
+int main() {
+
+  if (test_static_scene() || test_max_skipped() || test_histogram()) {
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
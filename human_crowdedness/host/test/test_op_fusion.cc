@@ -0,0 +1,95 @@
+/**
+ * @file test_op_fusion.cc
+ * @brief Runs the model with and without the fused depthwise + pointwise convolutions.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "frame_sources.h"
+#include "model.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+// The same as test_person_detector.cc.
+constexpr size_t arena_size = 112 * 1024;
+alignas(16) static uint8_t fused_arena[arena_size];
+alignas(16) static uint8_t plain_arena[arena_size];
+
+int main() {
+
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+
+  tflite::MicroMutableOpResolver<5> resolver;
+  resolver.AddAveragePool2D();
+  resolver.AddConv2D();
+  resolver.AddDepthwiseConv2D();
+  resolver.AddReshape();
+  resolver.AddSoftmax();
+
+  tflite::MicroInterpreter fused(model, resolver, fused_arena, arena_size);
+  fused.SetOpFusion(true);
+  CHECK(fused.AllocateTensors() == kTfLiteOk);
+
+  tflite::MicroInterpreter plain(model, resolver, plain_arena, arena_size);
+  plain.SetOpFusion(false);
+  CHECK(plain.AllocateTensors() == kTfLiteOk);
+
+  // The tensors between the fused convolutions are not planned anymore, only
+  // strips of a few of their rows and the data of the fused nodes are added.
+  printf("arena: %zu bytes fused, %zu bytes without fusion\n",
+         fused.arena_used_bytes(), plain.arena_used_bytes());
+  CHECK(fused.arena_used_bytes() < plain.arena_used_bytes() + 2048);
+
+  TfLiteTensor* fused_input = fused.input(0);
+  TfLiteTensor* plain_input = plain.input(0);
+  CHECK(fused_input->bytes == 96 * 96);
+  CHECK(plain_input->bytes == fused_input->bytes);
+
+  // Both give exactly the same scores, for scenes and for noise.
+  SyntheticFrameSource source(96, 96, 0, 1);
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < SyntheticFrameSource::period; i += 8) {
+    if (i % 16 == 0) {
+      source.render(i, fused_input->data.int8);
+    } else {
+      for (size_t p = 0; p < fused_input->bytes; p++) {
+        seed = seed * 1664525 + 1013904223;
+        fused_input->data.int8[p] = (int8_t) (seed >> 24);
+      }
+    }
+    memcpy(plain_input->data.int8, fused_input->data.int8, fused_input->bytes);
+
+    CHECK(fused.Invoke() == kTfLiteOk);
+    CHECK(plain.Invoke() == kTfLiteOk);
+
+    TfLiteTensor* fused_output = fused.output(0);
+    TfLiteTensor* plain_output = plain.output(0);
+    CHECK(fused_output->bytes == plain_output->bytes);
+    CHECK(memcmp(fused_output->data.int8, plain_output->data.int8, fused_output->bytes) == 0);
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
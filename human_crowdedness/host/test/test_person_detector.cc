@@ -0,0 +1,76 @@
+/**
+ * @file test_person_detector.cc
+ * @brief Runs the real model on the host through the person detector.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+
+#include "frame_sources.h"
+#include "person_detector.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+// A bit more than alloc_size in main.cc (100 KB), as the interpreter structures
+// in the arena are full of pointers, which are twice as big on the host.
+constexpr size_t arena_size = 112 * 1024;
+alignas(16) static uint8_t arena[arena_size];
+
+int main() {
+
+  // An arena that is too small must fail cleanly.
+  static uint8_t tiny_arena[1024];
+  PersonDetector tiny;
+  CHECK(tiny.init(tiny_arena, sizeof(tiny_arena)) == person_detector_allocation_failed);
+
+  PersonDetector detector;
+  CHECK(detector.init(arena, arena_size) == person_detector_ok);
+  CHECK(detector.input_size() == 96 * 96);
+  CHECK(detector.arena_used_bytes() <= arena_size);
+
+  // A detector whose tensors did not fit can be given a bigger arena, and
+  // then works as the other one.
+  static uint8_t small_arena[64 * 1024];
+  alignas(16) static uint8_t retry_arena[arena_size];
+  PersonDetector retried;
+  CHECK(retried.init(small_arena, sizeof(small_arena)) == person_detector_allocation_failed);
+  CHECK(retried.memory().activation_bytes == 0);
+  CHECK(retried.init(tiny_arena, sizeof(tiny_arena)) == person_detector_allocation_failed);
+  CHECK(retried.init(retry_arena, arena_size) == person_detector_ok);
+  CHECK(retried.init(retry_arena, arena_size) == person_detector_no_arena);
+  CHECK(retried.arena_used_bytes() == detector.arena_used_bytes());
+
+  // Scores are probabilities, and the same image always gives the same one.
+  SyntheticFrameSource source(96, 96, 0, 1);
+  float first = -1, again = -1;
+  for (uint32_t i = 0; i < SyntheticFrameSource::period; i += 8) {
+    source.render(i, detector.input());
+    CHECK(detector.invoke(&first) == person_detector_ok);
+    CHECK(first >= 0.0f && first <= 1.0f);
+    source.render(i, detector.input());
+    CHECK(detector.invoke(&again) == person_detector_ok);
+    CHECK(first == again);
+    source.render(i, retried.input());
+    CHECK(retried.invoke(&again) == person_detector_ok);
+    CHECK(first == again);
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
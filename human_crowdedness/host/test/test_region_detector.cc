@@ -0,0 +1,146 @@
+/**
+ * @file test_region_detector.cc
+ * @brief Checks the tile grid and the tile scheduling of the region detector.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "person_detector.h"
+#include "region_detector.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+constexpr int frame_width = 320;
+constexpr int frame_height = 240;
+
+constexpr size_t arena_size = 112 * 1024;
+alignas(16) static uint8_t arena[arena_size];
+
+/**
+ * @brief Clock that moves a fixed step every time it is read.
+ */
+class TickingClock : public Clock {
+
+ public:
+
+  explicit TickingClock(uint32_t step_us) : step_us_(step_us) {}
+
+  uint64_t now_us() override { return now_ += step_us_; }
+
+ private:
+
+  uint64_t now_ = 0;
+  uint32_t step_us_;
+
+};
+
+static int test_grid(PersonDetector* detector) {
+
+  RegionDetector regions;
+
+  // QVGA in tiles of 96 every 64 pixels, the last ones against the edges.
+  TileGridConfig config = {frame_width, frame_height, 96, 64, 4, 0};
+  CHECK(regions.init(detector, config) == person_detector_ok);
+  CHECK(regions.columns() == 5 && regions.rows() == 4 && regions.tiles() == 20);
+  CHECK(regions.tile(4).x == 224 && regions.tile(4).y == 0);
+  CHECK(regions.tile(19).x == 224 && regions.tile(19).y == 144);
+
+  // The weights add up to the number of tiles that fit in the frame, and the
+  // corner tiles overlap less than the middle ones.
+  float total = 0;
+  for (int i = 0; i < regions.tiles(); i++) {
+    total += regions.tile(i).weight;
+  }
+  CHECK(fabsf(total - (float) frame_width * frame_height / (96 * 96)) < 0.01f);
+  CHECK(regions.tile(0).weight > regions.tile(6).weight);
+
+  // A frame the size of a tile is a single tile that weighs one.
+  TileGridConfig single = {96, 96, 96, 64, 1, 0};
+  CHECK(regions.init(detector, single) == person_detector_ok);
+  CHECK(regions.tiles() == 1 && fabsf(regions.tile(0).weight - 1.0f) < 1e-4f);
+
+  // Grids that do not fit.
+  TileGridConfig too_many = {frame_width, frame_height, 96, 8, 4, 0};
+  CHECK(regions.init(detector, too_many) == region_detector_bad_grid);
+  TileGridConfig too_big = {64, 64, 96, 64, 4, 0};
+  CHECK(regions.init(detector, too_big) == region_detector_bad_grid);
+
+  return 0;
+
+}
+
+static int test_scheduling(PersonDetector* detector) {
+
+  static uint8_t frame[frame_width * frame_height];
+  for (size_t i = 0; i < sizeof(frame); i++) {
+    frame[i] = (uint8_t) rand();
+  }
+
+  // Four tiles every update go round the whole grid in five updates.
+  RegionDetector regions;
+  TileGridConfig config = {frame_width, frame_height, 96, 64, 4, 0};
+  CHECK(regions.init(detector, config) == person_detector_ok);
+  for (int update = 0; update < 5; update++) {
+    CHECK(regions.update(frame) == person_detector_ok);
+    CHECK(regions.refreshed() == 4);
+    for (int i = 0; i < 4; i++) {
+      CHECK(regions.tile(update * 4 + i).age == 0);
+    }
+  }
+  for (int i = 0; i < regions.tiles(); i++) {
+    CHECK(regions.tile(i).age == (uint32_t) (4 - i / 4));
+    CHECK(regions.tile(i).score >= 0.0f && regions.tile(i).score <= 1.0f);
+  }
+  CHECK(regions.max_score() >= regions.tile(0).score);
+
+  // Every tile counts when the threshold is 0, and none above 1.
+  CHECK(fabsf(regions.count_estimate(0.0f) - (float) frame_width * frame_height / (96 * 96)) < 0.01f);
+  CHECK(regions.count_estimate(1.1f) == 0.0f);
+
+  // With a budget of about two tiles, fewer tiles are refreshed, but never
+  // none. The clock moves 1 ms every time it is read.
+  TickingClock clock(1000);
+  config.budget_us = 5000;
+  CHECK(regions.init(detector, config, &clock) == person_detector_ok);
+  CHECK(regions.update(frame) == person_detector_ok);
+  CHECK(regions.refreshed() == 2);
+  config.budget_us = 1;
+  CHECK(regions.init(detector, config, &clock) == person_detector_ok);
+  CHECK(regions.update(frame) == person_detector_ok);
+  CHECK(regions.refreshed() == 1);
+
+  return 0;
+
+}
+
+int main() {
+
+  PersonDetector detector;
+  CHECK(detector.init(arena, arena_size) == person_detector_ok);
+
+  if (test_grid(&detector) || test_scheduling(&detector)) {
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
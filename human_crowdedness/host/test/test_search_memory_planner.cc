@@ -0,0 +1,213 @@
+/**
+ * @file test_search_memory_planner.cc
+ * @brief Tests the memory planner that searches orders, and the offline plan.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "frame_sources.h"
+#include "model.h"
+#include "offline_plan.h"
+#include "person_detector.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/search_memory_planner.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+using tflite::GreedyMemoryPlanner;
+using tflite::SearchMemoryPlanner;
+
+// The same as test_person_detector.cc.
+constexpr size_t arena_size = 112 * 1024;
+alignas(16) static uint8_t arenas[3][arena_size];
+
+static unsigned char scratch[2][4096];
+
+struct Buffer {
+  int size;
+  int first_time_used;
+  int last_time_used;
+};
+
+static uint32_t random_state = 7;
+
+static uint32_t next_random() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+int main() {
+
+  // Largest first puts the 64 byte buffer above the three 48 byte ones, but
+  // the best plan never needs more than two of them at the same time.
+  const Buffer known[] = {{48, 2, 4}, {48, 0, 2}, {48, 0, 1}, {64, 3, 5}};
+  GreedyMemoryPlanner greedy;
+  SearchMemoryPlanner search;
+  greedy.Init(scratch[0], sizeof(scratch[0]));
+  search.Init(scratch[1], sizeof(scratch[1]));
+  for (const Buffer& b : known) {
+    CHECK(greedy.AddBuffer(b.size, b.first_time_used, b.last_time_used) == kTfLiteOk);
+    CHECK(search.AddBuffer(b.size, b.first_time_used, b.last_time_used) == kTfLiteOk);
+  }
+  CHECK(greedy.GetMaximumMemorySize() == 144);
+  CHECK(search.GetSizeOrderMemorySize() == 144);
+  CHECK(search.GetLowerBound() == 112);
+  CHECK(search.GetMaximumMemorySize() == 112);
+  CHECK(!search.DoAnyBuffersOverlap());
+
+  // Random buffers: never worse than largest first, which is exactly what
+  // GreedyMemoryPlanner does, never better than the lower bound, and the same
+  // plan every time.
+  int better = 0;
+  constexpr int sets = 200;
+  for (int set = 0; set < sets; set++) {
+    Buffer buffers[24];
+    const int count = 2 + next_random() % 23;
+    for (int i = 0; i < count; i++) {
+      buffers[i].size = 16 * (1 + next_random() % 8);
+      buffers[i].first_time_used = next_random() % 12;
+      buffers[i].last_time_used = buffers[i].first_time_used + next_random() % 4;
+    }
+    GreedyMemoryPlanner random_greedy;
+    SearchMemoryPlanner random_search, again;
+    random_greedy.Init(scratch[0], sizeof(scratch[0]));
+    random_search.Init(scratch[1], sizeof(scratch[1]) / 2);
+    again.Init(scratch[1] + sizeof(scratch[1]) / 2, sizeof(scratch[1]) / 2);
+    for (int i = 0; i < count; i++) {
+      random_greedy.AddBuffer(buffers[i].size, buffers[i].first_time_used, buffers[i].last_time_used);
+      random_search.AddBuffer(buffers[i].size, buffers[i].first_time_used, buffers[i].last_time_used);
+      again.AddBuffer(buffers[i].size, buffers[i].first_time_used, buffers[i].last_time_used);
+    }
+    CHECK(random_search.GetSizeOrderMemorySize() == random_greedy.GetMaximumMemorySize());
+    CHECK(random_search.GetMaximumMemorySize() <= random_greedy.GetMaximumMemorySize());
+    CHECK(random_search.GetMaximumMemorySize() >= random_search.GetLowerBound());
+    CHECK(!random_search.DoAnyBuffersOverlap());
+    for (int i = 0; i < count; i++) {
+      int offset, offset_again;
+      CHECK(random_search.GetOffsetForBuffer(i, &offset) == kTfLiteOk);
+      CHECK(again.GetOffsetForBuffer(i, &offset_again) == kTfLiteOk);
+      CHECK(offset == offset_again);
+      CHECK(offset + buffers[i].size <= (int) random_search.GetMaximumMemorySize());
+    }
+    better += random_search.GetMaximumMemorySize() < random_greedy.GetMaximumMemorySize();
+  }
+  CHECK(better > 0);
+
+  // Offline planned buffers stay where they were put.
+  search.Init(scratch[1], sizeof(scratch[1]));
+  CHECK(search.AddBuffer(32, 0, 3, 64) == kTfLiteOk);
+  CHECK(search.AddBuffer(64, 0, 1) == kTfLiteOk);
+  CHECK(search.AddBuffer(16, 2, 3) == kTfLiteOk);
+  int offset;
+  CHECK(search.GetOffsetForBuffer(0, &offset) == kTfLiteOk && offset == 64);
+  CHECK(!search.DoAnyBuffersOverlap());
+  CHECK(search.GetOffsetForBuffer(1, &offset) == kTfLiteOk && offset == 0);
+  CHECK(search.GetMaximumMemorySize() == 96);
+  CHECK(search.GetOffsetForBuffer(3, &offset) == kTfLiteError);
+
+  // No more buffers than the scratch has room for.
+  search.Init(scratch[1], 2 * SearchMemoryPlanner::per_buffer_size());
+  CHECK(search.AddBuffer(16, 0, 1) == kTfLiteOk);
+  CHECK(search.AddBuffer(16, 0, 1) == kTfLiteOk);
+  CHECK(search.AddBuffer(16, 0, 1) == kTfLiteError);
+
+  // The model: the detector plans with SearchMemoryPlanner, and a model with
+  // the plan in its metadata gets it from GreedyMemoryPlanner as it is. All of
+  // them give the scores of the default interpreter.
+  tflite::MicroMutableOpResolver<5> resolver;
+  resolver.AddAveragePool2D();
+  resolver.AddConv2D();
+  resolver.AddDepthwiseConv2D();
+  resolver.AddReshape();
+  resolver.AddSoftmax();
+
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+  std::vector<int32_t> offsets, greedy_offsets;
+  size_t search_used, greedy_used;
+  SearchMemoryPlanner model_search;
+  CHECK(plan_tensor_offsets(model, resolver, &model_search, arenas[0], arena_size, &offsets, &search_used));
+  GreedyMemoryPlanner model_greedy;
+  CHECK(plan_tensor_offsets(model, resolver, &model_greedy, arenas[0], arena_size, &greedy_offsets, &greedy_used));
+  CHECK(model_search.GetMaximumMemorySize() <= model_search.GetSizeOrderMemorySize());
+  CHECK(model_search.GetMaximumMemorySize() >= model_search.GetLowerBound());
+  CHECK(search_used <= greedy_used);
+  int planned_tensors = 0;
+  for (size_t i = 0; i < offsets.size(); i++) {
+    CHECK((offsets[i] == tflite::kOnlinePlannedBuffer) == (greedy_offsets[i] == tflite::kOnlinePlannedBuffer));
+    planned_tensors += offsets[i] != tflite::kOnlinePlannedBuffer;
+  }
+  CHECK(planned_tensors > 0);
+
+  std::vector<uint8_t> planned;
+  CHECK(!embed_offline_plan(g_person_detect_model_data, g_person_detect_model_data_len,
+                            std::vector<int32_t>(offsets.size() + 1, -1), &planned));
+  CHECK(embed_offline_plan(g_person_detect_model_data, g_person_detect_model_data_len, offsets, &planned));
+  const tflite::Model* planned_model = tflite::GetModel(planned.data());
+  std::vector<int32_t> offline_offsets;
+  size_t offline_used;
+  GreedyMemoryPlanner offline_greedy;
+  CHECK(plan_tensor_offsets(planned_model, resolver, &offline_greedy, arenas[0], arena_size, &offline_offsets, &offline_used));
+  CHECK(offline_offsets == offsets);
+  CHECK(offline_used <= greedy_used);
+
+  // Planning again replaces the plan instead of adding another one.
+  std::vector<uint8_t> replanned;
+  CHECK(embed_offline_plan(planned.data(), planned.size(), offsets, &replanned));
+  CHECK(tflite::GetModel(replanned.data())->metadata()->size() == planned_model->metadata()->size());
+
+  tflite::MicroAllocator* reference_allocator = tflite::MicroAllocator::Create(arenas[0], arena_size);
+  tflite::MicroInterpreter reference(model, resolver, reference_allocator);
+  CHECK(reference.AllocateTensors() == kTfLiteOk);
+  tflite::MicroInterpreter offline(planned_model, resolver, arenas[1], arena_size);
+  CHECK(offline.AllocateTensors() == kTfLiteOk);
+  PersonDetector detector;
+  CHECK(detector.init(arenas[2], arena_size) == person_detector_ok);
+  CHECK(detector.memory().activation_bytes <= reference_allocator->non_persistent_used_bytes());
+
+  SyntheticFrameSource source(96, 96, 0, 1);
+  constexpr int inferences = 20;
+  for (int i = 0; i < inferences; i++) {
+    source.render(i, detector.input());
+    memcpy(reference.input(0)->data.int8, detector.input(), detector.input_size());
+    memcpy(offline.input(0)->data.int8, detector.input(), detector.input_size());
+    float score;
+    CHECK(detector.invoke(&score) == person_detector_ok);
+    CHECK(reference.Invoke() == kTfLiteOk);
+    CHECK(offline.Invoke() == kTfLiteOk);
+
+    TfLiteTensor* expected = reference.output(0);
+    CHECK(memcmp(detector.interpreter()->output(0)->data.int8, expected->data.int8, expected->bytes) == 0);
+    CHECK(memcmp(offline.output(0)->data.int8, expected->data.int8, expected->bytes) == 0);
+  }
+
+  printf("%d of %d sets smaller than largest first\n", better, sets);
+  printf("model: %zu bytes, %zu largest first, %zu at least, %d tensors planned offline\n",
+         model_search.GetMaximumMemorySize(), model_search.GetSizeOrderMemorySize(),
+         model_search.GetLowerBound(), planned_tensors);
+  printf("PASS\n");
+  return 0;
+
+}
@@ -0,0 +1,163 @@
+/**
+ * @file test_sparse_weights.cc
+ * @brief Runs a pruned copy of the model with its 1x1 filters stored sparse.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_nn_defs.h>
+
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "frame_sources.h"
+#include "model.h"
+#include "sparse_model.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+// The same as test_esp_nn_workers.cc.
+constexpr size_t arena_size = 320 * 1024;
+alignas(16) static uint8_t arenas[5][arena_size];
+
+// Unstructured pruning, as it comes out of training.
+constexpr int pruned_percent = 60;
+
+int main() {
+
+  // The shipped model is dense, nothing in it is worth storing sparse.
+  std::vector<uint8_t> unchanged;
+  SparseModelStats stats;
+  CHECK(sparsify_model(g_person_detect_model_data, g_person_detect_model_data_len, &unchanged, &stats));
+  CHECK(stats.filters > 0);
+  CHECK(stats.sparse_filters == 0);
+
+  std::vector<uint8_t> pruned;
+  CHECK(prune_model_filters(g_person_detect_model_data, g_person_detect_model_data_len, pruned_percent, &pruned));
+  std::vector<uint8_t> sparse;
+  CHECK(sparsify_model(pruned.data(), pruned.size(), &sparse, &stats));
+  // The smallest filters have fewer weights per row than their row starts
+  // take, they stay dense.
+  CHECK(stats.sparse_filters > stats.filters / 2);
+
+  // The sparse filters are smaller in flash...
+  printf("%d filters sparse, %zu bytes of weights in %zu, model %zu bytes from %zu\n",
+         stats.sparse_filters, stats.dense_bytes, stats.sparse_bytes, sparse.size(), pruned.size());
+  CHECK(stats.sparse_bytes < stats.dense_bytes);
+  CHECK(sparse.size() < pruned.size());
+  const tflite::Model* dense = tflite::GetModel(pruned.data());
+  const tflite::Model* model = tflite::GetModel(sparse.data());
+
+  tflite::MicroMutableOpResolver<5> resolver;
+  resolver.AddAveragePool2D();
+  resolver.AddConv2D();
+  resolver.AddDepthwiseConv2D();
+  resolver.AddReshape();
+  resolver.AddSoftmax();
+
+  // The pruned model run dense is the reference.
+  tflite::MicroInterpreter reference(dense, resolver, arenas[0], arena_size);
+  reference.SetOpFusion(false);
+  CHECK(reference.AllocateTensors() == kTfLiteOk);
+
+  tflite::MicroInterpreter single(model, resolver, arenas[1], arena_size);
+  single.SetOpFusion(true);
+  CHECK(single.AllocateTensors() == kTfLiteOk);
+  tflite::MicroInterpreter single_unfused(model, resolver, arenas[2], arena_size);
+  single_unfused.SetOpFusion(false);
+  CHECK(single_unfused.AllocateTensors() == kTfLiteOk);
+
+  // ...and read there, the arena only gets the descriptor of every sparse
+  // filter. With CONFIG_NN_CONV_ARENA_BUFFERS it is less than the prepared
+  // buffer the dense filter had.
+  printf("arena: %zu bytes dense, %zu bytes sparse\n",
+         reference.arena_used_bytes(), single_unfused.arena_used_bytes());
+  const size_t descriptor_bytes = (sizeof(sparse_s8_t) + 15) / 16 * 16;
+  CHECK(single_unfused.arena_used_bytes() <=
+        reference.arena_used_bytes() + stats.sparse_filters * descriptor_bytes);
+
+  // The sparse layers split between workers, through CONV_2D and through the
+  // fused depthwise + pointwise nodes.
+  CHECK(tflite::StartEspNnWorkers(3));
+  tflite::SetEspNnParallelMinMacs(0);
+  tflite::MicroInterpreter split(model, resolver, arenas[3], arena_size);
+  split.SetOpFusion(true);
+  CHECK(split.AllocateTensors() == kTfLiteOk);
+  tflite::MicroInterpreter split_unfused(model, resolver, arenas[4], arena_size);
+  split_unfused.SetOpFusion(false);
+  CHECK(split_unfused.AllocateTensors() == kTfLiteOk);
+  tflite::SetEspNnParallelMinMacs(tflite::kEspNnParallelMinMacs);
+
+  tflite::MicroInterpreter* interpreters[] = {&single, &single_unfused, &split, &split_unfused};
+
+  // All of them give exactly the scores of the pruned model.
+  SyntheticFrameSource source(96, 96, 0, 1);
+  for (uint32_t i = 0; i < SyntheticFrameSource::period; i += 8) {
+    // The arenas reuse the input for later tensors, it is copied first.
+    static int8_t frame[96 * 96];
+    source.render(i, frame);
+    for (tflite::MicroInterpreter* interpreter : interpreters) {
+      TfLiteTensor* input = interpreter->input(0);
+      CHECK(input->bytes == sizeof(frame));
+      memcpy(input->data.int8, frame, sizeof(frame));
+      CHECK(interpreter->Invoke() == kTfLiteOk);
+    }
+    memcpy(reference.input(0)->data.int8, frame, sizeof(frame));
+    CHECK(reference.Invoke() == kTfLiteOk);
+
+    TfLiteTensor* expected = reference.output(0);
+    for (tflite::MicroInterpreter* interpreter : interpreters) {
+      TfLiteTensor* output = interpreter->output(0);
+      CHECK(output->bytes == expected->bytes);
+      CHECK(memcmp(output->data.int8, expected->data.int8, expected->bytes) == 0);
+    }
+  }
+
+  tflite::StopEspNnWorkers();
+
+  // A column out of its row fails Prepare instead of reading past the values.
+  std::vector<uint8_t> broken = sparse;
+  const tflite::Model* broken_model = tflite::GetModel(broken.data());
+  const tflite::SubGraph* subgraph = broken_model->subgraphs()->Get(0);
+  bool corrupted = false;
+  for (const tflite::Tensor* tensor : *subgraph->tensors()) {
+    if (tensor->sparsity() == nullptr) {
+      continue;
+    }
+    const tflite::DimensionMetadata* csr = tensor->sparsity()->dim_metadata()->Get(tensor->shape()->size() - 1);
+    const tflite::Uint8Vector* cols = csr->array_indices_as_Uint8Vector();
+    const int row_len = tensor->shape()->Get(tensor->shape()->size() - 1);
+    if (cols != nullptr && row_len < 256) {
+      const size_t offset = cols->values()->data() - broken.data();
+      broken[offset] = (uint8_t) row_len;
+      corrupted = true;
+      break;
+    }
+  }
+  CHECK(corrupted);
+  tflite::MicroInterpreter rejected(broken_model, resolver, arenas[0], arena_size);
+  CHECK(rejected.AllocateTensors() != kTfLiteOk);
+
+  printf("PASS\n");
+  return 0;
+
+}
@@ -0,0 +1,133 @@
+/**
+ * @file test_split_arena.cc
+ * @brief Tests the detector with the activations and the rest in two arenas.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "frame_sources.h"
+#include "person_detector.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+// The same as test_person_detector.cc.
+constexpr size_t arena_size = 112 * 1024;
+alignas(16) static uint8_t arena[arena_size];
+
+// The internal SRAM and the PSRAM of the board.
+alignas(16) static uint8_t activation_arena[arena_size];
+alignas(16) static uint8_t persistent_arena[64 * 1024];
+
+// Whether two sizes are the same up to `slack` bytes.
+static bool near(size_t a, size_t b, size_t slack) {
+  return a <= b + slack && b <= a + slack;
+}
+
+static bool inside(const void* p, const uint8_t* region, size_t size) {
+  const uint8_t* b = static_cast<const uint8_t*>(p);
+  return b >= region && b < region + size;
+}
+
+int main() {
+
+  PersonDetector unused;
+  CHECK(unused.memory().activation_bytes == 0 && unused.memory().persistent.activation_arena == 0);
+
+  // With a single arena, everything is in it.
+  PersonDetector single;
+  CHECK(single.init(arena, arena_size) == person_detector_ok);
+  const PersonDetectorMemory whole = single.memory();
+  CHECK(whole.activation_bytes + whole.persistent.activation_arena == single.arena_used_bytes());
+  CHECK(whole.persistent.persistent_arena == 0);
+  CHECK(whole.eval_tensors.activation_arena > 0);
+  CHECK(whole.tensors.activation_arena > 0);
+  CHECK(whole.quantization.activation_arena > 0);
+  CHECK(whole.kernels.activation_arena > 0);
+  CHECK(whole.nodes.activation_arena > 0);
+  CHECK(whole.eval_tensors.persistent_arena + whole.tensors.persistent_arena + whole.quantization.persistent_arena +
+        whole.kernels.persistent_arena + whole.variables.persistent_arena + whole.nodes.persistent_arena == 0);
+  CHECK(whole.eval_tensors.activation_arena + whole.tensors.activation_arena + whole.quantization.activation_arena +
+        whole.kernels.activation_arena + whole.variables.activation_arena + whole.nodes.activation_arena <=
+        whole.persistent.activation_arena);
+
+  // Both arenas must be there, and big enough.
+  PersonDetector no_persistent;
+  CHECK(no_persistent.init(activation_arena, arena_size, nullptr, sizeof(persistent_arena)) == person_detector_no_arena);
+  PersonDetector small_persistent;
+  CHECK(small_persistent.init(activation_arena, arena_size, persistent_arena, 1024) == person_detector_allocation_failed);
+  PersonDetector small_activations;
+  CHECK(small_activations.init(activation_arena, whole.activation_bytes, persistent_arena, sizeof(persistent_arena)) ==
+        person_detector_allocation_failed);
+
+  // The activations take what they took of the single arena, and so do the
+  // kernels, next to them. Only the structs of the graph go to the other arena,
+  // where the persistent region takes as much as before, give or take the
+  // allocators that keep the two arenas.
+  PersonDetector measured;
+  CHECK(measured.init(activation_arena, arena_size, persistent_arena, sizeof(persistent_arena)) == person_detector_ok);
+  const PersonDetectorMemory needed = measured.memory();
+  const size_t activation_size = needed.activation_bytes + needed.persistent.activation_arena;
+  PersonDetector split;
+  CHECK(split.init(activation_arena, activation_size, persistent_arena, sizeof(persistent_arena)) == person_detector_ok);
+  const PersonDetectorMemory parts = split.memory();
+  CHECK(parts.activation_bytes == whole.activation_bytes);
+  CHECK(near(parts.persistent.activation_arena + parts.persistent.persistent_arena, whole.persistent.activation_arena, 256));
+  CHECK(parts.kernels.activation_arena == whole.kernels.activation_arena && parts.kernels.persistent_arena == 0);
+  CHECK(parts.variables.activation_arena == whole.variables.activation_arena && parts.variables.persistent_arena == 0);
+  CHECK(parts.eval_tensors.persistent_arena == whole.eval_tensors.activation_arena && parts.eval_tensors.activation_arena == 0);
+  CHECK(parts.tensors.persistent_arena == whole.tensors.activation_arena && parts.tensors.activation_arena == 0);
+  CHECK(parts.quantization.persistent_arena == whole.quantization.activation_arena &&
+        parts.quantization.activation_arena == 0);
+  CHECK(parts.nodes.persistent_arena == whole.nodes.activation_arena && parts.nodes.activation_arena == 0);
+
+  // The tensors are in the activation arena, their structs are not.
+  tflite::MicroInterpreter* interpreter = split.interpreter();
+  CHECK(inside(split.input(), activation_arena, parts.activation_bytes));
+  CHECK(inside(interpreter->output(0)->data.raw, activation_arena, parts.activation_bytes));
+  CHECK(inside(interpreter->input(0), persistent_arena, sizeof(persistent_arena)));
+  CHECK(inside(interpreter->output(0), persistent_arena, sizeof(persistent_arena)));
+  CHECK(inside(interpreter->output(0)->quantization.params, persistent_arena, sizeof(persistent_arena)));
+
+  // Where the memory is does not change what comes out of it.
+  SyntheticFrameSource source(96, 96, 0, 1);
+  constexpr int inferences = 20;
+  for (int i = 0; i < inferences; i++) {
+    source.render(i, single.input());
+    memcpy(split.input(), single.input(), single.input_size());
+    float expected, score;
+    CHECK(single.invoke(&expected) == person_detector_ok);
+    CHECK(split.invoke(&score) == person_detector_ok);
+    CHECK(score == expected);
+    TfLiteTensor* output = single.interpreter()->output(0);
+    CHECK(memcmp(interpreter->output(0)->data.int8, output->data.int8, output->bytes) == 0);
+  }
+
+  printf("single: %zu bytes of activations, %zu persistent\n", whole.activation_bytes, whole.persistent.activation_arena);
+  printf("split:  %zu bytes of activations, %zu persistent with them, %zu in the other arena\n", parts.activation_bytes,
+         parts.persistent.activation_arena, parts.persistent.persistent_arena);
+  printf("with the activations: %zu kernels, %zu variables\n", parts.kernels.activation_arena,
+         parts.variables.activation_arena);
+  printf("in the other arena: %zu eval tensors, %zu tensors, %zu quantization, %zu nodes\n",
+         parts.eval_tensors.persistent_arena, parts.tensors.persistent_arena, parts.quantization.persistent_arena,
+         parts.nodes.persistent_arena);
+  printf("PASS\n");
+  return 0;
+
+}
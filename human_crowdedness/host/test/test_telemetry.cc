@@ -0,0 +1,187 @@
+/**
+ * @file test_telemetry.cc
+ * @brief Checks the telemetry encoding round trip and its size against text.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sstream>
+
+#include "crowd_classifier.h"
+#include "telemetry.h"
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+/**
+ * @brief A cycle of a steady loop: about a second apart, with some jitter on
+ * every stage.
+ */
+static TelemetryRecord next_record(uint32_t* now_ms) {
+
+  static uint32_t faults = 0;
+
+  TelemetryRecord record;
+  *now_ms += 990 + rand() % 20;
+  record.timestamp_ms = *now_ms;
+  record.score = (uint8_t) (rand() % 256);
+  record.state = (uint8_t) (rand() % 3);
+  record.stage_us[cycle_capture] = 200 + rand() % 100;
+  record.stage_us[cycle_convert] = 150 + rand() % 50;
+  record.stage_us[cycle_invoke] = 640000 + rand() % 8000;
+  record.stage_us[cycle_post] = 100 + rand() % 50;
+  record.stage_us[cycle_sleep] = 345000 + rand() % 16000;
+  record.faults = rand() % 100 == 0 ? ++faults : faults;
+  return record;
+
+}
+
+static bool same(const TelemetryRecord& a, const TelemetryRecord& b) {
+
+  return a.timestamp_ms == b.timestamp_ms && a.score == b.score && a.state == b.state &&
+         memcmp(a.stage_us, b.stage_us, sizeof(a.stage_us)) == 0 && a.faults == b.faults;
+
+}
+
+static int test_round_trip() {
+
+  uint8_t payload[telemetry_payload_size];
+  TelemetryWriter writer(payload, sizeof(payload));
+  CHECK(writer.size() == 2 && writer.count() == 0);
+
+  // Fill a payload, then check that everything comes back.
+  TelemetryRecord sent[UINT8_MAX];
+  uint32_t now_ms = 123456;
+  int count = 0;
+  while (true) {
+    TelemetryRecord record = next_record(&now_ms);
+    size_t before = writer.size();
+    if (!writer.append(record)) {
+      // A record that does not fit leaves the payload as it was.
+      CHECK(writer.size() == before && writer.count() == count);
+      break;
+    }
+    sent[count++] = record;
+  }
+  CHECK(count > 1 && writer.count() == count);
+  CHECK(writer.size() <= telemetry_payload_size);
+  CHECK(writer.size() + telemetry_max_record_size > telemetry_payload_size);
+
+  TelemetryRecord received[UINT8_MAX];
+  CHECK(telemetry_decode(writer.data(), writer.size(), received, UINT8_MAX) == count);
+  for (int i = 0; i < count; i++) {
+    CHECK(same(sent[i], received[i]));
+  }
+
+  // A new payload starts against zero and decodes on its own.
+  writer.reset();
+  CHECK(writer.append(sent[5]));
+  CHECK(telemetry_decode(writer.data(), writer.size(), received, 1) == 1);
+  CHECK(same(sent[5], received[0]));
+
+  // Times that go backwards and values at the limits survive too.
+  TelemetryRecord extreme = {UINT32_MAX, 255, crowd_full, {0, UINT32_MAX, 1, UINT32_MAX - 1, 0x80000000u}, UINT32_MAX};
+  TelemetryRecord earlier = {0, 0, crowd_empty, {UINT32_MAX, 0, UINT32_MAX, 0, 0x7fffffffu}, 0};
+  CHECK(writer.append(extreme) && writer.append(earlier));
+  CHECK(telemetry_decode(writer.data(), writer.size(), received, 3) == 3);
+  CHECK(same(extreme, received[1]) && same(earlier, received[2]));
+
+  return 0;
+
+}
+
+static int test_bad_payloads() {
+
+  uint8_t payload[telemetry_payload_size];
+  TelemetryWriter writer(payload, sizeof(payload));
+  uint32_t now_ms = 0;
+  for (int i = 0; i < 4; i++) {
+    CHECK(writer.append(next_record(&now_ms)));
+  }
+
+  TelemetryRecord received[4];
+  CHECK(telemetry_decode(writer.data(), writer.size(), received, 4) == 4);
+
+  // Too many records for the caller, cut short, too long and wrong version.
+  CHECK(telemetry_decode(writer.data(), writer.size(), received, 3) == -1);
+  CHECK(telemetry_decode(writer.data(), writer.size() - 1, received, 4) == -1);
+  CHECK(telemetry_decode(writer.data(), writer.size() + 1, received, 4) == -1);
+  CHECK(telemetry_decode(writer.data(), 1, received, 4) == -1);
+  payload[0]++;
+  CHECK(telemetry_decode(writer.data(), writer.size(), received, 4) == -1);
+
+  // A buffer smaller than a record never takes one.
+  uint8_t tiny[8];
+  TelemetryWriter small(tiny, sizeof(tiny));
+  CHECK(!small.append(next_record(&now_ms)) && small.count() == 0);
+
+  // Scores are clamped to a byte.
+  CHECK(telemetry_quantize_score(-1.0f) == 0 && telemetry_quantize_score(0.0f) == 0);
+  CHECK(telemetry_quantize_score(0.5f) == 128 && telemetry_quantize_score(2.0f) == 255);
+
+  return 0;
+
+}
+
+static int test_size_against_text() {
+
+  // The same results as the current printing path writes them, for a score
+  // that has all its decimals, and as records.
+  constexpr int results = 1000;
+  std::ostringstream text;
+  uint8_t payload[telemetry_payload_size];
+  TelemetryWriter writer(payload, sizeof(payload));
+  size_t binary_bytes = 0;
+  uint32_t now_ms = 0;
+
+  for (int i = 0; i < results; i++) {
+    TelemetryRecord record = next_record(&now_ms);
+    text << "People score: " << record.score / 255.0f * 100 << std::endl;
+    if (!writer.append(record)) {
+      binary_bytes += writer.size();
+      writer.reset();
+      CHECK(writer.append(record));
+    }
+  }
+  binary_bytes += writer.size();
+
+  // The records carry the timings and the state as well as the score, and
+  // they still take less than the score alone as text.
+  double text_per_result = (double) text.str().size() / results;
+  double binary_per_result = (double) binary_bytes / results;
+  printf("text:   %.1f bytes/result\nbinary: %.1f bytes/result\n", text_per_result, binary_per_result);
+  CHECK(binary_per_result < text_per_result);
+
+  return 0;
+
+}
+
+int main() {
+
+  srand(1);
+
+  if (test_round_trip() || test_bad_payloads() || test_size_against_text()) {
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
@@ -19,10 +19,40 @@
 #include "esp_system.h"
 #include "sensor.h"
 
+#include "frame_convert.h"
+
+std::mutex camera_frames_mutex;
+
+camera_fb_t* get_frame_from_cam() {
+
+  return esp_camera_fb_get();
+
+}
+
+void return_frame_to_cam(camera_fb_t* fb) {
+
+  esp_camera_fb_return(fb);
+
+}
+
+int frame_to_image(const camera_fb_t* fb, int8_t* img) {
+
+  // If the frame is smaller than what the model expects, something is off.
+  if (fb->len < (size_t) cam_size) {
+    return -1;
+  }
+
+  // Convert the data from the buffer to the right integers.
+  convert_frame_to_input(fb->buf, img, cam_size);
+
+  return ESP_OK;
+
+}
+
 int get_image_from_cam(int8_t* img) {
 
   // Read a frame from the camera.
-  camera_fb_t* fb = esp_camera_fb_get();
+  camera_fb_t* fb = get_frame_from_cam();
 
   // If nothing was read, an error occurred.
   if (!fb) {
@@ -30,15 +60,41 @@ int get_image_from_cam(int8_t* img) {
   }
 
   // Convert the data from the buffer to the right integers.
-  for (int i = 0; i < cam_width * cam_height; i++) {
-    img[i] = ((uint8_t *) fb->buf)[i] ^ 0x80;
-  }
+  int status = frame_to_image(fb, img);
 
-  // Free the camera.
-  esp_camera_fb_return(fb);
+  // Free the camera straight away, so that the driver can fill this buffer
+  // again while the model is running.
+  return_frame_to_cam(fb);
 
   // Return an OK code if all went well.
-  return ESP_OK;
+  return status;
+
+}
+
+int CameraFrameSource::get_image(int8_t* img) {
+
+  std::lock_guard<std::mutex> lock(camera_frames_mutex);
+
+  // Get the latest frame from the capture task.
+  camera_fb_t* fb = nullptr;
+  if (!queue_->pop(&fb, timeout_ms_)) {
+    return frame_source_error;
+  }
+
+  if (timer_) {
+    timer_->mark(cycle_capture);
+  }
+
+  // Convert it into the model input and give it back to the camera before the
+  // model starts.
+  int status = frame_to_image(fb, img);
+  return_frame_to_cam(fb);
+
+  if (timer_) {
+    timer_->mark(cycle_convert);
+  }
+
+  return status;
 
 }
 
@@ -54,7 +110,7 @@ int init_camera() {
   gpio_config(&conf);
   conf.pin_bit_mask = 1LL << 14;
   gpio_config(&conf);
-  camera_config_t config;
+  camera_config_t config = {};
   config.ledc_channel = LEDC_CHANNEL_0;
   config.ledc_timer = LEDC_TIMER_0;
   config.pin_d0 = CAMERA_PIN_D0;
@@ -77,9 +133,13 @@ int init_camera() {
   config.pixel_format = CAMERA_PIXEL_FORMAT;
   config.frame_size = CAMERA_FRAME_SIZE;
   config.jpeg_quality = 10;
-  config.fb_count = 2;
+  config.fb_count = cam_fb_count;
   config.fb_location = CAMERA_FB_IN_PSRAM;
 
+  // Keep both buffers filling in the background while we run the model, so
+  // that the next frame is already waiting (and fresh) when we ask for it.
+  config.grab_mode = CAMERA_GRAB_LATEST;
+
   // Init the camera and detect if it failed.
   if (ESP_OK != esp_camera_init(&config)) {
     return -1;
@@ -93,3 +153,19 @@ int init_camera() {
   return ESP_OK;
 
 }
+
+int reinit_camera(CameraFrameQueue* queue) {
+
+  // Wait until nobody is using a frame, and give back the ones nobody took.
+  std::lock_guard<std::mutex> lock(camera_frames_mutex);
+  camera_fb_t* fb = nullptr;
+  while (queue->try_pop(&fb)) {
+    return_frame_to_cam(fb);
+  }
+
+  // Stop the driver. If it is too broken to stop, starting it will tell.
+  esp_camera_deinit();
+
+  return init_camera();
+
+}
@@ -16,10 +16,16 @@
 #ifndef CAMERA_CTRL_H_
 #define CAMERA_CTRL_H_
 
+#include <mutex>
+
 #include "esp_camera.h"
 #include "esp_system.h"
 #include "sensor.h"
 
+#include "duty_cycle.h"
+#include "frame_queue.h"
+#include "frame_source.h"
+
 /**
  * COLOR:
  * 
@@ -45,8 +51,19 @@
  * FRAMESIZE_UXGA,     // 1600x1200
  */
 
+// Set to 1 to capture QVGA frames and run the model on tiles of them (see
+// region_detector.h), which gives an occupancy map of the room instead of a
+// single score for all of it.
+#ifndef CAMERA_TILED_MODE
+#define CAMERA_TILED_MODE 0
+#endif
+
 #define CAMERA_PIXEL_FORMAT PIXFORMAT_GRAYSCALE
+#if CAMERA_TILED_MODE
+#define CAMERA_FRAME_SIZE FRAMESIZE_QVGA
+#else
 #define CAMERA_FRAME_SIZE FRAMESIZE_96X96
+#endif
 
 #define CAMERA_MODULE_NAME "ESP-EYE"
 #define CAMERA_PIN_PWDN -1
@@ -70,11 +87,89 @@
 #define XCLK_FREQ_HZ 15000000
 
 // Set the camera constants.
+#if CAMERA_TILED_MODE
+constexpr int cam_width = 320;
+constexpr int cam_height = 240;
+#else
 constexpr int cam_width = 96;
 constexpr int cam_height = 96;
+#endif
 constexpr int cam_channels = 1;
 constexpr int cam_size = cam_width * cam_height * cam_channels;
 
+// Number of frame buffers the camera driver works with. One of them is always
+// being filled by the driver, the rest can be held by the application.
+constexpr int cam_fb_count = 2;
+
+// Queue that takes the frames from the capture task to the inference task.
+// The driver is always filling one of the buffers, so only the rest of them
+// can be waiting here.
+typedef FrameQueue<camera_fb_t*, cam_fb_count - 1> CameraFrameQueue;
+
+// Held by whoever has a frame of the driver outside the capture task, so that
+// the driver is not restarted while the frame is still in use.
+extern std::mutex camera_frames_mutex;
+
+/**
+ * @brief Frame source that takes the frames the capture task left in a queue.
+ *
+ * Every frame is converted into the model input and given back to the camera
+ * straight away, so that it can be filled again while the model is running.
+ * The frame is taken with camera_frames_mutex held.
+ */
+class CameraFrameSource : public FrameSource {
+
+ public:
+
+  /**
+   * @brief Build the source.
+   *
+   * @param queue The queue the capture task pushes the frames into.
+   * @param timeout_ms How long to wait for a frame before failing.
+   * @param timer If given, where the time spent waiting for the frame and
+   * converting it is marked.
+   */
+  CameraFrameSource(CameraFrameQueue* queue, uint32_t timeout_ms, CycleTimer* timer = nullptr)
+      : queue_(queue), timeout_ms_(timeout_ms), timer_(timer) {}
+
+  int get_image(int8_t* img) override;
+
+ private:
+
+  CameraFrameQueue* queue_;
+  uint32_t timeout_ms_;
+  CycleTimer* timer_;
+
+};
+
+/**
+ * @brief Get a raw frame from the camera.
+ * 
+ * Get a frame buffer from the ESP-EYE camera without copying it. It must be
+ * given back with return_frame_to_cam() as soon as possible, as the camera
+ * only has cam_fb_count of them.
+ * 
+ * @returns The frame, or NULL if the camera failed.
+ */
+camera_fb_t* get_frame_from_cam();
+
+/**
+ * @brief Give a raw frame back to the camera.
+ * 
+ * @param fb The frame obtained from get_frame_from_cam().
+ */
+void return_frame_to_cam(camera_fb_t* fb);
+
+/**
+ * @brief Convert a raw frame into the model input.
+ * 
+ * @param fb The frame obtained from get_frame_from_cam().
+ * @param img Where the image will be stored.
+ * 
+ * @returns A status. If is ESP_OK, it's that everything worked.
+ */
+int frame_to_image(const camera_fb_t* fb, int8_t* img);
+
 /**
  * @brief Get ain image from the camera.
  * 
@@ -95,4 +190,17 @@ int get_image_from_cam(int8_t* img);
  */
 int init_camera();
 
+/**
+ * @brief Restart the camera driver.
+ * 
+ * Gives the frames still in the queue back, then stops and starts the driver
+ * again. The model and its arena are not touched, so it is much faster than
+ * restarting the board. It must be called from the capture task.
+ * 
+ * @param queue The queue the capture task pushes the frames into.
+ * 
+ * @returns A status. If is ESP_OK, it's that everything worked.
+ */
+int reinit_camera(CameraFrameQueue* queue);
+
 #endif  // CAMERA_CTRL_H_
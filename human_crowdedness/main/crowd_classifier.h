@@ -0,0 +1,212 @@
+/**
+ * @file crowd_classifier.h
+ * @brief Turns the stream of people scores into a stable crowdedness verdict.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef CROWD_CLASSIFIER_H_
+#define CROWD_CLASSIFIER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief How crowded the room is.
+ *
+ * The values are the ones of the result that loop() used to compute straight
+ * from the score of a single frame.
+ */
+enum CrowdState {
+  crowd_empty = 0,  // The room is empty.
+  crowd_some = 1,   // There are some people in the room.
+  crowd_full = 2,   // The room is too full.
+};
+
+/**
+ * @brief Thresholds on the smoothed score to move between states.
+ *
+ * A state is entered when the score goes up to its enter threshold and left
+ * when it goes below its exit one, which must be lower so that a score that
+ * hovers around a threshold does not make the verdict flicker.
+ */
+struct CrowdThresholds {
+  float enter_some;
+  float exit_some;
+  float enter_full;
+  float exit_full;
+};
+
+// The thresholds loop() used to have (0.5 and 0.65), with some room below.
+constexpr CrowdThresholds default_crowd_thresholds = {0.5f, 0.4f, 0.65f, 0.55f};
+
+/**
+ * @brief A change of the crowdedness verdict.
+ */
+struct CrowdEvent {
+  CrowdState from;
+  CrowdState to;
+  float score;      // The smoothed score that made the state change.
+  uint32_t frame;   // The number of the frame that made the state change.
+};
+
+/**
+ * @brief Smooths the people score over a window of frames, with hysteresis.
+ *
+ * Keeps the last Window scores in a ring buffer together with their running
+ * sum, so every frame costs the same no matter how long the window is, and
+ * nothing is allocated. The scores are kept in fixed point so that the sum
+ * never drifts, however many frames go through it.
+ *
+ * Only changes of the verdict are reported, which is what has to go through
+ * the radio.
+ *
+ * @tparam Window How many frames the score is averaged over.
+ */
+template <size_t Window>
+class CrowdClassifier {
+
+  static_assert(Window > 0, "The window needs at least one frame");
+
+ public:
+
+  /**
+   * @brief Build the classifier, starting with an empty room.
+   *
+   * @param thresholds Where the states begin and end.
+   */
+  explicit CrowdClassifier(const CrowdThresholds& thresholds = default_crowd_thresholds)
+      : enter_some_(to_fixed(thresholds.enter_some)),
+        exit_some_(to_fixed(thresholds.exit_some)),
+        enter_full_(to_fixed(thresholds.enter_full)),
+        exit_full_(to_fixed(thresholds.exit_full)) {}
+
+  /**
+   * @brief Add the score of a new frame.
+   *
+   * @param score The probability of having people in the frame, in [0, 1].
+   * @param event Where the change will be stored if the verdict changed.
+   *
+   * @returns True if the verdict changed, false otherwise.
+   */
+  bool update(float score, CrowdEvent* event) {
+
+    uint32_t fixed = to_fixed(score);
+
+    // Replace the oldest score in the window.
+    if (count_ == Window) {
+      sum_ -= scores_[next_];
+    } else {
+      count_++;
+    }
+    scores_[next_] = fixed;
+    sum_ += fixed;
+    next_ = next_ + 1 == Window ? 0 : next_ + 1;
+    frame_++;
+
+    CrowdState next_state = next();
+
+    if (next_state == state_) {
+      return false;
+    }
+
+    event->from = state_;
+    event->to = next_state;
+    event->score = smoothed_score();
+    event->frame = frame_ - 1;
+    state_ = next_state;
+
+    return true;
+
+  }
+
+  /**
+   * @brief The current verdict.
+   */
+  CrowdState state() const { return state_; }
+
+  /**
+   * @brief The score averaged over the window, or over what we have of it.
+   */
+  float smoothed_score() const {
+    return count_ ? (float) sum_ / count_ / score_one : 0.0f;
+  }
+
+  /**
+   * @brief Forget every score and go back to an empty room.
+   */
+  void reset() {
+    count_ = 0;
+    next_ = 0;
+    sum_ = 0;
+    frame_ = 0;
+    state_ = crowd_empty;
+  }
+
+ private:
+
+  // Fixed point scale of the scores, enough to keep every bit of the 8-bit
+  // quantized scores of the model.
+  static constexpr uint32_t score_one = 1 << 16;
+
+  // Clamp a score to [0, 1] and convert it to fixed point.
+  static uint32_t to_fixed(float score) {
+    if (!(score > 0.0f)) {
+      return 0;
+    }
+    if (score > 1.0f) {
+      return score_one;
+    }
+    return (uint32_t) (score * score_one + 0.5f);
+  }
+
+  // Apply the hysteresis to the smoothed score. The sum is compared against
+  // the thresholds scaled by the number of scores, so that no division is
+  // needed and a score right on a threshold always counts as reaching it.
+  CrowdState next() const {
+
+    auto reaches = [this](uint32_t threshold) { return sum_ >= (uint64_t) threshold * count_; };
+
+    switch (state_) {
+      case crowd_empty:
+        if (reaches(enter_full_)) return crowd_full;
+        if (reaches(enter_some_)) return crowd_some;
+        return crowd_empty;
+      case crowd_some:
+        if (reaches(enter_full_)) return crowd_full;
+        if (!reaches(exit_some_)) return crowd_empty;
+        return crowd_some;
+      case crowd_full:
+      default:
+        if (!reaches(exit_some_)) return crowd_empty;
+        if (!reaches(exit_full_)) return crowd_some;
+        return crowd_full;
+    }
+
+  }
+
+  // The thresholds, in fixed point.
+  uint32_t enter_some_;
+  uint32_t exit_some_;
+  uint32_t enter_full_;
+  uint32_t exit_full_;
+
+  uint32_t scores_[Window];
+  size_t count_ = 0;
+  size_t next_ = 0;
+  uint64_t sum_ = 0;
+  uint32_t frame_ = 0;
+
+  CrowdState state_ = crowd_empty;
+
+};
+
+#endif  // CROWD_CLASSIFIER_H_
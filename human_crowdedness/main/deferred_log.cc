@@ -0,0 +1,114 @@
+/**
+ * @file deferred_log.cc
+ * @brief Logging that leaves the formatting to a low priority task.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include "deferred_log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Letter of every level at the start of the lines.
+static const char level_letters[] = "-EWID";
+
+// Longest conversion, flags, width and precision included.
+constexpr size_t max_spec = 16;
+
+size_t log_format(const LogRecord& record, char* line, size_t size) {
+
+  // Leave room for the newline and the terminator.
+  if (size < 2) {
+    return 0;
+  }
+  size_t room = size - 1;
+
+  char level = record.level < sizeof(level_letters) - 1 ? level_letters[record.level] : '?';
+  int len = snprintf(line, room, "[%c %lu.%03lu] ", level,
+                     (unsigned long) (record.timestamp_us / 1000000),
+                     (unsigned long) (record.timestamp_us / 1000 % 1000));
+  size_t pos = len < 0 ? 0 : (size_t) len < room ? (size_t) len : room - 1;
+
+  int arg = 0;
+  for (const char* in = record.format; *in && pos < room - 1; in++) {
+
+    if (*in != '%') {
+      line[pos++] = *in;
+      continue;
+    }
+
+    if (in[1] == '%') {
+      line[pos++] = '%';
+      in++;
+      continue;
+    }
+
+    // Copy the flags, width and precision, and skip the length modifiers.
+    char spec[max_spec];
+    size_t spec_len = 0;
+    spec[spec_len++] = *in++;
+    while (*in && strchr("-+ #0123456789.hlzjt", *in)) {
+      if (!strchr("hlzjt", *in) && spec_len < max_spec - 2) {
+        spec[spec_len++] = *in;
+      }
+      in++;
+    }
+    if (!*in) {
+      break;
+    }
+    spec[spec_len++] = *in;
+    spec[spec_len] = '\0';
+
+    // A conversion without its argument is left out.
+    if (arg >= record.argc) {
+      continue;
+    }
+    const LogArg& value = record.args[arg++];
+
+    char* out = line + pos;
+    size_t left = room - pos;
+    switch (*in) {
+      case 'd':
+      case 'i':
+        len = snprintf(out, left, spec, (int) value.i);
+        break;
+      case 'u':
+      case 'x':
+      case 'X':
+        len = snprintf(out, left, spec, (unsigned) value.u);
+        break;
+      case 'c':
+        len = snprintf(out, left, spec, (int) value.i);
+        break;
+      case 'f':
+      case 'g':
+      case 'e':
+        len = snprintf(out, left, spec, (double) value.f);
+        break;
+      case 's':
+        len = snprintf(out, left, spec, value.s ? value.s : "(null)");
+        break;
+      default:
+        len = 0;
+        break;
+    }
+    if (len > 0) {
+      pos += (size_t) len < left ? (size_t) len : left - 1;
+    }
+
+  }
+
+  line[pos++] = '\n';
+  line[pos] = '\0';
+  return pos;
+
+}
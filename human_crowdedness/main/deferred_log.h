@@ -0,0 +1,306 @@
+/**
+ * @file deferred_log.h
+ * @brief Logging that leaves the formatting to a low priority task.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef DEFERRED_LOG_H_
+#define DEFERRED_LOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <type_traits>
+
+#include "duty_cycle.h"
+
+// Levels of the messages. Messages above DLOG_LEVEL are removed at compile
+// time, arguments included.
+#define DLOG_LEVEL_NONE 0
+#define DLOG_LEVEL_ERROR 1
+#define DLOG_LEVEL_WARN 2
+#define DLOG_LEVEL_INFO 3
+#define DLOG_LEVEL_DEBUG 4
+
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_ERROR
+#define DLOG_ERROR(log, ...) (log).write(DLOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define DLOG_ERROR(log, ...) ((void) 0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_WARN
+#define DLOG_WARN(log, ...) (log).write(DLOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define DLOG_WARN(log, ...) ((void) 0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_INFO
+#define DLOG_INFO(log, ...) (log).write(DLOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define DLOG_INFO(log, ...) ((void) 0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_DEBUG
+#define DLOG_DEBUG(log, ...) (log).write(DLOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define DLOG_DEBUG(log, ...) ((void) 0)
+#endif
+
+// Most arguments a message can take.
+constexpr int log_max_args = 4;
+
+// Longest line a message is formatted into, longer ones are cut.
+constexpr size_t log_max_line = 128;
+
+/**
+ * @brief An argument of a message, as it was given.
+ */
+union LogArg {
+  int32_t i;
+  uint32_t u;
+  float f;
+  const char* s;
+};
+
+/**
+ * @brief A message that has not been formatted yet.
+ *
+ * The format is a string literal, so its address identifies the message and
+ * the text itself stays in flash until the record is formatted.
+ */
+struct LogRecord {
+  uint64_t timestamp_us;
+  const char* format;
+  uint8_t level;
+  uint8_t argc;
+  LogArg args[log_max_args];
+};
+
+/**
+ * @brief Where the formatted lines go.
+ */
+class LogWriter {
+
+ public:
+
+  virtual ~LogWriter() {}
+
+  /**
+   * @brief Write one line, newline included.
+   */
+  virtual void write(const char* line, size_t len) = 0;
+
+};
+
+/**
+ * @brief Format a record into a line.
+ *
+ * The format takes the printf conversions d, i, u, x, X, c, f, g, e and s,
+ * with flags, width and precision. Length modifiers are ignored, as every
+ * argument was stored in 32 bits. Strings must be literals, as they are only
+ * read when the record is formatted.
+ *
+ * @param record The record to format.
+ * @param line Where the line will be written, with its newline.
+ * @param size The size of line.
+ *
+ * @returns The length of the line.
+ */
+size_t log_format(const LogRecord& record, char* line, size_t size);
+
+/**
+ * @brief Ring of messages written by one task and formatted by another.
+ *
+ * The task that logs only stores the format and the arguments, which takes a
+ * few dozen cycles and never blocks: when the ring is full the message is
+ * dropped and counted. Another task, with a low priority, drains the ring
+ * every now and then, formats the messages and writes them out, so that the
+ * printing and its flushes never stall the inference.
+ *
+ * There must be a single producer and a single consumer. Tasks that log from
+ * different tasks must each have their own ring.
+ *
+ * @tparam Capacity How many messages can be waiting. A power of two.
+ */
+template <size_t Capacity>
+class DeferredLog {
+
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "The capacity must be a power of two");
+
+ public:
+
+  /**
+   * @brief Build the ring.
+   *
+   * @param clock Where the time of the messages comes from, or null to not
+   * stamp them.
+   */
+  explicit DeferredLog(Clock* clock = nullptr) : clock_(clock) {}
+
+  /**
+   * @brief Log a message. Use the DLOG_ macros instead, so that the levels
+   * can be removed at compile time.
+   *
+   * @param level One of DLOG_LEVEL_ERROR to DLOG_LEVEL_DEBUG.
+   * @param format A string literal with printf conversions.
+   * @param args Up to log_max_args numbers or string literals.
+   *
+   * @returns True if the message was stored, false if it was dropped.
+   */
+  template <typename... Args>
+  bool write(uint8_t level, const char* format, Args... args) {
+
+    static_assert(sizeof...(Args) <= log_max_args, "Too many arguments for a log message");
+
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    LogRecord& record = records_[head & (Capacity - 1)];
+    record.timestamp_us = clock_ ? clock_->now_us() : 0;
+    record.format = format;
+    record.level = level;
+    record.argc = (uint8_t) sizeof...(Args);
+    store(record.args, args...);
+
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+
+  }
+
+  /**
+   * @brief Take the oldest message out of the ring. Consumer only.
+   *
+   * @param record Where the message will be stored.
+   *
+   * @returns True if a message was taken, false if the ring was empty.
+   */
+  bool pop(LogRecord* record) {
+
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    *record = records_[tail & (Capacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+
+  }
+
+  /**
+   * @brief Format the waiting messages and write them out. Consumer only.
+   *
+   * A line is added for the messages dropped since the last drain.
+   *
+   * @param writer Where the lines go.
+   * @param max The most messages to write.
+   *
+   * @returns The number of messages written.
+   */
+  size_t drain(LogWriter* writer, size_t max = Capacity) {
+
+    char line[log_max_line];
+    LogRecord record;
+    size_t count = 0;
+
+    uint32_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_) {
+      LogRecord lost = {0, "%u log messages dropped", DLOG_LEVEL_WARN, 1, {}};
+      lost.args[0].u = dropped - reported_;
+      writer->write(line, log_format(lost, line, sizeof(line)));
+      reported_ = dropped;
+    }
+
+    while (count < max && pop(&record)) {
+      writer->write(line, log_format(record, line, sizeof(line)));
+      count++;
+    }
+
+    return count;
+
+  }
+
+  /**
+   * @brief The number of messages waiting to be written.
+   */
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief The number of messages dropped because the ring was full.
+   */
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+
+  // Store every argument in the 32 bits its conversion will read.
+  template <typename T>
+  static LogArg to_arg(T value, std::true_type /* integral */) {
+    LogArg arg;
+    if (std::is_signed<T>::value) {
+      arg.i = (int32_t) value;
+    } else {
+      arg.u = (uint32_t) value;
+    }
+    return arg;
+  }
+
+  template <typename T>
+  static LogArg to_arg(T value, std::false_type /* floating point */) {
+    LogArg arg;
+    arg.f = (float) value;
+    return arg;
+  }
+
+  static LogArg to_arg(const char* value) {
+    LogArg arg;
+    arg.s = value;
+    return arg;
+  }
+
+  template <typename T>
+  static LogArg to_arg(T value) {
+    static_assert(std::is_arithmetic<T>::value, "Log arguments must be numbers or string literals");
+    return to_arg(value, std::is_integral<T>());
+  }
+
+  static void store(LogArg*) {}
+
+  template <typename T, typename... Rest>
+  static void store(LogArg* out, T first, Rest... rest) {
+    *out = to_arg(first);
+    store(out + 1, rest...);
+  }
+
+  Clock* clock_;
+
+  LogRecord records_[Capacity];
+
+  // Free running counters, the slot is the counter modulo the capacity.
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+
+  std::atomic<uint32_t> dropped_{0};
+  uint32_t reported_ = 0;
+
+};
+
+#endif  // DEFERRED_LOG_H_
@@ -0,0 +1,295 @@
+/**
+ * @file duty_cycle.h
+ * @brief Picks how long to sleep between frames and keeps their timings.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef DUTY_CYCLE_H_
+#define DUTY_CYCLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crowd_classifier.h"
+
+/**
+ * @brief Where the time goes in a cycle of the main loop.
+ */
+enum CycleStage {
+  cycle_capture = 0,  // Waiting for a frame.
+  cycle_convert,      // Converting it into the model input.
+  cycle_invoke,       // Running the model, or deciding not to.
+  cycle_post,         // Everything done with the result.
+  cycle_sleep,        // Sleeping until the next cycle.
+  cycle_stages,
+};
+
+/**
+ * @brief The time spent in every stage of one cycle.
+ */
+struct CycleTiming {
+  uint32_t us[cycle_stages];
+};
+
+/**
+ * @brief Something that tells the time.
+ *
+ * The board uses its high resolution timer, and tests a clock they move by
+ * hand.
+ */
+class Clock {
+
+ public:
+
+  virtual ~Clock() {}
+
+  /**
+   * @brief The time since some fixed point in the past, in microseconds.
+   */
+  virtual uint64_t now_us() = 0;
+
+};
+
+/**
+ * @brief Times the stages of a cycle.
+ *
+ * Every stage is charged the time since the previous mark, so the stages of a
+ * cycle always add up to its length. It is kept apart from the scheduler so
+ * that whoever does a stage, like the frame source, can mark it.
+ */
+class CycleTimer {
+
+ public:
+
+  /**
+   * @brief Build the timer.
+   *
+   * @param clock The clock used to time the stages. It must outlive the
+   * timer.
+   */
+  explicit CycleTimer(Clock* clock) : clock_(clock) {}
+
+  /**
+   * @brief Charge the time since the last mark to a stage.
+   *
+   * @param stage The stage that just finished.
+   */
+  void mark(CycleStage stage) {
+
+    uint64_t now = clock_->now_us();
+    current_.us[stage] += (uint32_t) (now - mark_us_);
+    mark_us_ = now;
+
+  }
+
+ protected:
+
+  // Start timing a new cycle.
+  uint64_t start() {
+
+    uint64_t now = clock_->now_us();
+    cycle_start_us_ = now;
+    mark_us_ = now;
+    for (int i = 0; i < cycle_stages; i++) {
+      current_.us[i] = 0;
+    }
+    return now;
+
+  }
+
+  Clock* clock_;
+  CycleTiming current_ = {};
+  uint64_t cycle_start_us_ = 0;
+  uint64_t mark_us_ = 0;
+
+};
+
+/**
+ * @brief Limits of the scheduler.
+ */
+struct DutyCycleConfig {
+
+  // Shortest and longest time between the start of two cycles.
+  uint32_t min_period_ms;
+  uint32_t max_period_ms;
+
+  // Number of cycles the room must stay empty before the period doubles.
+  uint32_t empty_cycles_per_step;
+
+  // Highest fraction of the time the loop may be busy, in (0, 1]. The period
+  // is stretched when a cycle takes longer than this allows.
+  float max_duty;
+
+  // Shortest sleep, so that the lower priority tasks always get to run.
+  uint32_t min_sleep_ms;
+
+};
+
+// Four frames a second when the room is busy, where the fixed vTaskDelay(100)
+// gave one, and up to 8 s between frames when it has been empty for a while.
+constexpr DutyCycleConfig default_duty_cycle_config = {250, 8000, 10, 0.8f, 10};
+
+/**
+ * @brief Adaptive duty cycling of the main loop.
+ *
+ * Runs as fast as allowed while there are people in the room or the verdict
+ * just changed, and backs off exponentially, up to the maximum period, while
+ * the room stays empty. The measured time of every cycle is subtracted from
+ * the period, and the period grows if the model takes so long that the loop
+ * would be busy more than max_duty of the time.
+ *
+ * The timings of the last History cycles are kept in a ring buffer so that
+ * they can be read back at any moment.
+ *
+ * @tparam History How many cycles to keep the timings of.
+ */
+template <size_t History>
+class DutyCycleScheduler : public CycleTimer {
+
+  static_assert(History > 0, "The history needs at least one cycle");
+
+ public:
+
+  /**
+   * @brief Build the scheduler.
+   *
+   * @param clock The clock used to time the stages. It must outlive the
+   * scheduler.
+   * @param config The limits of the scheduler.
+   */
+  DutyCycleScheduler(Clock* clock, const DutyCycleConfig& config = default_duty_cycle_config)
+      : CycleTimer(clock), config_(config), period_ms_(config.min_period_ms) {}
+
+  /**
+   * @brief Start a new cycle.
+   *
+   * The time since the end of the last cycle is its real sleep time.
+   */
+  void begin_cycle() {
+
+    uint64_t now = start();
+
+    if (count_ > 0 && sleeping_) {
+      timings_[last()].us[cycle_sleep] = (uint32_t) (now - sleep_start_us_);
+    }
+    sleeping_ = false;
+
+  }
+
+  /**
+   * @brief Finish the cycle and decide how long to sleep.
+   *
+   * The time since the last mark is charged to the post-processing stage.
+   *
+   * @param state The verdict after this cycle.
+   *
+   * @returns How long to sleep before the next cycle, in milliseconds.
+   */
+  uint32_t end_cycle(CrowdState state) {
+
+    mark(cycle_post);
+
+    // Busy room, or it just changed: as fast as allowed. Empty: back off.
+    if (state != crowd_empty || state != last_state_) {
+      period_ms_ = config_.min_period_ms;
+      empty_cycles_ = 0;
+    } else if (++empty_cycles_ >= config_.empty_cycles_per_step) {
+      period_ms_ = period_ms_ * 2 > config_.max_period_ms ? config_.max_period_ms : period_ms_ * 2;
+      empty_cycles_ = 0;
+    }
+    last_state_ = state;
+
+    // Do not let the loop eat more than its share of the CPU.
+    uint32_t busy_ms = (uint32_t) ((mark_us_ - cycle_start_us_ + 999) / 1000);
+    uint32_t period_ms = period_ms_;
+    if (config_.max_duty > 0.0f && busy_ms > config_.max_duty * period_ms) {
+      period_ms = (uint32_t) (busy_ms / config_.max_duty);
+    }
+
+    uint32_t sleep_ms = period_ms > busy_ms ? period_ms - busy_ms : 0;
+    if (sleep_ms < config_.min_sleep_ms) {
+      sleep_ms = config_.min_sleep_ms;
+    }
+
+    // Store the cycle with the planned sleep, the real one replaces it when
+    // the next cycle begins.
+    current_.us[cycle_sleep] = sleep_ms * 1000;
+    next_ = next_ + 1 == History ? 0 : next_ + 1;
+    timings_[last()] = current_;
+    if (count_ < History) {
+      count_++;
+    }
+    sleeping_ = true;
+    sleep_start_us_ = mark_us_;
+
+    return sleep_ms;
+
+  }
+
+  /**
+   * @brief The number of cycles whose timings are kept.
+   */
+  size_t size() const { return count_; }
+
+  /**
+   * @brief The timings of a past cycle.
+   *
+   * @param age 0 for the last cycle, 1 for the one before it, and so on. It
+   * must be smaller than size().
+   */
+  const CycleTiming& timing(size_t age) const {
+    return timings_[(last() + History - age) % History];
+  }
+
+  /**
+   * @brief The average time of every stage over the kept cycles.
+   *
+   * @param average Where the averages will be stored.
+   */
+  void average(CycleTiming* average) const {
+
+    for (int stage = 0; stage < cycle_stages; stage++) {
+      uint64_t sum = 0;
+      for (size_t i = 0; i < count_; i++) {
+        sum += timings_[i].us[stage];
+      }
+      average->us[stage] = count_ ? (uint32_t) (sum / count_) : 0;
+    }
+
+  }
+
+  /**
+   * @brief The current period while the loop is not stretched, in ms.
+   */
+  uint32_t period_ms() const { return period_ms_; }
+
+ private:
+
+  // Index of the last stored cycle.
+  size_t last() const { return (next_ + History - 1) % History; }
+
+  DutyCycleConfig config_;
+
+  uint32_t period_ms_;
+  uint32_t empty_cycles_ = 0;
+  CrowdState last_state_ = crowd_empty;
+
+  bool sleeping_ = false;
+  uint64_t sleep_start_us_ = 0;
+
+  CycleTiming timings_[History];
+  size_t next_ = 0;
+  size_t count_ = 0;
+
+};
+
+#endif  // DUTY_CYCLE_H_
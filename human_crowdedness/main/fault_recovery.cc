@@ -0,0 +1,69 @@
+/**
+ * @file fault_recovery.cc
+ * @brief Decides how to get over camera and inference faults.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include "fault_recovery.h"
+
+FaultRecovery::FaultRecovery(const FaultRecoveryConfig& config) : config_(config) {
+
+  for (int kind = 0; kind < fault_kinds; kind++) {
+    faults_[kind].store(0, std::memory_order_relaxed);
+  }
+
+}
+
+void FaultRecovery::succeeded() {
+
+  in_row_ = 0;
+  reinits_in_row_ = 0;
+  backoff_ms_ = 0;
+
+}
+
+FaultAction FaultRecovery::failed(FaultKind kind) {
+
+  faults_[kind].fetch_add(1, std::memory_order_relaxed);
+
+  // Wait longer after every retry, up to the limit.
+  if (in_row_ < config_.retries) {
+    backoff_ms_ = in_row_ == 0 ? config_.min_backoff_ms : backoff_ms_ * 2;
+    if (backoff_ms_ > config_.max_backoff_ms) {
+      backoff_ms_ = config_.max_backoff_ms;
+    }
+    in_row_++;
+    return fault_action_retry;
+  }
+
+  // Out of retries, restart the component and retry again straight away.
+  if (reinits_in_row_ < config_.max_reinits) {
+    reinits_in_row_++;
+    reinits_.fetch_add(1, std::memory_order_relaxed);
+    in_row_ = 0;
+    backoff_ms_ = 0;
+    return fault_action_reinit;
+  }
+
+  return fault_action_restart;
+
+}
+
+uint32_t FaultRecovery::total_faults() const {
+
+  uint32_t total = 0;
+  for (int kind = 0; kind < fault_kinds; kind++) {
+    total += faults_[kind].load(std::memory_order_relaxed);
+  }
+  return total;
+
+}
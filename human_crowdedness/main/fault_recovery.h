@@ -0,0 +1,130 @@
+/**
+ * @file fault_recovery.h
+ * @brief Decides how to get over camera and inference faults.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef FAULT_RECOVERY_H_
+#define FAULT_RECOVERY_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+/**
+ * @brief What failed.
+ */
+enum FaultKind {
+  fault_capture = 0,        // The camera did not give a frame.
+  fault_frame_timeout = 1,  // No frame arrived from the capture task in time.
+  fault_invoke = 2,         // The model failed to run.
+  fault_kinds = 3,
+};
+
+/**
+ * @brief What to do after a fault.
+ */
+enum FaultAction {
+  fault_action_retry = 0,    // Wait backoff_ms() and try again.
+  fault_action_reinit = 1,   // Restart the failing component and try again.
+  fault_action_restart = 2,  // Nothing else worked, restart the board.
+};
+
+/**
+ * @brief How hard to try before giving up.
+ */
+struct FaultRecoveryConfig {
+  uint32_t retries;         // Retries in a row before a reinit.
+  uint32_t min_backoff_ms;  // Wait before the first retry, doubled every time.
+  uint32_t max_backoff_ms;  // Longest wait before a retry.
+  uint32_t max_reinits;     // Reinits in a row before a restart.
+};
+
+constexpr FaultRecoveryConfig default_fault_recovery_config = {3, 50, 2000, 2};
+
+/**
+ * @brief Recovery state machine of one component.
+ *
+ * A fault is first retried a few times, waiting longer every time, as most of
+ * them are a glitch that goes away on its own. If it does not, the component
+ * is restarted, which is much cheaper than restarting the board, and the
+ * retries start again. Only if the component keeps failing after a few
+ * restarts is the board restarted. Any success ends the outage.
+ *
+ * The fault counters can be read from any task, for the telemetry.
+ */
+class FaultRecovery {
+
+ public:
+
+  /**
+   * @brief Build the state machine.
+   *
+   * @param config How hard to try. With no reinits, the retries go straight
+   * to a restart.
+   */
+  explicit FaultRecovery(const FaultRecoveryConfig& config = default_fault_recovery_config);
+
+  /**
+   * @brief The component worked, the outage is over if there was one.
+   */
+  void succeeded();
+
+  /**
+   * @brief The component failed.
+   *
+   * @param kind What failed.
+   *
+   * @returns What to do next.
+   */
+  FaultAction failed(FaultKind kind);
+
+  /**
+   * @brief How long to wait before retrying, after fault_action_retry.
+   */
+  uint32_t backoff_ms() const { return backoff_ms_; }
+
+  /**
+   * @brief Whether the component is failing right now.
+   */
+  bool recovering() const { return in_row_ > 0 || reinits_in_row_ > 0; }
+
+  /**
+   * @brief The number of faults of a kind since the beginning.
+   */
+  uint32_t faults(FaultKind kind) const { return faults_[kind].load(std::memory_order_relaxed); }
+
+  /**
+   * @brief The number of faults of all kinds since the beginning.
+   */
+  uint32_t total_faults() const;
+
+  /**
+   * @brief The number of reinits since the beginning.
+   */
+  uint32_t reinits() const { return reinits_.load(std::memory_order_relaxed); }
+
+ private:
+
+  FaultRecoveryConfig config_;
+
+  // State of the current outage.
+  uint32_t in_row_ = 0;
+  uint32_t reinits_in_row_ = 0;
+  uint32_t backoff_ms_ = 0;
+
+  std::atomic<uint32_t> faults_[fault_kinds];
+  std::atomic<uint32_t> reinits_{0};
+
+};
+
+#endif  // FAULT_RECOVERY_H_
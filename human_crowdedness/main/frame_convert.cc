@@ -0,0 +1,136 @@
+/**
+ * @file frame_convert.cc
+ * @brief Converts camera pixels into the model input format.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include "frame_convert.h"
+
+#include <string.h>
+
+// Use the widest integer the CPU handles natively: 32 bits on the ESP32 and
+// 64 bits on the host.
+typedef uintptr_t word_t;
+
+// The sign bit of every byte in a word.
+static constexpr word_t sign_bits = (word_t) 0x8080808080808080ULL;
+
+/**
+ * @brief Convert whole words, four at a time.
+ *
+ * memcpy() is used for the loads and stores to keep the compiler happy about
+ * aliasing, it turns them into plain word loads and stores anyway.
+ *
+ * @param src The unsigned pixels coming from the camera.
+ * @param dst Where the signed pixels will be stored.
+ * @param words The number of words to convert.
+ */
+static inline void convert_words(const uint8_t* src, uint8_t* dst, size_t words) {
+
+  size_t i = 0;
+
+  for (; i + 4 <= words; i += 4) {
+    word_t w0, w1, w2, w3;
+    memcpy(&w0, src, sizeof(word_t));
+    memcpy(&w1, src + sizeof(word_t), sizeof(word_t));
+    memcpy(&w2, src + 2 * sizeof(word_t), sizeof(word_t));
+    memcpy(&w3, src + 3 * sizeof(word_t), sizeof(word_t));
+    w0 ^= sign_bits;
+    w1 ^= sign_bits;
+    w2 ^= sign_bits;
+    w3 ^= sign_bits;
+    memcpy(dst, &w0, sizeof(word_t));
+    memcpy(dst + sizeof(word_t), &w1, sizeof(word_t));
+    memcpy(dst + 2 * sizeof(word_t), &w2, sizeof(word_t));
+    memcpy(dst + 3 * sizeof(word_t), &w3, sizeof(word_t));
+    src += 4 * sizeof(word_t);
+    dst += 4 * sizeof(word_t);
+  }
+
+  for (; i < words; i++) {
+    word_t w;
+    memcpy(&w, src, sizeof(word_t));
+    w ^= sign_bits;
+    memcpy(dst, &w, sizeof(word_t));
+    src += sizeof(word_t);
+    dst += sizeof(word_t);
+  }
+
+}
+
+void convert_frame_to_input(const uint8_t* src, int8_t* dst, size_t len) {
+
+  uint8_t* out = (uint8_t *) dst;
+
+  // Do the first bytes one by one until the output is aligned to a word.
+  while (len > 0 && ((uintptr_t) out % sizeof(word_t)) != 0) {
+    *out++ = *src++ ^ 0x80;
+    len--;
+  }
+
+  size_t words = len / sizeof(word_t);
+
+  // Both the frame buffer and the tensor arena are word aligned, so this is
+  // the path we take on the board. Telling the compiler about it matters there,
+  // as the ESP32 cannot load a word from an unaligned address.
+  if (((uintptr_t) src % sizeof(word_t)) == 0) {
+    convert_words((const uint8_t *) __builtin_assume_aligned(src, sizeof(word_t)),
+                  (uint8_t *) __builtin_assume_aligned(out, sizeof(word_t)), words);
+  } else {
+    convert_words(src, out, words);
+  }
+
+  // And finally the bytes that do not fill a word.
+  src += words * sizeof(word_t);
+  out += words * sizeof(word_t);
+  for (size_t i = 0; i < len % sizeof(word_t); i++) {
+    out[i] = src[i] ^ 0x80;
+  }
+
+}
+
+void crop_frame_to_input(const uint8_t* frame, size_t frame_width, size_t x, size_t y,
+                         size_t src_size, int8_t* dst, size_t dst_size) {
+
+  const uint8_t* origin = frame + y * frame_width + x;
+
+  // Same size, just a strided copy.
+  if (src_size == dst_size) {
+    for (size_t row = 0; row < dst_size; row++) {
+      convert_frame_to_input(origin + row * frame_width, dst + row * dst_size, dst_size);
+    }
+    return;
+  }
+
+  // Step between samples in 16.16 fixed point, starting half a step in so
+  // that the samples sit in the middle of the pixels they stand for.
+  uint32_t step = (uint32_t) ((src_size << 16) / dst_size);
+  uint32_t sy = step / 2;
+
+  for (size_t row = 0; row < dst_size; row++, sy += step) {
+    const uint8_t* src_row = origin + (sy >> 16) * frame_width;
+    uint8_t* out = (uint8_t *) dst + row * dst_size;
+    uint32_t sx = step / 2;
+    for (size_t col = 0; col < dst_size; col++, sx += step) {
+      out[col] = src_row[sx >> 16] ^ 0x80;
+    }
+  }
+
+}
+
+void convert_frame_to_input_bytewise(const uint8_t* src, int8_t* dst, size_t len) {
+
+  for (size_t i = 0; i < len; i++) {
+    dst[i] = src[i] ^ 0x80;
+  }
+
+}
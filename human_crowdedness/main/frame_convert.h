@@ -0,0 +1,68 @@
+/**
+ * @file frame_convert.h
+ * @brief Converts camera pixels into the model input format.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef FRAME_CONVERT_H_
+#define FRAME_CONVERT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Convert grayscale pixels into signed model input.
+ *
+ * The camera gives unsigned pixels in [0, 255] and the quantized model wants
+ * them in [-128, 127] with a zero point of -128, which is the same as flipping
+ * the sign bit of every byte. This does it a whole machine word at a time
+ * instead of pixel by pixel, so it takes a fraction of the time of the
+ * original loop. Neither buffer needs to be aligned.
+ *
+ * @param src The unsigned pixels coming from the camera.
+ * @param dst Where the signed pixels will be stored. It may be the same as src.
+ * @param len The number of pixels to convert.
+ */
+void convert_frame_to_input(const uint8_t* src, int8_t* dst, size_t len);
+
+/**
+ * @brief Crop a square out of a bigger frame and scale it into model input.
+ *
+ * Used to run the model on tiles of a frame bigger than its input. The square
+ * is scaled with nearest neighbour sampling, which needs no extra memory and
+ * is cheap enough to do for every tile of every frame. When no scaling is
+ * needed every row goes through convert_frame_to_input().
+ *
+ * @param frame The unsigned pixels of the whole frame.
+ * @param frame_width The width of the frame in pixels.
+ * @param x The left column of the square.
+ * @param y The top row of the square.
+ * @param src_size The side of the square in the frame, in pixels.
+ * @param dst Where the signed pixels will be stored.
+ * @param dst_size The side of the square in the model input, in pixels.
+ */
+void crop_frame_to_input(const uint8_t* frame, size_t frame_width, size_t x, size_t y,
+                         size_t src_size, int8_t* dst, size_t dst_size);
+
+/**
+ * @brief Reference version of convert_frame_to_input().
+ *
+ * Does the conversion one pixel at a time, exactly like we used to. It is only
+ * kept to check and benchmark the fast version against it.
+ *
+ * @param src The unsigned pixels coming from the camera.
+ * @param dst Where the signed pixels will be stored.
+ * @param len The number of pixels to convert.
+ */
+void convert_frame_to_input_bytewise(const uint8_t* src, int8_t* dst, size_t len);
+
+#endif  // FRAME_CONVERT_H_
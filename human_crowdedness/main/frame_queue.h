@@ -0,0 +1,201 @@
+/**
+ * @file frame_queue.h
+ * @brief Bounded queue that joins the capture and the inference stages.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef FRAME_QUEUE_H_
+#define FRAME_QUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @brief Bounded queue of frames where the latest frame always wins.
+ *
+ * The capture stage pushes frames as fast as the camera gives them and the
+ * inference stage pops them when it is ready for the next one. We only care
+ * about the most recent picture of the room, so when the queue is full the
+ * oldest frame is dropped to make room for the new one instead of blocking
+ * the camera, and the queue only ever holds the last Capacity frames. With a
+ * capacity of one the consumer always gets the newest frame.
+ *
+ * The dropped frame is handed back to the producer, as it owns the buffer and
+ * has to give it back to the camera driver.
+ *
+ * It is plain C++ (std::mutex works both on ESP-IDF and on Linux), so that it
+ * can be tested on the host with any kind of frame.
+ *
+ * @tparam T The frame handle, normally a pointer.
+ * @tparam Capacity How many frames can be waiting at the same time.
+ */
+template <typename T, size_t Capacity>
+class FrameQueue {
+
+  static_assert(Capacity > 0, "A frame queue needs room for at least one frame");
+
+ public:
+
+  /**
+   * @brief Add a frame to the queue.
+   *
+   * @param frame The frame to add.
+   * @param dropped Where the oldest frame will be stored if it had to be
+   * dropped to make room. Its owner must release it.
+   *
+   * @returns True if a frame was dropped, false otherwise.
+   */
+  bool push(const T& frame, T* dropped) {
+
+    bool was_full = false;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      // Refuse new frames after closing, the producer gets its own one back.
+      if (closed_) {
+        *dropped = frame;
+        return true;
+      }
+
+      // Make room by dropping the oldest frame.
+      if (count_ == Capacity) {
+        *dropped = frames_[head_];
+        head_ = (head_ + 1) % Capacity;
+        count_--;
+        dropped_++;
+        was_full = true;
+      }
+
+      frames_[(head_ + count_) % Capacity] = frame;
+      count_++;
+      pushed_++;
+    }
+
+    ready_.notify_one();
+
+    return was_full;
+
+  }
+
+  /**
+   * @brief Take the oldest frame out of the queue, waiting for one if needed.
+   *
+   * @param frame Where the frame will be stored.
+   * @param timeout_ms How long to wait for a frame.
+   *
+   * @returns True if a frame was taken, false on timeout or if the queue was
+   * closed and is empty.
+   */
+  bool pop(T* frame, uint32_t timeout_ms) {
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (!ready_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                         [this] { return count_ > 0 || closed_; })) {
+      return false;
+    }
+
+    return take(frame);
+
+  }
+
+  /**
+   * @brief Take the oldest frame out of the queue without waiting.
+   *
+   * @param frame Where the frame will be stored.
+   *
+   * @returns True if a frame was taken, false if the queue was empty.
+   */
+  bool try_pop(T* frame) {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return take(frame);
+
+  }
+
+  /**
+   * @brief Close the queue and wake up anyone waiting on it.
+   *
+   * Frames that are already in the queue can still be popped, but no new ones
+   * are accepted.
+   */
+  void close() {
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+
+    ready_.notify_all();
+
+  }
+
+  /**
+   * @brief The number of frames waiting in the queue.
+   */
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+  }
+
+  /**
+   * @brief The number of frames that were accepted since the beginning.
+   */
+  uint32_t pushed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pushed_;
+  }
+
+  /**
+   * @brief The number of frames that were dropped because nobody took them.
+   */
+  uint32_t dropped() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+  }
+
+ private:
+
+  // Must be called with the mutex held.
+  bool take(T* frame) {
+
+    if (count_ == 0) {
+      return false;
+    }
+
+    *frame = frames_[head_];
+    head_ = (head_ + 1) % Capacity;
+    count_--;
+
+    return true;
+
+  }
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+
+  T frames_[Capacity];
+  size_t head_ = 0;
+  size_t count_ = 0;
+  bool closed_ = false;
+
+  uint32_t pushed_ = 0;
+  uint32_t dropped_ = 0;
+
+};
+
+#endif  // FRAME_QUEUE_H_
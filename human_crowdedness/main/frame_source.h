@@ -0,0 +1,53 @@
+/**
+ * @file frame_source.h
+ * @brief Where the frames that go into the model come from.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef FRAME_SOURCE_H_
+#define FRAME_SOURCE_H_
+
+#include <stdint.h>
+
+// Statuses returned by FrameSource::get_image(). The OK one has the same value
+// as ESP_OK so that the camera can return its own statuses straight away.
+constexpr int frame_source_ok = 0;
+constexpr int frame_source_error = -1;
+constexpr int frame_source_end = 1;
+
+/**
+ * @brief Something that gives frames in the model input format.
+ *
+ * On the board this is the camera, but on the host it can be a directory of
+ * recorded frames or a generator, so that the whole inference path can run
+ * without the sensor.
+ */
+class FrameSource {
+
+ public:
+
+  virtual ~FrameSource() {}
+
+  /**
+   * @brief Get the next image.
+   *
+   * @param img Where the image will be stored, one signed byte per pixel of
+   * the model input.
+   *
+   * @returns frame_source_ok if an image was stored, frame_source_end if there
+   * are no more images, or frame_source_error if the source failed.
+   */
+  virtual int get_image(int8_t* img) = 0;
+
+};
+
+#endif  // FRAME_SOURCE_H_
@@ -13,52 +13,235 @@
  * The University of Dublin, Ireland during Hilary term 2023.
 */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-#include <iostream>
+#include <atomic>
 
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "tensorflow/lite/micro/micro_interpreter.h"
-#include "tensorflow/lite/micro/micro_log.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
-#include "tensorflow/lite/schema/schema_generated.h"
 
 #include "camera_ctrl.h"
-#include "model.h"
+#include "crowd_classifier.h"
+#include "deferred_log.h"
+#include "duty_cycle.h"
+#include "fault_recovery.h"
+#include "frame_queue.h"
+#include "frame_source.h"
+#include "motion_gate.h"
+#include "person_detector.h"
+#include "region_detector.h"
+#include "telemetry.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/esp_nn_workers.h"
+#include "tensorflow/lite/micro/micro_stats_profiler.h"
+
+// Set to 1 to time every operator of the model and print a JSON report of
+// their statistics every inference_report_period inferences.
+#ifndef INFERENCE_PROFILING
+#define INFERENCE_PROFILING 0
+#endif
 
 // Set the model variables we will use from all functions.
-const tflite::Model* model = nullptr;
-tflite::MicroInterpreter* interpreter = nullptr;
-TfLiteTensor* input = nullptr;
-
-// Set the memory allocation variables we need.
-constexpr int alloc_size = 81 * 1024;
+static PersonDetector detector;
+
+// Set the memory allocation variables we need. The convolutions keep their
+// quantization for as long as the model lives, and with
+// CONFIG_NN_CONV_ARENA_BUFFERS the offset terms of their weights and scratch
+// space too. The exact size comes from the header that host/arena_size
+// writes, when it was measured for this target.
+//
+// Only the activations and what the kernels keep, which every inference goes
+// through, need the internal SRAM. The structs of the tensors and nodes that
+// the interpreter sets up once go to the PSRAM when the board has one, and
+// everything goes in a single internal arena when not. That is all the split
+// saves, about 5 KB: the kernels read everything else they keep on every
+// inference.
+//
+// Without the header, the sizes arena_size measured on the host, rounded up
+// to the KB. Its pointers are twice as big, so they hold on the board too.
+#if __has_include("person_detect_arena.h")
+#include "person_detect_arena.h"
+constexpr int alloc_size = person_detect_arena_size;
+constexpr int activation_alloc_size = person_detect_activation_arena_size;
+constexpr int persistent_alloc_size = person_detect_persistent_arena_size;
+#elif defined(CONFIG_NN_CONV_ARENA_BUFFERS)
+constexpr int alloc_size = 97 * 1024;
+constexpr int activation_alloc_size = 92 * 1024;
+constexpr int persistent_alloc_size = 5 * 1024;
+#else
+constexpr int alloc_size = 86 * 1024;
+constexpr int activation_alloc_size = 82 * 1024;
+constexpr int persistent_alloc_size = 5 * 1024;
+#endif
 static uint8_t *alloc_space;
+static uint8_t *persistent_space;
+
+#if CAMERA_TILED_MODE
+// Occupancy map of the room, refreshed a few tiles at a time so that a frame
+// does not take much longer than a single inference.
+static RegionDetector region_detector;
+#else
+// Change detector that lets the model skip the frames where nothing moved.
+static MotionGate<cam_width, cam_height> motion_gate;
+#endif
+
+// Number of frames the people score is averaged over before deciding how
+// crowded the room is.
+constexpr size_t smoothing_window = 5;
+static CrowdClassifier<smoothing_window> classifier;
+
+// Set the pipeline constants. Capture runs on the PRO core and inference on the
+// APP core, so that the camera keeps working while the model is running.
+constexpr BaseType_t capture_core = 0;
+constexpr BaseType_t inference_core = 1;
+constexpr uint32_t frame_timeout_ms = 1000;
+
+// The big convolutions are split with a worker on the capture core, which
+// mostly waits for the camera.
+constexpr int inference_workers = 1;
+
+#if __has_include("person_detect_arena.h")
+static_assert(person_detect_arena_workers == inference_workers,
+              "the arena was measured for another number of workers, run arena_size -w again");
+#if defined(CONFIG_NN_CONV_ARENA_BUFFERS)
+static_assert(person_detect_arena_conv_buffers,
+              "the arena was measured without CONFIG_NN_CONV_ARENA_BUFFERS, run arena_size again");
+#else
+static_assert(!person_detect_arena_conv_buffers,
+              "the arena was measured with CONFIG_NN_CONV_ARENA_BUFFERS, run arena_size again");
+#endif
+#endif
+
+/**
+ * @brief The clock of the board, its high resolution timer.
+ */
+class BoardClock : public Clock {
+
+ public:
+
+  uint64_t now_us() override { return esp_timer_get_time(); }
 
-// Set the model constants.
-constexpr int num_of_labels = 2;
-constexpr int index_nothing = 0;
-constexpr int index_people = 1;
-const char* labels_array[num_of_labels] = {
-    "nothing",
-    "people",
 };
 
+static BoardClock board_clock;
+
+// Scheduler that picks how long to sleep after every frame, and keeps the
+// timings of the last few of them.
+constexpr size_t timing_history = 32;
+static DutyCycleScheduler<timing_history> scheduler(&board_clock);
+
+// Messages of the inference task, printed by the log task when it gets some
+// time so that the prints never stall the inference.
+constexpr size_t log_capacity = 32;
+constexpr uint32_t log_period_ms = 100;
+static DeferredLog<log_capacity> app_log(&board_clock);
+
+/**
+ * @brief Writes the log lines to the console.
+ */
+class ConsoleLogWriter : public LogWriter {
+
+ public:
+
+  void write(const char* line, size_t len) override { fwrite(line, 1, len, stdout); }
+
+};
+
+static ConsoleLogWriter console_log_writer;
+
+// Messages of the capture task, which needs its own ring.
+constexpr size_t capture_log_capacity = 8;
+static DeferredLog<capture_log_capacity> capture_log(&board_clock);
+
+// Recovery from the faults of the camera, handled by the capture task, and of
+// the inference task. The inference task does not restart anything on its
+// own: a camera that stops is the business of the capture task.
+static FaultRecovery camera_recovery;
+constexpr FaultRecoveryConfig inference_recovery_config = {10, 100, 2000, 0};
+static FaultRecovery inference_recovery(inference_recovery_config);
+
+// Queue that takes the frames from the capture task to the inference task.
+static CameraFrameQueue frame_queue;
+
+// Payload the results of every cycle are packed into until it is full.
+static uint8_t telemetry_payload[telemetry_payload_size];
+static TelemetryWriter telemetry(telemetry_payload, sizeof(telemetry_payload));
+
+#if INFERENCE_PROFILING
+// Statistics of every operator, about 350 bytes each, and the last report,
+// written by the inference task and printed by the log task.
+constexpr int profiled_nodes = 40;
+constexpr uint32_t inference_report_period = 100;
+static tflite::MicroNodeStats node_stats[profiled_nodes];
+static tflite::MicroStatsProfiler profiler(node_stats, profiled_nodes);
+static char inference_report[4096];
+static std::atomic<bool> inference_report_ready{false};
+#endif
+
+#if !CAMERA_TILED_MODE
+// Where the inference stage gets its images from.
+static CameraFrameSource camera_source(&frame_queue, frame_timeout_ms, &scheduler);
+static FrameSource* frame_source = &camera_source;
+#endif
+
 /**
  * @brief Print a message before killing the execution.
  * 
- * Print a message before killing the execution.
+ * Print a message before killing the execution. Only for the faults that
+ * cannot be recovered from, the rest go through FaultRecovery first.
  * 
  * @param error The message that will be printed before 
  */
 void kill_with_error(const char * error) {
 
-  std::cerr << "[KILL PROCESS] " << error << std::endl;
+  // Straight to the console, the log task may never get to run again.
+  fprintf(stderr, "[KILL PROCESS] %s\n", error);
   exit(1);
 
 }
 
+/**
+ * @brief Send the results packed so far and start a new payload.
+ */
+void send_telemetry() {
+
+  /**
+   * @todo HERE IS WHERE THE WIFI / BLUETOOTH CONNECTION SHOULD BE IMPLEMENTED.
+   *
+   * The payload is decoded with telemetry_decode(). The state of every record
+   * is a CrowdState:
+   *
+   * state = 2: Means that the room is too full.
+   * state = 1: Means that there are some people in the room.
+   * state = 0: Means that the room is empty.
+   */
+  DLOG_INFO(app_log, "Telemetry: %u results in %u bytes", telemetry.count(), telemetry.size());
+
+  telemetry.reset();
+
+}
+
+/**
+ * @brief Deal with a fault of the inference task.
+ *
+ * @param kind What failed.
+ * @param error What to print about it. A string literal.
+ *
+ * @returns How long to wait before the next try, in milliseconds. If the
+ * faults go on for too long, it restarts the board instead.
+ */
+uint32_t inference_fault(FaultKind kind, const char* error) {
+
+  DLOG_WARN(app_log, "%s", error);
+  if (fault_action_restart == inference_recovery.failed(kind)) {
+    kill_with_error(error);
+  }
+  return inference_recovery.backoff_ms();
+
+}
+
 /**
  * @brief Setup the system.
  * 
@@ -71,44 +254,70 @@ void kill_with_error(const char * error) {
  */
 void setup() {
 
-  // Load the TensorFlow model into the C/C++ interface we can interact with.
-  model = tflite::GetModel(g_person_detect_model_data);
-
-  // Check that this model uses the same version we have installed in components.
-  if (model->version() != TFLITE_SCHEMA_VERSION) {
-    std::cerr << "TF version " << model->version() << " != " << TFLITE_SCHEMA_VERSION << std::endl;
-    kill_with_error("Wrong TF model version!");
-  }
-  
-  // Allocate the memory that the processes will use.
-  alloc_space = (uint8_t *) heap_caps_malloc(alloc_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  // Allocate the memory that the processes will use: the activations in
+  // internal memory and the rest in the PSRAM, if there is any.
+  persistent_space = (uint8_t *) heap_caps_malloc(persistent_alloc_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  const int arena_size = persistent_space != NULL ? activation_alloc_size : alloc_size;
+  alloc_space = (uint8_t *) heap_caps_malloc(arena_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
 
   // If the returned value is NULL, it means that the memory allocation failed.
   if (alloc_space == NULL) {
     kill_with_error("Memory allocation failed!\n");
   }
 
-  // Build the resolver that we will use to build the interpreter.
-  static tflite::MicroMutableOpResolver<5> resolver;
-  resolver.AddAveragePool2D();
-  resolver.AddConv2D();
-  resolver.AddDepthwiseConv2D();
-  resolver.AddReshape();
-  resolver.AddSoftmax();
+  // The convolutions are split between the cores when they are prepared, so
+  // the worker has to be there before the model is loaded.
+  if (!tflite::StartEspNnWorkers(inference_workers, capture_core)) {
+    kill_with_error("Inference worker could not be started!");
+  }
 
-  // Now, we build the interpreter.
-  // We have to do it in two lines so that memory allocation does not crash.
-  static tflite::MicroInterpreter local_interpreter(model, resolver, alloc_space, alloc_size);
-  interpreter = &local_interpreter;
+  // Load the model and build the interpreter in that memory.
+#if INFERENCE_PROFILING
+  tflite::MicroProfilerInterface* model_profiler = &profiler;
+#else
+  tflite::MicroProfilerInterface* model_profiler = nullptr;
+#endif
+  const int status = persistent_space != NULL
+    ? detector.init(alloc_space, arena_size, persistent_space, persistent_alloc_size, model_profiler)
+    : detector.init(alloc_space, arena_size, model_profiler);
+  switch (status) {
+    case person_detector_ok:
+      break;
+    case person_detector_wrong_version:
+      kill_with_error("Wrong TF model version!");
+      break;
+    default:
+      kill_with_error("Tensor allocation failed!");
+      break;
+  }
 
-  // Then, we allocate the actual tensors.
-  if (kTfLiteOk != interpreter->AllocateTensors()) {
-    kill_with_error("Tensor allocation failed!");
+  const PersonDetectorMemory memory = detector.memory();
+  DLOG_INFO(app_log, "Arena: %u bytes of activations and %u persistent in SRAM, %u persistent in PSRAM",
+            (unsigned) memory.activation_bytes, (unsigned) memory.persistent.activation_arena,
+            (unsigned) memory.persistent.persistent_arena);
+  // A log message takes log_max_args arguments at most, so one per kind.
+  const struct {
+    const char* name;
+    PersonDetectorBytes bytes;
+  } persistent_parts[] = {
+    {"eval tensors", memory.eval_tensors},
+    {"tensors", memory.tensors},
+    {"quantization", memory.quantization},
+    {"kernels", memory.kernels},
+    {"nodes", memory.nodes},
+  };
+  for (const auto& part : persistent_parts) {
+    DLOG_INFO(app_log, "Persistent %s: %u bytes in SRAM, %u in PSRAM", part.name,
+              (unsigned) part.bytes.activation_arena, (unsigned) part.bytes.persistent_arena);
   }
 
-  // Then, store the info about where the input must go into a global variable
-  // to be used elsewhere.
-  input = interpreter->input(0);
+#if CAMERA_TILED_MODE
+  // Cut the frames into overlapping tiles of the size of the model input.
+  const TileGridConfig grid = {cam_width, cam_height, detector.input_width(), 64, 4, 1000 * 1000};
+  if (person_detector_ok != region_detector.init(&detector, grid, &board_clock)) {
+    kill_with_error("Tile grid does not fit!");
+  }
+#endif
 
   // Init the camera.
   if (ESP_OK != init_camera()) {
@@ -129,50 +338,177 @@ void setup() {
  */
 void loop() {
 
-  // Get image from provider.
-  if (ESP_OK != get_image_from_cam(input->data.int8)) {
-    kill_with_error("Camera failed when reading!");
+  scheduler.begin_cycle();
+
+  static float score_people_float = 0;
+
+  // If something fails, how long to wait before trying again.
+  uint32_t fault_backoff_ms = 0;
+
+#if CAMERA_TILED_MODE
+
+  // Get the latest frame from the capture task. It is kept until all the
+  // tiles of this cycle are cropped out of it, the driver fills the other
+  // buffer in the meantime.
+  {
+    std::lock_guard<std::mutex> lock(camera_frames_mutex);
+    camera_fb_t* fb = nullptr;
+    if (!frame_queue.pop(&fb, frame_timeout_ms)) {
+      fault_backoff_ms = inference_fault(fault_frame_timeout, "No frame from the camera!");
+    } else {
+      scheduler.mark(cycle_capture);
+
+      // Refresh the next tiles. The room has people if any of them has.
+      int status = fb->len < (size_t) cam_size ? person_detector_invoke_failed : region_detector.update(fb->buf);
+      return_frame_to_cam(fb);
+      if (person_detector_ok != status) {
+        fault_backoff_ms = inference_fault(fault_invoke, "Prediction failed!");
+      }
+    }
+  }
+  score_people_float = region_detector.max_score();
+  scheduler.mark(cycle_invoke);
+
+  DLOG_DEBUG(app_log, "People count: %.2f", region_detector.count_estimate());
+
+#else
+
+  // Get the latest image straight into the model input, and predict the label,
+  // but only if the room changed since the last time the model ran. Otherwise,
+  // the last score still holds.
+  if (frame_source_ok != frame_source->get_image(detector.input())) {
+    fault_backoff_ms = inference_fault(fault_frame_timeout, "No frame from the camera!");
+  } else if (motion_gate.should_infer(detector.input())) {
+    if (person_detector_ok != detector.invoke(&score_people_float)) {
+      fault_backoff_ms = inference_fault(fault_invoke, "Prediction failed!");
+    }
   }
+  scheduler.mark(cycle_invoke);
 
-  // Predict the label.
-  if (kTfLiteOk != interpreter->Invoke()) {
-    kill_with_error("Prediction failed!");
+#endif
+
+  // A cycle that failed leaves the score and the verdict as they were, and
+  // the next one comes after the backoff.
+  if (fault_backoff_ms > 0) {
+    scheduler.end_cycle(classifier.state());
+    vTaskDelay(pdMS_TO_TICKS(fault_backoff_ms));
+    return;
+  }
+  inference_recovery.succeeded();
+
+  // Smooth the score over the last frames. The verdict only changes when the
+  // room really changes, not every time one frame is a bit off.
+  CrowdEvent event;
+  bool changed = classifier.update(score_people_float, &event);
+  DLOG_DEBUG(app_log, "People score: %.1f", score_people_float * 100);
+  if (changed) {
+    DLOG_INFO(app_log, "Crowdedness: %d -> %d", (int) event.from, (int) event.to);
   }
 
-  // Obtain the predictions from the model.
-  TfLiteTensor* output = interpreter->output(0);
+  // Sleep until the next frame is due. It comes sooner when there are people
+  // in the room and later when it has been empty for a while.
+  uint32_t sleep_ms = scheduler.end_cycle(classifier.state());
+
+  // Pack the result of this cycle, with its timings and the planned sleep.
+  // It goes out when the payload is full, or straight away when the verdict
+  // changed, so that the change is not held back.
+  TelemetryRecord record;
+  record.timestamp_ms = (uint32_t) (board_clock.now_us() / 1000);
+  record.score = telemetry_quantize_score(score_people_float);
+  record.state = (uint8_t) classifier.state();
+  memcpy(record.stage_us, scheduler.timing(0).us, sizeof(record.stage_us));
+  record.faults = camera_recovery.total_faults() + inference_recovery.total_faults();
+  if (!telemetry.append(record)) {
+    send_telemetry();
+    telemetry.append(record);
+  }
+  if (changed) {
+    send_telemetry();
+  }
 
-  // Process the inference results.
-  int8_t score_nothing = output->data.uint8[index_nothing];
-  int8_t score_people = output->data.uint8[index_people];
+#if INFERENCE_PROFILING
+  // Hand the statistics to the log task, unless it did not print the last
+  // ones yet.
+  static uint32_t cycles = 0;
+  if (++cycles % inference_report_period == 0 && !inference_report_ready.load()) {
+    if (profiler.WriteJson(inference_report, sizeof(inference_report)) > 0) {
+      inference_report_ready.store(true);
+    } else {
+      DLOG_WARN(app_log, "Inference report does not fit");
+    }
+  }
+#endif
 
-  float score_nothing_float = (score_nothing - output->params.zero_point) * output->params.scale;
-  float score_people_float = (score_people - output->params.zero_point) * output->params.scale;
+  vTaskDelay(pdMS_TO_TICKS(sleep_ms));
 
-  // Print how likely it is to get people in this frame.
-  std::cout << "People score: " << score_people_float * 100 << std::endl;
+}
 
-  // Here is where the response is.
-  int result = 0;
+/**
+ * @brief Capture stage of the pipeline.
+ * 
+ * Reads frames from the camera as fast as it gives them and leaves them in the
+ * frame queue for the inference task. If the inference task did not take the
+ * previous frame yet, that one is dropped and given back to the camera.
+ */
+void capture_task(void) {
 
-  // Pass from probability to numbers.
-  if (score_people_float >= 0.65)
-    result = 2;
-  else if (score_people_float >= 0.5)
-    result = 1;
-  else
-    result = 0;
+  while (true) {
 
-  /**
-   * @todo HERE IS WHERE THE WIFI / BLUETOOTH CONNECTION SHOULD BE IMPLEMENTED.
-   * 
-   * result = 2: Means that the room is too full.
-   * result = 1: Means that there are some people in the room.
-   * result = 0: Means that the room is empty.
-   */
+    camera_fb_t* fb = get_frame_from_cam();
+
+    // If nothing was read, an error occurred. Try again a bit later, then
+    // restart the camera, and only restart the board if nothing else works.
+    if (!fb) {
+      switch (camera_recovery.failed(fault_capture)) {
+        case fault_action_retry:
+          DLOG_WARN(capture_log, "Camera failed when reading, retrying in %u ms", camera_recovery.backoff_ms());
+          vTaskDelay(pdMS_TO_TICKS(camera_recovery.backoff_ms()));
+          break;
+        case fault_action_reinit:
+          DLOG_WARN(capture_log, "Camera keeps failing, restarting it");
+          if (ESP_OK != reinit_camera(&frame_queue)) {
+            DLOG_ERROR(capture_log, "Camera restart failed!");
+          }
+          break;
+        case fault_action_restart:
+          kill_with_error("Camera failed when reading!");
+          break;
+      }
+      continue;
+    }
+    camera_recovery.succeeded();
+
+    camera_fb_t* dropped = nullptr;
+    if (frame_queue.push(fb, &dropped)) {
+      return_frame_to_cam(dropped);
+    }
+
+  }
+
+}
+
+/**
+ * @brief Log stage of the pipeline.
+ *
+ * Formats and prints the messages of the other tasks every now and then, with
+ * the lowest priority so that it only runs when the cores are idle.
+ */
+void log_task(void) {
+
+  while (true) {
 
-  // Delay the next task so that we can get different results.
-  vTaskDelay(100);
+    capture_log.drain(&console_log_writer);
+    app_log.drain(&console_log_writer);
+#if INFERENCE_PROFILING
+    if (inference_report_ready.load()) {
+      printf("Inference report: %s\n", inference_report);
+      inference_report_ready.store(false);
+    }
+#endif
+    fflush(stdout);
+    vTaskDelay(pdMS_TO_TICKS(log_period_ms));
+
+  }
 
 }
 
@@ -181,7 +517,13 @@ void main_task(void) {
   // Set up the components.
   setup();
 
-  // Main loop.
+  // Start capturing on the other core.
+  xTaskCreatePinnedToCore((TaskFunction_t)&capture_task, "capture_task", 3 * 1024, NULL, 8, NULL, capture_core);
+
+  // Print the log when the cores are idle.
+  xTaskCreatePinnedToCore((TaskFunction_t)&log_task, "log_task", 3 * 1024, NULL, 1, NULL, capture_core);
+
+  // Main loop, which is the inference stage.
   while (true) {
 
     loop();
@@ -197,7 +539,7 @@ void main_task(void) {
  */
 extern "C" void app_main() {
 
-  xTaskCreate((TaskFunction_t)&main_task, "main_task", 4 * 1024, NULL, 8, NULL);
+  xTaskCreatePinnedToCore((TaskFunction_t)&main_task, "main_task", 4 * 1024, NULL, 8, NULL, inference_core);
   
   vTaskDelete(NULL);
 
@@ -0,0 +1,243 @@
+/**
+ * @file motion_gate.h
+ * @brief Decides if a frame changed enough to be worth running the model on.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef MOTION_GATE_H_
+#define MOTION_GATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief When a frame counts as changed.
+ */
+struct MotionGateConfig {
+
+  // Mean absolute difference, in gray levels, that any region of the
+  // decimated frame must have against the reference to count as changed.
+  uint8_t region_threshold;
+
+  // Fraction of the decimated pixels, in [0, 1], that must have moved to
+  // another histogram bin to count as changed.
+  float histogram_threshold;
+
+  // Run the model anyway after skipping this many frames in a row, so that
+  // slow changes are never missed for long. 0 means never skip.
+  uint32_t max_skipped;
+
+};
+
+// Above the sensor noise once decimated, and a full inference every 30 frames.
+constexpr MotionGateConfig default_motion_gate_config = {6, 0.1f, 30};
+
+/**
+ * @brief Cheap change detector that runs before the model.
+ *
+ * The frame is decimated by averaging Block x Block pixels, and the decimated
+ * frame is compared against the one of the last frame the model ran on. The
+ * frame counts as changed if any region of the decimated frame has a sum of
+ * absolute differences (SAD) above a threshold, or if the histogram of the
+ * frame moved too much. Regions are Region x Region decimated pixels, so a
+ * person walking in through a corner is not averaged away by the rest of the
+ * room.
+ *
+ * Everything lives in fixed size arrays and the loops run over contiguous
+ * rows, so nothing is allocated and the compiler can vectorize it where the
+ * target has SIMD.
+ *
+ * @tparam Width The width of the frames in pixels.
+ * @tparam Height The height of the frames in pixels.
+ * @tparam Block The side of the blocks that are averaged into one pixel.
+ * @tparam Region The side of the regions, in decimated pixels.
+ */
+template <int Width, int Height, int Block = 4, int Region = 6>
+class MotionGate {
+
+  static_assert(Width % Block == 0 && Height % Block == 0, "The frame must be made of whole blocks");
+  static_assert((Width / Block) % Region == 0 && (Height / Block) % Region == 0, "The decimated frame must be made of whole regions");
+  static_assert(Block * Block * 255 <= UINT16_MAX, "The sum of a block must fit in 16 bits");
+
+ public:
+
+  // Size of the decimated frame.
+  static constexpr int small_width = Width / Block;
+  static constexpr int small_height = Height / Block;
+  static constexpr int small_size = small_width * small_height;
+
+  // Number of histogram bins.
+  static constexpr int bins = 16;
+
+  /**
+   * @brief Build the gate. The first frame always goes to the model.
+   *
+   * @param config When a frame counts as changed.
+   */
+  explicit MotionGate(const MotionGateConfig& config = default_motion_gate_config)
+      : config_(config) {}
+
+  /**
+   * @brief Decide if the model must run on a frame.
+   *
+   * If it must, the frame becomes the new reference, as its result is the one
+   * that will be reused until the next change.
+   *
+   * @param img The frame in the model input format.
+   *
+   * @returns True if the model must run, false if the last result still holds.
+   */
+  bool should_infer(const int8_t* img) {
+
+    decimate(img, current_);
+
+    frames_++;
+
+    bool infer = !has_reference_ || config_.max_skipped == 0 ||
+                 skipped_in_a_row_ >= config_.max_skipped || changed();
+
+    if (!infer) {
+      skipped_++;
+      skipped_in_a_row_++;
+      return false;
+    }
+
+    memcpy(reference_, current_, sizeof(reference_));
+    histogram(reference_, reference_histogram_);
+    has_reference_ = true;
+    skipped_in_a_row_ = 0;
+
+    return true;
+
+  }
+
+  /**
+   * @brief Make the next frame go to the model, whatever it looks like.
+   */
+  void reset() {
+    has_reference_ = false;
+    skipped_in_a_row_ = 0;
+  }
+
+  /**
+   * @brief The number of frames seen.
+   */
+  uint32_t frames() const { return frames_; }
+
+  /**
+   * @brief The number of frames the model did not have to run on.
+   */
+  uint32_t skipped() const { return skipped_; }
+
+ private:
+
+  // Average every Block x Block block of the frame into one pixel. The sign
+  // bit is flipped back, so the decimated frame is in camera gray levels.
+  static void decimate(const int8_t* img, uint8_t* small) {
+
+    for (int by = 0; by < small_height; by++) {
+
+      // Add up the rows of the block first, which is a plain vertical sum
+      // over contiguous memory.
+      uint16_t column_sums[Width];
+      const int8_t* row = img + by * Block * Width;
+      for (int x = 0; x < Width; x++) {
+        column_sums[x] = (uint8_t) (row[x] ^ 0x80);
+      }
+      for (int y = 1; y < Block; y++) {
+        row += Width;
+        for (int x = 0; x < Width; x++) {
+          column_sums[x] += (uint8_t) (row[x] ^ 0x80);
+        }
+      }
+
+      // Then the columns of every block.
+      for (int bx = 0; bx < small_width; bx++) {
+        uint16_t sum = 0;
+        for (int x = 0; x < Block; x++) {
+          sum += column_sums[bx * Block + x];
+        }
+        small[by * small_width + bx] = (uint8_t) (sum / (Block * Block));
+      }
+
+    }
+
+  }
+
+  static void histogram(const uint8_t* small, uint16_t* hist) {
+
+    memset(hist, 0, bins * sizeof(uint16_t));
+    for (int i = 0; i < small_size; i++) {
+      hist[small[i] >> 4]++;
+    }
+
+  }
+
+  // Compare the current decimated frame against the reference.
+  bool changed() const {
+
+    // SAD of every region, one row of decimated pixels at a time.
+    constexpr int regions_x = small_width / Region;
+    uint32_t region_sad[regions_x];
+    const uint32_t region_limit = (uint32_t) config_.region_threshold * Region * Region;
+
+    for (int ry = 0; ry < small_height / Region; ry++) {
+      memset(region_sad, 0, sizeof(region_sad));
+      for (int y = ry * Region; y < (ry + 1) * Region; y++) {
+        const uint8_t* cur = current_ + y * small_width;
+        const uint8_t* ref = reference_ + y * small_width;
+        uint8_t diff[small_width];
+        for (int x = 0; x < small_width; x++) {
+          diff[x] = cur[x] > ref[x] ? cur[x] - ref[x] : ref[x] - cur[x];
+        }
+        for (int rx = 0; rx < regions_x; rx++) {
+          for (int x = 0; x < Region; x++) {
+            region_sad[rx] += diff[rx * Region + x];
+          }
+        }
+      }
+      for (int rx = 0; rx < regions_x; rx++) {
+        if (region_sad[rx] > region_limit) {
+          return true;
+        }
+      }
+    }
+
+    // Histogram delta. Half the L1 distance is the number of pixels that went
+    // to another bin.
+    uint16_t hist[bins];
+    histogram(current_, hist);
+    uint32_t moved = 0;
+    for (int i = 0; i < bins; i++) {
+      moved += hist[i] > reference_histogram_[i] ? hist[i] - reference_histogram_[i] : reference_histogram_[i] - hist[i];
+    }
+    moved /= 2;
+
+    return moved > config_.histogram_threshold * small_size;
+
+  }
+
+  MotionGateConfig config_;
+
+  uint8_t current_[small_size];
+  uint8_t reference_[small_size];
+  uint16_t reference_histogram_[bins];
+  bool has_reference_ = false;
+
+  uint32_t frames_ = 0;
+  uint32_t skipped_ = 0;
+  uint32_t skipped_in_a_row_ = 0;
+
+};
+
+#endif  // MOTION_GATE_H_
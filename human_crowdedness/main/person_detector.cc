@@ -0,0 +1,159 @@
+/**
+ * @file person_detector.cc
+ * @brief Runs the person detection model on one image.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include "person_detector.h"
+
+#include <new>
+
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "model.h"
+
+PersonDetector::~PersonDetector() {
+
+  if (interpreter_) {
+    interpreter_->~MicroInterpreter();
+  }
+
+}
+
+int PersonDetector::init(uint8_t* arena, size_t arena_size, tflite::MicroProfilerInterface* profiler) {
+
+  int status = prepare(arena != nullptr);
+  if (status != person_detector_ok) {
+    return status;
+  }
+
+  // The allocator lives at the end of the arena and places the tensors with
+  // our own planner, which tries more orders than the default one.
+  allocator_ = tflite::RecordingMicroAllocator::Create(arena, arena_size, &planner_);
+  has_persistent_arena_ = false;
+  return build(profiler);
+
+}
+
+int PersonDetector::init(uint8_t* activation_arena, size_t activation_size, uint8_t* persistent_arena, size_t persistent_size, tflite::MicroProfilerInterface* profiler) {
+
+  int status = prepare(activation_arena != nullptr && persistent_arena != nullptr);
+  if (status != person_detector_ok) {
+    return status;
+  }
+
+  // The same, but the planned tensors, the scratch buffers and what the
+  // kernels keep for when they run go in the activation arena, and only the
+  // structures of the graph in the persistent one.
+  allocator_ = tflite::RecordingMicroAllocator::Create(persistent_arena, persistent_size, activation_arena, activation_size, &planner_);
+  has_persistent_arena_ = true;
+  return build(profiler);
+
+}
+
+int PersonDetector::prepare(bool has_arena) {
+
+  // Load the TensorFlow model into the C/C++ interface we can interact with.
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+
+  // Check that this model uses the same version we have installed in components.
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    return person_detector_wrong_version;
+  }
+
+  if (!has_arena || interpreter_ != nullptr) {
+    return person_detector_no_arena;
+  }
+
+  // Build the resolver with the operators the model uses, the first time only,
+  // as init() can be tried again after the tensors did not fit.
+  if (resolver_.GetRegistrationLength() == 0) {
+    resolver_.AddAveragePool2D();
+    resolver_.AddConv2D();
+    resolver_.AddDepthwiseConv2D();
+    resolver_.AddReshape();
+    resolver_.AddSoftmax();
+  }
+
+  return person_detector_ok;
+
+}
+
+int PersonDetector::build(tflite::MicroProfilerInterface* profiler) {
+
+  if (allocator_ == nullptr) {
+    return person_detector_allocation_failed;
+  }
+
+  // Now, we build the interpreter and allocate the actual tensors.
+  const tflite::Model* model = tflite::GetModel(g_person_detect_model_data);
+  interpreter_ = new (interpreter_storage_) tflite::MicroInterpreter(model, resolver_, allocator_, nullptr, profiler);
+  if (kTfLiteOk != interpreter_->AllocateTensors()) {
+    // Leave the detector as it was, so that init() can be tried again with
+    // a bigger arena.
+    interpreter_->~MicroInterpreter();
+    interpreter_ = nullptr;
+    allocator_ = nullptr;
+    return person_detector_allocation_failed;
+  }
+
+  input_ = interpreter_->input(0);
+
+  return person_detector_ok;
+
+}
+
+PersonDetectorBytes PersonDetector::recorded(tflite::RecordedAllocationType type) const {
+
+  PersonDetectorBytes bytes;
+  bytes.persistent_arena = allocator_->GetRecordedPersistentArenaAllocation(type).used_bytes;
+  bytes.activation_arena = allocator_->GetRecordedAllocation(type).used_bytes - bytes.persistent_arena;
+  return bytes;
+
+}
+
+PersonDetectorMemory PersonDetector::memory() const {
+
+  PersonDetectorMemory memory = {};
+  if (input_ == nullptr) {
+    return memory;
+  }
+
+  memory.activation_bytes = allocator_->non_persistent_used_bytes();
+  const size_t persistent_bytes = allocator_->persistent_used_bytes();
+  memory.persistent.persistent_arena = has_persistent_arena_ ? persistent_bytes - allocator_->kernel_persistent_used_bytes() : 0;
+  memory.persistent.activation_arena = persistent_bytes - memory.persistent.persistent_arena;
+  memory.eval_tensors = recorded(tflite::RecordedAllocationType::kTfLiteEvalTensorData);
+  memory.tensors = recorded(tflite::RecordedAllocationType::kPersistentTfLiteTensorData);
+  memory.quantization = recorded(tflite::RecordedAllocationType::kPersistentTfLiteTensorQuantizationData);
+  memory.kernels = recorded(tflite::RecordedAllocationType::kPersistentBufferData);
+  memory.variables = recorded(tflite::RecordedAllocationType::kTfLiteTensorVariableBufferData);
+  memory.nodes = recorded(tflite::RecordedAllocationType::kNodeAndRegistrationArray);
+  return memory;
+
+}
+
+int PersonDetector::invoke(float* score_people) {
+
+  // Predict the label.
+  if (kTfLiteOk != interpreter_->Invoke()) {
+    return person_detector_invoke_failed;
+  }
+
+  // Obtain the prediction from the model and dequantize it.
+  TfLiteTensor* output = interpreter_->output(0);
+  int8_t score = output->data.int8[person_detector_index_people];
+  *score_people = (score - output->params.zero_point) * output->params.scale;
+
+  return person_detector_ok;
+
+}
@@ -0,0 +1,203 @@
+/**
+ * @file person_detector.h
+ * @brief Runs the person detection model on one image.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef PERSON_DETECTOR_H_
+#define PERSON_DETECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tensorflow/lite/micro/memory_planner/search_memory_planner.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/micro/recording_micro_allocator.h"
+
+// Statuses returned by the detector.
+constexpr int person_detector_ok = 0;
+constexpr int person_detector_wrong_version = -1;
+constexpr int person_detector_no_arena = -2;
+constexpr int person_detector_allocation_failed = -3;
+constexpr int person_detector_invoke_failed = -4;
+
+// Positions of the labels in the model output.
+constexpr int person_detector_index_nothing = 0;
+constexpr int person_detector_index_people = 1;
+
+/**
+ * @brief Bytes of one kind in each arena of the detector.
+ *
+ * With a single arena, everything is in it and counts as its activation arena.
+ */
+struct PersonDetectorBytes {
+  size_t activation_arena;
+  size_t persistent_arena;
+};
+
+/**
+ * @brief Where the memory of the detector went.
+ *
+ * The activations are the tensors the planner places and the scratch buffers
+ * of the kernels, at the head of the activation arena. The persistent region
+ * holds the structures the interpreter sets up once, the ones below and the
+ * allocators. What the kernels read while they run, their buffers and the
+ * variable tensors, stays at the tail of the activation arena, and only the
+ * structs and quantization of the tensors and nodes go to the persistent
+ * arena, when there is one.
+ */
+struct PersonDetectorMemory {
+  size_t activation_bytes;
+  PersonDetectorBytes persistent;
+
+  // What the persistent region holds, in bytes.
+  PersonDetectorBytes eval_tensors;  // The TfLiteEvalTensor of every tensor.
+  PersonDetectorBytes tensors;       // The TfLiteTensor structs of inputs and outputs.
+  PersonDetectorBytes quantization;  // The quantization parameters of those.
+  PersonDetectorBytes kernels;       // What the kernels keep, like per channel scales.
+  PersonDetectorBytes variables;     // The buffers of variable tensors.
+  PersonDetectorBytes nodes;         // The node and registration arrays.
+};
+
+/**
+ * @brief The person detection model and its interpreter.
+ *
+ * Loads g_person_detect_model_data into an interpreter that lives in the arena
+ * given by the caller. It does not depend on ESP-IDF, so the same code runs on
+ * the board and on the host.
+ */
+class PersonDetector {
+
+ public:
+
+  PersonDetector() {}
+  ~PersonDetector();
+
+  PersonDetector(const PersonDetector&) = delete;
+  PersonDetector& operator=(const PersonDetector&) = delete;
+
+  /**
+   * @brief Load the model and allocate its tensors.
+   *
+   * @param arena The memory the interpreter will work in. It must outlive the
+   * detector.
+   * @param arena_size The size of the arena in bytes.
+   * @param profiler Optional profiler that gets every operator invocation.
+   *
+   * @returns person_detector_ok if everything worked, another status if not.
+   */
+  int init(uint8_t* arena, size_t arena_size, tflite::MicroProfilerInterface* profiler = nullptr);
+
+  /**
+   * @brief Load the model with the activations and the rest in two arenas.
+   *
+   * Lets the activations, which every inference goes through, stay in fast
+   * memory while the structures that are only set up once go somewhere
+   * bigger, like the internal SRAM and the PSRAM of the board.
+   *
+   * @param activation_arena The memory of the planned tensors, of the scratch
+   * buffers and of what the kernels keep. It must outlive the detector.
+   * @param activation_size The size of the activation arena in bytes.
+   * @param persistent_arena The memory of everything else. It must outlive the
+   * detector.
+   * @param persistent_size The size of the persistent arena in bytes.
+   * @param profiler Optional profiler that gets every operator invocation.
+   *
+   * @returns person_detector_ok if everything worked, another status if not.
+   */
+  int init(uint8_t* activation_arena, size_t activation_size, uint8_t* persistent_arena, size_t persistent_size, tflite::MicroProfilerInterface* profiler = nullptr);
+
+  /**
+   * @brief Where the next image must be written before calling invoke().
+   */
+  int8_t* input() { return input_->data.int8; }
+
+  /**
+   * @brief The number of pixels of the input image.
+   */
+  size_t input_size() const { return input_->bytes; }
+
+  /**
+   * @brief The size of the input image, in pixels.
+   */
+  int input_width() const { return input_->dims->data[2]; }
+  int input_height() const { return input_->dims->data[1]; }
+
+  /**
+   * @brief Run the model on the image that is in input().
+   *
+   * @param score_people Where the probability of having people in the image
+   * will be stored, between 0 and 1.
+   *
+   * @returns person_detector_ok if everything worked, another status if not.
+   */
+  int invoke(float* score_people);
+
+  /**
+   * @brief How much of the arena the interpreter really needs.
+   */
+  size_t arena_used_bytes() const { return interpreter_->arena_used_bytes(); }
+
+  /**
+   * @brief How much of each region the interpreter needs, and what for.
+   *
+   * All zero before init() has worked.
+   */
+  PersonDetectorMemory memory() const;
+
+  /**
+   * @brief The interpreter, for whoever needs more than the people score.
+   */
+  tflite::MicroInterpreter* interpreter() { return interpreter_; }
+
+ private:
+
+  /**
+   * @brief Check the model and the arena, and add the operators.
+   */
+  int prepare(bool has_arena);
+
+  /**
+   * @brief Build the interpreter on the allocator and allocate the tensors.
+   */
+  int build(tflite::MicroProfilerInterface* profiler);
+
+  /**
+   * @brief What the allocator recorded of a kind, in each arena.
+   */
+  PersonDetectorBytes recorded(tflite::RecordedAllocationType type) const;
+
+  tflite::MicroMutableOpResolver<5> resolver_;
+
+  // Places the tensors in the arena. It only uses the arena while planning, so
+  // it is not in it.
+  tflite::SearchMemoryPlanner planner_;
+
+  // Records what it puts where, for memory(). It lives in the persistent
+  // region.
+  tflite::RecordingMicroAllocator* allocator_ = nullptr;
+
+  // Whether init() got a persistent arena of its own.
+  bool has_persistent_arena_ = false;
+
+  // The interpreter cannot be built until we have the arena, so it is built
+  // in place here by init().
+  alignas(tflite::MicroInterpreter) uint8_t interpreter_storage_[sizeof(tflite::MicroInterpreter)];
+  tflite::MicroInterpreter* interpreter_ = nullptr;
+
+  TfLiteTensor* input_ = nullptr;
+
+};
+
+#endif  // PERSON_DETECTOR_H_
@@ -0,0 +1,171 @@
+/**
+ * @file region_detector.cc
+ * @brief Runs the person detector on tiles of a bigger frame.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include "region_detector.h"
+
+#include "frame_convert.h"
+
+// The overlap of the tiles is measured on a coarse grid of cells this big.
+constexpr int weight_cell = 16;
+constexpr int max_cells = 1024;
+
+constexpr int RegionDetector::max_tiles;
+
+int RegionDetector::positions(int frame_size, int tile_size, int stride, int16_t* out, int max) {
+
+  int count = 0;
+  for (int pos = 0; count < max; pos += stride) {
+    // The last tile is pushed back against the edge, so it overlaps more.
+    if (pos + tile_size >= frame_size) {
+      out[count++] = (int16_t) (frame_size - tile_size);
+      return count;
+    }
+    out[count++] = (int16_t) pos;
+  }
+
+  // Too many tiles.
+  return -1;
+
+}
+
+int RegionDetector::init(PersonDetector* detector, const TileGridConfig& config, Clock* clock) {
+
+  detector_ = detector;
+  clock_ = clock;
+  config_ = config;
+  tile_count_ = 0;
+  next_ = 0;
+  refreshed_ = 0;
+  tile_us_ = 0;
+
+  if (config.tile_size <= 0 || config.stride <= 0 || config.tiles_per_cycle <= 0 ||
+      config.tile_size > config.frame_width || config.tile_size > config.frame_height) {
+    return region_detector_bad_grid;
+  }
+
+  int16_t xs[max_tiles];
+  int16_t ys[max_tiles];
+  columns_ = positions(config.frame_width, config.tile_size, config.stride, xs, max_tiles);
+  rows_ = positions(config.frame_height, config.tile_size, config.stride, ys, max_tiles);
+  if (columns_ < 0 || rows_ < 0 || columns_ * rows_ > max_tiles) {
+    return region_detector_bad_grid;
+  }
+
+  int cells_x = (config.frame_width + weight_cell - 1) / weight_cell;
+  int cells_y = (config.frame_height + weight_cell - 1) / weight_cell;
+  if (cells_x * cells_y > max_cells) {
+    return region_detector_bad_grid;
+  }
+
+  // Count how many tiles cover every cell of the frame.
+  uint8_t cover[max_cells] = {};
+  for (int row = 0; row < rows_; row++) {
+    for (int col = 0; col < columns_; col++) {
+      for (int cy = ys[row] / weight_cell; cy * weight_cell < ys[row] + config.tile_size && cy < cells_y; cy++) {
+        for (int cx = xs[col] / weight_cell; cx * weight_cell < xs[col] + config.tile_size && cx < cells_x; cx++) {
+          cover[cy * cells_x + cx]++;
+        }
+      }
+    }
+  }
+
+  // A tile is worth the share of every cell it covers, so that the weights of
+  // all the tiles add up to the number of tiles that fit in the frame.
+  float tile_cells = (float) config.tile_size * config.tile_size / (weight_cell * weight_cell);
+  for (int row = 0; row < rows_; row++) {
+    for (int col = 0; col < columns_; col++) {
+      float share = 0;
+      for (int cy = ys[row] / weight_cell; cy * weight_cell < ys[row] + config.tile_size && cy < cells_y; cy++) {
+        for (int cx = xs[col] / weight_cell; cx * weight_cell < xs[col] + config.tile_size && cx < cells_x; cx++) {
+          share += 1.0f / cover[cy * cells_x + cx];
+        }
+      }
+      Tile& tile = tiles_[tile_count_++];
+      tile.x = xs[col];
+      tile.y = ys[row];
+      tile.score = 0;
+      tile.age = 0;
+      tile.weight = share / tile_cells;
+    }
+  }
+
+  return person_detector_ok;
+
+}
+
+int RegionDetector::update(const uint8_t* frame) {
+
+  int side = detector_->input_width();
+  uint64_t start = clock_ ? clock_->now_us() : 0;
+
+  for (int i = 0; i < tile_count_; i++) {
+    tiles_[i].age++;
+  }
+
+  refreshed_ = 0;
+  while (refreshed_ < config_.tiles_per_cycle && refreshed_ < tile_count_) {
+
+    // Stop before going over the budget, but always do at least one tile.
+    uint64_t now = clock_ ? clock_->now_us() : 0;
+    if (refreshed_ > 0 && clock_ && config_.budget_us &&
+        now - start + tile_us_ > config_.budget_us) {
+      break;
+    }
+
+    Tile& tile = tiles_[next_];
+    crop_frame_to_input(frame, config_.frame_width, tile.x, tile.y, config_.tile_size, detector_->input(), side);
+
+    int status = detector_->invoke(&tile.score);
+    if (status != person_detector_ok) {
+      return status;
+    }
+    tile.age = 0;
+
+    // Keep a running average of the time of a tile.
+    if (clock_) {
+      uint32_t took = (uint32_t) (clock_->now_us() - now);
+      tile_us_ = tile_us_ ? (tile_us_ * 7 + took) / 8 : took;
+    }
+
+    next_ = next_ + 1 == tile_count_ ? 0 : next_ + 1;
+    refreshed_++;
+
+  }
+
+  return person_detector_ok;
+
+}
+
+float RegionDetector::max_score() const {
+
+  float max = 0;
+  for (int i = 0; i < tile_count_; i++) {
+    max = tiles_[i].score > max ? tiles_[i].score : max;
+  }
+  return max;
+
+}
+
+float RegionDetector::count_estimate(float threshold) const {
+
+  float count = 0;
+  for (int i = 0; i < tile_count_; i++) {
+    if (tiles_[i].score >= threshold) {
+      count += tiles_[i].weight;
+    }
+  }
+  return count;
+
+}
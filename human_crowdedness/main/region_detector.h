@@ -0,0 +1,167 @@
+/**
+ * @file region_detector.h
+ * @brief Runs the person detector on tiles of a bigger frame.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef REGION_DETECTOR_H_
+#define REGION_DETECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "duty_cycle.h"
+#include "person_detector.h"
+
+// Statuses returned by the region detector, on top of the ones of the person
+// detector.
+constexpr int region_detector_bad_grid = -10;
+
+/**
+ * @brief How a frame is cut into tiles.
+ */
+struct TileGridConfig {
+
+  // Size of the frames, in pixels.
+  int frame_width;
+  int frame_height;
+
+  // Side of the square tiles in the frame, in pixels. They are scaled to the
+  // input of the model, so anything other than its side costs some detail.
+  int tile_size;
+
+  // Distance between the corners of two neighbouring tiles. Smaller than the
+  // tile size makes them overlap, so that people on an edge are not cut in
+  // half.
+  int stride;
+
+  // Most tiles to run the model on in one call to update().
+  int tiles_per_cycle;
+
+  // If not 0, stop refreshing tiles once the next one would not end within
+  // this many microseconds since the start of update(). At least one tile is
+  // always refreshed.
+  uint32_t budget_us;
+
+};
+
+/**
+ * @brief What is known about one tile.
+ */
+struct Tile {
+  int16_t x;
+  int16_t y;
+  float score;      // People score of the last time the model ran on it.
+  uint32_t age;     // Calls to update() since then.
+  float weight;     // Share of the frame that belongs to this tile alone.
+};
+
+/**
+ * @brief Occupancy map of the room, one tile at a time.
+ *
+ * Cuts the frame into a grid of overlapping tiles and runs the same person
+ * detector, and so the same interpreter and arena, on each of them. Running
+ * the model on all the tiles would take several times the latency of a single
+ * frame, so every update only refreshes the next few tiles in turn and the
+ * rest keep their last score.
+ *
+ * The count estimate adds up the occupied tiles, each one weighted by how much
+ * of the frame only it covers, so that a person seen by two overlapping tiles
+ * is not counted twice.
+ */
+class RegionDetector {
+
+ public:
+
+  // Most tiles a grid can have.
+  static constexpr int max_tiles = 32;
+
+  /**
+   * @brief Build the grid.
+   *
+   * @param detector The person detector, already initialized. It must outlive
+   * the region detector.
+   * @param config How to cut the frames.
+   * @param clock Clock used for the latency budget, it can be null if there is
+   * no budget.
+   *
+   * @returns person_detector_ok, or region_detector_bad_grid if the grid does
+   * not fit.
+   */
+  int init(PersonDetector* detector, const TileGridConfig& config, Clock* clock = nullptr);
+
+  /**
+   * @brief Refresh the next tiles with a new frame.
+   *
+   * @param frame The unsigned pixels of the whole frame.
+   *
+   * @returns person_detector_ok if everything worked, another status if not.
+   */
+  int update(const uint8_t* frame);
+
+  /**
+   * @brief The number of tiles in the grid.
+   */
+  int tiles() const { return tile_count_; }
+
+  /**
+   * @brief The number of columns and rows of the grid.
+   */
+  int columns() const { return columns_; }
+  int rows() const { return rows_; }
+
+  /**
+   * @brief A tile of the grid, in row order.
+   */
+  const Tile& tile(int index) const { return tiles_[index]; }
+
+  /**
+   * @brief The number of tiles refreshed by the last update().
+   */
+  int refreshed() const { return refreshed_; }
+
+  /**
+   * @brief The highest people score among the tiles.
+   */
+  float max_score() const;
+
+  /**
+   * @brief Rough number of people in the frame.
+   *
+   * @param threshold The score from which a tile counts as occupied.
+   */
+  float count_estimate(float threshold = 0.5f) const;
+
+ private:
+
+  // Positions of the tiles along one side of the frame.
+  static int positions(int frame_size, int tile_size, int stride, int16_t* out, int max);
+
+  PersonDetector* detector_ = nullptr;
+  Clock* clock_ = nullptr;
+  TileGridConfig config_ = {};
+
+  Tile tiles_[max_tiles];
+  int tile_count_ = 0;
+  int columns_ = 0;
+  int rows_ = 0;
+
+  // The next tile to refresh.
+  int next_ = 0;
+  int refreshed_ = 0;
+
+  // Average time of one tile, for the budget.
+  uint32_t tile_us_ = 0;
+
+};
+
+#endif  // REGION_DETECTOR_H_
@@ -0,0 +1,172 @@
+/**
+ * @file telemetry.cc
+ * @brief Compact binary encoding of the occupancy results.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#include "telemetry.h"
+
+#include <string.h>
+
+// Size of the payload header: version and number of records.
+constexpr size_t header_size = 2;
+
+/**
+ * @brief Write an unsigned variable length integer, 7 bits per byte.
+ *
+ * @returns The number of bytes written.
+ */
+static inline size_t put_varint(uint8_t* out, uint32_t value) {
+
+  size_t len = 0;
+  while (value >= 0x80) {
+    out[len++] = (uint8_t) (value | 0x80);
+    value >>= 7;
+  }
+  out[len++] = (uint8_t) value;
+  return len;
+
+}
+
+/**
+ * @brief Read an unsigned variable length integer.
+ *
+ * @returns The number of bytes read, or 0 if it does not end before end.
+ */
+static inline size_t get_varint(const uint8_t* in, const uint8_t* end, uint32_t* value) {
+
+  uint32_t result = 0;
+  for (size_t len = 0; len < 5 && in + len < end; len++) {
+    result |= (uint32_t) (in[len] & 0x7f) << (7 * len);
+    if (!(in[len] & 0x80)) {
+      *value = result;
+      return len + 1;
+    }
+  }
+  return 0;
+
+}
+
+// Map signed differences to unsigned ones, small either way.
+static inline uint32_t zigzag(int32_t value) {
+  return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value) {
+  return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+}
+
+TelemetryWriter::TelemetryWriter(uint8_t* buffer, size_t capacity)
+    : buffer_(buffer), capacity_(capacity) {
+
+  reset();
+
+}
+
+void TelemetryWriter::reset() {
+
+  buffer_[0] = telemetry_version;
+  buffer_[1] = 0;
+  size_ = header_size;
+  memset(&last_, 0, sizeof(last_));
+
+}
+
+bool TelemetryWriter::append(const TelemetryRecord& record) {
+
+  if (buffer_[1] == UINT8_MAX) {
+    return false;
+  }
+
+  // Encode it aside first, so a record that does not fit leaves no trace.
+  uint8_t encoded[telemetry_max_record_size];
+  size_t len = put_varint(encoded, record.timestamp_ms - last_.timestamp_ms);
+  encoded[len++] = record.score;
+  encoded[len++] = record.state;
+  for (int stage = 0; stage < cycle_stages; stage++) {
+    len += put_varint(encoded + len, zigzag((int32_t) (record.stage_us[stage] - last_.stage_us[stage])));
+  }
+  len += put_varint(encoded + len, zigzag((int32_t) (record.faults - last_.faults)));
+
+  if (size_ + len > capacity_) {
+    return false;
+  }
+
+  memcpy(buffer_ + size_, encoded, len);
+  size_ += len;
+  buffer_[1]++;
+  last_ = record;
+
+  return true;
+
+}
+
+uint8_t telemetry_quantize_score(float score) {
+
+  if (!(score > 0.0f)) {
+    return 0;
+  }
+  if (score >= 1.0f) {
+    return 255;
+  }
+  return (uint8_t) (score * 255.0f + 0.5f);
+
+}
+
+int telemetry_decode(const uint8_t* data, size_t len, TelemetryRecord* records, size_t max_records) {
+
+  if (len < header_size || data[0] != telemetry_version || data[1] > max_records) {
+    return -1;
+  }
+
+  const uint8_t* in = data + header_size;
+  const uint8_t* end = data + len;
+  TelemetryRecord last = {};
+
+  for (int i = 0; i < data[1]; i++) {
+
+    TelemetryRecord& record = records[i];
+    uint32_t value;
+
+    size_t used = get_varint(in, end, &value);
+    if (!used || in + used + 2 > end) {
+      return -1;
+    }
+    record.timestamp_ms = last.timestamp_ms + value;
+    in += used;
+    record.score = *in++;
+    record.state = *in++;
+
+    for (int stage = 0; stage < cycle_stages; stage++) {
+      used = get_varint(in, end, &value);
+      if (!used) {
+        return -1;
+      }
+      record.stage_us[stage] = last.stage_us[stage] + (uint32_t) unzigzag(value);
+      in += used;
+    }
+
+    used = get_varint(in, end, &value);
+    if (!used) {
+      return -1;
+    }
+    record.faults = last.faults + (uint32_t) unzigzag(value);
+    in += used;
+
+    last = record;
+
+  }
+
+  // Anything left over means the payload is not what it says.
+  return in == end ? data[1] : -1;
+
+}
@@ -0,0 +1,131 @@
+/**
+ * @file telemetry.h
+ * @brief Compact binary encoding of the occupancy results.
+ * @date 2026-10-17
+ * @version 1.0.0
+ *
+ * @author Borja García Quiroga <garcaqub@tcd.ie>
+ *
+ * © 2023 Group LPL, CS7NS2-202223
+ *
+ * This code has been developed for the Internet of Things (CS7NS2) module
+ * as partial requisits for the MSc in Computer Science at Trinity College,
+ * The University of Dublin, Ireland during Hilary term 2023.
+*/
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "duty_cycle.h"
+
+// Version of the format, the first byte of every payload.
+constexpr uint8_t telemetry_version = 2;
+
+// Size of a payload: the largest ATT payload of a BLE 4.2 notification, which
+// also fits in any WiFi packet.
+constexpr size_t telemetry_payload_size = 244;
+
+// Most bytes a single record can take once encoded.
+constexpr size_t telemetry_max_record_size = 5 + 1 + 1 + 5 * cycle_stages + 5;
+
+/**
+ * @brief The result of one cycle of the main loop.
+ */
+struct TelemetryRecord {
+  uint32_t timestamp_ms;          // When the cycle ended.
+  uint8_t score;                  // People score, 0 to 255 for 0 to 1.
+  uint8_t state;                  // The smoothed CrowdState.
+  uint32_t stage_us[cycle_stages];  // Time of every stage, see CycleStage.
+  uint32_t faults;                // Faults recovered from since the start.
+};
+
+/**
+ * @brief Packs records into payloads of a fixed maximum size.
+ *
+ * A payload is the version, the number of records and then the records. The
+ * timestamp, the stage times and the fault count of every record are stored as the difference
+ * with the previous record of the same payload, as variable length integers,
+ * so a record of a steady loop takes around a dozen bytes. The first record of
+ * a payload is stored against zero, so every payload can be decoded on its
+ * own even if others were lost.
+ *
+ * It works on a buffer given by the caller and never allocates.
+ */
+class TelemetryWriter {
+
+ public:
+
+  /**
+   * @brief Build the writer.
+   *
+   * @param buffer Where the payload is built. It must outlive the writer.
+   * @param capacity The size of the buffer, the largest payload to build.
+   */
+  TelemetryWriter(uint8_t* buffer, size_t capacity);
+
+  /**
+   * @brief Add a record to the payload.
+   *
+   * @param record The record to add.
+   *
+   * @returns True if it was added, false if it does not fit and the payload
+   * must be sent and reset first.
+   */
+  bool append(const TelemetryRecord& record);
+
+  /**
+   * @brief Start a new, empty payload.
+   */
+  void reset();
+
+  /**
+   * @brief The payload built so far.
+   */
+  const uint8_t* data() const { return buffer_; }
+
+  /**
+   * @brief The size of the payload built so far, in bytes.
+   */
+  size_t size() const { return size_; }
+
+  /**
+   * @brief The number of records in the payload.
+   */
+  uint8_t count() const { return buffer_[1]; }
+
+ private:
+
+  uint8_t* buffer_;
+  size_t capacity_;
+  size_t size_ = 0;
+
+  // The last record appended, the next one is stored against it.
+  TelemetryRecord last_ = {};
+
+};
+
+/**
+ * @brief Quantize a people score for a record.
+ *
+ * @param score The probability of having people, between 0 and 1.
+ *
+ * @returns The score from 0 to 255.
+ */
+uint8_t telemetry_quantize_score(float score);
+
+/**
+ * @brief Decode a payload built by a TelemetryWriter.
+ *
+ * @param data The payload.
+ * @param len The size of the payload in bytes.
+ * @param records Where the records will be stored.
+ * @param max_records The most records that fit in records.
+ *
+ * @returns The number of records decoded, or -1 if the payload is not valid.
+ */
+int telemetry_decode(const uint8_t* data, size_t len, TelemetryRecord* records, size_t max_records);
+
+#endif  // TELEMETRY_H_